@@ -0,0 +1,121 @@
+/*
+ * EEPROM.c
+ *
+ *	Word access to the on-chip EEPROM of the TM4C123
+ *
+ * Created on: October 17th, 2026
+ *
+ */
+
+#include "EEPROM.h"
+#include "util.h"
+#include "tm4c123gh6pm.h"
+
+/*	------------------EEPROM_Wait--------------------
+ *	Local function waiting for the controller to finish
+ *	Input: None
+ *	Output: EEPROM_OK or EEPROM_ERR_TIMEOUT
+ */
+static uint8_t EEPROM_Wait(void){
+	uint32_t start = CYCCNT_Get();
+	uint32_t timeout = (SYSCLK_Get_Hz() / 1000000) * EEPROM_TIMEOUT_US;
+
+	while(EEPROM_EEDONE_R & EEPROM_EEDONE_WORKING){
+		if((CYCCNT_Get() - start) > timeout)
+			return EEPROM_ERR_TIMEOUT;
+	}
+	return EEPROM_OK;
+}
+
+/*	------------------EEPROM_Check-------------------
+ *	Local function reporting an erase or program that has to be retried
+ *	Input: None
+ *	Output: EEPROM_OK or EEPROM_ERR_RETRY
+ */
+static uint8_t EEPROM_Check(void){
+	if(EEPROM_EESUPP_R & (EEPROM_EESUPP_PRETRY|EEPROM_EESUPP_ERETRY))
+		return EEPROM_ERR_RETRY;
+	return EEPROM_OK;
+}
+
+/*	-------------------EEPROM_Init-------------------
+ *	Clocks and resets the EEPROM module (datasheet 8.2.4.1)
+ *	Input: None
+ *	Output: EEPROM_OK or EEPROM_ERR_* status code
+ */
+uint8_t EEPROM_Init(void){
+	uint8_t ret;
+
+	SYSCTL_RCGCEEPROM_R |= SYSCTL_RCGCEEPROM_R0;
+	while((SYSCTL_PREEPROM_R & SYSCTL_PREEPROM_R0) == 0);
+
+	ret = EEPROM_Wait();
+	if(ret == EEPROM_OK)
+		ret = EEPROM_Check();
+	if(ret != EEPROM_OK)
+		return ret;
+
+	SYSCTL_SREEPROM_R |= SYSCTL_SREEPROM_R0;
+	SYSCTL_SREEPROM_R &= ~SYSCTL_SREEPROM_R0;
+	while((SYSCTL_PREEPROM_R & SYSCTL_PREEPROM_R0) == 0);
+
+	ret = EEPROM_Wait();
+	if(ret == EEPROM_OK)
+		ret = EEPROM_Check();
+	return ret;
+}
+
+/*	-------------------EEPROM_Read-------------------
+ *	Input: First word address, Buffer, Number of words
+ *	Output: EEPROM_OK or EEPROM_ERR_* status code
+ */
+uint8_t EEPROM_Read(uint16_t addr, uint32_t* data, uint16_t count){
+	if(data == 0 || (uint32_t)addr + count > EEPROM_WORDS)
+		return EEPROM_ERR_PARAM;
+
+	EEPROM_EEBLOCK_R = addr / EEPROM_BLOCK_WORDS;
+	EEPROM_EEOFFSET_R = addr % EEPROM_BLOCK_WORDS;
+	while(count--){
+		*data++ = EEPROM_EERDWRINC_R;
+
+		/* The offset wraps inside a block, move the block by hand */
+		if(++addr % EEPROM_BLOCK_WORDS == 0 && count != 0){
+			EEPROM_EEBLOCK_R = addr / EEPROM_BLOCK_WORDS;
+			EEPROM_EEOFFSET_R = 0;
+		}
+	}
+	return EEPROM_OK;
+}
+
+/*	-------------------EEPROM_Write------------------
+ *	Programs the words one after the other, waiting for each
+ *	Input: First word address, Words, Number of words
+ *	Output: EEPROM_OK or EEPROM_ERR_* status code
+ */
+uint8_t EEPROM_Write(uint16_t addr, const uint32_t* data, uint16_t count){
+	uint8_t ret;
+
+	if(data == 0 || (uint32_t)addr + count > EEPROM_WORDS)
+		return EEPROM_ERR_PARAM;
+
+	EEPROM_EEBLOCK_R = addr / EEPROM_BLOCK_WORDS;
+	EEPROM_EEOFFSET_R = addr % EEPROM_BLOCK_WORDS;
+	while(count--){
+		EEPROM_EERDWRINC_R = *data++;
+		ret = EEPROM_Wait();
+		if(ret != EEPROM_OK)
+			return ret;
+		if(EEPROM_EEDONE_R & EEPROM_EEDONE_NOPERM)
+			return EEPROM_ERR_PERM;
+		ret = EEPROM_Check();
+		if(ret != EEPROM_OK)
+			return ret;
+
+		/* The offset wraps inside a block, move the block by hand */
+		if(++addr % EEPROM_BLOCK_WORDS == 0 && count != 0){
+			EEPROM_EEBLOCK_R = addr / EEPROM_BLOCK_WORDS;
+			EEPROM_EEOFFSET_R = 0;
+		}
+	}
+	return EEPROM_OK;
+}
@@ -0,0 +1,54 @@
+/*
+ * EEPROM.h
+ *
+ *	Provides word access to the 2KB on-chip EEPROM of the TM4C123,
+ *	32 blocks of 16 words. Addresses are in words (0-511), a
+ *	transfer may cross blocks. Reads take a few cycles per word, each
+ *	word written waits for the controller to program it
+ *
+ * Created on: October 17th, 2026
+ *
+ */
+
+#ifndef EEPROM_H_
+#define EEPROM_H_
+
+#include <stdint.h>
+
+/* List of Macros */
+#define EEPROM_WORDS            512         // 2KB
+#define EEPROM_BLOCK_WORDS      16
+#define EEPROM_TIMEOUT_US       20000       // Longest a word write may take, erase and copy included
+
+/* Status codes */
+#define EEPROM_OK               0x00
+#define EEPROM_ERR_PARAM        0x01        // Range outside the EEPROM or no buffer
+#define EEPROM_ERR_TIMEOUT      0x02        // Controller stayed busy
+#define EEPROM_ERR_RETRY        0x04        // Erase or program must be retried (EESUPP)
+#define EEPROM_ERR_PERM         0x08        // Block is protected
+
+/*
+ *	-------------------EEPROM_Init-------------------
+ *	Clocks and resets the EEPROM module, then checks that the last
+ *	erase or program before power down finished
+ *	Input: None
+ *	Output: EEPROM_OK or EEPROM_ERR_* status code
+ */
+uint8_t EEPROM_Init(void);
+
+/*
+ *	-------------------EEPROM_Read-------------------
+ *	Input: First word address, Buffer, Number of words
+ *	Output: EEPROM_OK or EEPROM_ERR_* status code
+ */
+uint8_t EEPROM_Read(uint16_t addr, uint32_t* data, uint16_t count);
+
+/*
+ *	-------------------EEPROM_Write------------------
+ *	Programs the words one after the other, waiting for each
+ *	Input: First word address, Words, Number of words
+ *	Output: EEPROM_OK or EEPROM_ERR_* status code
+ */
+uint8_t EEPROM_Write(uint16_t addr, const uint32_t* data, uint16_t count);
+
+#endif //EEPROM_H_
@@ -9,38 +9,181 @@
  */
  
 #include "I2C.h"
+#include "I2CAsync.h"
+#include "I2CTrace.h"
+#include "I2CStats.h"
+#include "SoftI2C.h"
 #include "tm4c123gh6pm.h"
 
+static uint8_t Burst_Receive_Polled(I2C_BUS_t* bus, uint8_t slave_addr, uint8_t slave_reg_addr, uint8_t* data, uint32_t size);
+static uint8_t Burst_Transmit_Polled(I2C_BUS_t* bus, uint8_t slave_addr, uint8_t slave_reg_addr, uint8_t* data, uint32_t size);
+static uint8_t Write_Segments_Polled(I2C_BUS_t* bus, uint8_t slave_addr, const I2C_SEG_t* segs, uint8_t count, uint32_t total);
+
+/* Bus Handles, pin mux per the TM4C123 data sheet */
+I2C_BUS_t I2C_Bus[I2C_MODULE_COUNT] = {
+	{.base = I2C0_BASE_ADDR, .gpio_base = GPIOB_BASE_ADDR, .module = 0, .gpio_port = SYSCTL_RCGCGPIO_R1,
+	 .scl_pin = 0x04, .sda_pin = 0x08, .irq = 8, .retry_limit = I2C_RETRY_DEFAULT},		// PB2/PB3
+	{.base = I2C1_BASE_ADDR, .gpio_base = GPIOA_BASE_ADDR, .module = 1, .gpio_port = SYSCTL_RCGCGPIO_R0,
+	 .scl_pin = 0x40, .sda_pin = 0x80, .irq = 37, .retry_limit = I2C_RETRY_DEFAULT},	// PA6/PA7
+	{.base = I2C2_BASE_ADDR, .gpio_base = GPIOE_BASE_ADDR, .module = 2, .gpio_port = SYSCTL_RCGCGPIO_R4,
+	 .scl_pin = 0x10, .sda_pin = 0x20, .irq = 68, .retry_limit = I2C_RETRY_DEFAULT},	// PE4/PE5
+	{.base = I2C3_BASE_ADDR, .gpio_base = GPIOD_BASE_ADDR, .module = 3, .gpio_port = SYSCTL_RCGCGPIO_R3,
+	 .scl_pin = 0x01, .sda_pin = 0x02, .irq = 69, .retry_limit = I2C_RETRY_DEFAULT}		// PD0/PD1
+};
+
+/*
+ *	---------------------I2C_Wait---------------------
+ *	Local function to wait for MCS flags to clear with a deadline
+ *	taken from the cycle counter instead of spinning forever
+ *	Input: Bus Handle, MCS flag(s) to wait on
+ *	Output: I2C_OK, or I2C_ERR_TIMEOUT if the deadline passed
+ */
+static uint8_t I2C_Wait(I2C_BUS_t* bus, uint32_t flags){
+	
+	uint32_t start = CYCCNT_Get();
+	
+	while(I2C_MCS(bus) & flags){
+		if((CYCCNT_Get() - start) > bus->timeout_cycles){
+			bus->stats.timeouts++;
+			return I2C_ERR_TIMEOUT;
+		}
+	}
+	
+	return I2C_OK;
+}
+
+/*
+ *	------------------I2C_Wait_Status-----------------
+ *	Local function to wait for a command to finish and check errors.
+ *	On NACK a STOP is issued so the bus is released, unless the
+ *	command carried STOP: the controller sent it already and is idle
+ *	Input: Bus Handle, MCS command that was issued
+ *	Output: I2C_OK, I2C_ERR_TIMEOUT, or MCS error bits
+ */
+static uint8_t I2C_Wait_Status(I2C_BUS_t* bus, uint32_t cmd){
+	
+	uint8_t error;
+	
+	if(I2C_Wait(bus, I2C_MCS_BUSY) != I2C_OK)
+		return I2C_ERR_TIMEOUT;
+	
+	error = I2C_MCS(bus) & I2C_ERR_MSK;
+	if(error != 0 && !(error & I2C_MCS_ARBLST) && !(cmd & I2C_MCS_STOP))
+		I2C_MCS(bus) = I2C_MCS_STOP;
+	
+	return error;
+}
+
+/*
+ *	-----------------I2C_Retry_Needed-----------------
+ *	Local function applying the retry policy after a failed attempt.
+ *	Timeouts recover the bus first; NACKs are not retried since the
+ *	slave answered and another attempt will not change that
+ *	Input: Bus Handle, Status of the attempt, Attempt number (0 first)
+ *	Output: 1 if the transfer should be repeated
+ */
+static uint8_t I2C_Retry_Needed(I2C_BUS_t* bus, uint8_t error, uint8_t attempt){
+	
+	if(error == I2C_ERR_TIMEOUT)
+		I2C_Recover(bus);
+	else if(!(error & I2C_MCS_ARBLST))
+		return 0;
+	
+	if(attempt >= bus->retry_limit)
+		return 0;
+	
+	bus->stats.retries++;
+	return 1;
+}
+
+/*
+ *	-----------------Recover_Delay--------------------
+ *	Local busy wait used to time the recovery clock pulses
+ *	Input: Cycles to wait
+ *	Output: None
+ */
+static void Recover_Delay(uint32_t cycles){
+	uint32_t start = CYCCNT_Get();
+	while((CYCCNT_Get() - start) < cycles);
+}
+
+/*
+ *	-------------------Pins_Pctl---------------------
+ *	Local function to build the PCTL field covering the given pins
+ *	Input: Pin mask, Function number
+ *	Output: PCTL value with func in every selected pin's nibble
+ */
+static uint32_t Pins_Pctl(uint8_t pins, uint32_t func){
+	
+	uint8_t pin;
+	uint32_t pctl = 0;
+	
+	for(pin = 0; pin < 8; pin++){
+		if(pins & (1U << pin))
+			pctl |= func << (pin * 4);
+	}
+	
+	return pctl;
+}
+
 /*
- *	-------------------I2C0_Init------------------
+ *	--------------------I2C_Init------------------
  *	Basic I2C Initialization function for master mode @ 100kHz
- *	Input: None
+ *	Input: Bus Handle
  *	Output: None
  */
-void I2C0_Init(void){
+void I2C_Init(I2C_BUS_t* bus){
+	
+	uint8_t pins = bus->scl_pin | bus->sda_pin;
 	
 	/* Enable Required System Clock */
-	SYSCTL_RCGC1_R |= EN_I2C0_CLOCK;							//Enable I2C0 System Clock
-	SYSCTL_RCGC2_R |= EN_GPIOB_CLOCK;							//Enable GPIOB System Clock
+	SYSCTL_RCGCI2C_R |= (1U << bus->module);						//Enable I2Cn System Clock
+	SYSCTL_RCGCGPIO_R |= bus->gpio_port;							//Enable GPIO Port System Clock
 	
-	//Wait Until GPIOx System Clock is enabled
-	//while((SYSCTL_RCGC1_R & EN_I2C0_CLOCK) != EN_I2C0_CLOCK);
-	while((SYSCTL_RCGC2_R&EN_GPIOB_CLOCK)!= EN_GPIOB_CLOCK);
+	//Wait Until Peripherals are ready
+	while((SYSCTL_PRGPIO_R & bus->gpio_port) == 0);
+	while((SYSCTL_PRI2C_R & (1U << bus->module)) == 0);
 	
 	/* GPIOx I2C Alternate Function Setup	*/
-	GPIO_PORTB_DEN_R	 |= I2C0_PINS;								//Enable Digital I/O
-	GPIO_PORTB_AFSEL_R |= I2C0_PINS;								//Enable Alternate Function Selection
+	I2C_GPIO_REG(bus, GPIO_DEN_OFFSET)   |= pins;					//Enable Digital I/O
+	I2C_GPIO_REG(bus, GPIO_AFSEL_OFFSET) |= pins;					//Enable Alternate Function Selection
 	
-	//Select I2C0 as the alternate function 
-	GPIO_PORTB_PCTL_R  |= (GPIO_PORTB_PCTL_R & I2C0_ALT_FUNC_MSK) | I2C0_ALT_FUNC_SET;
-	GPIO_PORTB_ODR_R	 |= I2C0_SDA_PIN;						  //Enable Open Drain for SDA pin
-	GPIO_PORTB_AMSEL_R &= ~I2C0_PINS;								//Disable Analog Mode
+	//Select I2C as the alternate function
+	I2C_GPIO_REG(bus, GPIO_PCTL_OFFSET) = (I2C_GPIO_REG(bus, GPIO_PCTL_OFFSET) & ~Pins_Pctl(pins, 0xF)) | Pins_Pctl(pins, I2C_PCTL_FUNC);
+	I2C_GPIO_REG(bus, GPIO_ODR_OFFSET)   |= bus->sda_pin;			//Enable Open Drain for SDA pin
+	I2C_GPIO_REG(bus, GPIO_AMSEL_OFFSET) &= ~pins;					//Disable Analog Mode
 	
-	/*	I2C0 Setup as Master Mode @ 100kBits	*/
-	I2C0_MCR_R |= EN_I2C0_MASTER;									//Configure I2C0 as Master 
+	/*	I2Cn Setup as Master Mode @ 100kBits	*/
+	I2C_MCR(bus) |= EN_I2C_MASTER;										//Configure I2Cn as Master 
 	
-	/* Configuring I2C Clock Frequency to 100KHz
-		
+	/* Bound every wait on the controller, needs the cycle counter running */
+	if(!(DWT_CTRL_R & DWT_CYCCNTENA))
+		CYCCNT_Init();
+	I2C_Set_Timeout(bus, I2C_TIMEOUT_DEFAULT_US);
+	
+	/* Configuring I2C Clock Frequency to 100KHz, see I2C_SetSpeed */
+	I2C_SetSpeed(bus, I2C_SPEED_STANDARD);
+
+}
+
+/*
+ *	------------------I2C_SetSpeed----------------
+ *	Programs the master timer period for the fastest SCL rate that does
+ *	not exceed the request at the current system clock
+ *	Input: Bus Handle, Requested SCL rate in Hz
+ *	Output: SCL rate actually programmed in Hz, 0 if out of range
+ */
+uint32_t I2C_SetSpeed(I2C_BUS_t* bus, uint32_t scl_hz){
+	
+	uint32_t sys_clk = SYSCLK_Get_Hz();
+	uint32_t period;
+	uint32_t tpr;
+	
+	/* Asserting Param */
+	if(scl_hz == 0)
+		return 0;
+	
+	/* 
 		TPR = (System Clock / (2*(SCL_LP + SCL_HP) * SCL_CLK)) - 1
 		SCL_LP and SCL_HP are fixed
 		SCL_LP = 6 & SCL_HP = 4
@@ -49,167 +192,633 @@ void I2C0_Init(void){
 		TPR = (40MHz / ((2*(6+4)) * 100kHz)) - 1 		(Convert Everything to Hz)
 		TPR = 19
 		
+		Rounding the division up keeps SCL at or below the request so a
+		device is never clocked faster than it is rated for
 	*/
+	period = 2 * I2C_SCL_LP_HP * scl_hz;
+	tpr = (sys_clk + period - 1) / period;
+	if(tpr > 0)
+		tpr--;
 	
-	// take care of master timer period: standard speed and TPR value	
-	I2C0_MTPR_R = (I2C0_MTPR_R&~(0xFF))| I2C_MTPR_TPR_VALUE | I2C_MTPR_STD_SPEED;
+	/* Slowest the timer can go is still too fast for this request */
+	if(tpr > I2C_MTPR_TPR_M)
+		return 0;
+	
+	/* Wait for any transfer in flight before changing the timing */
+	I2C_Async_Acquire(bus);
+	I2C_Wait(bus, I2C_MCS_BUSY);
+	I2C_MTPR(bus) = (I2C_MTPR(bus)&~(0xFF)) | tpr | I2C_MTPR_STD_SPEED;
+	I2C_Async_Release(bus);
+	
+	return sys_clk / (2 * I2C_SCL_LP_HP * (tpr + 1));
+}
 
+/*
+ *	------------------I2C_GetSpeed----------------
+ *	Input: Bus Handle
+ *	Output: SCL rate currently programmed in Hz
+ */
+uint32_t I2C_GetSpeed(I2C_BUS_t* bus){
+	uint32_t tpr = I2C_MTPR(bus) & I2C_MTPR_TPR_M;
+	return SYSCLK_Get_Hz() / (2 * I2C_SCL_LP_HP * (tpr + 1));
 }
 
 /*
- *	-------------------I2C0_Receive------------------
- *	Polls to receive data from specified peripheral
- *	Input: Slave address & Slave Register Address
- *	Output: Returns 8-bit data that has been received
+ *	-------------I2C_SetSpeed_For_Devices---------
+ *	Runs the bus at the fastest rate every listed device allows
+ *	Input: Bus Handle, Array of device descriptors, Number of devices
+ *	Output: SCL rate actually programmed in Hz, 0 if out of range
  */
-uint8_t I2C0_Receive(uint8_t slave_addr, uint8_t slave_reg_addr){
-	
-	char error;		//Temp Variable to hold errors
+uint32_t I2C_SetSpeed_For_Devices(I2C_BUS_t* bus, const I2C_DEVICE_t* const devices[], uint8_t count){
 	
-	/* Check if I2C0 is busy: check MCS register Busy bit */
-	while(I2C0_MCS_R & I2C_MCS_BUSY);
+	uint8_t i;
+	uint32_t scl_hz = I2C_SPEED_FAST_PLUS;				//Fastest mode this driver supports
 	
-	/* Configure I2C0 Slave Address and Read Mode */
-	I2C0_MSA_R = slave_addr << 1;								// Slave Address is the 7 MSB
-	I2C0_MDR_R = slave_reg_addr;								// Set Data Register to slave register address
-	
-	/* Initiate I2C by generating a START & RUN cmd:
-	   Set MCS register START bit to generate and RUN bit to enable I2C Master
-	*/
-	I2C0_MCS_R |= I2C_MCS_START | I2C_MCS_RUN;
+	/* Slowest device sets the pace, parts on a soft bus are not on this one */
+	for(i = 0; i < count; i++){
+		if(devices[i] != 0 && devices[i]->soft == 0 && devices[i]->max_speed < scl_hz)
+			scl_hz = devices[i]->max_speed;
+	}
 	
-	/* Wait until write is done: check MCS register to see is I2C is still busy */
-	while(I2C0_MCS_R & I2C_MCS_BUSY);
+	return I2C_SetSpeed(bus, scl_hz);
+}
+
+/*
+ *	-----------------I2C_Burst_Receive-----------------
+ *	Polls to receive multiple bytes of data from specified
+ *  peripheral by incrementing starting slave register address
+ *	Input: Bus Handle, Slave address, Slave Register Address, Data Buffer, Size of Receive
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t I2C_Burst_Receive(I2C_BUS_t* bus, uint8_t slave_addr, uint8_t slave_reg_addr, uint8_t* data, uint32_t size){
 	
-	/* Set I2C to Receive with Slave Address and change to Read */
-	I2C0_MSA_R = (slave_addr << 1) | 0x01;
+	uint8_t error;
+	uint8_t attempt = 0;
+	uint32_t start;
 	
-	/* Initiate I2C by generating a repeated START, STOP, & RUN cmd */
-	I2C0_MCS_R |= I2C_MCS_START | I2C_MCS_STOP | I2C_MCS_RUN;
+	/* Keep the interrupt driven queue off the bus while polling */
+	I2C_Async_Acquire(bus);
+	start = CYCCNT_Get();
 	
-	/* Wait until I2C bus is not busy: check MCS register for I2C bus busy bit */
-	while(I2C0_MCS_R & I2C_MCS_BUSBSY);
+	while(1){
+		error = Burst_Receive_Polled(bus, slave_addr, slave_reg_addr, data, size);
+		if(!I2C_Retry_Needed(bus, error, attempt++))
+			break;
+	}
 	
-	/* Check for any error: read the error flag from MCS register */
-	error = I2C0_MCS_R & I2C_MCS_ERROR;
-	if(error != 0)
-		return error;
-	else
-		return (I2C0_MDR_R & I2C_MDR_DATA_M);  // return I2C data register least significant 8 bits.
+	I2C_Stats_Record(bus, slave_addr, size, start, error);
+	I2C_TRACE_SPAN(start, bus, slave_addr, slave_reg_addr, size, I2C_TRACE_READ, error);
+	I2C_Async_Release(bus);
 	
+	return error;
 }
 
 /*
- *	-------------------I2C0_Transmit------------------
- *	Transmit a byte of data to specified peripheral
- *	Input: Slave address, Slave Register Address, Data to Transmit
- *	Output: Any Errors if detected, otherwise 0
+ *	--------------Burst_Receive_Polled---------------
+ *	Local function holding the polled burst receive sequence
+ *	Input: Bus Handle, Slave address, Slave Register Address, Data Buffer, Size of Receive
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
  */
-uint8_t I2C0_Transmit(uint8_t slave_addr, uint8_t slave_reg_addr, uint8_t data){
-	
-	char error;																	//Temp Variable to hold errors
+static uint8_t Burst_Receive_Polled(I2C_BUS_t* bus, uint8_t slave_addr, uint8_t slave_reg_addr, uint8_t* data, uint32_t size){
 	
-	/* Check if I2C0 is busy: check MCS register Busy bit */
-	while(I2C0_MCS_R & I2C_MCS_BUSY);
+	uint8_t error;														//Temp Error Variable
+	uint32_t cmd;															//Command in flight
 	
-	/* Configure I2C Slave Address, R/W Mode, and what to transmit */
-	I2C0_MSA_R = slave_addr << 1;								//Slave Address is the first 7 MSB
-	I2C0_MSA_R &= ~I2C0_RW_PIN; 						// Clear LSB to write
-	I2C0_MDR_R = slave_reg_addr;								//Transmit register addr to interact
+	/* Asserting Param */
+	if(size == 0 || data == 0)
+		return I2C_ERR_PARAM;
 	
-	/* Initiate I2C by generate a START bit and RUN cmd */
-	I2C0_MCS_R |= I2C_MCS_START | I2C_MCS_RUN;
+	/* Check if I2Cn is busy */
+	if(I2C_Wait(bus, I2C_MCS_BUSY) != I2C_OK)
+		return I2C_ERR_TIMEOUT;
 	
-	/* Wait until write has been completed */
-	while(I2C0_MCS_R & I2C_MCS_BUSY);
+	/* Write phase: send the starting register address once */
+	I2C_MSA(bus) = (slave_addr<<1);						//Slave Address is the first 7 MSB, LSB cleared to write
+	I2C_MDR(bus) = slave_reg_addr;						//Transmit register addr to start reading from
+	I2C_MCS(bus) = I2C_MCS_START|I2C_MCS_RUN;
 	
-	/* Update Data Register with data to be transmitted */
-	I2C0_MDR_R = data; 
+	/* Slave did not ACK address or register, release the bus */
+	error = I2C_Wait_Status(bus, I2C_MCS_START|I2C_MCS_RUN);
+	if(error != I2C_OK)
+		return error;
 	
-	/* Initiate I2C by generating a STOP & RUN cmd */
-	I2C0_MCS_R |= I2C_MCS_STOP | I2C_MCS_RUN;
+	/* Read phase: switch to read and issue a repeated START */
+	I2C_MSA(bus) = (slave_addr<<1) | I2C_READ_CMD;
 	
-	/* Wait until write has been completed: check MCS register Busy bit */
-	while(I2C0_MCS_R & I2C_MCS_BUSY);
+	//Single byte read is START, RUN and STOP in one go (NACK on the only byte)
+	if(size == 1)
+		cmd = I2C_MCS_START|I2C_MCS_RUN|I2C_MCS_STOP;
+	else
+		cmd = I2C_MCS_START|I2C_MCS_RUN|I2C_MCS_ACK;
+	I2C_MCS(bus) = cmd;
 	
-	/* Wait until bus isn't busy: check MCS register for I2C bus busy bit */
-	while(I2C0_MCS_R & I2C_MCS_BUSBSY);
+	while(1){
+		
+		error = I2C_Wait_Status(bus, cmd);			//Wait until byte has been clocked in
+		if(error != I2C_OK)
+			return error;
+		
+		*data++ = I2C_MDR(bus) & I2C_MDR_DATA_M;	//Store byte and move to next slot
+		size--;
+		
+		if(size == 0)
+			break;
+		
+		//ACK every byte except the last one, which is NACKed and followed by STOP
+		if(size == 1)
+			cmd = I2C_MCS_RUN|I2C_MCS_STOP;
+		else
+			cmd = I2C_MCS_RUN|I2C_MCS_ACK;
+		I2C_MCS(bus) = cmd;
+	}
 	
-	/* Check for any error: read the error flag from MCS register */
-	error = I2C0_MCS_R & I2C_MCS_ERROR;
-	if(error != 0)
-		return error;
-  else
-		return 0;
+	/* Wait until bus isn't busy */
+	return I2C_Wait(bus, I2C_MCS_BUSBSY);
 }
 
-//Has Yet to be Implemented
-// Will need for LCD
+
 /*
- *	----------------I2C0_Burst_Receive-----------------
- *	Polls to receive multiple bytes of data from specified
- *  peripheral by incrementing starting slave register address
- *	Input: Slave address, Slave Register Address, Data Buffer
- *	Output: None
+ *	-----------------I2C_Burst_Transmit-----------------
+ *	Transmit multiple bytes of data to specified peripheral
+ *  by incrementing starting slave address
+ *	Input: Bus Handle, Slave address, Slave Register Address, Data Buffer to transmit, Size of Transmit
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
  */
-void I2C0_Burst_Receive(uint8_t slave_addr, uint8_t slave_reg_addr, uint8_t* data, uint32_t size){
+uint8_t I2C_Burst_Transmit(I2C_BUS_t* bus, uint8_t slave_addr, uint8_t slave_reg_addr, uint8_t* data, uint32_t size){
+	
+	uint8_t error;
+	uint8_t attempt = 0;
+	uint32_t start;
+	
+	/* Keep the interrupt driven queue off the bus while polling */
+	I2C_Async_Acquire(bus);
+	start = CYCCNT_Get();
 	
+	while(1){
+		error = Burst_Transmit_Polled(bus, slave_addr, slave_reg_addr, data, size);
+		if(!I2C_Retry_Needed(bus, error, attempt++))
+			break;
+	}
+	
+	I2C_Stats_Record(bus, slave_addr, size, start, error);
+	I2C_TRACE_SPAN(start, bus, slave_addr, slave_reg_addr, size, 0, error);
+	I2C_Async_Release(bus);
+	
+	return error;
 }
 
-
 /*
- *	----------------I2C0_Burst_Transmit-----------------
- *	Transmit multiple bytes of data to specified peripheral
- *  by incrementing starting slave address
- *	Input: Slave address, Slave Register Address, Data Buffer to transmit
- *	Output: None
+ *	--------------Burst_Transmit_Polled--------------
+ *	Local function holding the polled burst transmit sequence
+ *	Input: Bus Handle, Slave address, Slave Register Address, Data Buffer to transmit, Size of Transmit
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
  */
-uint8_t I2C0_Burst_Transmit(uint8_t slave_addr, uint8_t slave_reg_addr, uint8_t* data, uint32_t size){
+static uint8_t Burst_Transmit_Polled(I2C_BUS_t* bus, uint8_t slave_addr, uint8_t slave_reg_addr, uint8_t* data, uint32_t size){
 	
-	char error;															//Temp Error Variable
+	uint8_t error;														//Temp Error Variable
 	
 	/* Asserting Param */
-	if(size <= 0)
-		return 0;
+	if(size == 0 || data == 0)
+		return I2C_ERR_PARAM;
 	
-	/* Check if I2C0 is busy */
-	while(I2C0_MCS_R&I2C_MCS_BUSY);
+	/* Check if I2Cn is busy */
+	if(I2C_Wait(bus, I2C_MCS_BUSY) != I2C_OK)
+		return I2C_ERR_TIMEOUT;
 	
 	/* Configure I2C Slave Address, R/W Mode, and what to transmit */
-	I2C0_MSA_R = (slave_addr<<1);							//Slave Address is the first 7 MSB
-	I2C0_MSA_R &= ~I2C0_RW_PIN; 							//Clear LSB to write
-	I2C0_MDR_R = slave_reg_addr;								//Transmit register addr to interact
+	I2C_MSA(bus) = (slave_addr<<1);						//Slave Address is the first 7 MSB
+	I2C_MSA(bus) &= ~I2C_RW_PIN; 						//Clear LSB to write
+	I2C_MDR(bus) = slave_reg_addr;						//Transmit register addr to interact
 	
 	/* Initiate I2C by generate a START bit and RUN cmd */
-	I2C0_MCS_R = I2C_MCS_START|I2C_MCS_RUN;
+	I2C_MCS(bus) = I2C_MCS_START|I2C_MCS_RUN;
 	
 	/* Wait until write has been completed */
-	while(I2C0_MCS_R&I2C_MCS_BUSY);
+	error = I2C_Wait_Status(bus, I2C_MCS_START|I2C_MCS_RUN);
+	if(error != I2C_OK)
+		return error;
 	
 	/* Loop to Burst Transmit what is stored in data buffer */
 	while(size > 1){
 		
-		I2C0_MDR_R = (*data);							//Deference Pointer from data array and load into data reg. Post-Increment the pointer after
+		I2C_MDR(bus) = (*data);								//Deference Pointer from data array and load into data reg. Post-Increment the pointer after
 		data++;
-		I2C0_MCS_R = RUN_CMD;									//Initiate I2C RUN CMD
-		while(I2C0_MCS_R&I2C_MCS_BUSY);							//Wait until transmit is complete
+		I2C_MCS(bus) = RUN_CMD;								//Initiate I2C RUN CMD
+		error = I2C_Wait_Status(bus, RUN_CMD);	//Wait until transmit is complete
+		if(error != I2C_OK)
+			return error;
 		size--;																//Reduce size until 1 is left
 		
 	}
 	
-	I2C0_MDR_R = (*data);								//Deference Pointer from data array and load into data reg
-	I2C0_MCS_R = I2C_MCS_STOP|I2C_MCS_RUN;							//Initiate I2C STOP condition and RUN CMD
+	I2C_MDR(bus) = (*data);									//Deference Pointer from data array and load into data reg
+	I2C_MCS(bus) = I2C_MCS_STOP|I2C_MCS_RUN;				//Initiate I2C STOP condition and RUN CMD
 	
-	/* Wait until write has been completed */
-	while(I2C0_MCS_R&I2C_MCS_BUSY);
+	/* Wait until write has been completed, a NACK here already ended with STOP */
+	error = I2C_Wait_Status(bus, I2C_MCS_STOP|I2C_MCS_RUN);
+	if(error != I2C_OK)
+		return error;
 	
 	/* Wait until bus isn't busy */
-	while(I2C0_MCS_R & I2C_MCS_BUSBSY);
+	return I2C_Wait(bus, I2C_MCS_BUSBSY);
+}
+
+/*
+ *	----------------I2C_Write_Segments----------------
+ *	Streams every segment to the slave in one write transaction
+ *	without copying them into a contiguous buffer
+ *	Input: Bus Handle, Slave address, Segment list, Number of segments
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t I2C_Write_Segments(I2C_BUS_t* bus, uint8_t slave_addr, const I2C_SEG_t* segs, uint8_t count){
+	
+	uint8_t i;
+	uint8_t error;
+	uint8_t attempt = 0;
+	uint32_t total = 0;
+	uint32_t start;
+	
+	/* Asserting Param */
+	if(segs == 0)
+		return I2C_ERR_PARAM;
+	for(i = 0; i < count; i++){
+		if(segs[i].len != 0 && segs[i].data == 0)
+			return I2C_ERR_PARAM;
+		total += segs[i].len;
+	}
+	if(total == 0)
+		return I2C_ERR_PARAM;
+	
+	/* Keep the interrupt driven queue off the bus while polling */
+	I2C_Async_Acquire(bus);
+	start = CYCCNT_Get();
+	
+	while(1){
+		error = Write_Segments_Polled(bus, slave_addr, segs, count, total);
+		if(!I2C_Retry_Needed(bus, error, attempt++))
+			break;
+	}
+	
+	I2C_Stats_Record(bus, slave_addr, total, start, error);
+	I2C_TRACE_SPAN(start, bus, slave_addr, 0, total, 0, error);			//No register byte of its own
+	I2C_Async_Release(bus);
+	
+	return error;
+}
+
+/*
+ *	--------------Write_Segments_Polled--------------
+ *	Local function holding the polled scatter-gather write sequence.
+ *	The first byte goes out with START, the last with STOP
+ *	Input: Bus Handle, Slave address, Segment list, Number of segments, Total bytes
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+static uint8_t Write_Segments_Polled(I2C_BUS_t* bus, uint8_t slave_addr, const I2C_SEG_t* segs, uint8_t count, uint32_t total){
+	
+	uint8_t error;
+	uint8_t i;
+	uint32_t j;
+	uint32_t cmd = I2C_MCS_START|I2C_MCS_RUN;
+	
+	/* Check if I2Cn is busy */
+	if(I2C_Wait(bus, I2C_MCS_BUSY) != I2C_OK)
+		return I2C_ERR_TIMEOUT;
+	
+	I2C_MSA(bus) = (slave_addr<<1);						//Slave Address is the first 7 MSB, LSB cleared to write
+	
+	for(i = 0; i < count; i++){
+		for(j = 0; j < segs[i].len; j++){
+			
+			total--;
+			I2C_MDR(bus) = segs[i].data[j];
+			if(total == 0)
+				cmd |= I2C_MCS_STOP;
+			I2C_MCS(bus) = cmd;
+			
+			error = I2C_Wait_Status(bus, cmd);
+			if(error != I2C_OK)
+				return error;
+			cmd = I2C_MCS_RUN;												//Only the first byte carries START
+		}
+	}
+	
+	/* Wait until bus isn't busy */
+	return I2C_Wait(bus, I2C_MCS_BUSBSY);
+}
+
+/*
+ *	--------------------I2C_Probe---------------------
+ *	Checks if a slave answers at an address with a 1 byte read
+ *	Input: Bus Handle, 7-bit address
+ *	Output: I2C_OK if ACKed, otherwise I2C_ERR_* status code
+ */
+uint8_t I2C_Probe(I2C_BUS_t* bus, uint8_t slave_addr){
+	
+	uint8_t error;
+	
+	I2C_Async_Acquire(bus);
+	
+	/* Check if I2Cn is busy */
+	if(I2C_Wait(bus, I2C_MCS_BUSY) != I2C_OK){
+		error = I2C_ERR_TIMEOUT;
+	}
+	else{
+		/* STOP is part of the command, a NACKed address ends right there */
+		I2C_MSA(bus) = (slave_addr<<1) | I2C_READ_CMD;
+		I2C_MCS(bus) = I2C_MCS_START|I2C_MCS_RUN|I2C_MCS_STOP;
+		
+		if(I2C_Wait(bus, I2C_MCS_BUSY) != I2C_OK){
+			error = I2C_ERR_TIMEOUT;
+		}
+		else{
+			error = I2C_MCS(bus) & I2C_ERR_MSK;
+			if(I2C_Wait(bus, I2C_MCS_BUSBSY) != I2C_OK)
+				error = I2C_ERR_TIMEOUT;
+		}
+	}
+	
+	/* A stuck bus would fail every later probe too */
+	if(error == I2C_ERR_TIMEOUT)
+		I2C_Recover(bus);
+	
+	I2C_Async_Release(bus);
+	
+	return error;
+}
+
+/*
+ *	--------------I2C_Dev_Burst_Receive--------------
+ *	I2C_Burst_Receive for a device, on its soft bus if it has one and
+ *	on the hardware module otherwise
+ *	Input: Bus Handle, Device, Slave Register Address, Data Buffer, Size of Receive
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t I2C_Dev_Burst_Receive(I2C_BUS_t* bus, const I2C_DEVICE_t* dev, uint8_t slave_reg_addr, uint8_t* data, uint32_t size){
+	
+	if(dev->soft != 0)
+		return SoftI2C_Burst_Receive(dev->soft, dev->addr, slave_reg_addr, data, size);
+	
+	return I2C_Burst_Receive(bus, dev->addr, slave_reg_addr, data, size);
+}
+
+/*
+ *	--------------I2C_Dev_Burst_Transmit-------------
+ *	I2C_Burst_Transmit for a device, routed like I2C_Dev_Burst_Receive
+ *	Input: Bus Handle, Device, Slave Register Address, Data Buffer, Size of Transmit
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t I2C_Dev_Burst_Transmit(I2C_BUS_t* bus, const I2C_DEVICE_t* dev, uint8_t slave_reg_addr, uint8_t* data, uint32_t size){
+	
+	if(dev->soft != 0)
+		return SoftI2C_Burst_Transmit(dev->soft, dev->addr, slave_reg_addr, data, size);
+	
+	return I2C_Burst_Transmit(bus, dev->addr, slave_reg_addr, data, size);
+}
+
+/*
+ *	-----------------I2C_Dev_Receive-----------------
+ *	Input: Bus Handle, Device, Slave Register Address
+ *	Output: Byte received, or the error in its place like I2C0_Receive
+ */
+uint8_t I2C_Dev_Receive(I2C_BUS_t* bus, const I2C_DEVICE_t* dev, uint8_t slave_reg_addr){
+	
+	uint8_t data;
+	uint8_t error;
+	
+	error = I2C_Dev_Burst_Receive(bus, dev, slave_reg_addr, &data, 1);
 	
-	/* Check for any error */
-	error = I2C0_MCS_R & I2C_MCS_ERROR;
 	if(error != 0)
 		return error;
-  else
-		return 0;
+	else
+		return data;
+}
+
+/*
+ *	-----------------I2C_Dev_Transmit----------------
+ *	Input: Bus Handle, Device, Slave Register Address, Data to Transmit
+ *	Output: Any Errors if detected, otherwise 0
+ */
+uint8_t I2C_Dev_Transmit(I2C_BUS_t* bus, const I2C_DEVICE_t* dev, uint8_t slave_reg_addr, uint8_t data){
+	return I2C_Dev_Burst_Transmit(bus, dev, slave_reg_addr, &data, 1);
+}
+
+/*
+ *	-----------------I2C_Dev_Command-----------------
+ *	Input: Bus Handle, Device, Command byte
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t I2C_Dev_Command(I2C_BUS_t* bus, const I2C_DEVICE_t* dev, uint8_t cmd){
+	
+	I2C_SEG_t seg = {&cmd, 1};
+	
+	if(dev->soft != 0)
+		return SoftI2C_Command(dev->soft, dev->addr, cmd);
+	
+	return I2C_Write_Segments(bus, dev->addr, &seg, 1);
+}
+
+/*
+ *	-------------------I2C_Recover--------------------
+ *	Frees a bus held by a slave stuck mid-byte. SCL/SDA are taken over
+ *	as open drain GPIO, SCL is pulsed until the slave lets SDA go (at
+ *	most nine times), a STOP is generated, and the module is reset.
+ *	The reset clears every register, the master, slave (I2CSlave.c)
+ *	and loopback (I2CBench.c) setup is put back as it was
+ *	Input: Bus Handle
+ *	Output: None
+ */
+void I2C_Recover(I2C_BUS_t* bus){
+	
+	uint8_t pulse;
+	uint8_t pins = bus->scl_pin | bus->sda_pin;
+	uint32_t pctl = Pins_Pctl(pins, 0xF);
+	uint32_t module = 1U << bus->module;
+	uint32_t start = CYCCNT_Get();
+	uint32_t mtpr = I2C_MTPR(bus);								//Keep programmed bus speed
+	uint32_t mcr = I2C_MCR(bus);									//Master, slave and loopback enables
+	uint32_t mimr = I2C_MIMR(bus);
+	uint32_t soar = I2C_SOAR(bus);
+	uint32_t simr = I2C_SIMR(bus);
+	uint32_t half_period = SYSCLK_Get_Hz() / (2 * I2C_RECOVERY_SCL_HZ);
+	
+	/* Take the pins away from the module: SCL open drain output, SDA input */
+	I2C_GPIO_REG(bus, GPIO_AFSEL_OFFSET) &= ~pins;
+	I2C_GPIO_REG(bus, GPIO_PCTL_OFFSET) &= ~pctl;
+	I2C_GPIO_REG(bus, GPIO_ODR_OFFSET) |= pins;
+	I2C_GPIO_REG(bus, GPIO_DATA_OFFSET) |= pins;					//Released (pulled up) when driven as 1
+	I2C_GPIO_REG(bus, GPIO_DIR_OFFSET) = (I2C_GPIO_REG(bus, GPIO_DIR_OFFSET) | bus->scl_pin) & ~bus->sda_pin;
+	
+	/* Clock until the slave has shifted out the rest of its byte */
+	for(pulse = 0; pulse < I2C_RECOVERY_PULSES; pulse++){
+		if(I2C_GPIO_REG(bus, GPIO_DATA_OFFSET) & bus->sda_pin)
+			break;
+		I2C_GPIO_REG(bus, GPIO_DATA_OFFSET) &= ~bus->scl_pin;
+		Recover_Delay(half_period);
+		I2C_GPIO_REG(bus, GPIO_DATA_OFFSET) |= bus->scl_pin;
+		Recover_Delay(half_period);
+	}
+	
+	/* STOP: SDA goes low then high while SCL is high */
+	I2C_GPIO_REG(bus, GPIO_DATA_OFFSET) &= ~bus->scl_pin;
+	Recover_Delay(half_period);
+	I2C_GPIO_REG(bus, GPIO_DATA_OFFSET) &= ~bus->sda_pin;
+	I2C_GPIO_REG(bus, GPIO_DIR_OFFSET) |= bus->sda_pin;
+	Recover_Delay(half_period);
+	I2C_GPIO_REG(bus, GPIO_DATA_OFFSET) |= bus->scl_pin;
+	Recover_Delay(half_period);
+	I2C_GPIO_REG(bus, GPIO_DIR_OFFSET) &= ~bus->sda_pin;
+	Recover_Delay(half_period);
+	
+	/* Hand the pins back to the module the same way I2C_Init does */
+	I2C_GPIO_REG(bus, GPIO_DIR_OFFSET) &= ~pins;
+	I2C_GPIO_REG(bus, GPIO_ODR_OFFSET) &= ~bus->scl_pin;
+	I2C_GPIO_REG(bus, GPIO_AFSEL_OFFSET) |= pins;
+	I2C_GPIO_REG(bus, GPIO_PCTL_OFFSET) = (I2C_GPIO_REG(bus, GPIO_PCTL_OFFSET) & ~pctl) | Pins_Pctl(pins, I2C_PCTL_FUNC);
+	
+	/* Reset the controller to clear any half finished state */
+	SYSCTL_SRI2C_R |= module;
+	SYSCTL_SRI2C_R &= ~module;
+	while((SYSCTL_PRI2C_R & module) == 0);
+	I2C_MTPR(bus) = mtpr;
+	I2C_SOAR(bus) = soar;
+	I2C_MCR(bus) = mcr | EN_I2C_MASTER;
+	
+	/* SCSR reads back status, not DA, a slave that was on answers again */
+	if(mcr & I2C_MCR_SFE)
+		I2C_SCSR(bus) = I2C_SCSR_DA;
+	I2C_SIMR(bus) = simr;
+	I2C_MIMR(bus) = mimr;
+	
+	bus->stats.recoveries++;
+	bus->stats.recovery_cycles_last = CYCCNT_Get() - start;
+	if(bus->stats.recovery_cycles_last > bus->stats.recovery_cycles_max)
+		bus->stats.recovery_cycles_max = bus->stats.recovery_cycles_last;
+}
+
+/*
+ *	------------------I2C_Set_Retries----------------
+ *	Sets how many times a transfer that timed out or lost arbitration
+ *	is repeated. A timeout always triggers bus recovery first, so the
+ *	worst case cost is (retries + 1) * (timeout + recovery)
+ *	Input: Bus Handle, Number of retries (0 disables)
+ *	Output: None
+ */
+void I2C_Set_Retries(I2C_BUS_t* bus, uint8_t retries){
+	bus->retry_limit = retries;
+}
+
+/*
+ *	------------------I2C_Set_Timeout----------------
+ *	Sets the longest time a single wait on the controller may take
+ *	Input: Bus Handle, Timeout in microseconds
+ *	Output: None
+ */
+void I2C_Set_Timeout(I2C_BUS_t* bus, uint32_t timeout_us){
+	bus->timeout_cycles = (SYSCLK_Get_Hz() / 1000000) * timeout_us;
+}
+
+/*
+ *	----------------I2C_Get_Bus_Stats----------------
+ *	Copies the timeout and recovery counters
+ *	Input: Bus Handle, Struct to fill
+ *	Output: None
+ */
+void I2C_Get_Bus_Stats(I2C_BUS_t* bus, I2C_BUS_STATS_t* stats){
+	*stats = bus->stats;
+}
+
+/*
+ *	---------------I2C_Reset_Bus_Stats---------------
+ *	Clears the timeout and recovery counters
+ *	Input: Bus Handle
+ *	Output: None
+ */
+void I2C_Reset_Bus_Stats(I2C_BUS_t* bus){
+	bus->stats.timeouts = 0;
+	bus->stats.retries = 0;
+	bus->stats.recoveries = 0;
+	bus->stats.recovery_cycles_last = 0;
+	bus->stats.recovery_cycles_max = 0;
+}
+
+/* I2C0 Interface, see I2C.h */
+void I2C0_Init(void){
+	I2C_Init(I2C_BUS0);
+}
+
+uint32_t I2C0_SetSpeed(uint32_t scl_hz){
+	return I2C_SetSpeed(I2C_BUS0, scl_hz);
+}
+
+uint32_t I2C0_GetSpeed(void){
+	return I2C_GetSpeed(I2C_BUS0);
+}
+
+uint32_t I2C0_SetSpeed_For_Devices(const I2C_DEVICE_t* const devices[], uint8_t count){
+	return I2C_SetSpeed_For_Devices(I2C_BUS0, devices, count);
+}
+
+uint8_t I2C0_Burst_Receive(uint8_t slave_addr, uint8_t slave_reg_addr, uint8_t* data, uint32_t size){
+	return I2C_Burst_Receive(I2C_BUS0, slave_addr, slave_reg_addr, data, size);
+}
+
+uint8_t I2C0_Burst_Transmit(uint8_t slave_addr, uint8_t slave_reg_addr, uint8_t* data, uint32_t size){
+	return I2C_Burst_Transmit(I2C_BUS0, slave_addr, slave_reg_addr, data, size);
+}
+
+void I2C0_Recover(void){
+	I2C_Recover(I2C_BUS0);
+}
+
+void I2C0_Set_Retries(uint8_t retries){
+	I2C_Set_Retries(I2C_BUS0, retries);
+}
+
+void I2C0_Set_Timeout(uint32_t timeout_us){
+	I2C_Set_Timeout(I2C_BUS0, timeout_us);
+}
+
+uint32_t I2C0_Get_Timeout_Cycles(void){
+	return I2C_BUS0->timeout_cycles;
+}
+
+void I2C0_Get_Bus_Stats(I2C_BUS_STATS_t* stats){
+	I2C_Get_Bus_Stats(I2C_BUS0, stats);
+}
+
+void I2C0_Reset_Bus_Stats(void){
+	I2C_Reset_Bus_Stats(I2C_BUS0);
+}
+
+/*
+ *	-------------------I2C0_Receive------------------
+ *	Polls to receive data from specified peripheral
+ *	Input: Slave address & Slave Register Address
+ *	Output: Returns 8-bit data that has been received
+ */
+uint8_t I2C0_Receive(uint8_t slave_addr, uint8_t slave_reg_addr){
+	
+	uint8_t data;																//Byte received
+	uint8_t error;															//Temp Variable to hold errors
+	
+	/* Single byte burst: register write, repeated START, read with STOP */
+	error = I2C0_Burst_Receive(slave_addr, slave_reg_addr, &data, 1);
+	
+	/* Errors are returned in place of data to keep the original interface */
+	if(error != 0)
+		return error;
+	else
+		return data;
+}
+
+/*
+ *	-------------------I2C0_Transmit------------------
+ *	Transmit a byte of data to specified peripheral
+ *	Input: Slave address, Slave Register Address, Data to Transmit
+ *	Output: Any Errors if detected, otherwise 0
+ */
+uint8_t I2C0_Transmit(uint8_t slave_addr, uint8_t slave_reg_addr, uint8_t data){
+	
+	/* Single byte burst: register address then data with STOP */
+	return I2C0_Burst_Transmit(slave_addr, slave_reg_addr, &data, 1);
 }
@@ -14,70 +14,382 @@
 #include <stdint.h>
 #include "tm4c123gh6pm.h"
 #include "util.h"
+#ifdef I2C_SIM
+#include "I2CSim.h"							// Host build, registers live in the simulated bus
+#endif
 
 /* List of Fill In Macros */
 
 //Init Function
-#define EN_I2C0_CLOCK       0x00001000  // Enable I2C0 Clock
-#define EN_GPIOB_CLOCK      0x00000002  // Enable GPIOB Clock
-#define I2C0_PINS           0x0C        // PB2,PB3 for I2C
-#define I2C0_ALT_FUNC_MSK   0xFFFF00FF  // Mask to clear bits for PB2,PB3
-#define I2C0_ALT_FUNC_SET   0x00003300  // Set PB2,PB3 to function 3 (I2C)
-#define I2C0_SDA_PIN        0x08        // PB3 for SDA
-#define I2C0_SCL_PIN        0x04        // PB2 for SCL
-#define EN_I2C0_MASTER      0x00000010  // Enable I2C0 Master
-#define I2C_MTPR_TPR_VALUE  0x07        // For 100kHz @ 16MHz = 7
-#define I2C_MTPR_STD_SPEED  0x00        // Standard mode (100kHz)
+#define I2C_MODULE_COUNT    4           // I2C0 - I2C3
+#define I2C_PCTL_FUNC       0x3         // Alternate function number of I2C on every port
+#define EN_I2C_MASTER       0x00000010  // Enable I2Cn Master
+#define I2C_MTPR_STD_SPEED  0x00        // Standard/Fast/Fast-mode Plus (HS bit clear)
+
+//Module Register Blocks, TM4C123 has one pin option per module
+#define I2C0_BASE_ADDR      0x40020000  // I2C0 on PB2 (SCL) / PB3 (SDA)
+#define I2C1_BASE_ADDR      0x40021000  // I2C1 on PA6 (SCL) / PA7 (SDA)
+#define I2C2_BASE_ADDR      0x40022000  // I2C2 on PE4 (SCL) / PE5 (SDA)
+#define I2C3_BASE_ADDR      0x40023000  // I2C3 on PD0 (SCL) / PD1 (SDA)
+#define GPIOA_BASE_ADDR     0x40004000  // GPIO Port A (APB)
+#define GPIOB_BASE_ADDR     0x40005000  // GPIO Port B (APB)
+#define GPIOD_BASE_ADDR     0x40007000  // GPIO Port D (APB)
+#define GPIOE_BASE_ADDR     0x40024000  // GPIO Port E (APB)
+
+//Master Register Offsets
+#define I2C_MSA_OFFSET      0x000
+#define I2C_MCS_OFFSET      0x004
+#define I2C_MDR_OFFSET      0x008
+#define I2C_MTPR_OFFSET     0x00C
+#define I2C_MIMR_OFFSET     0x010
+#define I2C_MRIS_OFFSET     0x014
+#define I2C_MICR_OFFSET     0x01C
+#define I2C_MCR_OFFSET      0x020
+#define I2C_MBMON_OFFSET    0x02C
+
+//Slave Register Offsets
+#define I2C_SOAR_OFFSET     0x800
+#define I2C_SCSR_OFFSET     0x804
+#define I2C_SDR_OFFSET      0x808
+#define I2C_SIMR_OFFSET     0x80C
+#define I2C_SMIS_OFFSET     0x814
+#define I2C_SICR_OFFSET     0x818
+
+//GPIO Register Offsets
+#define GPIO_DATA_OFFSET    0x3FC
+#define GPIO_DIR_OFFSET     0x400
+#define GPIO_IS_OFFSET      0x404
+#define GPIO_IBE_OFFSET     0x408
+#define GPIO_IEV_OFFSET     0x40C
+#define GPIO_IM_OFFSET      0x410
+#define GPIO_RIS_OFFSET     0x414
+#define GPIO_MIS_OFFSET     0x418
+#define GPIO_ICR_OFFSET     0x41C
+#define GPIO_AFSEL_OFFSET   0x420
+#define GPIO_ODR_OFFSET     0x50C
+#define GPIO_DEN_OFFSET     0x51C
+#define GPIO_AMSEL_OFFSET   0x528
+#define GPIO_PCTL_OFFSET    0x52C
+
+//Register Access through a bus handle
+#ifndef I2C_REG
+#define I2C_REG(bus, off)   (*((volatile unsigned long *)((bus)->base + (off))))
+#endif
+#define I2C_MSA(bus)        I2C_REG(bus, I2C_MSA_OFFSET)
+#define I2C_MCS(bus)        I2C_REG(bus, I2C_MCS_OFFSET)
+#define I2C_MDR(bus)        I2C_REG(bus, I2C_MDR_OFFSET)
+#define I2C_MTPR(bus)       I2C_REG(bus, I2C_MTPR_OFFSET)
+#define I2C_MIMR(bus)       I2C_REG(bus, I2C_MIMR_OFFSET)
+#define I2C_MRIS(bus)       I2C_REG(bus, I2C_MRIS_OFFSET)
+#define I2C_MICR(bus)       I2C_REG(bus, I2C_MICR_OFFSET)
+#define I2C_MCR(bus)        I2C_REG(bus, I2C_MCR_OFFSET)
+#define I2C_MBMON(bus)      I2C_REG(bus, I2C_MBMON_OFFSET)
+#define I2C_SOAR(bus)       I2C_REG(bus, I2C_SOAR_OFFSET)
+#define I2C_SCSR(bus)       I2C_REG(bus, I2C_SCSR_OFFSET)
+#define I2C_SDR(bus)        I2C_REG(bus, I2C_SDR_OFFSET)
+#define I2C_SIMR(bus)       I2C_REG(bus, I2C_SIMR_OFFSET)
+#define I2C_SMIS(bus)       I2C_REG(bus, I2C_SMIS_OFFSET)
+#define I2C_SICR(bus)       I2C_REG(bus, I2C_SICR_OFFSET)
+#ifndef I2C_GPIO_REG
+#define I2C_GPIO_REG(bus, off) (*((volatile unsigned long *)((bus)->gpio_base + (off))))
+#endif
+
+//GPIO Register Access for the lines parts drive (interrupt outputs)
+#ifndef GPIO_REG
+#define GPIO_REG(base, off) (*((volatile unsigned long *)((base) + (off))))
+#endif
+
+//Body of loops that wait on an interrupt driven transfer, nothing to
+//do on the target. The host build lets simulated time run in it
+#ifndef I2C_SPIN
+#define I2C_SPIN()
+#endif
+
+//One pass of a loop standing in for application work, the host build
+//charges it a few cycles so simulated time runs
+#ifndef I2C_IDLE_PASS
+#define I2C_IDLE_PASS()
+#endif
+
+//Speed Function
+#define I2C_SPEED_STANDARD  100000      // Standard mode SCL (Hz)
+#define I2C_SPEED_FAST      400000      // Fast-mode SCL (Hz)
+#define I2C_SPEED_FAST_PLUS 1000000     // Fast-mode Plus SCL (Hz)
+#define I2C_SCL_LP_HP       10          // SCL_LP (6) + SCL_HP (4), fixed by hardware
+#define I2C_BITS_PER_BYTE   9           // 8 data bits + ACK
 //Transmit Function
-#define I2C0_RW_PIN         0x00000001  // R/W bit for I2C transfer
+#define I2C_RW_PIN          0x00000001  // R/W bit for I2C transfer
 
 //Burst Transmit Function
 #define RUN_CMD             0x00000001  // Run command bit
 
+//Burst Receive Function
+#define I2C_READ_CMD        0x00000001  // R/W bit set to read
+
+/* Status Codes returned by the transfer functions
+	 Errors are the MCS error bits straight from the controller so a failed
+	 transfer can be decoded (ADRACK = address NACK, DATACK = data NACK, etc.)
+	 Driver-level codes use bits the error mask can never return */
+#define I2C_OK              0x00        // Transfer completed
+#define I2C_ERR_MSK         (I2C_MCS_ERROR|I2C_MCS_ADRACK|I2C_MCS_DATACK|I2C_MCS_ARBLST)
+#define I2C_ERR_PARAM       0x40        // Invalid size or buffer
+#define I2C_ERR_TIMEOUT     0x80        // Controller did not finish before the deadline
+
+//Timeout and Recovery
+#define I2C_TIMEOUT_DEFAULT_US  2000    // Per wait deadline, covers clock stretching at 100kHz
+#define I2C_RETRY_DEFAULT       2       // Retries after a timeout or lost arbitration
+#define I2C_RECOVERY_PULSES     9       // SCL pulses to flush a slave stuck mid-byte
+#define I2C_RECOVERY_SCL_HZ     100000  // Bit-banged SCL rate during recovery
+
+
+/* Device Descriptor
+	 Every driver on the bus publishes one so the bus speed can be
+	 picked from what all attached devices support. addr starts as the
+	 usual strapping and is rebound at boot to whichever of addr and
+	 alt_addr the bus scan found, see I2CScan.h. soft moves the part
+	 onto a bit-banged bus for drivers using the I2C_Dev_* calls */
+typedef struct SOFT_I2C SOFT_I2C_t;
+typedef struct{
+	const char* name;										// Part name for logs
+	uint8_t addr;												// 7-bit slave address
+	uint32_t max_speed;									// Highest SCL the part is specified for (Hz)
+	const uint8_t* alt_addr;						// Other addresses the part can be strapped to, may be 0
+	uint8_t alt_count;									// Number of alt_addr entries
+	SOFT_I2C_t* soft;										// Bit-banged bus the part hangs off, 0 for the hardware module
+} I2C_DEVICE_t;
+
+/* Bus Fault Counters (cycles are core clock cycles) */
+typedef struct{
+	uint32_t timeouts;									// Waits that hit the deadline
+	uint32_t retries;										// Transfers repeated by the retry policy
+	uint32_t recoveries;								// Bus recovery sequences run
+	uint32_t recovery_cycles_last;			// Duration of the last recovery
+	uint32_t recovery_cycles_max;				// Longest recovery seen
+} I2C_BUS_STATS_t;
+
+/* Write Segment
+	 One piece of a scatter-gather write. Segments go out back to back
+	 in a single transaction straight from the caller's memory, with no
+	 register byte added, so a register address is just another segment */
+typedef struct{
+	const uint8_t* data;								// Bytes to send
+	uint32_t len;												// Number of bytes, may be 0
+} I2C_SEG_t;
+
+/* Bus Handle
+	 One per I2C module. The first block is fixed by the pin mux, the
+	 rest is owned by the driver. Use the I2C_BUSn handles below */
+typedef struct I2C_BUS I2C_BUS_t;
+struct I2C_BUS{
+	uint32_t base;											// I2Cn register block
+	uint32_t gpio_base;									// GPIO port holding SCL/SDA
+	uint8_t module;											// Module number, bit in RCGCI2C/SRI2C/PRI2C
+	uint8_t gpio_port;									// Port bit in RCGCGPIO/PRGPIO
+	uint8_t scl_pin;										// SCL pin mask
+	uint8_t sda_pin;										// SDA pin mask
+	uint8_t irq;												// NVIC interrupt number
+
+	uint32_t timeout_cycles;						// Longest single wait on MCS
+	uint8_t retry_limit;								// Retries after timeout/lost arbitration
+	I2C_BUS_STATS_t stats;							// Fault counters
+	void (*slave_handler)(I2C_BUS_t* bus);	// Runs on slave interrupts, 0 if the slave is off
+};
+
+extern I2C_BUS_t I2C_Bus[I2C_MODULE_COUNT];
+#define I2C_BUS0            (&I2C_Bus[0])
+#define I2C_BUS1            (&I2C_Bus[1])
+#define I2C_BUS2            (&I2C_Bus[2])
+#define I2C_BUS3            (&I2C_Bus[3])
 
 /*
- *	-------------------I2C0_Init------------------
- *	Basic I2C Initialization function for master mode @ 100kHz
- *	Input: None
+ *	--------------------I2C_Init------------------
+ *	Basic I2C Initialization function for master mode @ 100kHz.
+ *	Turns on the module and GPIO clocks and muxes SCL/SDA
+ *	Input: Bus Handle
  *	Output: None
  */
-void I2C0_Init(void);
+void I2C_Init(I2C_BUS_t* bus);
 
 /*
- *	-------------------I2C0_Receive------------------
- *	Polls to receive data from specified peripheral
- *	Input: Slave address & Slave Register Address
- *	Output: Returns 8-bit data that has been received
+ *	------------------I2C_SetSpeed----------------
+ *	Programs the master timer period for the fastest SCL rate that does
+ *	not exceed the request at the current system clock.
+ *	TPR = ceil(System Clock / (2*(SCL_LP + SCL_HP) * SCL)) - 1
+ *	At 16MHz the fastest rate is 800kHz, Fast-mode Plus needs >= 20MHz
+ *	Input: Bus Handle, Requested SCL rate in Hz
+ *	Output: SCL rate actually programmed in Hz, 0 if out of range
  */
-uint8_t I2C0_Receive(uint8_t slave_addr, uint8_t slave_reg_addr);
+uint32_t I2C_SetSpeed(I2C_BUS_t* bus, uint32_t scl_hz);
 
 /*
- *	-------------------I2C0_Transmit------------------
- *	Transmit a byte of data to specified peripheral
- *	Input: Slave address, Slave Register Address, Data to Transmit
- *	Output: Any Errors if detected, otherwise 0
+ *	------------------I2C_GetSpeed----------------
+ *	Input: Bus Handle
+ *	Output: SCL rate currently programmed in Hz
  */
-uint8_t I2C0_Transmit(uint8_t slave_addr, uint8_t slave_reg_addr, uint8_t data);
+uint32_t I2C_GetSpeed(I2C_BUS_t* bus);
 
-//Has Yet to be Implemented
 /*
- *	----------------I2C0_Burst_Receive-----------------
+ *	-------------I2C_SetSpeed_For_Devices---------
+ *	Runs the bus at the fastest rate every listed device allows
+ *	Input: Bus Handle, Array of device descriptors, Number of devices
+ *	Output: SCL rate actually programmed in Hz, 0 if out of range
+ */
+uint32_t I2C_SetSpeed_For_Devices(I2C_BUS_t* bus, const I2C_DEVICE_t* const devices[], uint8_t count);
+
+/*
+ *	-----------------I2C_Burst_Receive-----------------
  *	Polls to receive multiple bytes of data from specified
- *  peripheral by incrementing starting slave register address
- *	Input: Slave address, Slave Register Address, Data Buffer
- *	Output: None
+ *  peripheral by incrementing starting slave register address.
+ *	The register address is written once, then all bytes are clocked
+ *	in after a single repeated START
+ *	Input: Bus Handle, Slave address, Slave Register Address, Data Buffer, Size of Receive
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
  */
-void I2C0_Burst_Receive(uint8_t slave_addr, uint8_t slave_reg_addr, uint8_t* data, uint32_t size);
+uint8_t I2C_Burst_Receive(I2C_BUS_t* bus, uint8_t slave_addr, uint8_t slave_reg_addr, uint8_t* data, uint32_t size);
 
 /*
- *	----------------I2C0_Burst_Transmit-----------------
+ *	-----------------I2C_Burst_Transmit-----------------
  *	Transmit multiple bytes of data to specified peripheral
  *  by incrementing starting slave address
- *	Input: Slave address, Slave Register Address, Data Buffer to transmit, Size of Transmit
+ *	Input: Bus Handle, Slave address, Slave Register Address, Data Buffer to transmit, Size of Transmit
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t I2C_Burst_Transmit(I2C_BUS_t* bus, uint8_t slave_addr, uint8_t slave_reg_addr, uint8_t* data, uint32_t size);
+
+/*
+ *	----------------I2C_Write_Segments----------------
+ *	Streams every segment to the slave in one write transaction
+ *	without copying them into a contiguous buffer
+ *	Input: Bus Handle, Slave address, Segment list, Number of segments
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t I2C_Write_Segments(I2C_BUS_t* bus, uint8_t slave_addr, const I2C_SEG_t* segs, uint8_t count);
+
+/*
+ *	--------------------I2C_Probe---------------------
+ *	Checks if a slave answers at an address. The controller has no
+ *	address only command, so this is a 1 byte read: an empty address
+ *	costs just the address byte, and a read has no side effect on the
+ *	parts on this board. Not retried and not counted in the stats
+ *	Input: Bus Handle, 7-bit address
+ *	Output: I2C_OK if ACKed, otherwise I2C_ERR_* status code
+ */
+uint8_t I2C_Probe(I2C_BUS_t* bus, uint8_t slave_addr);
+
+/*
+ *	--------------I2C_Dev_Burst_Receive--------------
+ *	I2C_Burst_Receive for a device, on its soft bus if it has one and
+ *	on the hardware module otherwise
+ *	Input: Bus Handle, Device, Slave Register Address, Data Buffer, Size of Receive
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t I2C_Dev_Burst_Receive(I2C_BUS_t* bus, const I2C_DEVICE_t* dev, uint8_t slave_reg_addr, uint8_t* data, uint32_t size);
+
+/*
+ *	--------------I2C_Dev_Burst_Transmit-------------
+ *	I2C_Burst_Transmit for a device, routed like I2C_Dev_Burst_Receive
+ *	Input: Bus Handle, Device, Slave Register Address, Data Buffer, Size of Transmit
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t I2C_Dev_Burst_Transmit(I2C_BUS_t* bus, const I2C_DEVICE_t* dev, uint8_t slave_reg_addr, uint8_t* data, uint32_t size);
+
+/*
+ *	-----------------I2C_Dev_Receive-----------------
+ *	Input: Bus Handle, Device, Slave Register Address
+ *	Output: Byte received, or the error in its place like I2C0_Receive
+ */
+uint8_t I2C_Dev_Receive(I2C_BUS_t* bus, const I2C_DEVICE_t* dev, uint8_t slave_reg_addr);
+
+/*
+ *	-----------------I2C_Dev_Transmit----------------
+ *	Input: Bus Handle, Device, Slave Register Address, Data to Transmit
+ *	Output: Any Errors if detected, otherwise 0
+ */
+uint8_t I2C_Dev_Transmit(I2C_BUS_t* bus, const I2C_DEVICE_t* dev, uint8_t slave_reg_addr, uint8_t data);
+
+/*
+ *	-----------------I2C_Dev_Command-----------------
+ *	Single byte write, for parts that act on a command byte alone
+ *	Input: Bus Handle, Device, Command byte
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t I2C_Dev_Command(I2C_BUS_t* bus, const I2C_DEVICE_t* dev, uint8_t cmd);
+
+/*
+ *	-------------------I2C_Recover--------------------
+ *	Frees a bus held by a slave stuck mid-byte. SCL/SDA are taken over
+ *	as open drain GPIO, SCL is pulsed until the slave lets SDA go (at
+ *	most nine times), a STOP is generated, and the module is reset.
+ *	Called automatically when a wait times out
+ *	Input: Bus Handle
+ *	Output: None
+ */
+void I2C_Recover(I2C_BUS_t* bus);
+
+/*
+ *	------------------I2C_Set_Retries----------------
+ *	Sets how many times a transfer that timed out or lost arbitration
+ *	is repeated. A timeout always triggers bus recovery first, so the
+ *	worst case cost is (retries + 1) * (timeout + recovery)
+ *	Input: Bus Handle, Number of retries (0 disables)
+ *	Output: None
+ */
+void I2C_Set_Retries(I2C_BUS_t* bus, uint8_t retries);
+
+/*
+ *	------------------I2C_Set_Timeout----------------
+ *	Sets the longest time a single wait on the controller may take
+ *	Input: Bus Handle, Timeout in microseconds
+ *	Output: None
+ */
+void I2C_Set_Timeout(I2C_BUS_t* bus, uint32_t timeout_us);
+
+/*
+ *	----------------I2C_Get_Bus_Stats----------------
+ *	Copies the timeout and recovery counters
+ *	Input: Bus Handle, Struct to fill
+ *	Output: None
+ */
+void I2C_Get_Bus_Stats(I2C_BUS_t* bus, I2C_BUS_STATS_t* stats);
+
+/*
+ *	---------------I2C_Reset_Bus_Stats---------------
+ *	Clears the timeout and recovery counters
+ *	Input: Bus Handle
  *	Output: None
  */
+void I2C_Reset_Bus_Stats(I2C_BUS_t* bus);
+
+/* I2C0 Interface
+	 Thin wrappers over the functions above on I2C_BUS0, kept so the
+	 sensor drivers did not have to change */
+void I2C0_Init(void);
+uint32_t I2C0_SetSpeed(uint32_t scl_hz);
+uint32_t I2C0_GetSpeed(void);
+uint32_t I2C0_SetSpeed_For_Devices(const I2C_DEVICE_t* const devices[], uint8_t count);
+uint8_t I2C0_Burst_Receive(uint8_t slave_addr, uint8_t slave_reg_addr, uint8_t* data, uint32_t size);
 uint8_t I2C0_Burst_Transmit(uint8_t slave_addr, uint8_t slave_reg_addr, uint8_t* data, uint32_t size);
+void I2C0_Recover(void);
+void I2C0_Set_Retries(uint8_t retries);
+void I2C0_Set_Timeout(uint32_t timeout_us);
+uint32_t I2C0_Get_Timeout_Cycles(void);
+void I2C0_Get_Bus_Stats(I2C_BUS_STATS_t* stats);
+void I2C0_Reset_Bus_Stats(void);
 
-#endif //I2C_H_
+/*
+ *	-------------------I2C0_Receive------------------
+ *	Polls to receive data from specified peripheral
+ *	Input: Slave address & Slave Register Address
+ *	Output: Returns 8-bit data that has been received
+ */
+uint8_t I2C0_Receive(uint8_t slave_addr, uint8_t slave_reg_addr);
 
+/*
+ *	-------------------I2C0_Transmit------------------
+ *	Transmit a byte of data to specified peripheral
+ *	Input: Slave address, Slave Register Address, Data to Transmit
+ *	Output: Any Errors if detected, otherwise 0
+ */
+uint8_t I2C0_Transmit(uint8_t slave_addr, uint8_t slave_reg_addr, uint8_t data);
 
+#endif //I2C_H_
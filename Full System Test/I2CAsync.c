@@ -0,0 +1,606 @@
+/*
+ * I2CAsync.c
+ *
+ *	Main implementation of the interrupt driven I2C transaction engine.
+ *	Each I2Cn interrupt advances a per-byte state machine that issues
+ *	the same MCS command sequence the polled driver uses, and the
+ *	priority queue that feeds it
+ *
+ * Created on: October 16th, 2026
+ *
+ */
+
+#include "I2CAsync.h"
+#include "I2CTrace.h"
+#include "I2CStats.h"
+#include "tm4c123gh6pm.h"
+#include "util.h"
+
+/* Defined in startup.s */
+long StartCritical(void);
+void EndCritical(long sr);
+
+/* Engine States (what the controller is doing when the interrupt fires) */
+typedef enum{
+	XFER_IDLE,
+	XFER_REG,						// Register address byte is being sent
+	XFER_TX,						// Middle data byte is being sent
+	XFER_TX_LAST,				// Last data byte is being sent with STOP
+	XFER_RX,						// Data byte is being received with ACK
+	XFER_RX_LAST,				// Last data byte is being received with STOP
+	XFER_STOPPING				// STOP issued after an error
+} XFER_STATE;
+
+/* Engine and Priority Queue of one module, one FIFO per class linked
+	 through the descriptors */
+typedef struct{
+	I2C_XFER_t* volatile active;				// Transfer currently on the bus
+	volatile XFER_STATE state;
+	uint32_t xfer_index;								// Next byte in the active buffer or segment
+	uint8_t seg_index;									// Active segment of a scatter-gather write
+	uint32_t left;											// Bytes still to transmit
+	uint8_t stop_status;								// Error being reported once STOP completes
+	uint32_t started_at;								// Cycle count when the active transfer went on the bus
+
+	I2C_XFER_t* queue_head[I2C_PRIO_COUNT];
+	I2C_XFER_t* queue_tail[I2C_PRIO_COUNT];
+	I2C_QUEUE_STATS_t queue_stats[I2C_PRIO_COUNT];
+	volatile uint8_t hold;							// Nonzero while polled code owns the bus
+} I2C_ENGINE_t;
+
+static I2C_ENGINE_t engines[I2C_MODULE_COUNT];
+
+static void Queue_Dispatch(I2C_BUS_t* bus);
+
+/*
+ *	-------------------Xfer_Check--------------------
+ *	Local function to validate a descriptor before it is started or
+ *	queued, sums up the segments of a scatter-gather write into size
+ *	Input: Transfer Descriptor
+ *	Output: true if the transfer can be started
+ */
+static bool Xfer_Check(I2C_XFER_t* xfer){
+	
+	uint8_t i;
+	
+	if(xfer == 0)
+		return false;
+	
+	if(xfer->segs == 0)
+		return xfer->data != 0 && xfer->size != 0;
+	
+	/* Segments are only ever written */
+	if(xfer->dir != I2C_XFER_WRITE)
+		return false;
+	
+	xfer->size = 0;
+	for(i = 0; i < xfer->seg_count; i++){
+		if(xfer->segs[i].len != 0 && xfer->segs[i].data == 0)
+			return false;
+		xfer->size += xfer->segs[i].len;
+	}
+	
+	return xfer->size != 0;
+}
+
+/*
+ *	------------------Xfer_Next_Tx-------------------
+ *	Local function to fetch the next byte to transmit, walking the
+ *	segments of a scatter-gather write in place
+ *	Input: Engine, Transfer Descriptor
+ *	Output: Byte to load into MDR
+ */
+static uint8_t Xfer_Next_Tx(I2C_ENGINE_t* eng, I2C_XFER_t* xfer){
+	
+	eng->left--;
+	
+	if(xfer->segs == 0)
+		return xfer->data[eng->xfer_index++];
+	
+	/* Step over finished and empty segments, size guarantees one is left */
+	while(eng->xfer_index == xfer->segs[eng->seg_index].len){
+		eng->seg_index++;
+		eng->xfer_index = 0;
+	}
+	
+	return xfer->segs[eng->seg_index].data[eng->xfer_index++];
+}
+
+/*
+ *	-------------------Async_Start-------------------
+ *	Local function to put a checked transfer on the bus
+ *	Input: Bus Handle, Transfer Descriptor
+ *	Output: None
+ */
+static void Async_Start(I2C_BUS_t* bus, I2C_XFER_t* xfer){
+	
+	I2C_ENGINE_t* eng = &engines[bus->module];
+	
+	eng->xfer_index = 0;
+	eng->seg_index = 0;
+	eng->left = xfer->size;
+	eng->active = xfer;
+	eng->state = XFER_REG;
+	eng->started_at = CYCCNT_Get();
+	
+	I2C_MICR(bus) = I2C_MICR_IC;															//Clear completion left by polled transfers
+	I2C_MIMR(bus) |= I2C_MIMR_IM;															//Arm master interrupt
+	
+	I2C_MSA(bus) = (xfer->slave_addr<<1);
+	
+	/* Scatter-gather write has no register byte, its first byte is data */
+	if(xfer->segs != 0){
+		I2C_MDR(bus) = Xfer_Next_Tx(eng, xfer);
+		if(eng->left == 0){
+			eng->state = XFER_TX_LAST;
+			I2C_MCS(bus) = I2C_MCS_START|I2C_MCS_RUN|I2C_MCS_STOP;
+		}
+		else{
+			eng->state = XFER_TX;
+			I2C_MCS(bus) = I2C_MCS_START|I2C_MCS_RUN;
+		}
+		return;
+	}
+	
+	/* Send slave address and register byte, the rest happens in the handler */
+	I2C_MDR(bus) = xfer->slave_reg_addr;
+	I2C_MCS(bus) = I2C_MCS_START|I2C_MCS_RUN;
+}
+
+/*
+ *	------------------Async_Finish-------------------
+ *	Local function to release the engine and report completion
+ *	Input: Bus Handle, Status to report
+ *	Output: None
+ */
+static void Async_Finish(I2C_BUS_t* bus, uint8_t status){
+	I2C_ENGINE_t* eng = &engines[bus->module];
+	I2C_XFER_t* xfer = eng->active;
+
+	/* Release engine before the callback so it can chain the next transfer */
+	eng->active = 0;
+	eng->state = XFER_IDLE;
+	I2C_MIMR(bus) &= ~I2C_MIMR_IM;														//Polled transfers should not interrupt
+
+	xfer->status = status;
+	xfer->done = true;
+	I2C_Stats_Record(bus, xfer->slave_addr, xfer->size, eng->started_at, status);
+	I2C_TRACE_SPAN(eng->started_at, bus, xfer->slave_addr, xfer->slave_reg_addr, xfer->size,
+		I2C_TRACE_ASYNC | (xfer->dir == I2C_XFER_READ ? I2C_TRACE_READ : 0), status);
+
+	if(xfer->callback)
+		xfer->callback(xfer);
+	
+	/* Bus is free again, start whatever is waiting */
+	Queue_Dispatch(bus);
+}
+
+/*
+ *	-----------------Queue_Dispatch------------------
+ *	Local function to start the oldest transfer of the highest class.
+ *	Called from the I2Cn handler or with interrupts disabled
+ *	Input: Bus Handle
+ *	Output: None
+ */
+static void Queue_Dispatch(I2C_BUS_t* bus){
+	
+	uint8_t prio;
+	uint32_t wait;
+	I2C_XFER_t* xfer;
+	I2C_ENGINE_t* eng = &engines[bus->module];
+	
+	if(eng->active != 0 || eng->hold != 0)
+		return;
+	
+	for(prio = 0; prio < I2C_PRIO_COUNT; prio++){
+		
+		xfer = eng->queue_head[prio];
+		if(xfer == 0)
+			continue;
+		
+		/* Pop from the front of this class */
+		eng->queue_head[prio] = xfer->next;
+		if(eng->queue_head[prio] == 0)
+			eng->queue_tail[prio] = 0;
+		xfer->next = 0;
+		
+		/* Record how long it sat in the queue */
+		wait = CYCCNT_Get() - xfer->queued_at;
+		eng->queue_stats[prio].depth--;
+		eng->queue_stats[prio].wait_total += wait;
+		if(wait > eng->queue_stats[prio].wait_max)
+			eng->queue_stats[prio].wait_max = wait;
+		
+		Async_Start(bus, xfer);
+		return;
+	}
+}
+
+/*
+ *	------------------I2C_Async_Init------------------
+ *	Enables the module interrupt in the NVIC. The controller interrupt
+ *	is only armed while a transfer is in flight.
+ *	I2C_Init must be called first
+ *	Input: Bus Handle
+ *	Output: None
+ */
+void I2C_Async_Init(I2C_BUS_t* bus){
+
+	I2C_ENGINE_t* eng = &engines[bus->module];
+	uint32_t shift = (bus->irq & 0x3) * 8 + I2C_NVIC_PRI_SHIFT;
+
+	eng->active = 0;
+	eng->state = XFER_IDLE;
+
+	I2C_MIMR(bus) &= ~I2C_MIMR_IM;														//Only armed while a transfer is in flight
+	I2C_MICR(bus) = I2C_MICR_IC;															//Clear any stale interrupt
+
+	/* Four interrupts per priority register, 32 per enable register */
+	(&NVIC_PRI0_R)[bus->irq >> 2] = ((&NVIC_PRI0_R)[bus->irq >> 2] & ~(0x7UL << shift)) | ((uint32_t)I2C_NVIC_PRI << shift);
+	(&NVIC_EN0_R)[bus->irq >> 5] |= 1UL << (bus->irq & 0x1F);
+}
+
+/*
+ *	-----------------I2C_Async_Submit-----------------
+ *	Starts a transfer and returns immediately. Completion is reported
+ *	through the descriptor's done flag and callback
+ *	Input: Bus Handle, Transfer Descriptor
+ *	Output: I2C_OK if started, I2C_ERR_BUSY or I2C_ERR_PARAM otherwise
+ */
+uint8_t I2C_Async_Submit(I2C_BUS_t* bus, I2C_XFER_t* xfer){
+
+	long sr;
+	I2C_ENGINE_t* eng = &engines[bus->module];
+
+	/* Asserting Param */
+	if(!Xfer_Check(xfer))
+		return I2C_ERR_PARAM;
+
+	sr = StartCritical();
+
+	/* Bus belongs to a queued or polled transfer */
+	if(eng->active != 0 || eng->hold != 0){
+		EndCritical(sr);
+		return I2C_ERR_BUSY;
+	}
+
+	xfer->done = false;
+	xfer->status = I2C_OK;
+	Async_Start(bus, xfer);
+
+	EndCritical(sr);
+
+	return I2C_OK;
+}
+
+/*
+ *	-----------------I2C_Queue_Submit-----------------
+ *	Queues a transfer behind others of the same class. Whenever the bus
+ *	frees up the oldest transfer of the highest class is started, so a
+ *	sensor transfer waits at most one transfer already on the bus
+ *	Input: Bus Handle, Transfer Descriptor, Priority Class
+ *	Output: I2C_OK if queued, I2C_ERR_PARAM otherwise
+ */
+uint8_t I2C_Queue_Submit(I2C_BUS_t* bus, I2C_XFER_t* xfer, I2C_PRIO prio){
+	
+	long sr;
+	I2C_ENGINE_t* eng = &engines[bus->module];
+	
+	/* Asserting Param */
+	if(prio >= I2C_PRIO_COUNT || !Xfer_Check(xfer))
+		return I2C_ERR_PARAM;
+	
+	xfer->done = false;
+	xfer->status = I2C_OK;
+	xfer->next = 0;
+	xfer->queued_at = CYCCNT_Get();
+	
+	sr = StartCritical();
+	
+	/* Append to the back of this class */
+	if(eng->queue_tail[prio] != 0)
+		eng->queue_tail[prio]->next = xfer;
+	else
+		eng->queue_head[prio] = xfer;
+	eng->queue_tail[prio] = xfer;
+	
+	eng->queue_stats[prio].submitted++;
+	eng->queue_stats[prio].depth++;
+	if(eng->queue_stats[prio].depth > eng->queue_stats[prio].max_depth)
+		eng->queue_stats[prio].max_depth = eng->queue_stats[prio].depth;
+	
+	Queue_Dispatch(bus);
+	
+	EndCritical(sr);
+	
+	return I2C_OK;
+}
+
+/*
+ *	----------------I2C_Queue_Get_Stats---------------
+ *	Copies the counters of one priority class
+ *	Input: Bus Handle, Priority Class, Struct to fill
+ *	Output: None
+ */
+void I2C_Queue_Get_Stats(I2C_BUS_t* bus, I2C_PRIO prio, I2C_QUEUE_STATS_t* stats){
+	
+	long sr;
+	
+	if(prio >= I2C_PRIO_COUNT || stats == 0)
+		return;
+	
+	sr = StartCritical();
+	*stats = engines[bus->module].queue_stats[prio];
+	EndCritical(sr);
+}
+
+/*
+ *	---------------I2C_Queue_Reset_Stats--------------
+ *	Clears the counters of every class (current depth is kept)
+ *	Input: Bus Handle
+ *	Output: None
+ */
+void I2C_Queue_Reset_Stats(I2C_BUS_t* bus){
+	
+	uint8_t prio;
+	I2C_QUEUE_STATS_t* stats = engines[bus->module].queue_stats;
+	long sr = StartCritical();
+	
+	for(prio = 0; prio < I2C_PRIO_COUNT; prio++){
+		stats[prio].submitted = 0;
+		stats[prio].max_depth = stats[prio].depth;
+		stats[prio].wait_max = 0;
+		stats[prio].wait_total = 0;
+	}
+	
+	EndCritical(sr);
+}
+
+/*
+ *	-----------------I2C_Async_Acquire----------------
+ *	Stops the queue from starting new transfers and waits for the one
+ *	on the bus to finish so polled code can use the controller.
+ *	Every Acquire must be paired with a Release
+ *	Input: Bus Handle
+ *	Output: None
+ */
+void I2C_Async_Acquire(I2C_BUS_t* bus){
+	
+	long sr;
+	uint32_t start = CYCCNT_Get();
+	uint32_t limit;
+	I2C_XFER_t* xfer;
+	I2C_ENGINE_t* eng = &engines[bus->module];
+	
+	eng->hold++;
+	
+	/* A healthy transfer needs one controller wait per byte plus address
+		 and register, give up past that and let the polled path recover */
+	xfer = eng->active;
+	if(xfer == 0)
+		return;
+	limit = bus->timeout_cycles * (xfer->size + 2);
+	
+	while(eng->active != 0){
+		if((CYCCNT_Get() - start) > limit){
+			sr = StartCritical();
+			if(eng->active != 0)
+				Async_Finish(bus, I2C_ERR_TIMEOUT);
+			EndCritical(sr);
+			break;
+		}
+	}
+}
+
+/*
+ *	-----------------I2C_Async_Release----------------
+ *	Hands the bus back to the queue and starts the next transfer
+ *	Input: Bus Handle
+ *	Output: None
+ */
+void I2C_Async_Release(I2C_BUS_t* bus){
+	
+	I2C_ENGINE_t* eng = &engines[bus->module];
+	long sr = StartCritical();
+	
+	if(eng->hold != 0)
+		eng->hold--;
+	Queue_Dispatch(bus);
+	
+	EndCritical(sr);
+}
+
+/*
+ *	------------------I2C_Async_Busy------------------
+ *	Checks if the engine currently owns the bus
+ *	Input: Bus Handle
+ *	Output: true while a transfer is in flight
+ */
+bool I2C_Async_Busy(I2C_BUS_t* bus){
+	return engines[bus->module].active != 0;
+}
+
+/*
+ *	------------------I2C_Async_Wait------------------
+ *	Blocks until a submitted transfer completes
+ *	Input: Transfer Descriptor
+ *	Output: Final status of the transfer
+ */
+uint8_t I2C_Async_Wait(I2C_XFER_t* xfer){
+	while(!xfer->done)
+		I2C_SPIN();
+	return xfer->status;
+}
+
+/*
+ *	------------------Async_Handler------------------
+ *	Local interrupt body shared by every module, runs each time the
+ *	master finishes a command and issues the next MCS command for the
+ *	active transfer
+ *	Input: Bus Handle
+ *	Output: None
+ */
+static void Async_Handler(I2C_BUS_t* bus){
+
+	uint8_t error;
+	I2C_ENGINE_t* eng = &engines[bus->module];
+	I2C_XFER_t* xfer = eng->active;
+
+	/* Slave function shares the module vector, see I2CSlave.h */
+	if(I2C_SMIS(bus) != 0 && bus->slave_handler != 0){
+		bus->slave_handler(bus);
+		if(!(I2C_MRIS(bus) & I2C_MRIS_RIS))
+			return;
+	}
+
+	I2C_MICR(bus) = I2C_MICR_IC;															//Acknowledge interrupt
+
+	if(xfer == 0)
+		return;
+
+	/* STOP after an error has gone out, report the original error */
+	if(eng->state == XFER_STOPPING){
+		Async_Finish(bus, eng->stop_status);
+		return;
+	}
+
+	/* On NACK release the bus with a STOP. Lost arbitration already released
+		 it, and a command carrying STOP sent it: the controller is idle and
+		 no further interrupt comes */
+	error = I2C_MCS(bus) & I2C_ERR_MSK;
+	if(error != 0){
+		if((error & I2C_MCS_ARBLST) || eng->state == XFER_TX_LAST || eng->state == XFER_RX_LAST){
+			Async_Finish(bus, error);
+		}
+		else{
+			eng->stop_status = error;
+			eng->state = XFER_STOPPING;
+			I2C_MCS(bus) = I2C_MCS_STOP;
+		}
+		return;
+	}
+
+	switch(eng->state){
+
+		/* Register byte is out, turn around for the data phase */
+		case XFER_REG:
+			if(xfer->dir == I2C_XFER_READ){
+				I2C_MSA(bus) = (xfer->slave_addr<<1) | I2C_READ_CMD;
+				if(xfer->size == 1){
+					eng->state = XFER_RX_LAST;
+					I2C_MCS(bus) = I2C_MCS_START|I2C_MCS_RUN|I2C_MCS_STOP;
+				}
+				else{
+					eng->state = XFER_RX;
+					I2C_MCS(bus) = I2C_MCS_START|I2C_MCS_RUN|I2C_MCS_ACK;
+				}
+			}
+			else{
+				I2C_MDR(bus) = Xfer_Next_Tx(eng, xfer);
+				if(eng->left == 0){
+					eng->state = XFER_TX_LAST;
+					I2C_MCS(bus) = I2C_MCS_STOP|I2C_MCS_RUN;
+				}
+				else{
+					eng->state = XFER_TX;
+					I2C_MCS(bus) = RUN_CMD;
+				}
+			}
+			break;
+
+		/* Previous data byte is out, load the next one */
+		case XFER_TX:
+			I2C_MDR(bus) = Xfer_Next_Tx(eng, xfer);
+			if(eng->left == 0){
+				eng->state = XFER_TX_LAST;
+				I2C_MCS(bus) = I2C_MCS_STOP|I2C_MCS_RUN;
+			}
+			else{
+				I2C_MCS(bus) = RUN_CMD;
+			}
+			break;
+
+		/* Byte received with ACK, NACK + STOP the final one */
+		case XFER_RX:
+			xfer->data[eng->xfer_index++] = I2C_MDR(bus) & I2C_MDR_DATA_M;
+			if(eng->xfer_index == xfer->size - 1){
+				eng->state = XFER_RX_LAST;
+				I2C_MCS(bus) = I2C_MCS_RUN|I2C_MCS_STOP;
+			}
+			else{
+				I2C_MCS(bus) = I2C_MCS_RUN|I2C_MCS_ACK;
+			}
+			break;
+
+		case XFER_RX_LAST:
+			xfer->data[eng->xfer_index++] = I2C_MDR(bus) & I2C_MDR_DATA_M;
+			Async_Finish(bus, I2C_OK);
+			break;
+
+		case XFER_TX_LAST:
+			Async_Finish(bus, I2C_OK);
+			break;
+
+		default:
+			break;
+	}
+}
+
+/*
+ *	---------------I2C0_Handler - I2C3_Handler---------------
+ *	Module interrupts from the vector table in startup.s
+ *	Input: None
+ *	Output: None
+ */
+void I2C0_Handler(void){
+	Async_Handler(I2C_BUS0);
+}
+
+void I2C1_Handler(void){
+	Async_Handler(I2C_BUS1);
+}
+
+void I2C2_Handler(void){
+	Async_Handler(I2C_BUS2);
+}
+
+void I2C3_Handler(void){
+	Async_Handler(I2C_BUS3);
+}
+
+/* I2C0 Interface, see I2CAsync.h */
+void I2C0_Async_Init(void){
+	I2C_Async_Init(I2C_BUS0);
+}
+
+uint8_t I2C0_Async_Submit(I2C_XFER_t* xfer){
+	return I2C_Async_Submit(I2C_BUS0, xfer);
+}
+
+uint8_t I2C0_Queue_Submit(I2C_XFER_t* xfer, I2C_PRIO prio){
+	return I2C_Queue_Submit(I2C_BUS0, xfer, prio);
+}
+
+void I2C0_Queue_Get_Stats(I2C_PRIO prio, I2C_QUEUE_STATS_t* stats){
+	I2C_Queue_Get_Stats(I2C_BUS0, prio, stats);
+}
+
+void I2C0_Queue_Reset_Stats(void){
+	I2C_Queue_Reset_Stats(I2C_BUS0);
+}
+
+void I2C0_Async_Acquire(void){
+	I2C_Async_Acquire(I2C_BUS0);
+}
+
+void I2C0_Async_Release(void){
+	I2C_Async_Release(I2C_BUS0);
+}
+
+bool I2C0_Async_Busy(void){
+	return I2C_Async_Busy(I2C_BUS0);
+}
+
+uint8_t I2C0_Async_Wait(I2C_XFER_t* xfer){
+	return I2C_Async_Wait(xfer);
+}
@@ -0,0 +1,167 @@
+/*
+ * I2CAsync.h
+ *
+ *	Provides a non-blocking, interrupt driven I2C transaction engine.
+ *	A transfer is described once, submitted, and then clocked out one
+ *	byte per I2Cn interrupt so the CPU is free while the bus is busy.
+ *	A two class priority queue sits in front of the engine so sensor
+ *	sampling is never stuck behind a long run of display frames.
+ *	Each module has its own engine, so two buses run side by side
+ *
+ * Created on: October 16th, 2026
+ *
+ */
+
+#ifndef I2CASYNC_H_
+#define I2CASYNC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "I2C.h"
+
+/* List of Macros */
+#define I2C_NVIC_PRI        2           // Priority of every I2Cn interrupt, above the Port F buttons
+#define I2C_NVIC_PRI_SHIFT  5           // Priority sits in the top 3 bits of each byte
+
+#define I2C_ERR_BUSY        0x20        // Engine already has a transfer in flight
+
+/* Queue Priority Classes (lower value is serviced first) */
+typedef enum{
+	I2C_PRIO_SENSOR = 0,								// Sensor sampling
+	I2C_PRIO_DISPLAY = 1								// LCD and other housekeeping
+} I2C_PRIO;
+#define I2C_PRIO_COUNT      2
+
+/* Transfer Direction */
+typedef enum{
+	I2C_XFER_WRITE = 0,
+	I2C_XFER_READ = 1
+} I2C_XFER_DIR;
+
+/* Transfer Descriptor
+	 Must stay in scope until done is set. The callback runs inside
+	 the I2Cn interrupt, so keep it short; submitting the next transfer
+	 from it is allowed. Polled I2C_* calls hold the queue for their
+	 duration, see I2C_Async_Acquire.
+	 With segs set the transfer is a write of the segments back to back,
+	 dir must be I2C_XFER_WRITE, slave_reg_addr and data are ignored
+	 (see I2C_Write_Segments) */
+typedef struct I2C_XFER I2C_XFER_t;
+struct I2C_XFER{
+	uint8_t slave_addr;									// 7-bit slave address
+	uint8_t slave_reg_addr;							// Register to start reading/writing at
+	I2C_XFER_DIR dir;										// Read or Write
+	uint8_t* data;											// Buffer to receive into or transmit from
+	uint32_t size;											// Number of data bytes (register byte excluded)
+	const I2C_SEG_t* segs;							// Scatter-gather write instead of data, 0 if unused
+	uint8_t seg_count;									// Number of segments, size is filled in on submit
+	void (*callback)(I2C_XFER_t* xfer);	// Completion callback, may be 0
+
+	volatile uint8_t status;						// I2C_OK or I2C_ERR_* once done
+	volatile bool done;									// Set by the engine when the transfer ends
+
+	I2C_XFER_t* next;										// Queue link, owned by the queue
+	uint32_t queued_at;									// Cycle count when queued
+};
+
+/* Per Class Queue Counters (wait times in core clock cycles) */
+typedef struct{
+	uint32_t submitted;									// Transfers queued since last reset
+	uint16_t depth;											// Transfers currently waiting
+	uint16_t max_depth;									// Highest depth seen
+	uint32_t wait_max;									// Longest queued -> started time
+	uint32_t wait_total;								// Sum of queued -> started times
+} I2C_QUEUE_STATS_t;
+
+/*
+ *	------------------I2C_Async_Init------------------
+ *	Enables the module interrupt in the NVIC. The controller interrupt
+ *	is only armed while a transfer is in flight.
+ *	I2C_Init must be called first
+ *	Input: Bus Handle
+ *	Output: None
+ */
+void I2C_Async_Init(I2C_BUS_t* bus);
+
+/*
+ *	-----------------I2C_Async_Submit-----------------
+ *	Starts a transfer and returns immediately. Completion is reported
+ *	through the descriptor's done flag and callback
+ *	Input: Bus Handle, Transfer Descriptor
+ *	Output: I2C_OK if started, I2C_ERR_BUSY or I2C_ERR_PARAM otherwise
+ */
+uint8_t I2C_Async_Submit(I2C_BUS_t* bus, I2C_XFER_t* xfer);
+
+/*
+ *	-----------------I2C_Queue_Submit-----------------
+ *	Queues a transfer behind others of the same class. Whenever the bus
+ *	frees up the oldest transfer of the highest class is started, so a
+ *	sensor transfer waits at most one transfer already on the bus
+ *	Input: Bus Handle, Transfer Descriptor, Priority Class
+ *	Output: I2C_OK if queued, I2C_ERR_PARAM otherwise
+ */
+uint8_t I2C_Queue_Submit(I2C_BUS_t* bus, I2C_XFER_t* xfer, I2C_PRIO prio);
+
+/*
+ *	----------------I2C_Queue_Get_Stats---------------
+ *	Copies the counters of one priority class
+ *	Input: Bus Handle, Priority Class, Struct to fill
+ *	Output: None
+ */
+void I2C_Queue_Get_Stats(I2C_BUS_t* bus, I2C_PRIO prio, I2C_QUEUE_STATS_t* stats);
+
+/*
+ *	---------------I2C_Queue_Reset_Stats--------------
+ *	Clears the counters of every class (current depth is kept)
+ *	Input: Bus Handle
+ *	Output: None
+ */
+void I2C_Queue_Reset_Stats(I2C_BUS_t* bus);
+
+/*
+ *	-----------------I2C_Async_Acquire----------------
+ *	Stops the queue from starting new transfers and waits for the one
+ *	on the bus to finish so polled code can use the controller.
+ *	Every Acquire must be paired with a Release
+ *	Input: Bus Handle
+ *	Output: None
+ */
+void I2C_Async_Acquire(I2C_BUS_t* bus);
+
+/*
+ *	-----------------I2C_Async_Release----------------
+ *	Hands the bus back to the queue and starts the next transfer
+ *	Input: Bus Handle
+ *	Output: None
+ */
+void I2C_Async_Release(I2C_BUS_t* bus);
+
+/*
+ *	------------------I2C_Async_Busy------------------
+ *	Checks if the engine currently owns the bus
+ *	Input: Bus Handle
+ *	Output: true while a transfer is in flight
+ */
+bool I2C_Async_Busy(I2C_BUS_t* bus);
+
+/*
+ *	------------------I2C_Async_Wait------------------
+ *	Blocks until a submitted transfer completes
+ *	Input: Transfer Descriptor
+ *	Output: Final status of the transfer
+ */
+uint8_t I2C_Async_Wait(I2C_XFER_t* xfer);
+
+/* I2C0 Interface
+	 Thin wrappers over the functions above on I2C_BUS0 */
+void I2C0_Async_Init(void);
+uint8_t I2C0_Async_Submit(I2C_XFER_t* xfer);
+uint8_t I2C0_Queue_Submit(I2C_XFER_t* xfer, I2C_PRIO prio);
+void I2C0_Queue_Get_Stats(I2C_PRIO prio, I2C_QUEUE_STATS_t* stats);
+void I2C0_Queue_Reset_Stats(void);
+void I2C0_Async_Acquire(void);
+void I2C0_Async_Release(void);
+bool I2C0_Async_Busy(void);
+uint8_t I2C0_Async_Wait(I2C_XFER_t* xfer);
+
+#endif //I2CASYNC_H_
@@ -0,0 +1,244 @@
+/*
+ * I2CBench.c
+ *
+ *	Main implementation of the I2C loopback throughput benchmark
+ *
+ * Created on: October 17th, 2026
+ *
+ */
+
+#include "I2CBench.h"
+#include "tm4c123gh6pm.h"
+#include "util.h"
+#include <stdio.h>
+
+#define BENCH_CAL_LOOPS     1000        // Idle loop passes timed to get their cost
+
+static uint8_t bench_buf[I2C_BENCH_LEN];
+static I2C_XFER_t bench_xfer;
+static uint8_t bench_pattern;							// Next byte the slave answers with
+static volatile uint8_t bench_sink;				// Last byte the slave swallowed
+
+/*
+ *	---------------Bench_Slave_Handler---------------
+ *	Local slave interrupt body, keeps the master going by taking
+ *	every written byte and answering every read
+ *	Input: Bus Handle
+ *	Output: None
+ */
+static void Bench_Slave_Handler(I2C_BUS_t* bus){
+
+	uint32_t status;
+
+	I2C_SICR(bus) = I2C_SICR_DATAIC;
+	status = I2C_SCSR(bus);
+
+	if(status & I2C_SCSR_RREQ)
+		bench_sink = I2C_SDR(bus);
+	if(status & I2C_SCSR_TREQ)
+		I2C_SDR(bus) = bench_pattern++;
+}
+
+/*
+ *	--------------------Bench_Idle--------------------
+ *	Local function standing in for application work while the engine
+ *	runs, counts how often it got the CPU
+ *	Input: Transfer Descriptor, Most passes to wait
+ *	Output: Number of passes
+ */
+static uint32_t Bench_Idle(I2C_XFER_t* xfer, uint32_t limit){
+
+	uint32_t idle = 0;
+
+	while(!xfer->done && idle < limit){
+		I2C_IDLE_PASS();
+		idle++;
+	}
+
+	return idle;
+}
+
+/*
+ *	------------------Bench_Burst--------------------
+ *	Local function running one burst in the requested mode
+ *	Input: Bus Handle, Mode, Direction, Length, Idle passes to add to
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+static uint8_t Bench_Burst(I2C_BUS_t* bus, I2C_BENCH_MODE mode, I2C_XFER_DIR dir, uint32_t len, uint32_t* idle){
+
+	uint8_t error;
+
+	if(mode == I2C_BENCH_POLLED){
+		if(dir == I2C_XFER_READ)
+			return I2C_Burst_Receive(bus, I2C_BENCH_ADDR, 0, bench_buf, len);
+		return I2C_Burst_Transmit(bus, I2C_BENCH_ADDR, 0, bench_buf, len);
+	}
+
+	bench_xfer.slave_addr = I2C_BENCH_ADDR;
+	bench_xfer.slave_reg_addr = 0;
+	bench_xfer.dir = dir;
+	bench_xfer.data = bench_buf;
+	bench_xfer.size = len;
+	bench_xfer.segs = 0;
+	bench_xfer.callback = 0;
+
+	error = I2C_Async_Submit(bus, &bench_xfer);
+	if(error != I2C_OK)
+		return error;
+
+	/* Each pass is at least a cycle, so this bounds the wait like a timeout */
+	*idle += Bench_Idle(&bench_xfer, bus->timeout_cycles * (len + 2));
+
+	/* Engine stalled, Acquire gives up on it and reports the timeout */
+	if(!bench_xfer.done){
+		I2C_Async_Acquire(bus);
+		I2C_Async_Release(bus);
+	}
+
+	return bench_xfer.status;
+}
+
+/*
+ *	------------------I2C_Bench_Init------------------
+ *	Clocks the module and puts it in loopback with both master and
+ *	slave enabled
+ *	Input: Bus Handle
+ *	Output: None
+ */
+void I2C_Bench_Init(I2C_BUS_t* bus){
+
+	SYSCTL_RCGCI2C_R |= (1U << bus->module);							//Enable I2Cn System Clock
+	while((SYSCTL_PRI2C_R & (1U << bus->module)) == 0);
+
+	/* Master output is wired to the slave input inside the module */
+	I2C_MCR(bus) = I2C_MCR_LPBK|I2C_MCR_MFE|I2C_MCR_SFE;
+	I2C_SOAR(bus) = I2C_BENCH_ADDR;
+	I2C_SICR(bus) = I2C_SICR_STOPIC|I2C_SICR_STARTIC|I2C_SICR_DATAIC;
+	I2C_SIMR(bus) = I2C_SIMR_DATAIM;
+	I2C_SCSR(bus) = I2C_SCSR_DA;
+
+	I2C_Set_Timeout(bus, I2C_TIMEOUT_DEFAULT_US);
+	I2C_SetSpeed(bus, I2C_SPEED_STANDARD);
+
+	bus->slave_handler = Bench_Slave_Handler;
+	I2C_Async_Init(bus);
+}
+
+/*
+ *	------------------I2C_Bench_Run-------------------
+ *	Times I2C_BENCH_REPS bursts of 1 and I2C_BENCH_LEN bytes at one
+ *	speed, mode and direction
+ *	Input: Bus Handle, SCL rate, Mode, Direction, Result to fill
+ *	Output: I2C_OK, or the first error seen
+ */
+uint8_t I2C_Bench_Run(I2C_BUS_t* bus, uint32_t scl_hz, I2C_BENCH_MODE mode, I2C_XFER_DIR dir, I2C_BENCH_RESULT_t* result){
+
+	uint8_t rep;
+	uint8_t error;
+	uint8_t first_error = I2C_OK;
+	uint32_t idle;
+	uint32_t idle_cost;
+	uint32_t start;
+	uint32_t elapsed;
+	uint32_t idle_cycles;
+
+	result->mode = mode;
+	result->dir = dir;
+	result->errors = 0;
+	result->scl_hz = I2C_SetSpeed(bus, scl_hz);
+	if(result->scl_hz == 0)
+		return I2C_ERR_PARAM;
+
+	/* Cost of one idle pass, done is never set on an idle descriptor */
+	bench_xfer.done = false;
+	start = CYCCNT_Get();
+	Bench_Idle(&bench_xfer, BENCH_CAL_LOOPS);
+	idle_cost = (CYCCNT_Get() - start) / BENCH_CAL_LOOPS;
+
+	/* Short bursts: almost all overhead */
+	start = CYCCNT_Get();
+	for(rep = 0; rep < I2C_BENCH_REPS; rep++){
+		idle = 0;
+		error = Bench_Burst(bus, mode, dir, 1, &idle);
+		if(error != I2C_OK){
+			result->errors++;
+			if(first_error == I2C_OK)
+				first_error = error;
+		}
+	}
+	result->cycles_short = (CYCCNT_Get() - start) / I2C_BENCH_REPS;
+
+	/* Long bursts: payload rate and the CPU left over */
+	idle = 0;
+	start = CYCCNT_Get();
+	for(rep = 0; rep < I2C_BENCH_REPS; rep++){
+		error = Bench_Burst(bus, mode, dir, I2C_BENCH_LEN, &idle);
+		if(error != I2C_OK){
+			result->errors++;
+			if(first_error == I2C_OK)
+				first_error = error;
+		}
+	}
+	elapsed = CYCCNT_Get() - start;
+	result->cycles_long = elapsed / I2C_BENCH_REPS;
+
+	idle_cycles = idle * idle_cost;
+	if(idle_cycles > elapsed)
+		idle_cycles = elapsed;
+	result->cpu_pct = (elapsed != 0) ? (uint8_t)(((uint64_t)(elapsed - idle_cycles) * 100) / elapsed) : 100;
+
+	I2C_Bench_Fit(result, SYSCLK_Get_Hz());
+
+	return first_error;
+}
+
+/*
+ *	------------------I2C_Bench_Fit-------------------
+ *	Splits the short and long burst times into overhead and per byte
+ *	cost and works out the payload rate
+ *	Input: Result with cycles_short and cycles_long set, System clock in Hz
+ *	Output: None
+ */
+void I2C_Bench_Fit(I2C_BENCH_RESULT_t* result, uint32_t sysclk_hz){
+
+	/* Two point line fit: time = overhead + per_byte * length */
+	if(result->cycles_long > result->cycles_short)
+		result->per_byte = (result->cycles_long - result->cycles_short) / (I2C_BENCH_LEN - 1);
+	else
+		result->per_byte = 0;
+
+	if(result->cycles_short > result->per_byte)
+		result->overhead = result->cycles_short - result->per_byte;
+	else
+		result->overhead = 0;
+
+	if(result->cycles_long != 0)
+		result->bytes_per_sec = (uint32_t)(((uint64_t)I2C_BENCH_LEN * sysclk_hz) / result->cycles_long);
+	else
+		result->bytes_per_sec = 0;
+}
+
+/*
+ *	-----------------I2C_Bench_Format-----------------
+ *	Formats one result as a report line
+ *	Input: Result, System clock in Hz, Buffer to fill
+ *	Output: None
+ */
+void I2C_Bench_Format(const I2C_BENCH_RESULT_t* result, uint32_t sysclk_hz, char* buf){
+
+	uint32_t cycles_per_us = sysclk_hz / 1000000;
+	uint32_t byte_tenths;
+
+	if(cycles_per_us == 0)
+		cycles_per_us = 1;
+	byte_tenths = (result->per_byte * 10) / cycles_per_us;
+
+	sprintf(buf, "%4lu kHz %-6s %-5s %6lu B/s  overhead %5lu us  %3lu.%lu us/byte  CPU %3u%%  err %u\r\n",
+			(unsigned long)(result->scl_hz / 1000),
+			(result->mode == I2C_BENCH_POLLED) ? "polled" : "irq",
+			(result->dir == I2C_XFER_READ) ? "read" : "write",
+			(unsigned long)result->bytes_per_sec,
+			(unsigned long)(result->overhead / cycles_per_us),
+			(unsigned long)(byte_tenths / 10), (unsigned long)(byte_tenths % 10),
+			result->cpu_pct, result->errors);
+}
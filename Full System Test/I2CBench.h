@@ -0,0 +1,84 @@
+/*
+ * I2CBench.h
+ *
+ *	Provides an I2C throughput benchmark that needs no sensors. A spare
+ *	module is put in internal loopback so its master talks to its own
+ *	slave, bursts are timed at each bus speed in polled and interrupt
+ *	driven mode, and the results are reported on UART0.
+ *	Measuring (I2C_Bench_Run) and reporting (I2C_Bench_Fit and
+ *	I2C_Bench_Format) are kept apart so the latter need no hardware
+ *
+ * Created on: October 17th, 2026
+ *
+ */
+
+#ifndef I2CBENCH_H_
+#define I2CBENCH_H_
+
+#include <stdint.h>
+#include "I2C.h"
+#include "I2CAsync.h"
+
+/* List of Macros */
+#define I2C_BENCH_BUS       I2C_BUS3    // Loopback is internal, PD0/PD1 are left alone
+#define I2C_BENCH_ADDR      0x3C        // Own slave address in loopback
+#define I2C_BENCH_LEN       64          // Longest burst timed
+#define I2C_BENCH_REPS      16          // Bursts per length
+
+/* Master side being timed */
+typedef enum{
+	I2C_BENCH_POLLED,										// I2C_Burst_* calls, CPU spins
+	I2C_BENCH_IRQ												// I2C_Async_Submit, CPU free while the engine runs
+} I2C_BENCH_MODE;
+
+/* One Benchmark Line (times in core clock cycles) */
+typedef struct{
+	uint32_t scl_hz;										// SCL rate actually programmed
+	I2C_BENCH_MODE mode;
+	I2C_XFER_DIR dir;
+	uint32_t cycles_short;							// Average 1 byte burst
+	uint32_t cycles_long;								// Average I2C_BENCH_LEN byte burst
+	uint32_t overhead;									// Fixed cost per transaction
+	uint32_t per_byte;									// Cost of every extra byte
+	uint32_t bytes_per_sec;							// Payload rate of the long bursts
+	uint8_t cpu_pct;										// CPU busy share during the long bursts
+	uint8_t errors;											// Bursts that did not end with I2C_OK
+} I2C_BENCH_RESULT_t;
+
+/*
+ *	------------------I2C_Bench_Init------------------
+ *	Clocks the module and puts it in loopback with both master and
+ *	slave enabled. The slave swallows writes and answers reads with a
+ *	counting pattern. No pins are muxed
+ *	Input: Bus Handle
+ *	Output: None
+ */
+void I2C_Bench_Init(I2C_BUS_t* bus);
+
+/*
+ *	------------------I2C_Bench_Run-------------------
+ *	Times I2C_BENCH_REPS bursts of 1 and I2C_BENCH_LEN bytes at one
+ *	speed, mode and direction, then fills in the derived figures
+ *	Input: Bus Handle, SCL rate, Mode, Direction, Result to fill
+ *	Output: I2C_OK, or the first error seen
+ */
+uint8_t I2C_Bench_Run(I2C_BUS_t* bus, uint32_t scl_hz, I2C_BENCH_MODE mode, I2C_XFER_DIR dir, I2C_BENCH_RESULT_t* result);
+
+/*
+ *	------------------I2C_Bench_Fit-------------------
+ *	Splits the short and long burst times into overhead and per byte
+ *	cost and works out the payload rate
+ *	Input: Result with cycles_short and cycles_long set, System clock in Hz
+ *	Output: None
+ */
+void I2C_Bench_Fit(I2C_BENCH_RESULT_t* result, uint32_t sysclk_hz);
+
+/*
+ *	-----------------I2C_Bench_Format-----------------
+ *	Formats one result as a report line (at least 96 chars)
+ *	Input: Result, System clock in Hz, Buffer to fill
+ *	Output: None
+ */
+void I2C_Bench_Format(const I2C_BENCH_RESULT_t* result, uint32_t sysclk_hz, char* buf);
+
+#endif //I2CBENCH_H_
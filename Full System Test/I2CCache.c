@@ -0,0 +1,162 @@
+/*
+ * I2CCache.c
+ *
+ *	Main implementation of the write-through register shadow cache
+ *
+ * Created on: October 17th, 2026
+ *
+ */
+
+#include "I2CCache.h"
+
+/* Shadow Entry Flags */
+#define CACHE_USED          0x01        // Slot holds a declared register
+#define CACHE_VALID         0x02        // Value matches the device
+
+typedef struct{
+	uint8_t bus;												// Module number
+	uint8_t addr;												// 7-bit slave address
+	uint8_t reg;												// Register address
+	uint8_t value;											// Last value written or read
+	uint8_t flags;											// CACHE_* flags
+} I2C_CACHE_ENTRY_t;
+
+static I2C_CACHE_ENTRY_t cache[I2C_CACHE_SIZE];
+static I2C_CACHE_STATS_t cache_stats;
+
+/*
+ *	-------------------Cache_Find--------------------
+ *	Local function to look up a declared register
+ *	Input: Bus Handle, Slave address, Register address
+ *	Output: Entry, or 0 if the register is volatile
+ */
+static I2C_CACHE_ENTRY_t* Cache_Find(I2C_BUS_t* bus, uint8_t addr, uint8_t reg){
+
+	uint8_t i;
+
+	for(i = 0; i < I2C_CACHE_SIZE; i++){
+		if((cache[i].flags & CACHE_USED) && cache[i].reg == reg && cache[i].addr == addr && cache[i].bus == bus->module)
+			return &cache[i];
+	}
+
+	return 0;
+}
+
+/*
+ *	-----------------I2C_Cache_Declare----------------
+ *	Marks a register non-volatile
+ *	Input: Bus Handle, Slave address, Register address
+ *	Output: I2C_OK, or I2C_ERR_PARAM if the table is full
+ */
+uint8_t I2C_Cache_Declare(I2C_BUS_t* bus, uint8_t addr, uint8_t reg){
+
+	uint8_t i;
+
+	if(Cache_Find(bus, addr, reg) != 0)
+		return I2C_OK;
+
+	for(i = 0; i < I2C_CACHE_SIZE; i++){
+		if(!(cache[i].flags & CACHE_USED)){
+			cache[i].bus = bus->module;
+			cache[i].addr = addr;
+			cache[i].reg = reg;
+			cache[i].flags = CACHE_USED;					//Value unknown until first access
+			return I2C_OK;
+		}
+	}
+
+	return I2C_ERR_PARAM;
+}
+
+/*
+ *	------------------I2C_Cache_Read------------------
+ *	Reads one register, from RAM when it is non-volatile and its value
+ *	is known, from the bus otherwise
+ *	Input: Bus Handle, Slave address, Register address, Byte to fill
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t I2C_Cache_Read(I2C_BUS_t* bus, uint8_t addr, uint8_t reg, uint8_t* value){
+
+	uint8_t error;
+	I2C_CACHE_ENTRY_t* entry = Cache_Find(bus, addr, reg);
+
+	if(entry != 0 && (entry->flags & CACHE_VALID)){
+		cache_stats.hits++;
+		*value = entry->value;
+		return I2C_OK;
+	}
+
+	cache_stats.misses++;
+	error = I2C_Burst_Receive(bus, addr, reg, value, 1);
+
+	/* First read of a non-volatile register fills the shadow */
+	if(entry != 0 && error == I2C_OK){
+		entry->value = *value;
+		entry->flags |= CACHE_VALID;
+	}
+
+	return error;
+}
+
+/*
+ *	-----------------I2C_Cache_Write------------------
+ *	Writes one register through to the bus and updates the shadow
+ *	Input: Bus Handle, Slave address, Register address, Value
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t I2C_Cache_Write(I2C_BUS_t* bus, uint8_t addr, uint8_t reg, uint8_t value){
+
+	uint8_t error;
+	I2C_CACHE_ENTRY_t* entry = Cache_Find(bus, addr, reg);
+
+	cache_stats.writes++;
+	error = I2C_Burst_Transmit(bus, addr, reg, &value, 1);
+
+	if(entry != 0){
+		if(error == I2C_OK){
+			entry->value = value;
+			entry->flags |= CACHE_VALID;
+		}
+		else{
+			entry->flags &= ~CACHE_VALID;						//Device may or may not have taken it
+		}
+	}
+
+	return error;
+}
+
+/*
+ *	---------------I2C_Cache_Invalidate---------------
+ *	Forgets every shadowed value of one slave
+ *	Input: Bus Handle, Slave address
+ *	Output: None
+ */
+void I2C_Cache_Invalidate(I2C_BUS_t* bus, uint8_t addr){
+
+	uint8_t i;
+
+	for(i = 0; i < I2C_CACHE_SIZE; i++){
+		if(cache[i].addr == addr && cache[i].bus == bus->module)
+			cache[i].flags &= ~CACHE_VALID;
+	}
+}
+
+/*
+ *	----------------I2C_Cache_Get_Stats---------------
+ *	Input: Struct to fill
+ *	Output: None
+ */
+void I2C_Cache_Get_Stats(I2C_CACHE_STATS_t* stats){
+	*stats = cache_stats;
+}
+
+/*
+ *	---------------I2C_Cache_Reset_Stats--------------
+ *	Input: None
+ *	Output: None
+ */
+void I2C_Cache_Reset_Stats(void){
+	cache_stats.hits = 0;
+	cache_stats.misses = 0;
+	cache_stats.writes = 0;
+}
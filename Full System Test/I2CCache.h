@@ -0,0 +1,80 @@
+/*
+ * I2CCache.h
+ *
+ *	Provides a write-through shadow of slave registers. Registers the
+ *	firmware owns (configuration written once at init) are declared
+ *	non-volatile and read back from RAM; everything else, data and
+ *	status registers, always goes to the bus
+ *
+ * Created on: October 17th, 2026
+ *
+ */
+
+#ifndef I2CCACHE_H_
+#define I2CCACHE_H_
+
+#include <stdint.h>
+#include "I2C.h"
+
+/* List of Macros */
+#define I2C_CACHE_SIZE      16          // Non-volatile registers that can be shadowed
+
+/* Cache Counters */
+typedef struct{
+	uint32_t hits;											// Reads served from RAM
+	uint32_t misses;										// Reads that went to the bus
+	uint32_t writes;										// Writes passed through to the bus
+} I2C_CACHE_STATS_t;
+
+/*
+ *	-----------------I2C_Cache_Declare----------------
+ *	Marks a register non-volatile: only the firmware changes it, so
+ *	once written or read its value is kept in RAM. Undeclared registers
+ *	are volatile. Declaring twice is harmless
+ *	Input: Bus Handle, Slave address, Register address
+ *	Output: I2C_OK, or I2C_ERR_PARAM if the table is full
+ */
+uint8_t I2C_Cache_Declare(I2C_BUS_t* bus, uint8_t addr, uint8_t reg);
+
+/*
+ *	------------------I2C_Cache_Read------------------
+ *	Reads one register, from RAM when it is non-volatile and its value
+ *	is known, from the bus otherwise
+ *	Input: Bus Handle, Slave address, Register address, Byte to fill
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t I2C_Cache_Read(I2C_BUS_t* bus, uint8_t addr, uint8_t reg, uint8_t* value);
+
+/*
+ *	-----------------I2C_Cache_Write------------------
+ *	Writes one register through to the bus and updates the shadow.
+ *	A failed write forgets the shadowed value
+ *	Input: Bus Handle, Slave address, Register address, Value
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t I2C_Cache_Write(I2C_BUS_t* bus, uint8_t addr, uint8_t reg, uint8_t value);
+
+/*
+ *	---------------I2C_Cache_Invalidate---------------
+ *	Forgets every shadowed value of one slave, call after anything that
+ *	changes its registers behind the cache (soft reset, power cycle)
+ *	Input: Bus Handle, Slave address
+ *	Output: None
+ */
+void I2C_Cache_Invalidate(I2C_BUS_t* bus, uint8_t addr);
+
+/*
+ *	----------------I2C_Cache_Get_Stats---------------
+ *	Input: Struct to fill
+ *	Output: None
+ */
+void I2C_Cache_Get_Stats(I2C_CACHE_STATS_t* stats);
+
+/*
+ *	---------------I2C_Cache_Reset_Stats--------------
+ *	Input: None
+ *	Output: None
+ */
+void I2C_Cache_Reset_Stats(void);
+
+#endif //I2CCACHE_H_
@@ -12,8 +12,13 @@
  
 #include "tm4c123gh6pm.h"
 #include "I2C.h"
+#include "I2CAsync.h"
+#include "I2CSlave.h"
+#include "I2CScan.h"
+#include "SoftI2C.h"
 #include "UART0.h"
 #include "TCS34727.h"
+#include "EEPROM.h"
 #include "MPU6050.h"
 #include "ButtonLED.h"
 #include "util.h"
@@ -35,26 +40,69 @@
 #define FULL_SYSTEM
 
 volatile uint8_t mode = FULL_SYSTEM_TEST;
+
+/* Every device on each bus, a bus runs as fast as its slowest device allows */
+static const I2C_DEVICE_t* const Sensor_Devices[] = {
+	&TCS34727_DEVICE,
+	&MPU6050_DEVICE
+};
+static const I2C_DEVICE_t* const LCD_Devices[] = {
+	&LCD_DEVICE
+};
 bool firstRun = false;
 
 int main(void){
 	
+	uint8_t dev;
+	
 	/* Peripheral Initialization */
 	UART0_Init();
 	LED_Init();
 	BTN_Init();
+	CYCCNT_Init();
 	
 	#if defined(DELAY) || defined(TCS34727) || defined(MPU6050) || defined(LCD) || defined(FULL_SYSTEM)	
 	WTIMER0_Init();
 	#endif
 	
 	#if defined (I2C) || defined(TCS34727) || defined(MPU6050) || defined(LCD) || defined(FULL_SYSTEM)
+	/* Sensors on I2C0, LCD on its own bus so display frames never wait on sensors */
 	I2C0_Init();
+	I2C0_Async_Init();
+	I2C0_SetSpeed_For_Devices(Sensor_Devices, sizeof(Sensor_Devices)/sizeof(Sensor_Devices[0]));
+	
+	if(LCD_BUS != I2C_BUS0){
+		I2C_Init(LCD_BUS);
+		I2C_Async_Init(LCD_BUS);
+	}
+	I2C_SetSpeed_For_Devices(LCD_BUS, LCD_Devices, sizeof(LCD_Devices)/sizeof(LCD_Devices[0]));
+	
+	/* Find out who answers where, the drivers bind to it in their Init */
+	I2C_Scan(I2C_BUS0, I2C_SCAN_FIRST, I2C_SCAN_LAST);
+	if(LCD_BUS != I2C_BUS0)
+		I2C_Scan(LCD_BUS, I2C_SCAN_FIRST, I2C_SCAN_LAST);
+	
+	/* Parts moved onto a bit-banged bus, each soft bus paced by its slowest part */
+	for(dev = 0; dev < sizeof(Sensor_Devices)/sizeof(Sensor_Devices[0]); dev++){
+		if(Sensor_Devices[dev]->soft != 0){
+			SoftI2C_Init(Sensor_Devices[dev]->soft);
+			SoftI2C_SetSpeed_For_Devices(Sensor_Devices[dev]->soft, Sensor_Devices, sizeof(Sensor_Devices)/sizeof(Sensor_Devices[0]));
+		}
+	}
+	
+	#ifdef I2C_SLAVE_ENABLE
+	/* Serve the full system sample to an external controller */
+	I2C_Slave_Init(I2C_SLAVE_BUS, I2C_SLAVE_ADDR);
+	#endif
 	#endif
 	
 	#if defined(TCS34727) || defined(FULL_SYSTEM)
 	/* Color Sensor Initialization */
 	TCS34727_Init();
+	
+	/* Stored color calibration, the sensor runs uncalibrated without one */
+	if(EEPROM_Init() == EEPROM_OK && TCS34727_Cal_Load())
+		UART0_OutString("Color calibration loaded\r\n");
 	#endif
 	
 	#if defined(MPU6050) || defined(FULL_SYSTEM)
@@ -72,6 +120,11 @@ int main(void){
 	LCD_Init();
 	#endif
 	
+	#if defined (I2C) || defined(TCS34727) || defined(MPU6050) || defined(LCD) || defined(FULL_SYSTEM)
+	/* Device table with what each driver bound to */
+	I2C_Scan_Print();
+	#endif
+	
 	UART0_OutCRLF();
 	while(1){		
 		
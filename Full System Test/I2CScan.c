@@ -0,0 +1,148 @@
+/*
+ * I2CScan.c
+ *
+ *	Main implementation of the boot-time bus scan and device binding
+ *
+ * Created on: October 17th, 2026
+ *
+ */
+
+#include "I2CScan.h"
+#include "UART0.h"
+#include "util.h"
+#include <stdio.h>
+
+static I2C_SCAN_ENTRY_t scan_table[I2C_SCAN_MAX];
+static uint8_t scan_count;									// Slots in use, filled in order
+static uint32_t scan_cycles[I2C_MODULE_COUNT];			// Duration of the last scan of each bus
+
+/*
+ *	-------------------Scan_Lookup--------------------
+ *	Local function to find a scanned address still free for a driver
+ *	Input: Bus Handle, Address, Descriptor asking
+ *	Output: Entry, or 0 if the address did not answer or is taken
+ */
+static I2C_SCAN_ENTRY_t* Scan_Lookup(I2C_BUS_t* bus, uint8_t addr, const I2C_DEVICE_t* dev){
+
+	uint8_t slot;
+
+	for(slot = 0; slot < scan_count; slot++){
+		if(scan_table[slot].bus == bus->module && scan_table[slot].addr == addr){
+			if(scan_table[slot].dev == 0 || scan_table[slot].dev == dev)
+				return &scan_table[slot];
+			return 0;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ *	---------------------I2C_Scan---------------------
+ *	Probes every address in a range and adds the slaves that answer to
+ *	the device table
+ *	Input: Bus Handle, First and last 7-bit address
+ *	Output: Number of slaves found on this bus
+ */
+uint8_t I2C_Scan(I2C_BUS_t* bus, uint8_t first, uint8_t last){
+
+	uint8_t slot;
+	uint8_t kept = 0;
+	uint8_t found = 0;
+	uint8_t addr;
+	uint32_t start = CYCCNT_Get();
+
+	/* Drop what an earlier scan of this bus found, keep the other buses */
+	for(slot = 0; slot < scan_count; slot++){
+		if(scan_table[slot].bus != bus->module)
+			scan_table[kept++] = scan_table[slot];
+	}
+	scan_count = kept;
+
+	for(addr = first; addr <= last && addr <= I2C_SCAN_LAST; addr++){
+
+		if(I2C_Probe(bus, addr) != I2C_OK)
+			continue;
+
+		found++;
+		if(scan_count < I2C_SCAN_MAX){
+			scan_table[scan_count].bus = bus->module;
+			scan_table[scan_count].addr = addr;
+			scan_table[scan_count].dev = 0;
+			scan_count++;
+		}
+	}
+
+	scan_cycles[bus->module] = CYCCNT_Get() - start;
+
+	return found;
+}
+
+/*
+ *	-------------------I2C_Scan_Bind------------------
+ *	Points a driver descriptor at the first of its addresses the scan
+ *	found and not bound to another driver
+ *	Input: Bus Handle, Descriptor to bind
+ *	Output: I2C_OK if bound, I2C_MCS_ADRACK if no address answered
+ */
+uint8_t I2C_Scan_Bind(I2C_BUS_t* bus, I2C_DEVICE_t* dev){
+
+	uint8_t i;
+	I2C_SCAN_ENTRY_t* entry = Scan_Lookup(bus, dev->addr, dev);
+
+	/* Usual strapping first, then the alternatives in order */
+	for(i = 0; entry == 0 && i < dev->alt_count; i++)
+		entry = Scan_Lookup(bus, dev->alt_addr[i], dev);
+
+	if(entry == 0)
+		return I2C_MCS_ADRACK;
+
+	entry->dev = dev;
+	dev->addr = entry->addr;
+
+	return I2C_OK;
+}
+
+/*
+ *	-------------------I2C_Scan_Get-------------------
+ *	Input: Table slot (0 to I2C_SCAN_MAX-1), Entry to fill
+ *	Output: 1 if the slot holds a device, 0 if it is unused
+ */
+uint8_t I2C_Scan_Get(uint8_t slot, I2C_SCAN_ENTRY_t* entry){
+
+	if(slot >= scan_count || entry == 0)
+		return 0;
+
+	*entry = scan_table[slot];
+	return 1;
+}
+
+/*
+ *	------------------I2C_Scan_Print------------------
+ *	Prints the device table and the time the last scan took on UART0
+ *	Input: None
+ *	Output: None
+ */
+void I2C_Scan_Print(void){
+
+	char buf[64];
+	uint8_t slot;
+	uint8_t module;
+	uint32_t cycles_per_us = SYSCLK_Get_Hz() / 1000000;
+
+	for(module = 0; module < I2C_MODULE_COUNT; module++){
+		if(scan_cycles[module] == 0)
+			continue;
+		sprintf(buf, "I2C%u scan: %lu us\r\n", module, (unsigned long)(scan_cycles[module] / cycles_per_us));
+		UART0_OutString(buf);
+	}
+
+	for(slot = 0; slot < scan_count; slot++){
+		if(scan_table[slot].dev != 0)
+			sprintf(buf, " I2C%u 0x%02X %s, max %lu Hz\r\n", scan_table[slot].bus, scan_table[slot].addr,
+					scan_table[slot].dev->name, (unsigned long)scan_table[slot].dev->max_speed);
+		else
+			sprintf(buf, " I2C%u 0x%02X unknown\r\n", scan_table[slot].bus, scan_table[slot].addr);
+		UART0_OutString(buf);
+	}
+}
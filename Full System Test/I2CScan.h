@@ -0,0 +1,66 @@
+/*
+ * I2CScan.h
+ *
+ *	Provides the boot-time bus scan. Every address is probed once, the
+ *	slaves that answer go into a device table, and each driver binds
+ *	its descriptor to whichever of its possible addresses was found
+ *	instead of relying on a compile-time strapping choice
+ *
+ * Created on: October 17th, 2026
+ *
+ */
+
+#ifndef I2CSCAN_H_
+#define I2CSCAN_H_
+
+#include <stdint.h>
+#include "I2C.h"
+
+/* List of Macros */
+#define I2C_SCAN_FIRST      0x08        // 0x00-0x07 and 0x78-0x7F are reserved
+#define I2C_SCAN_LAST       0x77
+#define I2C_SCAN_MAX        16          // Slaves remembered across all buses
+
+/* Device Table Entry */
+typedef struct{
+	uint8_t bus;												// Module number
+	uint8_t addr;												// 7-bit address that ACKed
+	const I2C_DEVICE_t* dev;						// Driver bound to it, 0 while unknown
+} I2C_SCAN_ENTRY_t;
+
+/*
+ *	---------------------I2C_Scan---------------------
+ *	Probes every address in a range and adds the slaves that answer to
+ *	the device table, forgetting what an earlier scan of this bus found.
+ *	Run it at the bus speed the devices will use, I2C_Init first
+ *	Input: Bus Handle, First and last 7-bit address
+ *	Output: Number of slaves found on this bus
+ */
+uint8_t I2C_Scan(I2C_BUS_t* bus, uint8_t first, uint8_t last);
+
+/*
+ *	-------------------I2C_Scan_Bind------------------
+ *	Points a driver descriptor at the first of its addresses (addr,
+ *	then alt_addr in order) the scan found and not bound to another
+ *	driver. The descriptor is left alone when none was found
+ *	Input: Bus Handle, Descriptor to bind
+ *	Output: I2C_OK if bound, I2C_MCS_ADRACK if no address answered
+ */
+uint8_t I2C_Scan_Bind(I2C_BUS_t* bus, I2C_DEVICE_t* dev);
+
+/*
+ *	-------------------I2C_Scan_Get-------------------
+ *	Input: Table slot (0 to I2C_SCAN_MAX-1), Entry to fill
+ *	Output: 1 if the slot holds a device, 0 if it is unused
+ */
+uint8_t I2C_Scan_Get(uint8_t slot, I2C_SCAN_ENTRY_t* entry);
+
+/*
+ *	------------------I2C_Scan_Print------------------
+ *	Prints the device table and the time the last scan took on UART0
+ *	Input: None
+ *	Output: None
+ */
+void I2C_Scan_Print(void);
+
+#endif //I2CSCAN_H_
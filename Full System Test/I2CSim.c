@@ -0,0 +1,1097 @@
+/*
+ * I2CSim.c
+ *
+ *	Main implementation of the simulated I2C peripheral for host builds
+ *
+ * Created on: October 17th, 2026
+ *
+ */
+
+#ifdef I2C_SIM
+
+#include "EEPROM.h"
+#include "I2C.h"
+#include "I2CSim.h"
+#include "UART0.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SIM_REG_WORDS       (0x1000 / 4)  // One module register block
+#define SIM_GPIO_WORDS      (0x530 / 4)   // Up to GPIOPCTL
+#define SIM_GPIO_PORTS      6             // A - F
+#define SIM_MCS_MARK        0x80000000UL  // Set in MCS when the driver has not written it
+#define SIM_MCS_CMD_M       0x1F          // RUN|START|STOP|ACK|HS
+#define SIM_MTPR_RESET      0x01
+#define SIM_MMIS_OFFSET     0x018         // Masked status, drives the simulated interrupt
+#define SIM_SRIS_OFFSET     0x810         // Slave raw interrupt status
+#define SIM_REG_MARK        0x80000000UL  // Set in SCSR and SDR when the driver has not written them
+#define SIM_HELD            (~(uint64_t)0)  // done_at of a command waiting on the own slave
+#define SIM_IDLE_SPIN       1000          // Cycles a spin runs when nothing is scheduled
+#define SIM_POLL_STEP       1000          // Longest jump of a polling loop, its deadline checks still run
+#define SIM_STUCK_CYCLES    I2C_SIM_SYSCLK_HZ   // A command on a bus held by SDA waits 1 s, past any deadline
+#define SIM_NO_PORT         0xFF
+
+/* Module interrupts from the vector table in startup.s */
+void I2C0_Handler(void);
+void I2C1_Handler(void);
+void I2C2_Handler(void);
+void I2C3_Handler(void);
+
+static void (* const sim_handlers[I2C_SIM_MODULES])(void) = {
+	I2C0_Handler, I2C1_Handler, I2C2_Handler, I2C3_Handler
+};
+static const uint8_t sim_irqs[I2C_SIM_MODULES] = {8, 37, 68, 69};
+static const uint8_t sim_gpio_irqs[SIM_GPIO_PORTS] = {0, 1, 2, 3, 4, 30};
+
+/* SCL/SDA of each module, the pin mux of I2C.c */
+static const struct{
+	uint32_t gpio_base;
+	uint8_t scl;
+	uint8_t sda;
+} sim_pins[I2C_SIM_MODULES] = {
+	{GPIOB_BASE_ADDR, 0x04, 0x08}, {GPIOA_BASE_ADDR, 0x40, 0x80},
+	{GPIOE_BASE_ADDR, 0x10, 0x20}, {GPIOD_BASE_ADDR, 0x01, 0x02}
+};
+
+/* One Simulated Module */
+typedef struct{
+	volatile unsigned long regs[SIM_REG_WORDS];
+	I2C_SIM_DEV_t* devs;								// Attached models
+	I2C_SIM_DEV_t* target;							// Model addressed in the open transaction, 0 if none answered
+	uint8_t open;												// START sent, no STOP yet
+	uint8_t read;												// Direction of the open transaction
+	uint8_t status;											// Error bits of the last command
+	uint8_t rx;													// Byte that lands in MDR when the command ends
+	uint64_t done_at;										// End of the command in flight, 0 when idle
+	uint8_t stuck;											// SCL pulses until a stuck slave lets SDA go, 0 if none
+	I2C_SIM_STATS_t stats;
+
+	/* Own slave function (MCR SFE, SCSR DA), the master reaches it on
+		 the bus and, with MCR LPBK, only it. SCL is held while it has a
+		 byte to give (TREQ) or has not taken the last one (RREQ) */
+	I2C_SIM_DEV_t slave;
+	uint8_t slave_on;										// DA written
+	uint8_t slave_first;								// Next byte in is the first after the address
+	uint8_t slave_pending;							// Byte in while SDR still held the last one
+	uint8_t held;												// Command waits on the slave: SIM_HOLD_TX or SIM_HOLD_RX
+	uint8_t held_stop;									// Held command ends with a STOP
+	uint8_t sdr_touched;								// SDR accessed since the last catch up
+	unsigned long scsr;									// Status SCSR reads
+	uint64_t held_since;								// Time the command started to wait
+	uint64_t held_cycles;								// Wire time left once the slave is done
+} SIM_BUS_t;
+
+#define SIM_HOLD_TX         1             // Slave has to write SDR
+#define SIM_HOLD_RX         2             // Slave has to read SDR
+
+static SIM_BUS_t sim_bus[I2C_SIM_MODULES];
+static volatile unsigned long sim_gpio[SIM_GPIO_PORTS][SIM_GPIO_WORDS];
+static uint8_t sim_gpio_low[SIM_GPIO_PORTS];		// Inputs a part pulls low
+static uint8_t sim_gpio_out[SIM_GPIO_PORTS];		// DATA output latch
+static uint8_t sim_data_port = SIM_NO_PORT;		// Port whose DATA sim_scratch holds
+static uint8_t sim_data_mask;									// Pins of that DATA access
+static unsigned long sim_data_level;						// What sim_scratch was handed out as
+static void (*sim_gpio_handlers[SIM_GPIO_PORTS])(void);
+static volatile unsigned long sim_scratch;
+static volatile unsigned long* sim_poll;		// Register of the last I2CSim_Reg access
+static uint64_t sim_now;
+static uint32_t sim_sysclk = I2C_SIM_SYSCLK_HZ;		// What SYSCLK_Get_Hz reports
+static long sim_primask;
+static uint8_t sim_in_irq;
+
+volatile unsigned long I2CSim_Sysctl[5];
+volatile unsigned long I2CSim_Nvic_Pri[32];
+volatile unsigned long I2CSim_Nvic_En[4];
+volatile uint32_t I2CSim_Dwt[2];
+
+#define SIM_REG(m, off)     (sim_bus[m].regs[(off) / 4])
+#define SIM_GPIO(p, off)    (sim_gpio[p][(off) / 4])
+
+/*
+ *	--------------------Sim_Port----------------------
+ *	Local function mapping a GPIO base address to its port
+ *	Input: GPIO port base address (APB)
+ *	Output: Port number, A is 0
+ */
+static uint8_t Sim_Port(uint32_t base){
+
+	uint8_t port = (base >= GPIOE_BASE_ADDR) ? 4 + ((base - GPIOE_BASE_ADDR) >> 12) : (base - GPIOA_BASE_ADDR) >> 12;
+
+	return port % SIM_GPIO_PORTS;
+}
+
+/*
+ *	-------------------Sim_Module---------------------
+ *	Local function mapping a register block address to its module
+ *	Input: Module base address
+ *	Output: Module number
+ */
+static uint8_t Sim_Module(uint32_t base){
+	return (base >> 12) & (I2C_SIM_MODULES - 1);
+}
+
+/*
+ *	-------------------Sim_Status---------------------
+ *	Local function building what MCS reads as right now
+ *	Input: Module number
+ *	Output: MCS status bits
+ */
+static unsigned long Sim_Status(uint8_t m){
+
+	SIM_BUS_t* bus = &sim_bus[m];
+
+	if(bus->done_at != 0)
+		return I2C_MCS_BUSY | I2C_MCS_BUSBSY;
+
+	return bus->status | (bus->open ? I2C_MCS_BUSBSY : I2C_MCS_IDLE);
+}
+
+/*
+ *	-----------------Sim_Module_Reset-----------------
+ *	Local function putting a module back to its reset state, the
+ *	attached models see the bus go away like a STOP
+ *	Input: Module number
+ *	Output: None
+ */
+static void Sim_Module_Reset(uint8_t m){
+
+	SIM_BUS_t* bus = &sim_bus[m];
+
+	if(bus->target != 0 && bus->target->stop != 0)
+		bus->target->stop(bus->target);
+
+	memset((void*)bus->regs, 0, sizeof(bus->regs));
+	SIM_REG(m, I2C_MTPR_OFFSET) = SIM_MTPR_RESET;
+	SIM_REG(m, I2C_SCSR_OFFSET) = SIM_REG_MARK;
+	SIM_REG(m, I2C_SDR_OFFSET) = SIM_REG_MARK;
+	bus->target = 0;
+	bus->open = 0;
+	bus->status = 0;
+	bus->done_at = 0;
+	bus->slave_on = 0;
+	bus->held = 0;
+	bus->held_stop = 0;
+	bus->sdr_touched = 0;
+	bus->scsr = 0;
+	SIM_REG(m, I2C_MCS_OFFSET) = Sim_Status(m) | SIM_MCS_MARK;
+}
+
+/*
+ *	-------------------Sim_Find-----------------------
+ *	Local function looking up the model answering an address
+ *	Input: Module number, 7-bit address
+ *	Output: Model, 0 if nothing answers
+ */
+static I2C_SIM_DEV_t* Sim_Find(uint8_t m, uint8_t addr){
+
+	SIM_BUS_t* bus = &sim_bus[m];
+	I2C_SIM_DEV_t* dev;
+
+	if((SIM_REG(m, I2C_MCR_OFFSET) & I2C_MCR_SFE) && bus->slave_on && (SIM_REG(m, I2C_SOAR_OFFSET) & I2C_SOAR_OAR_M) == addr)
+		return &bus->slave;
+
+	/* Loopback wires the master to its own slave only */
+	if(SIM_REG(m, I2C_MCR_OFFSET) & I2C_MCR_LPBK)
+		return 0;
+
+	for(dev = bus->devs; dev != 0; dev = dev->next){
+		if(dev->addr == addr)
+			return dev;
+	}
+
+	return 0;
+}
+
+/*
+ *	-------------------Sim_Command--------------------
+ *	Local function running one MCS command against the models. The
+ *	models see the bytes right away, the driver sees the result once
+ *	the command has had its time on the wire. A (repeated) START and a
+ *	STOP take one SCL period each, every byte 8 bits plus the ACK
+ *	Input: Module number, MCS command bits
+ *	Output: None
+ */
+static void Sim_Command(uint8_t m, uint8_t cmd){
+
+	SIM_BUS_t* bus = &sim_bus[m];
+	uint64_t bit = 2 * I2C_SCL_LP_HP * (uint64_t)((SIM_REG(m, I2C_MTPR_OFFSET) & I2C_MTPR_TPR_M) + 1);
+	uint32_t clocks = 0;
+	uint64_t stretch = 0;
+	uint64_t cycles;
+	uint8_t addr;
+
+	/* Controller off or a command written while busy, the hardware ignores it */
+	if(!(SIM_REG(m, I2C_MCR_OFFSET) & EN_I2C_MASTER) || bus->done_at != 0)
+		return;
+
+	/* A part holding SDA low keeps the bus busy, nothing goes on the wire */
+	if(sim_gpio_low[Sim_Port(sim_pins[m].gpio_base)] & sim_pins[m].sda){
+		bus->status = I2C_MCS_ERROR | I2C_MCS_ARBLST;
+		bus->done_at = sim_now + SIM_STUCK_CYCLES;
+		return;
+	}
+
+	/* No transaction open and no START: a STOP or RUN on an idle bus puts
+	   nothing on the wire, the command does not complete or interrupt */
+	if(!bus->open && !((cmd & I2C_MCS_START) && (cmd & I2C_MCS_RUN))){
+		bus->stats.idle_cmds++;
+		return;
+	}
+
+	bus->status = 0;
+
+	/* Address phase, a START on an open transaction is a repeated START */
+	if((cmd & I2C_MCS_START) && (cmd & I2C_MCS_RUN)){
+		if(!bus->open)
+			bus->stats.transactions++;
+		else
+			bus->stats.restarts++;
+		bus->open = 1;
+		addr = (SIM_REG(m, I2C_MSA_OFFSET) >> 1) & 0x7F;
+		bus->read = SIM_REG(m, I2C_MSA_OFFSET) & 0x01;
+		bus->target = Sim_Find(m, addr);
+		bus->stats.bytes++;
+		bus->stats.addr_bytes++;
+		clocks += 1 + I2C_BITS_PER_BYTE;
+
+		if(bus->target == 0 || !bus->target->start(bus->target, bus->read)){
+			bus->target = 0;
+			bus->status = I2C_MCS_ERROR | I2C_MCS_ADRACK;
+			bus->stats.nacks++;
+		}
+		else{
+			stretch += bus->target->stretch_cycles;
+		}
+	}
+
+	/* Data phase */
+	if(bus->status == 0 && (cmd & I2C_MCS_RUN) && bus->open && bus->target != 0){
+		bus->stats.bytes++;
+		clocks += I2C_BITS_PER_BYTE;
+		stretch += bus->target->stretch_cycles;
+
+		if(bus->read){
+			bus->rx = bus->target->read(bus->target);
+			bus->target->bytes_out++;
+		}
+		else if(bus->target->write(bus->target, SIM_REG(m, I2C_MDR_OFFSET) & I2C_MDR_DATA_M)){
+			bus->target->bytes_in++;
+		}
+		else{
+			bus->status = I2C_MCS_ERROR | I2C_MCS_DATACK;
+			bus->stats.nacks++;
+		}
+	}
+
+	/* STOP goes out after a NACK too when the command asked for it */
+	if((cmd & I2C_MCS_STOP) && bus->open){
+		bus->stats.stops++;
+		clocks += 1;
+		bus->open = 0;
+		if(bus->target != 0 && bus->target->stop != 0)
+			bus->target->stop(bus->target);
+		bus->target = 0;
+	}
+
+	cycles = clocks * bit + stretch;
+	if(cycles == 0)
+		cycles = 1;
+	bus->done_at = sim_now + cycles;
+	bus->stats.scl_clocks += clocks;
+	bus->stats.busy_cycles += cycles;
+
+	/* Own slave stretching SCL, the wire time starts once it is done */
+	if(bus->held){
+		bus->done_at = SIM_HELD;
+		bus->held_since = sim_now;
+		bus->held_cycles = cycles;
+	}
+}
+
+/* ---------------------------------------------------------------- */
+/* Own slave function, the device hooks the master sees it through   */
+/* ---------------------------------------------------------------- */
+
+static SIM_BUS_t* Sim_Slave_Bus(I2C_SIM_DEV_t* dev){
+	return (SIM_BUS_t*)((char*)dev - offsetof(SIM_BUS_t, slave));
+}
+
+/*
+ *	----------------Sim_Slave_Deliver----------------
+ *	Local function handing a byte from the master to the slave: SDR,
+ *	RREQ (FBR for the first one after the address) and DATARIS
+ *	Input: Bus, Byte
+ *	Output: None
+ */
+static void Sim_Slave_Deliver(SIM_BUS_t* bus, uint8_t byte){
+
+	bus->regs[I2C_SDR_OFFSET / 4] = byte | SIM_REG_MARK;
+	bus->scsr = (bus->scsr & ~I2C_SCSR_FBR) | I2C_SCSR_RREQ | (bus->slave_first ? I2C_SCSR_FBR : 0);
+	bus->slave_first = 0;
+	bus->regs[SIM_SRIS_OFFSET / 4] |= I2C_SRIS_DATARIS;
+}
+
+static uint8_t Sim_Slave_Start(I2C_SIM_DEV_t* dev, uint8_t read){
+
+	SIM_BUS_t* bus = Sim_Slave_Bus(dev);
+
+	bus->slave_first = !read;
+	bus->regs[SIM_SRIS_OFFSET / 4] |= I2C_SRIS_STARTRIS;
+
+	return 1;
+}
+
+/* The byte waits in the master if the slave has not read the last one */
+static uint8_t Sim_Slave_Write(I2C_SIM_DEV_t* dev, uint8_t byte){
+
+	SIM_BUS_t* bus = Sim_Slave_Bus(dev);
+
+	if(bus->scsr & I2C_SCSR_RREQ){
+		bus->slave_pending = byte;
+		bus->held = SIM_HOLD_RX;
+	}
+	else{
+		Sim_Slave_Deliver(bus, byte);
+	}
+
+	return 1;
+}
+
+/* The byte comes from SDR once the slave has written it */
+static uint8_t Sim_Slave_Read(I2C_SIM_DEV_t* dev){
+
+	SIM_BUS_t* bus = Sim_Slave_Bus(dev);
+
+	bus->scsr |= I2C_SCSR_TREQ;
+	bus->regs[SIM_SRIS_OFFSET / 4] |= I2C_SRIS_DATARIS;
+	bus->held = SIM_HOLD_TX;
+
+	return 0;
+}
+
+static void Sim_Slave_Stop(I2C_SIM_DEV_t* dev){
+
+	SIM_BUS_t* bus = Sim_Slave_Bus(dev);
+
+	/* The STOP follows the byte the slave is holding up */
+	if(bus->held){
+		bus->held_stop = 1;
+		return;
+	}
+
+	bus->scsr &= ~I2C_SCSR_TREQ;
+	bus->regs[SIM_SRIS_OFFSET / 4] |= I2C_SRIS_STOPRIS;
+}
+
+/*
+ *	----------------Sim_Slave_Writes-----------------
+ *	Local function acting on what the slave side driver did: DA
+ *	written to SCSR, SDR written (TREQ) or read (RREQ), interrupts
+ *	cleared. A command the slave held starts its wire time
+ *	Input: Module number
+ *	Output: None
+ */
+static void Sim_Slave_Writes(uint8_t m){
+
+	SIM_BUS_t* bus = &sim_bus[m];
+	unsigned long value;
+	uint8_t released = 0;
+
+	value = SIM_REG(m, I2C_SCSR_OFFSET);
+	if(!(value & SIM_REG_MARK))
+		bus->slave_on = value & I2C_SCSR_DA;
+
+	value = SIM_REG(m, I2C_SDR_OFFSET);
+	if(!(value & SIM_REG_MARK)){
+		if(bus->scsr & I2C_SCSR_TREQ){
+			bus->scsr &= ~I2C_SCSR_TREQ;
+			bus->rx = value & I2C_MDR_DATA_M;
+			released = (bus->held == SIM_HOLD_TX);
+		}
+		SIM_REG(m, I2C_SDR_OFFSET) = (value & I2C_MDR_DATA_M) | SIM_REG_MARK;
+	}
+	else if(bus->sdr_touched && (bus->scsr & I2C_SCSR_RREQ)){
+		bus->scsr &= ~(I2C_SCSR_RREQ | I2C_SCSR_FBR);
+		if(bus->held == SIM_HOLD_RX){
+			Sim_Slave_Deliver(bus, bus->slave_pending);
+			released = 1;
+		}
+	}
+	bus->sdr_touched = 0;
+
+	if(released){
+		bus->held = 0;
+		bus->done_at = sim_now + bus->held_cycles;
+		bus->stats.busy_cycles += sim_now - bus->held_since;
+		if(bus->held_stop){
+			bus->held_stop = 0;
+			Sim_Slave_Stop(&bus->slave);
+		}
+	}
+
+	value = SIM_REG(m, I2C_SICR_OFFSET);
+	if(value != 0){
+		SIM_REG(m, SIM_SRIS_OFFSET) &= ~value;
+		SIM_REG(m, I2C_SICR_OFFSET) = 0;
+	}
+
+	SIM_REG(m, I2C_SCSR_OFFSET) = bus->scsr | SIM_REG_MARK;
+	SIM_REG(m, I2C_SMIS_OFFSET) = SIM_REG(m, SIM_SRIS_OFFSET) & SIM_REG(m, I2C_SIMR_OFFSET);
+}
+
+/*
+ *	-------------------Sim_Writes---------------------
+ *	Local function acting on what the driver wrote since the last
+ *	access: module resets, interrupt clears and MCS commands
+ *	Input: None
+ *	Output: None
+ */
+static void Sim_Writes(void){
+
+	uint8_t m;
+	unsigned long value;
+
+	for(m = 0; m < I2C_SIM_MODULES; m++){
+
+		if(I2CSim_Sysctl[2] & (1UL << m))
+			Sim_Module_Reset(m);
+
+		value = SIM_REG(m, I2C_MICR_OFFSET);
+		if(value != 0){
+			SIM_REG(m, I2C_MRIS_OFFSET) &= ~value;
+			SIM_REG(m, I2C_MICR_OFFSET) = 0;
+		}
+
+		value = SIM_REG(m, I2C_MCS_OFFSET);
+		if(!(value & SIM_MCS_MARK))
+			Sim_Command(m, value & SIM_MCS_CMD_M);
+		Sim_Slave_Writes(m);
+
+		SIM_REG(m, I2C_MCS_OFFSET) = Sim_Status(m) | SIM_MCS_MARK;
+		SIM_REG(m, SIM_MMIS_OFFSET) = SIM_REG(m, I2C_MRIS_OFFSET) & SIM_REG(m, I2C_MIMR_OFFSET);
+	}
+}
+
+/*
+ *	-------------------Sim_Complete-------------------
+ *	Local function ending every command due by now
+ *	Input: None
+ *	Output: 1 if a command ended
+ */
+static uint8_t Sim_Complete(void){
+
+	uint8_t m;
+	uint8_t completed = 0;
+	SIM_BUS_t* bus;
+
+	for(m = 0; m < I2C_SIM_MODULES; m++){
+		bus = &sim_bus[m];
+		if(bus->done_at == 0 || bus->done_at > sim_now)
+			continue;
+
+		bus->done_at = 0;
+		if(bus->read && bus->status == 0)
+			SIM_REG(m, I2C_MDR_OFFSET) = bus->rx;
+		SIM_REG(m, I2C_MRIS_OFFSET) |= I2C_MRIS_RIS;
+		completed = 1;
+	}
+
+	return completed;
+}
+
+/*
+ *	---------------------Sim_Wake---------------------
+ *	Local function letting models whose time has come change
+ *	Input: None
+ *	Output: None
+ */
+static void Sim_Wake(void){
+
+	uint8_t m;
+	I2C_SIM_DEV_t* dev;
+
+	for(m = 0; m < I2C_SIM_MODULES; m++){
+		for(dev = sim_bus[m].devs; dev != 0; dev = dev->next){
+			if(dev->wake != 0 && dev->wake_at != 0 && dev->wake_at <= sim_now)
+				dev->wake(dev);
+		}
+	}
+}
+
+/*
+ *	------------------Sim_Gpio_Level------------------
+ *	Local function giving the lines of a port: high unless a part
+ *	pulls them low or they are GPIO outputs driven low
+ *	Input: Port number
+ *	Output: Pin levels
+ */
+static uint8_t Sim_Gpio_Level(uint8_t p){
+
+	uint8_t driven = SIM_GPIO(p, GPIO_DIR_OFFSET) & ~SIM_GPIO(p, GPIO_AFSEL_OFFSET);
+
+	return ~(sim_gpio_low[p] | (driven & ~sim_gpio_out[p]));
+}
+
+/*
+ *	------------------Sim_Gpio_Latch------------------
+ *	Local function taking in a DATA write. A write that changed the
+ *	value handed out goes to the output latch. SCL pulses on the pins
+ *	of a module count towards freeing a stuck slave
+ *	Input: None
+ *	Output: None
+ */
+static void Sim_Gpio_Latch(void){
+
+	uint8_t p = sim_data_port;
+	uint8_t before, rose;
+	uint8_t m;
+
+	sim_data_port = SIM_NO_PORT;
+	if(p == SIM_NO_PORT || sim_scratch == sim_data_level)
+		return;
+
+	before = Sim_Gpio_Level(p);
+	sim_gpio_out[p] = (sim_gpio_out[p] & ~sim_data_mask) | (sim_scratch & sim_data_mask);
+	rose = ~before & Sim_Gpio_Level(p);
+
+	for(m = 0; m < I2C_SIM_MODULES; m++){
+		if(Sim_Port(sim_pins[m].gpio_base) != p || !(rose & sim_pins[m].scl))
+			continue;
+		sim_bus[m].stats.gpio_clocks++;
+		if(sim_bus[m].stuck != 0 && --sim_bus[m].stuck == 0)
+			I2CSim_Drive_Pin(sim_pins[m].gpio_base, sim_pins[m].sda, 0);
+	}
+}
+
+/*
+ *	-----------------Sim_Gpio_Update------------------
+ *	Local function taking in ICR writes and level sensitive inputs,
+ *	MIS follows RIS and IM
+ *	Input: None
+ *	Output: None
+ */
+static void Sim_Gpio_Update(void){
+
+	uint8_t p;
+	unsigned long level;
+	unsigned long high;
+
+	for(p = 0; p < SIM_GPIO_PORTS; p++){
+		SIM_GPIO(p, GPIO_RIS_OFFSET) &= ~SIM_GPIO(p, GPIO_ICR_OFFSET);
+		SIM_GPIO(p, GPIO_ICR_OFFSET) = 0;
+
+		/* Level sensitive pins follow the line, raised while at the IEV level */
+		level = SIM_GPIO(p, GPIO_IS_OFFSET) & 0xFF;
+		high = ~(unsigned long)sim_gpio_low[p];
+		SIM_GPIO(p, GPIO_RIS_OFFSET) = (SIM_GPIO(p, GPIO_RIS_OFFSET) & ~level)
+			| (level & ((high & SIM_GPIO(p, GPIO_IEV_OFFSET)) | (~high & ~SIM_GPIO(p, GPIO_IEV_OFFSET))));
+		SIM_GPIO(p, GPIO_MIS_OFFSET) = SIM_GPIO(p, GPIO_RIS_OFFSET) & SIM_GPIO(p, GPIO_IM_OFFSET);
+	}
+}
+
+/*
+ *	-------------------Sim_Catch_Up-------------------
+ *	Local function bringing the peripheral up to the current time and
+ *	running any interrupt that is due and not masked. A handler gets
+ *	the module to itself, nothing nests at the same priority
+ *	Input: None
+ *	Output: None
+ */
+static void Sim_Catch_Up(void){
+
+	uint8_t m;
+	uint8_t irq;
+	uint8_t deliveries = 0;
+	uint8_t fired;
+
+	Sim_Gpio_Latch();
+
+	do{
+		fired = 0;
+		Sim_Writes();
+		if(Sim_Complete())
+			Sim_Writes();
+		Sim_Wake();
+		Sim_Gpio_Update();
+
+		if(sim_primask || sim_in_irq)
+			return;
+
+		for(m = 0; m < I2C_SIM_MODULES; m++){
+			irq = sim_irqs[m];
+			if(!(SIM_REG(m, SIM_MMIS_OFFSET) & I2C_MRIS_RIS) && SIM_REG(m, I2C_SMIS_OFFSET) == 0)
+				continue;
+			if(!(I2CSim_Nvic_En[irq >> 5] & (1UL << (irq & 0x1F))))
+				continue;
+
+			sim_in_irq = 1;
+			sim_handlers[m]();
+			sim_in_irq = 0;
+			fired = 1;
+		}
+
+		for(m = 0; m < SIM_GPIO_PORTS; m++){
+			irq = sim_gpio_irqs[m];
+			if(!SIM_GPIO(m, GPIO_MIS_OFFSET) || sim_gpio_handlers[m] == 0)
+				continue;
+			if(!(I2CSim_Nvic_En[irq >> 5] & (1UL << (irq & 0x1F))))
+				continue;
+
+			sim_in_irq = 1;
+			sim_gpio_handlers[m]();
+			sim_in_irq = 0;
+			fired = 1;
+			Sim_Gpio_Update();
+		}
+	} while(fired && ++deliveries < I2C_SIM_IRQ_MAX);
+}
+
+/*
+ *	-------------------Sim_Next_Event-----------------
+ *	Local function finding the next command completion
+ *	Input: None
+ *	Output: Time of the next completion, 0 if nothing is in flight
+ */
+static uint64_t Sim_Next_Event(void){
+
+	uint8_t m;
+	uint64_t next = 0;
+	I2C_SIM_DEV_t* dev;
+
+	for(m = 0; m < I2C_SIM_MODULES; m++){
+		if(sim_bus[m].done_at != 0 && sim_bus[m].done_at != SIM_HELD && (next == 0 || sim_bus[m].done_at < next))
+			next = sim_bus[m].done_at;
+		for(dev = sim_bus[m].devs; dev != 0; dev = dev->next){
+			if(dev->wake != 0 && dev->wake_at != 0 && (next == 0 || dev->wake_at < next))
+				next = dev->wake_at;
+		}
+	}
+
+	return next;
+}
+
+/*
+ *	------------------I2CSim_Reset-------------------
+ *	Detaches every model, clears the registers and counters and sets
+ *	simulated time back to 0
+ *	Input: None
+ *	Output: None
+ */
+void I2CSim_Reset(void){
+
+	uint8_t m;
+
+	sim_now = 0;
+	sim_sysclk = I2C_SIM_SYSCLK_HZ;
+	sim_primask = 0;
+	sim_in_irq = 0;
+	memset((void*)I2CSim_Sysctl, 0, sizeof(I2CSim_Sysctl));
+	memset((void*)I2CSim_Nvic_Pri, 0, sizeof(I2CSim_Nvic_Pri));
+	memset((void*)I2CSim_Nvic_En, 0, sizeof(I2CSim_Nvic_En));
+	memset((void*)sim_gpio, 0, sizeof(sim_gpio));
+	memset(sim_gpio_low, 0, sizeof(sim_gpio_low));
+	memset(sim_gpio_out, 0, sizeof(sim_gpio_out));
+	sim_data_port = SIM_NO_PORT;
+	memset(sim_gpio_handlers, 0, sizeof(sim_gpio_handlers));
+
+	for(m = 0; m < I2C_SIM_MODULES; m++){
+		sim_bus[m].devs = 0;
+		sim_bus[m].target = 0;
+		sim_bus[m].stuck = 0;
+		memset(&sim_bus[m].slave, 0, sizeof(sim_bus[m].slave));
+		sim_bus[m].slave.name = "own slave";
+		sim_bus[m].slave.start = Sim_Slave_Start;
+		sim_bus[m].slave.write = Sim_Slave_Write;
+		sim_bus[m].slave.read = Sim_Slave_Read;
+		sim_bus[m].slave.stop = Sim_Slave_Stop;
+		Sim_Module_Reset(m);
+		memset(&sim_bus[m].stats, 0, sizeof(sim_bus[m].stats));
+	}
+
+	/* Peripherals report ready as soon as they are clocked */
+	I2CSim_Sysctl[1] = ~0UL;
+	I2CSim_Sysctl[4] = ~0UL;
+}
+
+/*
+ *	------------------I2CSim_Attach------------------
+ *	Input: Module number (0-3), Device model
+ *	Output: None
+ */
+void I2CSim_Attach(uint8_t module, I2C_SIM_DEV_t* dev){
+
+	dev->next = sim_bus[module].devs;
+	sim_bus[module].devs = dev;
+}
+
+/*
+ *	------------------I2CSim_Detach------------------
+ *	Input: Module number (0-3), Device model
+ *	Output: None
+ */
+void I2CSim_Detach(uint8_t module, I2C_SIM_DEV_t* dev){
+
+	I2C_SIM_DEV_t** link;
+
+	for(link = &sim_bus[module].devs; *link != 0; link = &(*link)->next){
+		if(*link == dev){
+			*link = dev->next;
+			break;
+		}
+	}
+
+	if(sim_bus[module].target == dev)
+		sim_bus[module].target = 0;
+}
+
+/*
+ *	------------------I2CSim_Cycles------------------
+ *	Input: None
+ *	Output: Simulated core clock cycles, wraps like DWT CYCCNT
+ */
+uint32_t I2CSim_Cycles(void){
+
+	sim_now += I2C_SIM_CNT_CYCLES;
+	Sim_Catch_Up();
+
+	return (uint32_t)sim_now;
+}
+
+/*
+ *	------------------I2CSim_Now---------------------
+ *	Input: None
+ *	Output: Simulated time in core clock cycles
+ */
+uint64_t I2CSim_Now(void){
+	return sim_now;
+}
+
+/*
+ *	-----------------I2CSim_Advance------------------
+ *	Lets simulated time run, one bus event at a time
+ *	Input: Cycles to run
+ *	Output: None
+ */
+void I2CSim_Advance(uint64_t cycles){
+
+	uint64_t end = sim_now + cycles;
+	uint64_t next;
+
+	Sim_Catch_Up();
+
+	for(;;){
+		next = Sim_Next_Event();
+		if(next == 0 || next > end)
+			break;
+		sim_now = next;
+		Sim_Catch_Up();
+	}
+
+	/* Handlers that ran on the way may already have taken it past the end */
+	if(sim_now < end)
+		sim_now = end;
+	Sim_Catch_Up();
+}
+
+/*
+ *	-------------------I2CSim_Spin-------------------
+ *	Runs time to the next bus event like WFI would
+ *	Input: None
+ *	Output: None
+ */
+void I2CSim_Spin(void){
+
+	uint64_t next = Sim_Next_Event();
+
+	if(next > sim_now)
+		I2CSim_Advance(next - sim_now);
+	else
+		I2CSim_Advance(SIM_IDLE_SPIN);
+}
+
+/*
+ *	--------------------I2CSim_Reg-------------------
+ *	Polling MCS skips ahead to the end of the command, other accesses
+ *	in between (the cycle counter aside) keep the poll cycle by cycle
+ *	Input: Module base address, Register offset
+ *	Output: Register storage
+ */
+volatile unsigned long* I2CSim_Reg(uint32_t base, uint32_t offset){
+
+	uint8_t m = Sim_Module(base);
+	uint32_t reg = (offset & 0xFFF) / 4;
+
+	sim_now += I2C_SIM_REG_CYCLES;
+	Sim_Catch_Up();
+
+	/* Second MCS read in a row on a busy module is a polling loop, the
+		 loop would see the same status until the command ends. Time moves
+		 in steps so a loop with a deadline still gets to time out */
+	if(reg == I2C_MCS_OFFSET / 4 && sim_poll == &sim_bus[m].regs[reg] && sim_bus[m].done_at > sim_now)
+		I2CSim_Advance(sim_bus[m].done_at - sim_now < SIM_POLL_STEP ? sim_bus[m].done_at - sim_now : SIM_POLL_STEP);
+	sim_poll = &sim_bus[m].regs[reg];
+	if(reg == I2C_SDR_OFFSET / 4)
+		sim_bus[m].sdr_touched = 1;
+
+	return sim_poll;
+}
+
+/*
+ *	----------------I2CSim_Sysctl_Reg----------------
+ *	Input: Index into I2CSim_Sysctl
+ *	Output: Register storage
+ */
+volatile unsigned long* I2CSim_Sysctl_Reg(uint8_t reg){
+
+	sim_now += I2C_SIM_REG_CYCLES;
+	Sim_Catch_Up();
+
+	return &I2CSim_Sysctl[reg];
+}
+
+/*
+ *	-------------------I2CSim_Gpio-------------------
+ *	Input: GPIO port base address, Register offset
+ *	Output: Register storage
+ */
+volatile unsigned long* I2CSim_Gpio(uint32_t base, uint32_t offset){
+
+	uint8_t port = Sim_Port(base);
+
+	sim_now += I2C_SIM_REG_CYCLES;
+	sim_poll = 0;
+	Sim_Catch_Up();
+
+	/* DATA through the address mask, what comes back is checked for a write later */
+	if(offset <= GPIO_DATA_OFFSET){
+		sim_data_port = port;
+		sim_data_mask = (offset >> 2) & 0xFF;
+		sim_data_level = sim_data_mask & Sim_Gpio_Level(port);
+		sim_scratch = sim_data_level;
+		return &sim_scratch;
+	}
+
+	return &sim_gpio[port][(offset / 4) % SIM_GPIO_WORDS];
+}
+
+/*
+ *	---------------I2CSim_Drive_Pin------------------
+ *	Input: GPIO port base address, Pin mask, 1 to pull low
+ *	Output: None
+ */
+void I2CSim_Drive_Pin(uint32_t base, uint8_t pins, uint8_t low){
+
+	uint8_t port = Sim_Port(base);
+	uint8_t was = sim_gpio_low[port];
+	uint8_t edge_pins = pins & ~SIM_GPIO(port, GPIO_IS_OFFSET);
+	uint8_t fell, rose;
+
+	if(low)
+		sim_gpio_low[port] |= pins;
+	else
+		sim_gpio_low[port] &= ~pins;
+
+	fell = sim_gpio_low[port] & ~was & edge_pins;
+	rose = was & ~sim_gpio_low[port] & edge_pins;
+
+	/* Both edges, else rising where IEV is set and falling where it is clear */
+	SIM_GPIO(port, GPIO_RIS_OFFSET) |= (fell | rose) & SIM_GPIO(port, GPIO_IBE_OFFSET);
+	SIM_GPIO(port, GPIO_RIS_OFFSET) |= rose & SIM_GPIO(port, GPIO_IEV_OFFSET);
+	SIM_GPIO(port, GPIO_RIS_OFFSET) |= fell & ~SIM_GPIO(port, GPIO_IEV_OFFSET);
+	SIM_GPIO(port, GPIO_MIS_OFFSET) = SIM_GPIO(port, GPIO_RIS_OFFSET) & SIM_GPIO(port, GPIO_IM_OFFSET);
+}
+
+/*
+ *	----------------I2CSim_Stick_Sda-----------------
+ *	Input: Module number (0-3), SCL pulses that free SDA
+ *	Output: None
+ */
+void I2CSim_Stick_Sda(uint8_t module, uint8_t pulses){
+
+	SIM_BUS_t* bus = &sim_bus[module % I2C_SIM_MODULES];
+
+	bus->stuck = pulses;
+	I2CSim_Drive_Pin(sim_pins[module % I2C_SIM_MODULES].gpio_base, sim_pins[module % I2C_SIM_MODULES].sda, pulses != 0);
+}
+
+/*
+ *	----------------I2CSim_Gpio_Irq-----------------
+ *	Input: GPIO port base address, Handler
+ *	Output: None
+ */
+void I2CSim_Gpio_Irq(uint32_t base, void (*handler)(void)){
+	sim_gpio_handlers[Sim_Port(base)] = handler;
+}
+
+/*
+ *	----------------I2CSim_Set_Sysclk----------------
+ *	Input: Core clock SYSCLK_Get_Hz reports, 0 for I2C_SIM_SYSCLK_HZ
+ *	Output: None
+ */
+void I2CSim_Set_Sysclk(uint32_t hz){
+	sim_sysclk = (hz != 0) ? hz : I2C_SIM_SYSCLK_HZ;
+}
+
+/*
+ *	----------------I2CSim_Get_Stats-----------------
+ *	Input: Module number (0-3), Struct to fill
+ *	Output: None
+ */
+void I2CSim_Get_Stats(uint8_t module, I2C_SIM_STATS_t* stats){
+	*stats = sim_bus[module].stats;
+}
+
+/*
+ *	-------------I2CSim_Regfile_Init-----------------
+ *	Input: Device model, Name, 7-bit address
+ *	Output: None
+ */
+void I2CSim_Regfile_Init(I2C_SIM_DEV_t* dev, const char* name, uint8_t addr){
+
+	memset(dev, 0, sizeof(*dev));
+	dev->name = name;
+	dev->addr = addr;
+	dev->start = I2CSim_Regfile_Start;
+	dev->write = I2CSim_Regfile_Write;
+	dev->read = I2CSim_Regfile_Read;
+	dev->auto_inc = 1;
+}
+
+/*
+ *	-------------I2CSim_Regfile_Start----------------
+ *	A write starts with the pointer, a read carries on from it
+ *	Input: Device model, 1 for a read
+ *	Output: 1 (ACK)
+ */
+uint8_t I2CSim_Regfile_Start(I2C_SIM_DEV_t* dev, uint8_t read){
+
+	if(!read)
+		dev->ptr_next = 1;
+
+	return 1;
+}
+
+/*
+ *	-------------I2CSim_Regfile_Write----------------
+ *	Input: Device model, Byte from the master
+ *	Output: 1 (ACK)
+ */
+uint8_t I2CSim_Regfile_Write(I2C_SIM_DEV_t* dev, uint8_t byte){
+
+	if(dev->ptr_next){
+		dev->ptr = (dev->decode_ptr != 0) ? dev->decode_ptr(dev, byte) : byte;
+		dev->ptr_next = 0;
+		return 1;
+	}
+
+	dev->regs[dev->ptr] = byte;
+	if(dev->on_write != 0)
+		dev->on_write(dev, dev->ptr);
+	if(dev->auto_inc)
+		dev->ptr++;
+
+	return 1;
+}
+
+/*
+ *	-------------I2CSim_Regfile_Read-----------------
+ *	Input: Device model
+ *	Output: Register at the pointer
+ */
+uint8_t I2CSim_Regfile_Read(I2C_SIM_DEV_t* dev){
+
+	uint8_t value;
+
+	if(dev->on_read != 0)
+		dev->on_read(dev, dev->ptr);
+	value = dev->regs[dev->ptr];
+	if(dev->auto_inc)
+		dev->ptr++;
+
+	return value;
+}
+
+/* ---------------------------------------------------------------- */
+/* Board services the drivers use, host versions                     */
+/* ---------------------------------------------------------------- */
+
+/* PRIMASK, the simulated interrupts wait while it is set */
+long StartCritical(void){
+
+	long sr = sim_primask;
+	sim_primask = 1;
+
+	return sr;
+}
+
+void EndCritical(long sr){
+
+	sim_primask = sr;
+	if(!sim_primask)
+		Sim_Catch_Up();
+}
+
+void CYCCNT_Init(void){
+	DEMCR_R |= DEMCR_TRCENA;
+	DWT_CTRL_R |= DWT_CYCCNTENA;
+}
+
+uint32_t SYSCLK_Get_Hz(void){
+	return sim_sysclk;
+}
+
+void DELAY_1MS(uint32_t delay){
+	I2CSim_Advance((uint64_t)delay * (I2C_SIM_SYSCLK_HZ / 1000));
+}
+
+void WTIMER0_Init(void){
+}
+
+void UART0_Init(void){
+}
+
+/* Console text goes to stdout, carriage returns dropped */
+void UART0_OutChar(char data){
+	if(data != '\r')
+		putchar(data);
+}
+
+void UART0_OutString(char *pt){
+	while(*pt)
+		UART0_OutChar(*pt++);
+}
+
+void UART0_OutCRLF(void){
+	UART0_OutChar('\n');
+}
+
+/* EEPROM in RAM, erased (all ones) at start like a blank part */
+static uint32_t sim_eeprom[EEPROM_WORDS];
+static uint8_t sim_eeprom_ready;
+
+uint8_t EEPROM_Init(void){
+	if(!sim_eeprom_ready){
+		memset(sim_eeprom, 0xFF, sizeof(sim_eeprom));
+		sim_eeprom_ready = 1;
+	}
+	return EEPROM_OK;
+}
+
+uint8_t EEPROM_Read(uint16_t addr, uint32_t* data, uint16_t count){
+	if(data == 0 || addr + (uint32_t)count > EEPROM_WORDS)
+		return EEPROM_ERR_PARAM;
+	EEPROM_Init();
+	memcpy(data, &sim_eeprom[addr], count * sizeof(uint32_t));
+	return EEPROM_OK;
+}
+
+uint8_t EEPROM_Write(uint16_t addr, const uint32_t* data, uint16_t count){
+	if(data == 0 || addr + (uint32_t)count > EEPROM_WORDS)
+		return EEPROM_ERR_PARAM;
+	EEPROM_Init();
+	memcpy(&sim_eeprom[addr], data, count * sizeof(uint32_t));
+	return EEPROM_OK;
+}
+
+#endif //I2C_SIM
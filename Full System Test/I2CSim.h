@@ -0,0 +1,273 @@
+/*
+ * I2CSim.h
+ *
+ *	Provides a simulated I2C peripheral for host (Linux) builds so the
+ *	drivers can run without a TM4C123. Defining I2C_SIM redirects the
+ *	I2C register accessors of I2C.h, the clock and GPIO registers they
+ *	touch, and the cycle counter of util.h into this module. A write to
+ *	MCS runs the master state machine against the device models
+ *	attached to that bus, each command keeps MCS busy for as long as
+ *	it takes on the wire at the programmed MTPR, and completions raise
+ *	the module interrupt into I2C0_Handler - I2C3_Handler.
+ *
+ *	Device models see the bus events a slave sees (addressed, byte in,
+ *	byte out, STOP). I2CSim_Regfile_* implement them for the usual
+ *	register file with a pointer set by the first byte written, see
+ *	I2CSimDev.h for the parts on this board. A model can also change
+ *	on its own at a set time (a conversion ending) and pull a GPIO
+ *	input low like an interrupt output, the GPIO edge and level
+ *	detection then raises the port interrupt into its handler.
+ *
+ *	Host build, from the repository root (see tools/i2c_sim_run.c):
+ *		cc -std=gnu11 -DI2C_SIM -I"Full System Test" ... "Full System Test"/I2CSim.c ...
+ *	The module also supplies what the drivers use from the rest of the
+ *	board: UART0 output goes to stdout, DELAY_1MS lets simulated time
+ *	run, StartCritical/EndCritical hold off the simulated interrupts,
+ *	the EEPROM is a RAM array that starts erased.
+ *
+ *	Each module's own slave function (MCR SFE, SOAR, SCSR DA) answers
+ *	the master like a device model, raising the slave interrupt for
+ *	every START, byte and STOP. It holds SCL until the driver reads
+ *	SDR (RREQ) or writes it (TREQ), the master command waits for it.
+ *	With MCR LPBK set the master reaches only its own slave
+ *
+ * Created on: October 17th, 2026
+ *
+ */
+
+#ifndef I2CSIM_H_
+#define I2CSIM_H_
+
+#include <stdint.h>
+#include "tm4c123gh6pm.h"
+
+/* List of Macros */
+#define I2C_SIM_SYSCLK_HZ   80000000    // Core clock the host build pretends to run at
+#define I2C_SIM_REG_CYCLES  2           // Cycles one peripheral register access costs
+#define I2C_SIM_CNT_CYCLES  1           // Cycles one cycle counter read costs
+#define I2C_SIM_MODULES     4           // Simulated I2C0 - I2C3
+#define I2C_SIM_IRQ_MAX     16          // Nested deliveries before the simulator gives up
+#define I2C_SIM_IDLE_PASS_CYCLES 4      // Cycles one I2C_IDLE_PASS costs
+
+//Register redirection, see I2C.h and util.h
+#define I2C_REG(bus, off)       (*I2CSim_Reg((bus)->base, (off)))
+#define I2C_GPIO_REG(bus, off)  (*I2CSim_Gpio((bus)->gpio_base, (off)))
+#define SOFT_I2C_GPIO_REG(bus, off) (*I2CSim_Gpio((bus)->gpio_base, (off)))
+#define GPIO_REG(base, off)     (*I2CSim_Gpio((base), (off)))
+#define I2C_SPIN()              I2CSim_Spin()
+#define I2C_IDLE_PASS()         I2CSim_Advance(I2C_SIM_IDLE_PASS_CYCLES)
+
+#undef SYSCTL_RCGCI2C_R
+#undef SYSCTL_PRI2C_R
+#undef SYSCTL_SRI2C_R
+#undef SYSCTL_RCGCGPIO_R
+#undef SYSCTL_PRGPIO_R
+#undef NVIC_PRI0_R
+#undef NVIC_PRI1_R
+#undef NVIC_EN0_R
+#define SYSCTL_RCGCI2C_R        I2CSim_Sysctl[0]
+#define SYSCTL_PRI2C_R          I2CSim_Sysctl[1]
+#define SYSCTL_SRI2C_R          (*I2CSim_Sysctl_Reg(2))
+#define SYSCTL_RCGCGPIO_R       I2CSim_Sysctl[3]
+#define SYSCTL_PRGPIO_R         I2CSim_Sysctl[4]
+#define NVIC_PRI0_R             I2CSim_Nvic_Pri[0]
+#define NVIC_PRI1_R             I2CSim_Nvic_Pri[1]
+#define NVIC_EN0_R              I2CSim_Nvic_En[0]
+
+extern volatile unsigned long I2CSim_Sysctl[5];
+extern volatile unsigned long I2CSim_Nvic_Pri[32];
+extern volatile unsigned long I2CSim_Nvic_En[4];
+
+/* Device Model
+	 One per simulated slave, attached to a bus with I2CSim_Attach. The
+	 hooks are the bus events, the rest is the register file the
+	 I2CSim_Regfile_* hooks work on. A model embeds this as its first
+	 member so the hooks can get back to the whole model */
+typedef struct I2C_SIM_DEV I2C_SIM_DEV_t;
+struct I2C_SIM_DEV{
+	const char* name;										// Part name for logs
+	uint8_t addr;												// 7-bit address it answers
+	uint8_t (*start)(I2C_SIM_DEV_t* dev, uint8_t read);		// Addressed by a (repeated) START, 1 to ACK
+	uint8_t (*write)(I2C_SIM_DEV_t* dev, uint8_t byte);		// Byte from the master, 1 to ACK
+	uint8_t (*read)(I2C_SIM_DEV_t* dev);									// Byte for the master
+	void (*stop)(I2C_SIM_DEV_t* dev);											// STOP or bus reset, may be 0
+	uint32_t stretch_cycles;						// SCL held low before each byte (slow slave)
+	uint64_t wake_at;										// Simulated time the part changes on its own, 0 if never
+	void (*wake)(I2C_SIM_DEV_t* dev);										// Called once wake_at is reached, may be 0
+
+	/* Register file */
+	uint8_t regs[256];
+	uint8_t ptr;												// Register the next byte goes to or comes from
+	uint8_t ptr_next;										// Next written byte is the pointer
+	uint8_t auto_inc;										// Pointer moves after each byte
+	uint8_t (*decode_ptr)(I2C_SIM_DEV_t* dev, uint8_t byte);	// Pointer from the first byte, 0 to take it as is
+	void (*on_write)(I2C_SIM_DEV_t* dev, uint8_t reg);				// After a register is written, may be 0
+	void (*on_read)(I2C_SIM_DEV_t* dev, uint8_t reg);					// Before a register is read, may be 0
+
+	uint32_t bytes_in;									// Bytes written to the part
+	uint32_t bytes_out;									// Bytes read from the part
+	I2C_SIM_DEV_t* next;								// Owned by the simulator
+};
+
+/* Per Bus Counters (cycles are simulated core clock cycles)
+	 Wire time is scl_clocks SCL periods at the MTPR of each command plus
+	 any clock stretching, busy_cycles adds the two up */
+typedef struct{
+	uint32_t transactions;							// STARTs that were not repeated
+	uint32_t restarts;									// Repeated STARTs
+	uint32_t stops;											// STOPs
+	uint32_t addr_bytes;								// Address bytes, one per START
+	uint32_t bytes;											// Address and data bytes on the wire
+	uint32_t nacks;											// Address and data NACKs
+	uint32_t idle_cmds;									// Commands with no transaction to act on (STOP on an idle bus)
+	uint32_t gpio_clocks;								// SCL pulses driven on the pins as GPIO (bus recovery)
+	uint64_t scl_clocks;								// 9 per byte, 1 per START, repeated START and STOP
+	uint64_t busy_cycles;								// Time the controller was busy
+} I2C_SIM_STATS_t;
+
+/*
+ *	------------------I2CSim_Reset-------------------
+ *	Detaches every model, clears the registers and counters and sets
+ *	simulated time back to 0
+ *	Input: None
+ *	Output: None
+ */
+void I2CSim_Reset(void);
+
+/*
+ *	------------------I2CSim_Attach------------------
+ *	Puts a device model on a simulated bus
+ *	Input: Module number (0-3), Device model
+ *	Output: None
+ */
+void I2CSim_Attach(uint8_t module, I2C_SIM_DEV_t* dev);
+
+/*
+ *	------------------I2CSim_Detach------------------
+ *	Takes a device model off its bus, e.g. to see a driver handle a
+ *	part that stopped answering
+ *	Input: Module number (0-3), Device model
+ *	Output: None
+ */
+void I2CSim_Detach(uint8_t module, I2C_SIM_DEV_t* dev);
+
+/*
+ *	------------------I2CSim_Cycles------------------
+ *	Cycle counter of the host build, each read costs I2C_SIM_CNT_CYCLES
+ *	Input: None
+ *	Output: Simulated core clock cycles, wraps like DWT CYCCNT
+ */
+uint32_t I2CSim_Cycles(void);
+
+/*
+ *	------------------I2CSim_Now---------------------
+ *	Input: None
+ *	Output: Simulated time in core clock cycles, does not wrap or advance
+ */
+uint64_t I2CSim_Now(void);
+
+/*
+ *	-----------------I2CSim_Advance------------------
+ *	Lets simulated time run, completing commands and delivering
+ *	interrupts on the way
+ *	Input: Cycles to run
+ *	Output: None
+ */
+void I2CSim_Advance(uint64_t cycles);
+
+/*
+ *	-------------------I2CSim_Spin-------------------
+ *	Body of loops waiting on an interrupt (I2C_SPIN), runs time to
+ *	the next bus event like WFI would
+ *	Input: None
+ *	Output: None
+ */
+void I2CSim_Spin(void);
+
+/*
+ *	--------------------I2CSim_Reg-------------------
+ *	Backs I2C_REG. Catches up on what the driver wrote since the last
+ *	access, then returns the register
+ *	Input: Module base address, Register offset
+ *	Output: Register storage
+ */
+volatile unsigned long* I2CSim_Reg(uint32_t base, uint32_t offset);
+
+/*
+ *	----------------I2CSim_Sysctl_Reg----------------
+ *	Backs SYSCTL_SRI2C_R. Catches up first like I2CSim_Reg, so a reset
+ *	bit set and cleared again right away is still seen
+ *	Input: Index into I2CSim_Sysctl
+ *	Output: Register storage
+ */
+volatile unsigned long* I2CSim_Sysctl_Reg(uint8_t reg);
+
+/*
+ *	-------------------I2CSim_Gpio-------------------
+ *	Backs I2C_GPIO_REG. DATA reads see every line high unless a part
+ *	pulls it low or it is a GPIO output written low. A DATA write that
+ *	changes the value read goes to the output latch
+ *	Input: GPIO port base address, Register offset
+ *	Output: Register storage
+ */
+volatile unsigned long* I2CSim_Gpio(uint32_t base, uint32_t offset);
+
+/*
+ *	---------------I2CSim_Drive_Pin------------------
+ *	A part pulling a GPIO input low or letting it go (open drain with
+ *	pull-up). Edges and levels raise RIS as GPIOIS/IBE/IEV select
+ *	Input: GPIO port base address, Pin mask, 1 to pull low
+ *	Output: None
+ */
+void I2CSim_Drive_Pin(uint32_t base, uint8_t pins, uint8_t low);
+
+/*
+ *	----------------I2CSim_Stick_Sda-----------------
+ *	A slave stuck mid-byte: SDA of the module's pins is held low until
+ *	SCL has been pulsed on them as GPIO (bus recovery) the given number
+ *	of times. Meanwhile commands put nothing on the wire and stay busy
+ *	for 1 s, then report lost arbitration
+ *	Input: Module number (0-3), SCL pulses that free SDA, 0 to let go now
+ *	Output: None
+ */
+void I2CSim_Stick_Sda(uint8_t module, uint8_t pulses);
+
+/*
+ *	----------------I2CSim_Gpio_Irq-----------------
+ *	Handler run for a port interrupt, the vector table of the host build
+ *	Input: GPIO port base address, Handler (e.g. GPIOPortE_Handler)
+ *	Output: None
+ */
+void I2CSim_Gpio_Irq(uint32_t base, void (*handler)(void));
+
+/*
+ *	----------------I2CSim_Set_Sysclk----------------
+ *	Changes the core clock SYSCLK_Get_Hz reports, so calculations from
+ *	it (MTPR, deadlines) can be checked at other clocks. Simulated
+ *	time stays in cycles of I2C_SIM_SYSCLK_HZ
+ *	Input: Core clock in Hz, 0 for I2C_SIM_SYSCLK_HZ
+ *	Output: None
+ */
+void I2CSim_Set_Sysclk(uint32_t hz);
+
+/*
+ *	----------------I2CSim_Get_Stats-----------------
+ *	Input: Module number (0-3), Struct to fill
+ *	Output: None
+ */
+void I2CSim_Get_Stats(uint8_t module, I2C_SIM_STATS_t* stats);
+
+/*
+ *	-------------I2CSim_Regfile_Init-----------------
+ *	Sets up a model as a plain register file: the first byte of a
+ *	write sets the pointer, the pointer moves after each byte
+ *	Input: Device model, Name, 7-bit address
+ *	Output: None
+ */
+void I2CSim_Regfile_Init(I2C_SIM_DEV_t* dev, const char* name, uint8_t addr);
+
+uint8_t I2CSim_Regfile_Start(I2C_SIM_DEV_t* dev, uint8_t read);
+uint8_t I2CSim_Regfile_Write(I2C_SIM_DEV_t* dev, uint8_t byte);
+uint8_t I2CSim_Regfile_Read(I2C_SIM_DEV_t* dev);
+
+#endif //I2CSIM_H_
@@ -0,0 +1,448 @@
+/*
+ * I2CSimDev.c
+ *
+ *	Main implementation of the simulated TCS34727, MPU6050 and
+ *	PCF8574A/HD44780 device models
+ *
+ * Created on: October 17th, 2026
+ *
+ */
+
+#ifdef I2C_SIM
+
+#include "I2CSimDev.h"
+#include "TCS34727.h"
+#include "MPU6050.h"
+#include "LCD.h"
+#include <string.h>
+
+#define SIM_US_CYCLES(us)   ((uint64_t)(us) * (I2C_SIM_SYSCLK_HZ / 1000000))
+
+//TCS34727
+#define SIM_TCS_TYPE_M      0x60        // Command byte transaction type
+#define SIM_TCS_TYPE_AUTO   0x20        // Auto-increment
+#define SIM_TCS_TYPE_SF     0x60        // Special function, nothing to address
+#define SIM_TCS_ADDR_M      0x1F
+#define SIM_TCS_STATUS      0x13
+#define SIM_TCS_AVALID      0x01
+#define SIM_TCS_AINT        0x10
+#define SIM_TCS_SF_M        0x1F
+#define SIM_TCS_SF_CLEAR    0x06        // RGBC interrupt clear
+#define SIM_TCS_PERS        0x0C
+#define SIM_TCS_APERS_M     0x0F
+#define SIM_TCS_APERS_LIN   3           // 1 - 3 count cycles, above that 5 per step
+#define SIM_TCS_AILTL       0x04
+#define SIM_TCS_AIHTL       0x06
+#define SIM_TCS_GAIN_M      0x03
+
+static const uint8_t sim_tcs_gain[4] = {1, 4, 16, 60};
+
+//MPU6050
+#define SIM_MPU_SLEEP       0x40        // PWR_MGMT_1 reset value
+#define SIM_MPU_DATA_BYTES  14          // ACCEL_XOUT_H - GYRO_ZOUT_L
+
+//HD44780 instructions by their highest set bit
+#define SIM_LCD_SET_DDRAM   0x80
+#define SIM_LCD_SET_CGRAM   0x40
+#define SIM_LCD_FUNC_SET    0x20
+#define SIM_LCD_FUNC_8BIT   0x10
+#define SIM_LCD_SHIFT       0x10
+#define SIM_LCD_ENTRY_INC   0x02
+#define SIM_LCD_PULL_UPS    0x0F        // D3-D0 are not wired on the backpack
+#define SIM_LCD_LINE_LEN    0x28        // DDRAM per line in 2-line mode
+#define SIM_LCD_LINE2       0x40
+
+/* ---------------------------------------------------------------- */
+/* TCS34727                                                          */
+/* ---------------------------------------------------------------- */
+
+/*
+ *	-------------------Sim_TCS_Pin-------------------
+ *	Local function driving INT, open drain low while AINT is set with AIEN
+ *	Input: Model
+ *	Output: None
+ */
+static void Sim_TCS_Pin(I2C_SIM_TCS34727_t* tcs){
+
+	uint8_t low = (tcs->dev.regs[SIM_TCS_STATUS] & SIM_TCS_AINT) && (tcs->dev.regs[TCS34727_ENABLE_R_ADDR] & TCS34727_ENABLE_AIEN);
+
+	if(tcs->int_pin != 0)
+		I2CSim_Drive_Pin(tcs->int_base, tcs->int_pin, low);
+}
+
+/*
+ *	------------------Sim_TCS_Cycle------------------
+ *	Local function ending one integration: new counts, AVALID, and AINT
+ *	as the persistence filter decides. Counts are light x steps x gain
+ *	up to the full scale of the programmed ATIME
+ *	Input: Model
+ *	Output: None
+ */
+static void Sim_TCS_Cycle(I2C_SIM_TCS34727_t* tcs){
+
+	uint8_t* regs = tcs->dev.regs;
+	uint32_t steps = 256 - regs[TCS34727_TIMING_R_ADDR];
+	uint32_t full = steps * SIM_TCS_FULL_SCALE;
+	uint32_t count;
+	uint16_t low = regs[SIM_TCS_AILTL] | (regs[SIM_TCS_AILTL + 1] << 8);
+	uint16_t high = regs[SIM_TCS_AIHTL] | (regs[SIM_TCS_AIHTL + 1] << 8);
+	uint8_t apers = regs[SIM_TCS_PERS] & SIM_TCS_APERS_M;
+	uint32_t needed = (apers <= SIM_TCS_APERS_LIN) ? apers : 5 * (apers - SIM_TCS_APERS_LIN);
+	uint8_t i;
+
+	if(full > 0xFFFF)
+		full = 0xFFFF;
+
+	regs[SIM_TCS_STATUS] |= SIM_TCS_AVALID;
+	for(i = 0; i < 4; i++){
+		count = tcs->light[i] * steps * sim_tcs_gain[regs[TCS34727_CTRL_R_ADDR] & SIM_TCS_GAIN_M];
+		if(count > full)
+			count = full;
+		regs[TCS34727_CDATAL_R_ADDR + 2*i] = count & 0xFF;
+		regs[TCS34727_CDATAH_R_ADDR + 2*i] = count >> 8;
+	}
+
+	/* Persistence counts cycles in a row with the clear channel outside the band */
+	count = regs[TCS34727_CDATAL_R_ADDR] | (regs[TCS34727_CDATAH_R_ADDR] << 8);
+	if(count < low || count > high)
+		tcs->out_count++;
+	else
+		tcs->out_count = 0;
+
+	if(!(regs[TCS34727_ENABLE_R_ADDR] & TCS34727_ENABLE_AIEN))
+		return;
+	if(apers == 0 || tcs->out_count >= needed)
+		regs[SIM_TCS_STATUS] |= SIM_TCS_AINT;
+}
+
+/*
+ *	-----------------Sim_TCS_Update------------------
+ *	Local function running the integrations that ended up to now,
+ *	also the wake hook at the end of each one
+ *	Input: Model
+ *	Output: None
+ */
+static void Sim_TCS_Update(I2C_SIM_DEV_t* dev){
+
+	I2C_SIM_TCS34727_t* tcs = (I2C_SIM_TCS34727_t*)dev;
+	uint64_t period = (256 - dev->regs[TCS34727_TIMING_R_ADDR]) * SIM_US_CYCLES(SIM_TCS_CYCLE_US);
+
+	if(tcs->aen_at == 0){
+		dev->wake_at = 0;
+		return;
+	}
+
+	while(I2CSim_Now() >= tcs->aen_at + (tcs->cycles + 1) * period){
+		tcs->cycles++;
+		Sim_TCS_Cycle(tcs);
+	}
+
+	dev->wake_at = tcs->aen_at + (tcs->cycles + 1) * period;
+	Sim_TCS_Pin(tcs);
+}
+
+/*
+ *	-----------------Sim_TCS_Decode------------------
+ *	Local function taking the register and access type from the
+ *	command byte. Special functions (interrupt clear) leave the
+ *	pointer where it was
+ *	Input: Model, Command byte
+ *	Output: Register pointer
+ */
+static uint8_t Sim_TCS_Decode(I2C_SIM_DEV_t* dev, uint8_t byte){
+
+	if((byte & SIM_TCS_TYPE_M) == SIM_TCS_TYPE_SF){
+		if((byte & SIM_TCS_SF_M) == SIM_TCS_SF_CLEAR){
+			dev->regs[SIM_TCS_STATUS] &= ~SIM_TCS_AINT;
+			Sim_TCS_Pin((I2C_SIM_TCS34727_t*)dev);
+		}
+		return dev->ptr;
+	}
+
+	dev->auto_inc = (byte & SIM_TCS_TYPE_M) == SIM_TCS_TYPE_AUTO;
+
+	return byte & SIM_TCS_ADDR_M;
+}
+
+/*
+ *	-----------------Sim_TCS_Written-----------------
+ *	Local function starting or stopping the RGBC cycle on ENABLE
+ *	Input: Model, Register written
+ *	Output: None
+ */
+static void Sim_TCS_Written(I2C_SIM_DEV_t* dev, uint8_t reg){
+
+	I2C_SIM_TCS34727_t* tcs = (I2C_SIM_TCS34727_t*)dev;
+	uint8_t on = TCS34727_ENABLE_PON|TCS34727_ENABLE_AEN;
+
+	if(reg != TCS34727_ENABLE_R_ADDR)
+		return;
+
+	if((dev->regs[reg] & on) != on){
+		tcs->aen_at = 0;
+		tcs->cycles = 0;
+		tcs->out_count = 0;
+		dev->regs[SIM_TCS_STATUS] &= ~SIM_TCS_AVALID;
+	}
+	else if(tcs->aen_at == 0){
+		tcs->aen_at = I2CSim_Now() + 1;
+	}
+
+	Sim_TCS_Update(dev);
+}
+
+/*
+ *	------------------Sim_TCS_Read-------------------
+ *	Local function bringing STATUS and the data registers up to date
+ *	and latching the high data bytes
+ *	Input: Model, Register about to be read
+ *	Output: None
+ */
+static void Sim_TCS_Read(I2C_SIM_DEV_t* dev, uint8_t reg){
+
+	I2C_SIM_TCS34727_t* tcs = (I2C_SIM_TCS34727_t*)dev;
+
+	Sim_TCS_Update(dev);
+
+	/* Low byte latches the high byte, the high byte reads the latch */
+	if(reg >= TCS34727_CDATAL_R_ADDR && reg <= TCS34727_BDATAH_R_ADDR){
+		if(reg == TCS34727_CDATAL_R_ADDR)
+			tcs->result = tcs->cycles;
+		if((reg & 0x01) == 0)
+			tcs->shadow = dev->regs[reg + 1];
+		else
+			dev->regs[reg] = tcs->shadow;
+	}
+}
+
+/*
+ *	----------------I2CSim_TCS34727_Init----------------
+ *	Input: Model, 7-bit address
+ *	Output: None
+ */
+void I2CSim_TCS34727_Init(I2C_SIM_TCS34727_t* tcs, uint8_t addr){
+
+	uint16_t light[4];
+
+	memcpy(light, tcs->light, sizeof(light));
+	memset(tcs, 0, sizeof(*tcs));
+	memcpy(tcs->light, light, sizeof(light));
+
+	I2CSim_Regfile_Init(&tcs->dev, "TCS34727", addr);
+	tcs->dev.decode_ptr = Sim_TCS_Decode;
+	tcs->dev.on_write = Sim_TCS_Written;
+	tcs->dev.on_read = Sim_TCS_Read;
+	tcs->dev.wake = Sim_TCS_Update;
+	tcs->dev.regs[TCS34727_TIMING_R_ADDR] = TCS34727_ATIME_2_4_MS;
+	tcs->dev.regs[TCS34727_ID_R_ADDR] = TCS34727_ID;
+}
+
+/* ---------------------------------------------------------------- */
+/* MPU6050                                                           */
+/* ---------------------------------------------------------------- */
+
+/*
+ *	-----------------Sim_MPU_Defaults----------------
+ *	Local function for the power on register values
+ *	Input: Model
+ *	Output: None
+ */
+static void Sim_MPU_Defaults(I2C_SIM_DEV_t* dev){
+
+	memset(dev->regs, 0, sizeof(dev->regs));
+	dev->regs[PWR_MGMT_1] = SIM_MPU_SLEEP;
+	dev->regs[WHO_AM_I] = MPU6050_ID;
+}
+
+/*
+ *	-----------------Sim_MPU_Written-----------------
+ *	Local function acting on DEVICE_RESET
+ *	Input: Model, Register written
+ *	Output: None
+ */
+static void Sim_MPU_Written(I2C_SIM_DEV_t* dev, uint8_t reg){
+
+	if(reg == PWR_MGMT_1 && (dev->regs[reg] & PWR_DEVICE_RESET))
+		Sim_MPU_Defaults(dev);
+}
+
+/*
+ *	------------------Sim_MPU_Read-------------------
+ *	Local function loading the measurements, they hold still while
+ *	the part sleeps
+ *	Input: Model, Register about to be read
+ *	Output: None
+ */
+static void Sim_MPU_Read(I2C_SIM_DEV_t* dev, uint8_t reg){
+
+	I2C_SIM_MPU6050_t* mpu = (I2C_SIM_MPU6050_t*)dev;
+	int16_t values[SIM_MPU_DATA_BYTES / 2];
+	uint8_t i;
+
+	if(reg < ACCEL_XOUT_H || reg > GYRO_ZOUT_L || (dev->regs[PWR_MGMT_1] & SIM_MPU_SLEEP))
+		return;
+
+	values[0] = mpu->accel[0];
+	values[1] = mpu->accel[1];
+	values[2] = mpu->accel[2];
+	values[3] = mpu->temp;
+	values[4] = mpu->gyro[0];
+	values[5] = mpu->gyro[1];
+	values[6] = mpu->gyro[2];
+
+	for(i = 0; i < SIM_MPU_DATA_BYTES / 2; i++){
+		dev->regs[ACCEL_XOUT_H + 2*i] = (uint16_t)values[i] >> 8;
+		dev->regs[ACCEL_XOUT_H + 2*i + 1] = (uint16_t)values[i] & 0xFF;
+	}
+}
+
+/*
+ *	----------------I2CSim_MPU6050_Init-----------------
+ *	Input: Model, 7-bit address
+ *	Output: None
+ */
+void I2CSim_MPU6050_Init(I2C_SIM_MPU6050_t* mpu, uint8_t addr){
+
+	I2CSim_Regfile_Init(&mpu->dev, "MPU6050", addr);
+	mpu->dev.on_write = Sim_MPU_Written;
+	mpu->dev.on_read = Sim_MPU_Read;
+	Sim_MPU_Defaults(&mpu->dev);
+}
+
+/* ---------------------------------------------------------------- */
+/* PCF8574A + HD44780                                                */
+/* ---------------------------------------------------------------- */
+
+/*
+ *	----------------Sim_LCD_Execute-----------------
+ *	Local function running one HD44780 instruction or data write
+ *	Input: Model, Instruction or character, RS
+ *	Output: None
+ */
+static void Sim_LCD_Execute(I2C_SIM_LCD_t* lcd, uint8_t value, uint8_t rs){
+
+	uint32_t us = SIM_LCD_CMD_US;
+
+	if(rs){
+		if(!lcd->cgram){
+			lcd->ddram[lcd->addr & 0x7F] = value;
+			lcd->addr = lcd->inc ? lcd->addr + 1 : lcd->addr - 1;
+			if(lcd->addr == SIM_LCD_LINE_LEN)
+				lcd->addr = SIM_LCD_LINE2;
+			else if(lcd->addr == SIM_LCD_LINE2 + SIM_LCD_LINE_LEN)
+				lcd->addr = 0;
+		}
+	}
+	else if(value & SIM_LCD_SET_DDRAM){
+		lcd->addr = value & 0x7F;
+		lcd->cgram = 0;
+	}
+	else if(value & SIM_LCD_SET_CGRAM){
+		lcd->cgram = 1;
+	}
+	else if(value & SIM_LCD_FUNC_SET){
+		if(!(value & SIM_LCD_FUNC_8BIT) && !lcd->four_bit){
+			lcd->four_bit = 1;
+			lcd->half = 0;
+		}
+		else if(value & SIM_LCD_FUNC_8BIT){
+			lcd->four_bit = 0;
+		}
+	}
+	else if(value & (SIM_LCD_SHIFT|DISP_CMD)){
+		/* Cursor/display shift and display control, nothing to show */
+	}
+	else if(value & ENTRY_MODE_CMD){
+		lcd->inc = (value & SIM_LCD_ENTRY_INC) != 0;
+	}
+	else if(value & RETURN_HOME_CMD){
+		lcd->addr = 0;
+		us = SIM_LCD_HOME_US;
+	}
+	else if(value & CLEAR_DISP_CMD){
+		memset(lcd->ddram, ' ', sizeof(lcd->ddram));
+		lcd->addr = 0;
+		lcd->inc = 1;
+		us = SIM_LCD_HOME_US;
+	}
+
+	lcd->busy_until = I2CSim_Now() + SIM_US_CYCLES(us);
+}
+
+/*
+ *	-----------------Sim_LCD_Write------------------
+ *	Local function setting the expander pins, EN falling clocks D7-D4
+ *	into the controller
+ *	Input: Model, Byte from the master
+ *	Output: 1 (ACK)
+ */
+static uint8_t Sim_LCD_Write(I2C_SIM_DEV_t* dev, uint8_t byte){
+
+	I2C_SIM_LCD_t* lcd = (I2C_SIM_LCD_t*)dev;
+	uint8_t falling = (lcd->pins & EN_Pin) && !(byte & EN_Pin);
+	uint8_t nibble = byte >> NIBBLE_SHIFT;
+
+	lcd->pins = byte;
+	if(!falling)
+		return 1;
+
+	if(I2CSim_Now() < lcd->busy_until){
+		lcd->ignored++;
+		return 1;
+	}
+
+	if(!lcd->four_bit){
+		Sim_LCD_Execute(lcd, (nibble << NIBBLE_SHIFT) | SIM_LCD_PULL_UPS, byte & RS_Pin);
+	}
+	else if(!lcd->half){
+		lcd->nibble = nibble;
+		lcd->half = 1;
+	}
+	else{
+		lcd->half = 0;
+		Sim_LCD_Execute(lcd, (lcd->nibble << NIBBLE_SHIFT) | nibble, byte & RS_Pin);
+	}
+
+	return 1;
+}
+
+/*
+ *	------------------Sim_LCD_Read------------------
+ *	Local function reading the quasi-bidirectional expander pins
+ *	Input: Model
+ *	Output: Pin levels
+ */
+static uint8_t Sim_LCD_Read(I2C_SIM_DEV_t* dev){
+	return ((I2C_SIM_LCD_t*)dev)->pins;
+}
+
+/*
+ *	------------------I2CSim_LCD_Init-------------------
+ *	Input: Model, 7-bit address of the expander
+ *	Output: None
+ */
+void I2CSim_LCD_Init(I2C_SIM_LCD_t* lcd, uint8_t addr){
+
+	memset(lcd, 0, sizeof(*lcd));
+	lcd->dev.name = "PCF8574A LCD";
+	lcd->dev.addr = addr;
+	lcd->dev.start = I2CSim_Regfile_Start;
+	lcd->dev.write = Sim_LCD_Write;
+	lcd->dev.read = Sim_LCD_Read;
+	lcd->pins = 0xFF;
+	lcd->inc = 1;
+	memset(lcd->ddram, ' ', sizeof(lcd->ddram));
+}
+
+/*
+ *	------------------I2CSim_LCD_Row--------------------
+ *	Input: Model, Row (0-1), Buffer of SIM_LCD_COLS + 1
+ *	Output: None
+ */
+void I2CSim_LCD_Row(const I2C_SIM_LCD_t* lcd, uint8_t row, char* text){
+
+	memcpy(text, &lcd->ddram[row ? SIM_LCD_LINE2 : 0], SIM_LCD_COLS);
+	text[SIM_LCD_COLS] = '\0';
+}
+
+#endif //I2C_SIM
@@ -0,0 +1,106 @@
+/*
+ * I2CSimDev.h
+ *
+ *	Provides device models of the parts on this board for the
+ *	simulated I2C bus (I2CSim.h): the TCS34727 color sensor, the
+ *	MPU6050 IMU and the PCF8574A backpack driving an HD44780 LCD.
+ *	Each model answers like the part does on the wire, the test sets
+ *	what the part measures and reads back what it was sent
+ *
+ * Created on: October 17th, 2026
+ *
+ */
+
+#ifndef I2CSIMDEV_H_
+#define I2CSIMDEV_H_
+
+#include <stdint.h>
+#include "I2CSim.h"
+
+/* List of Macros */
+#define SIM_TCS_CYCLE_US    2400        // One ATIME step
+#define SIM_TCS_FULL_SCALE  1024        // Counts per ATIME step at saturation
+#define SIM_LCD_ROWS        2
+#define SIM_LCD_COLS        16
+#define SIM_LCD_CMD_US      37          // Busy time of most instructions
+#define SIM_LCD_HOME_US     1520        // Busy time of clear and return home
+
+/* TCS34727
+	 Register file behind the command byte: bit 7 set, bits 6:5 pick
+	 repeated byte (00) or auto-increment (01) access. Reading a
+	 low data byte latches its high byte like the part does. STATUS
+	 gets AVALID after the first integration. With AIEN set AINT comes
+	 after every integration at PERS 0, else once the clear channel has
+	 been outside AILT - AIHT for the PERS number of integrations in a
+	 row. It stays until the 0xE6 special function, and holds the INT
+	 line low meanwhile if int_pin is wired */
+typedef struct{
+	I2C_SIM_DEV_t dev;									// Must be first
+	uint16_t light[4];									// C, R, G, B counts per ATIME step at 1x gain
+	uint64_t aen_at;										// Simulated time AEN was set, 0 while off
+	uint8_t shadow;											// High byte latched by the last low byte read
+	uint32_t cycles;										// Integrations finished since AEN
+	uint32_t result;										// Integration CDATAL was last read from, 1 is the first
+	uint32_t out_count;									// Integrations in a row outside the thresholds
+	uint32_t int_base;									// GPIO port INT is wired to
+	uint8_t int_pin;										// Pin mask, 0 when INT is not wired
+} I2C_SIM_TCS34727_t;
+
+/* MPU6050
+	 Plain auto-increment register file, the measurements below show
+	 up big-endian at ACCEL_XOUT_H - GYRO_ZOUT_L while the part is awake */
+typedef struct{
+	I2C_SIM_DEV_t dev;									// Must be first
+	int16_t accel[3];										// X, Y, Z raw
+	int16_t temp;												// Raw temperature
+	int16_t gyro[3];										// X, Y, Z raw
+} I2C_SIM_MPU6050_t;
+
+/* PCF8574A + HD44780
+	 Every byte written sets the expander pins, the LCD takes D7-D4 on
+	 EN falling. The controller starts in 8-bit mode with D3-D0 pulled
+	 up, and ignores what it is sent while an instruction is running */
+typedef struct{
+	I2C_SIM_DEV_t dev;									// Must be first
+	uint8_t pins;												// Expander output latch
+	uint8_t four_bit;										// Interface set to 4-bit
+	uint8_t half;												// High nibble held, 4-bit mode
+	uint8_t nibble;											// The held high nibble
+	uint8_t addr;												// DDRAM address counter
+	uint8_t cgram;											// Data goes to CGRAM
+	uint8_t inc;												// Entry mode increments
+	uint64_t busy_until;								// Simulated time the instruction ends
+	uint32_t ignored;										// Nibbles dropped while busy
+	char ddram[0x80];
+} I2C_SIM_LCD_t;
+
+/*
+ *	----------------I2CSim_TCS34727_Init----------------
+ *	Input: Model, 7-bit address
+ *	Output: None
+ */
+void I2CSim_TCS34727_Init(I2C_SIM_TCS34727_t* tcs, uint8_t addr);
+
+/*
+ *	----------------I2CSim_MPU6050_Init-----------------
+ *	Input: Model, 7-bit address
+ *	Output: None
+ */
+void I2CSim_MPU6050_Init(I2C_SIM_MPU6050_t* mpu, uint8_t addr);
+
+/*
+ *	------------------I2CSim_LCD_Init-------------------
+ *	Input: Model, 7-bit address of the expander
+ *	Output: None
+ */
+void I2CSim_LCD_Init(I2C_SIM_LCD_t* lcd, uint8_t addr);
+
+/*
+ *	------------------I2CSim_LCD_Row--------------------
+ *	Copies what one row of the display shows
+ *	Input: Model, Row (0-1), Buffer of SIM_LCD_COLS + 1
+ *	Output: None
+ */
+void I2CSim_LCD_Row(const I2C_SIM_LCD_t* lcd, uint8_t row, char* text);
+
+#endif //I2CSIMDEV_H_
@@ -0,0 +1,153 @@
+/*
+ * I2CSlave.c
+ *
+ *	Main implementation of the double buffered I2C slave data server
+ *
+ * Created on: October 17th, 2026
+ *
+ */
+
+#include "I2CSlave.h"
+#include "I2CAsync.h"
+#include "tm4c123gh6pm.h"
+
+/* Defined in startup.s */
+long StartCritical(void);
+void EndCritical(long sr);
+
+/* Front buffer is what a new host transaction latches, the other one
+	 belongs to I2C_Slave_Publish unless a slow host is still reading it */
+static I2C_SLAVE_MAP_t maps[2];
+static volatile uint8_t front;						// Buffer new host reads latch
+static volatile uint8_t latched;					// Buffer the current host transaction reads
+static volatile uint8_t active;						// Host transaction between START and STOP
+static uint8_t reg_ptr;										// Next map byte to send
+static uint8_t counted;										// Current transaction already counted as a read
+static uint16_t seq;
+static I2C_SLAVE_STATS_t slave_stats;
+
+/*
+ *	------------------I2C_Slave_Init------------------
+ *	Sets up the module pins and enables its slave function at the
+ *	given address alongside the master
+ *	Input: Bus Handle, Own 7-bit address
+ *	Output: None
+ */
+void I2C_Slave_Init(I2C_BUS_t* bus, uint8_t own_addr){
+
+	/* Same clocks and pins as the master, then turn the slave on too */
+	I2C_Init(bus);
+
+	front = 0;
+	active = 0;
+	reg_ptr = 0;
+
+	I2C_SOAR(bus) = own_addr & I2C_SOAR_OAR_M;
+	I2C_MCR(bus) |= I2C_MCR_SFE;													//Enable Slave Function
+	I2C_SICR(bus) = I2C_SICR_STOPIC|I2C_SICR_STARTIC|I2C_SICR_DATAIC;
+	I2C_SIMR(bus) = I2C_SIMR_STOPIM|I2C_SIMR_STARTIM|I2C_SIMR_DATAIM;
+	I2C_SCSR(bus) = I2C_SCSR_DA;														//Start answering our address
+
+	/* Module interrupt is shared with the master engine */
+	bus->slave_handler = I2C_Slave_Handler;
+	I2C_Async_Init(bus);
+}
+
+/*
+ *	-----------------I2C_Slave_Publish----------------
+ *	Copies a sample into the back buffer and swaps it to the front.
+ *	Thread context only
+ *	Input: Sample to serve
+ *	Output: I2C_OK, or I2C_ERR_BUSY if dropped
+ */
+uint8_t I2C_Slave_Publish(const I2C_SLAVE_MAP_t* sample){
+
+	uint8_t back;
+	long sr = StartCritical();
+
+	back = front ^ 1;
+
+	/* Host latched this buffer before the last swap and is still on it */
+	if(active && latched == back){
+		slave_stats.skipped++;
+		EndCritical(sr);
+		return I2C_ERR_BUSY;
+	}
+
+	EndCritical(sr);
+
+	/* Handler only ever latches front, so back can be filled with interrupts on */
+	maps[back] = *sample;
+	maps[back].id = I2C_SLAVE_MAP_ID;
+	maps[back].version = I2C_SLAVE_MAP_VER;
+	maps[back].seq = ++seq;
+
+	front = back;
+	slave_stats.published++;
+
+	return I2C_OK;
+}
+
+/*
+ *	-----------------I2C_Slave_Handler----------------
+ *	Slave interrupt body. STOP is handled before START so a STOP and
+ *	the next START pending together leave the new read active
+ *	Input: Bus Handle
+ *	Output: None
+ */
+void I2C_Slave_Handler(I2C_BUS_t* bus){
+
+	uint32_t mis = I2C_SMIS(bus);
+	uint32_t status;
+	uint8_t byte;
+
+	I2C_SICR(bus) = mis;																		//Acknowledge what we are about to handle
+
+	if(mis & I2C_SMIS_STOPMIS)
+		active = 0;
+
+	/* Every START, repeated or not, pins the transaction to one sample */
+	if(mis & I2C_SMIS_STARTMIS){
+		latched = front;
+		active = 1;
+		counted = 0;
+	}
+
+	if(mis & I2C_SMIS_DATAMIS){
+
+		status = I2C_SCSR(bus);
+
+		/* Host wrote a byte, the first one after the address is the pointer */
+		if(status & I2C_SCSR_RREQ){
+			byte = I2C_SDR(bus) & 0xFF;
+			if(status & I2C_SCSR_FBR)
+				reg_ptr = byte;
+		}
+
+		/* Host wants a byte, SCL is held low until SDR is written */
+		if(status & I2C_SCSR_TREQ){
+			if(reg_ptr < I2C_SLAVE_MAP_SIZE)
+				I2C_SDR(bus) = ((const uint8_t*)&maps[latched])[reg_ptr++];
+			else
+				I2C_SDR(bus) = I2C_SLAVE_FILL;
+
+			slave_stats.bytes++;
+			if(!counted){
+				slave_stats.reads++;
+				counted = 1;
+			}
+		}
+	}
+}
+
+/*
+ *	---------------I2C_Slave_Get_Stats----------------
+ *	Input: Struct to fill
+ *	Output: None
+ */
+void I2C_Slave_Get_Stats(I2C_SLAVE_STATS_t* stats){
+
+	long sr = StartCritical();
+	*stats = slave_stats;
+	EndCritical(sr);
+}
@@ -0,0 +1,96 @@
+/*
+ * I2CSlave.h
+ *
+ *	Provides an I2C slave data server so an external controller can read
+ *	the latest sensor sample as a register map instead of scraping the
+ *	UART0 text. The map is double buffered: a host read is served from
+ *	the buffer latched at its START, so it never sees a torn sample
+ *
+ *	Host protocol: write one byte to set the register pointer, then read
+ *	with a repeated START; the pointer auto-increments and reads past the
+ *	end return I2C_SLAVE_FILL. Writes after the pointer byte are ignored
+ *
+ * Created on: October 17th, 2026
+ *
+ */
+
+#ifndef I2CSLAVE_H_
+#define I2CSLAVE_H_
+
+#include <stdint.h>
+#include "I2C.h"
+
+/* Uncomment to serve the full system sample, needs a host on PE4/PE5 */
+//#define I2C_SLAVE_ENABLE
+
+/* List of Macros */
+#define I2C_SLAVE_BUS       I2C_BUS2    // PE4 (SCL) / PE5 (SDA)
+#define I2C_SLAVE_ADDR      0x42        // Own 7-bit address
+#define I2C_SLAVE_MAP_ID    0xA5        // Register 0x00, lets the host check it found us
+#define I2C_SLAVE_MAP_VER   1           // Register 0x01, bumped when the layout changes
+#define I2C_SLAVE_FILL      0xFF        // Returned past the end of the map
+
+/* Register Map (little endian, every field on its natural alignment)
+	 Angles are in hundredths of a degree, raw fields are straight from
+	 the sensors */
+typedef struct{
+	uint8_t id;													// 0x00 I2C_SLAVE_MAP_ID
+	uint8_t version;										// 0x01 I2C_SLAVE_MAP_VER
+	uint16_t seq;												// 0x02 Sample counter, changes once per publish
+	uint16_t rgbc[4];										// 0x04 Raw red, green, blue, clear
+	uint8_t color;											// 0x0C COLOR_DETECTED
+	uint8_t reserved;										// 0x0D
+	int16_t accel[3];										// 0x0E Raw accelerometer X, Y, Z
+	int16_t gyro[3];										// 0x14 Raw gyroscope X, Y, Z
+	int16_t angle[3];										// 0x1A Tilt angle X, Y, Z (0.01 deg)
+	int16_t servo;											// 0x20 Servo command (deg)
+} I2C_SLAVE_MAP_t;
+
+#define I2C_SLAVE_MAP_SIZE  sizeof(I2C_SLAVE_MAP_t)
+
+/* Server Counters */
+typedef struct{
+	uint32_t reads;											// Host transactions that read data
+	uint32_t bytes;											// Bytes sent to the host
+	uint32_t published;									// Samples made visible
+	uint32_t skipped;										// Publishes dropped, host still reading the back buffer
+} I2C_SLAVE_STATS_t;
+
+/*
+ *	------------------I2C_Slave_Init------------------
+ *	Sets up the module pins and enables its slave function at the
+ *	given address alongside the master. Serves an all zero map until
+ *	the first publish
+ *	Input: Bus Handle, Own 7-bit address
+ *	Output: None
+ */
+void I2C_Slave_Init(I2C_BUS_t* bus, uint8_t own_addr);
+
+/*
+ *	-----------------I2C_Slave_Publish----------------
+ *	Copies a sample into the back buffer and swaps it to the front.
+ *	id, version and seq are filled in here. If the host is still
+ *	reading the back buffer the sample is dropped; the next one goes
+ *	out instead
+ *	Input: Sample to serve
+ *	Output: I2C_OK, or I2C_ERR_BUSY if dropped
+ */
+uint8_t I2C_Slave_Publish(const I2C_SLAVE_MAP_t* sample);
+
+/*
+ *	-----------------I2C_Slave_Handler----------------
+ *	Slave interrupt body, called from the module interrupt when a
+ *	slave interrupt is pending
+ *	Input: Bus Handle
+ *	Output: None
+ */
+void I2C_Slave_Handler(I2C_BUS_t* bus);
+
+/*
+ *	---------------I2C_Slave_Get_Stats----------------
+ *	Input: Struct to fill
+ *	Output: None
+ */
+void I2C_Slave_Get_Stats(I2C_SLAVE_STATS_t* stats);
+
+#endif //I2CSLAVE_H_
@@ -0,0 +1,183 @@
+/*
+ * I2CStats.c
+ *
+ *	Main implementation of the per device I2C statistics
+ *
+ * Created on: October 17th, 2026
+ *
+ */
+
+#include "I2CStats.h"
+#include "UART0.h"
+#include "util.h"
+#include <stdio.h>
+
+/* Defined in startup.s */
+long StartCritical(void);
+void EndCritical(long sr);
+
+static I2C_DEV_STATS_t dev_stats[I2C_STATS_DEVICES];
+static uint8_t dev_count;								// Slots in use, filled in order
+static uint32_t untracked;							// Transactions to devices past the table
+
+/*
+ *	-----------------I2C_Stats_Bucket-----------------
+ *	Input: Transaction duration in cycles
+ *	Output: Histogram bucket it falls in
+ */
+uint8_t I2C_Stats_Bucket(uint32_t cycles){
+
+	uint32_t scaled = cycles >> I2C_STATS_SHIFT;
+	uint8_t bucket;
+
+	if(scaled == 0)
+		return 0;
+
+	/* Position of the highest set bit, one count instruction on the M4 */
+	bucket = 32 - __builtin_clz(scaled);
+	if(bucket >= I2C_STATS_BUCKETS)
+		bucket = I2C_STATS_BUCKETS - 1;
+
+	return bucket;
+}
+
+/*
+ *	-----------------I2C_Stats_Record-----------------
+ *	Counts one finished transaction, called by the driver and the
+ *	interrupt engine
+ *	Input: Bus Handle, Slave address, Data length, Start cycle count, Status
+ *	Output: None
+ */
+void I2C_Stats_Record(I2C_BUS_t* bus, uint8_t addr, uint32_t len, uint32_t start, uint8_t error){
+
+	uint8_t slot;
+	uint8_t bucket = I2C_Stats_Bucket(CYCCNT_Get() - start);
+	I2C_DEV_STATS_t* dev;
+	long sr;
+
+	/* Thread and interrupt context both record, keep each update whole */
+	sr = StartCritical();
+
+	/* Only a few devices per board, a linear search is the cheapest lookup */
+	for(slot = 0; slot < dev_count; slot++){
+		if(dev_stats[slot].addr == addr && dev_stats[slot].bus == bus->module)
+			break;
+	}
+
+	if(slot == dev_count){
+		if(dev_count == I2C_STATS_DEVICES){
+			untracked++;
+			EndCritical(sr);
+			return;
+		}
+		dev_stats[slot].bus = bus->module;
+		dev_stats[slot].addr = addr;
+		dev_count++;
+	}
+
+	dev = &dev_stats[slot];
+	dev->transactions++;
+	dev->hist[bucket]++;
+
+	if(error == I2C_OK)
+		dev->bytes += len;
+	else if(error == I2C_ERR_TIMEOUT)
+		dev->timeouts++;
+	else if(error & I2C_MCS_ARBLST)
+		dev->arb_lost++;
+	else if(error & (I2C_MCS_ADRACK|I2C_MCS_DATACK))
+		dev->nacks++;
+
+	EndCritical(sr);
+}
+
+/*
+ *	------------------I2C_Stats_Get------------------
+ *	Copies the counters of one tracked device
+ *	Input: Table slot (0 to I2C_STATS_DEVICES-1), Struct to fill
+ *	Output: 1 if the slot holds a device, 0 if it is unused
+ */
+uint8_t I2C_Stats_Get(uint8_t slot, I2C_DEV_STATS_t* stats){
+
+	long sr;
+
+	if(slot >= dev_count || stats == 0)
+		return 0;
+
+	sr = StartCritical();
+	*stats = dev_stats[slot];
+	EndCritical(sr);
+
+	return 1;
+}
+
+/*
+ *	-----------------I2C_Stats_Reset------------------
+ *	Clears every counter and forgets the tracked devices
+ *	Input: None
+ *	Output: None
+ */
+void I2C_Stats_Reset(void){
+
+	uint8_t slot;
+	uint8_t bucket;
+	long sr = StartCritical();
+
+	for(slot = 0; slot < I2C_STATS_DEVICES; slot++){
+		dev_stats[slot].transactions = 0;
+		dev_stats[slot].bytes = 0;
+		dev_stats[slot].nacks = 0;
+		dev_stats[slot].arb_lost = 0;
+		dev_stats[slot].timeouts = 0;
+		for(bucket = 0; bucket < I2C_STATS_BUCKETS; bucket++)
+			dev_stats[slot].hist[bucket] = 0;
+	}
+	dev_count = 0;
+	untracked = 0;
+
+	EndCritical(sr);
+}
+
+/*
+ *	-----------------I2C_Stats_Print------------------
+ *	Prints one line of counters and one histogram line per device on
+ *	UART0, bucket limits converted to microseconds
+ *	Input: None
+ *	Output: None
+ */
+void I2C_Stats_Print(void){
+
+	char buf[128];
+	uint8_t slot;
+	uint8_t bucket;
+	uint32_t cycles_per_us = SYSCLK_Get_Hz() / 1000000;
+	I2C_DEV_STATS_t dev;
+
+	for(slot = 0; I2C_Stats_Get(slot, &dev); slot++){
+
+		snprintf(buf, sizeof(buf), "I2C%u 0x%02X: %lu xfers %lu bytes %lu nack %lu arb %lu timeout\r\n", dev.bus, dev.addr,
+				(unsigned long)dev.transactions, (unsigned long)dev.bytes, (unsigned long)dev.nacks,
+				(unsigned long)dev.arb_lost, (unsigned long)dev.timeouts);
+		UART0_OutString(buf);
+
+		/* Only buckets that saw something, labelled with their upper limit */
+		UART0_OutString("  latency");
+		for(bucket = 0; bucket < I2C_STATS_BUCKETS; bucket++){
+			if(dev.hist[bucket] == 0)
+				continue;
+			if(bucket == I2C_STATS_BUCKETS - 1)
+				snprintf(buf, sizeof(buf), " >=%luus:%lu", (unsigned long)((1UL << (I2C_STATS_SHIFT + bucket - 1)) / cycles_per_us),
+						(unsigned long)dev.hist[bucket]);
+			else
+				snprintf(buf, sizeof(buf), " <%luus:%lu", (unsigned long)((1UL << (I2C_STATS_SHIFT + bucket)) / cycles_per_us),
+						(unsigned long)dev.hist[bucket]);
+			UART0_OutString(buf);
+		}
+		UART0_OutCRLF();
+	}
+
+	if(untracked != 0){
+		snprintf(buf, sizeof(buf), "%lu transactions to untracked devices\r\n", (unsigned long)untracked);
+		UART0_OutString(buf);
+	}
+}
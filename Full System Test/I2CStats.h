@@ -0,0 +1,80 @@
+/*
+ * I2CStats.h
+ *
+ *	Provides always-on per device I2C statistics: transaction and byte
+ *	counts, NACK and lost arbitration counts, and a log2 bucketed
+ *	latency histogram. Queried and reset from the UART0 console
+ *
+ * Created on: October 17th, 2026
+ *
+ */
+
+#ifndef I2CSTATS_H_
+#define I2CSTATS_H_
+
+#include <stdint.h>
+#include "I2C.h"
+
+/* List of Macros */
+#define I2C_STATS_DEVICES   8           // Distinct (bus, address) pairs tracked
+#define I2C_STATS_BUCKETS   16          // Latency histogram buckets
+#define I2C_STATS_SHIFT     8           // Bucket 0 is below 2^8 cycles
+
+/* Per Device Counters
+	 hist[0] counts transactions under 2^SHIFT cycles, hist[k] those in
+	 [2^(SHIFT+k-1), 2^(SHIFT+k)) cycles, the last bucket everything longer */
+typedef struct{
+	uint8_t bus;												// Module number
+	uint8_t addr;												// 7-bit slave address
+	uint32_t transactions;							// Calls and queued transfers finished
+	uint32_t bytes;											// Data bytes moved (register byte excluded)
+	uint32_t nacks;											// Address or data NACK
+	uint32_t arb_lost;									// Lost arbitration after all retries
+	uint32_t timeouts;									// Gave up on the controller
+	uint32_t hist[I2C_STATS_BUCKETS];		// Latency histogram
+} I2C_DEV_STATS_t;
+
+/*
+ *	-----------------I2C_Stats_Record-----------------
+ *	Counts one finished transaction, called by the driver and the
+ *	interrupt engine. Runs in a critical section with a linear search
+ *	of the I2C_STATS_DEVICES slots, a few dozen cycles with interrupts
+ *	masked, the last addresses of a full table are the slowest
+ *	Input: Bus Handle, Slave address, Data length, Start cycle count, Status
+ *	Output: None
+ */
+void I2C_Stats_Record(I2C_BUS_t* bus, uint8_t addr, uint32_t len, uint32_t start, uint8_t error);
+
+/*
+ *	-----------------I2C_Stats_Bucket-----------------
+ *	Input: Transaction duration in cycles
+ *	Output: Histogram bucket it falls in
+ */
+uint8_t I2C_Stats_Bucket(uint32_t cycles);
+
+/*
+ *	------------------I2C_Stats_Get------------------
+ *	Copies the counters of one tracked device
+ *	Input: Table slot (0 to I2C_STATS_DEVICES-1), Struct to fill
+ *	Output: 1 if the slot holds a device, 0 if it is unused
+ */
+uint8_t I2C_Stats_Get(uint8_t slot, I2C_DEV_STATS_t* stats);
+
+/*
+ *	-----------------I2C_Stats_Reset------------------
+ *	Clears every counter and forgets the tracked devices
+ *	Input: None
+ *	Output: None
+ */
+void I2C_Stats_Reset(void);
+
+/*
+ *	-----------------I2C_Stats_Print------------------
+ *	Prints one line of counters and one histogram line per device on
+ *	UART0, bucket limits converted to microseconds
+ *	Input: None
+ *	Output: None
+ */
+void I2C_Stats_Print(void);
+
+#endif //I2CSTATS_H_
@@ -0,0 +1,127 @@
+/*
+ * I2CTrace.c
+ *
+ *	Main implementation of the I2C transaction trace ring and its
+ *	binary UART0 dump
+ *
+ * Created on: October 17th, 2026
+ *
+ */
+
+#include "I2CTrace.h"
+
+#ifdef I2C_TRACE_ENABLE
+
+#include "UART0.h"
+
+static I2C_TRACE_t trace_ring[I2C_TRACE_SIZE];
+static uint32_t trace_head;							// Records ever written, next slot is head & MSK
+
+/*
+ *	------------------Trace_Out_U16------------------
+ *	Local function to send a little endian halfword
+ *	Input: Value
+ *	Output: None
+ */
+static void Trace_Out_U16(uint16_t value){
+	UART0_OutChar((char)(value & 0xFF));
+	UART0_OutChar((char)(value >> 8));
+}
+
+/*
+ *	------------------Trace_Out_U32------------------
+ *	Local function to send a little endian word
+ *	Input: Value
+ *	Output: None
+ */
+static void Trace_Out_U32(uint32_t value){
+	Trace_Out_U16((uint16_t)(value & 0xFFFF));
+	Trace_Out_U16((uint16_t)(value >> 16));
+}
+
+/*
+ *	-----------------I2C_Trace_Record-----------------
+ *	Appends one record. Safe to call from thread and interrupt context
+ *	at the same time, a slot is claimed with a single atomic increment
+ *	Input: Start cycle count, Slave address, Register, Data length, Flags, Status
+ *	Output: None
+ */
+void I2C_Trace_Record(uint32_t start, uint8_t addr, uint8_t reg, uint16_t len, uint8_t flags, uint8_t error){
+
+	uint32_t end = CYCCNT_Get();
+	uint32_t index = __atomic_fetch_add(&trace_head, 1, __ATOMIC_RELAXED);
+	I2C_TRACE_t* rec = &trace_ring[index & I2C_TRACE_MSK];
+
+	/* Invalid while the fields are filled, a preempting dump skips it */
+	rec->seq = 0;
+	__atomic_signal_fence(__ATOMIC_SEQ_CST);
+
+	rec->timestamp = start;
+	rec->duration = end - start;
+	rec->len = len;
+	rec->addr = addr;
+	rec->reg = reg;
+	rec->flags = flags;
+	rec->error = error;
+
+	__atomic_signal_fence(__ATOMIC_SEQ_CST);
+	rec->seq = (uint16_t)((index & I2C_TRACE_SEQ_MSK) | I2C_TRACE_SEQ_VALID);
+}
+
+/*
+ *	------------------I2C_Trace_Dump------------------
+ *	Sends the ring over UART0, oldest record first
+ *	Input: None
+ *	Output: None
+ */
+void I2C_Trace_Dump(void){
+
+	uint32_t head = __atomic_load_n(&trace_head, __ATOMIC_RELAXED);
+	uint32_t count = (head < I2C_TRACE_SIZE) ? head : I2C_TRACE_SIZE;
+	uint32_t index;
+	uint16_t expect;
+	I2C_TRACE_t rec;
+
+	/* Header */
+	UART0_OutString(I2C_TRACE_MAGIC);
+	UART0_OutChar(I2C_TRACE_VERSION);
+	UART0_OutChar(sizeof(I2C_TRACE_t));
+	Trace_Out_U16((uint16_t)count);
+	Trace_Out_U32(SYSCLK_Get_Hz());
+
+	for(index = head - count; index != head; index++){
+
+		/* Copy first, then make sure the slot still holds the record we expect */
+		rec = trace_ring[index & I2C_TRACE_MSK];
+		expect = (uint16_t)((index & I2C_TRACE_SEQ_MSK) | I2C_TRACE_SEQ_VALID);
+		__atomic_signal_fence(__ATOMIC_SEQ_CST);
+		if(rec.seq != expect || trace_ring[index & I2C_TRACE_MSK].seq != expect)
+			rec.seq = 0;
+
+		Trace_Out_U32(rec.timestamp);
+		Trace_Out_U32(rec.duration);
+		Trace_Out_U16(rec.seq);
+		Trace_Out_U16(rec.len);
+		UART0_OutChar(rec.addr);
+		UART0_OutChar(rec.reg);
+		UART0_OutChar(rec.flags);
+		UART0_OutChar(rec.error);
+	}
+}
+
+/*
+ *	------------------I2C_Trace_Clear-----------------
+ *	Empties the ring
+ *	Input: None
+ *	Output: None
+ */
+void I2C_Trace_Clear(void){
+
+	uint32_t index;
+
+	__atomic_store_n(&trace_head, 0, __ATOMIC_RELAXED);
+	for(index = 0; index < I2C_TRACE_SIZE; index++)
+		trace_ring[index].seq = 0;
+}
+
+#endif //I2C_TRACE_ENABLE
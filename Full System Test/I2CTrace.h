@@ -0,0 +1,87 @@
+/*
+ * I2CTrace.h
+ *
+ *	Provides an opt-in trace of every I2C transaction. Each polled call
+ *	and each interrupt driven transfer leaves one timestamped record in
+ *	a fixed size ring that can be dumped over UART0 in binary and
+ *	decoded on the host with tools/i2c_trace_decode.py
+ *
+ * Created on: October 17th, 2026
+ *
+ */
+
+#ifndef I2CTRACE_H_
+#define I2CTRACE_H_
+
+#include <stdint.h>
+#include "util.h"
+
+/* Uncomment to record I2C transactions, removes every hook when off */
+//#define I2C_TRACE_ENABLE
+
+/* List of Macros */
+#define I2C_TRACE_SIZE      64          // Records kept, must be a power of 2
+#define I2C_TRACE_MSK       (I2C_TRACE_SIZE - 1)
+#define I2C_TRACE_MAGIC     "I2CT"      // Start of a dump in the UART0 stream
+#define I2C_TRACE_VERSION   1
+#define I2C_TRACE_SEQ_VALID 0x8000      // Set in seq once a record is complete
+#define I2C_TRACE_SEQ_MSK   0x7FFF
+
+//Record Flags
+#define I2C_TRACE_READ      0x01        // Direction, clear for write
+#define I2C_TRACE_ASYNC     0x02        // Sent by the interrupt driven engine
+#define I2C_TRACE_BUS_SHIFT 2           // Module number in bits 3:2
+
+/* Trace Record (16 bytes, dumped little endian in this order) */
+typedef struct{
+	uint32_t timestamp;									// Cycle count when the transaction started
+	uint32_t duration;									// Cycles until it finished, retries included
+	uint16_t seq;												// Write order | I2C_TRACE_SEQ_VALID, 0 while being written
+	uint16_t len;												// Data bytes (register byte excluded)
+	uint8_t addr;												// 7-bit slave address
+	uint8_t reg;												// Register address
+	uint8_t flags;											// I2C_TRACE_* flags
+	uint8_t error;											// I2C_OK or I2C_ERR_* status
+} I2C_TRACE_t;
+
+#ifdef I2C_TRACE_ENABLE
+
+/* Hook used by the driver, compiled out when tracing is off */
+#define I2C_TRACE_SPAN(start, bus, addr, reg, len, flags, error) \
+	I2C_Trace_Record((start), (addr), (reg), (len), (uint8_t)((flags) | ((bus)->module << I2C_TRACE_BUS_SHIFT)), (error))
+
+/*
+ *	-----------------I2C_Trace_Record-----------------
+ *	Appends one record. Safe to call from thread and interrupt context
+ *	at the same time, a slot is claimed with a single atomic increment
+ *	Input: Start cycle count, Slave address, Register, Data length, Flags, Status
+ *	Output: None
+ */
+void I2C_Trace_Record(uint32_t start, uint8_t addr, uint8_t reg, uint16_t len, uint8_t flags, uint8_t error);
+
+/*
+ *	------------------I2C_Trace_Dump------------------
+ *	Sends the ring over UART0, oldest record first. Format:
+ *	"I2CT", version, record size, record count (u16), system clock (u32),
+ *	then the records. Records overwritten during the dump go out with
+ *	seq = 0 and are skipped by the decoder
+ *	Input: None
+ *	Output: None
+ */
+void I2C_Trace_Dump(void);
+
+/*
+ *	------------------I2C_Trace_Clear-----------------
+ *	Empties the ring
+ *	Input: None
+ *	Output: None
+ */
+void I2C_Trace_Clear(void);
+
+#else
+
+#define I2C_TRACE_SPAN(start, bus, addr, reg, len, flags, error)
+
+#endif //I2C_TRACE_ENABLE
+
+#endif //I2CTRACE_H_
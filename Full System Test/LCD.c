@@ -13,6 +13,115 @@
 #include "tm4c123gh6pm.h"
 #include "util.h"
 #include "I2C.h"
+#include "I2CAsync.h"
+#include "I2CScan.h"
+
+/* Backpacks come with a PCF8574 (0x20-0x27) or a PCF8574A (0x38-0x3F),
+	 0x27 and 0x3F being the usual jumper setting */
+static const uint8_t LCD_Alt_Addr[] = {
+	0x27, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E,
+	0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26
+};
+I2C_DEVICE_t LCD_DEVICE = {.name = "PCF8574A LCD", .addr = LCD_WRITE_ADDR, .max_speed = I2C_SPEED_STANDARD,
+	.alt_addr = LCD_Alt_Addr, .alt_count = sizeof(LCD_Alt_Addr)};
+
+/* Display Frames are built in place and sent straight from here,
+	 the PCF8574A has no registers so each frame is its own write */
+#ifdef LCD_USE_I2C_QUEUE
+/* Frames waiting in or sent by the LCD_BUS queue */
+typedef struct{
+	I2C_XFER_t xfer;
+	I2C_SEG_t seg;
+	uint8_t bytes[LCD_FRAME_SIZE];
+} LCD_FRAME_t;
+
+static LCD_FRAME_t lcd_frames[LCD_FRAME_POOL_SIZE];
+static uint8_t lcd_frame_next;
+static LCD_FRAME_t* lcd_frame_last;		//Last frame handed to the queue
+#else
+static uint8_t lcd_frame[LCD_FRAME_SIZE];
+static const I2C_SEG_t lcd_frame_seg = {lcd_frame, LCD_FRAME_SIZE};
+#endif
+
+/*
+ *	------------------LCD_Frame_Get-----------------
+ *	Local function to get the buffer the next frame is built in.
+ *	With LCD_USE_I2C_QUEUE this is the next pool slot, and the call
+ *	only blocks when every frame in the pool is still waiting
+ *	Input: None
+ *	Output: LCD_FRAME_SIZE byte buffer
+ */
+static uint8_t* LCD_Frame_Get(void){
+	
+	#ifdef LCD_USE_I2C_QUEUE
+	LCD_FRAME_t* slot = &lcd_frames[lcd_frame_next];
+	
+	/* Slots are reused in order, wait for the oldest one to go out */
+	if(slot->xfer.segs != 0)
+		while(!slot->xfer.done)
+			I2C_SPIN();
+	
+	return slot->bytes;
+	#else
+	return lcd_frame;
+	#endif
+}
+
+/*
+ *	------------------LCD_Frame_Send----------------
+ *	Local function to send the frame built by LCD_Frame_Get to the
+ *	PCF8574A. With LCD_USE_I2C_QUEUE the frame is queued at display
+ *	priority so sensor transfers can go first
+ *	Input: None
+ *	Output: None
+ */
+static void LCD_Frame_Send(void){
+	
+	#ifdef LCD_USE_I2C_QUEUE
+	LCD_FRAME_t* slot = &lcd_frames[lcd_frame_next];
+	uint8_t status;
+	
+	slot->seg.data = slot->bytes;
+	slot->seg.len = LCD_FRAME_SIZE;
+	
+	slot->xfer.slave_addr = LCD_DEVICE.addr;
+	slot->xfer.dir = I2C_XFER_WRITE;
+	slot->xfer.segs = &slot->seg;
+	slot->xfer.seg_count = 1;
+	slot->xfer.callback = 0;
+	
+	/* A frame the queue turns down is dropped, marking it done keeps
+		 LCD_Frame_Get and LCD_Delay from waiting on it forever */
+	status = I2C_Queue_Submit(LCD_BUS, &slot->xfer, I2C_PRIO_DISPLAY);
+	if(status != I2C_OK){
+		slot->xfer.status = status;
+		slot->xfer.done = true;
+	}
+	lcd_frame_last = slot;
+	lcd_frame_next = (lcd_frame_next + 1) % LCD_FRAME_POOL_SIZE;
+	#else
+	I2C_Write_Segments(LCD_BUS, LCD_DEVICE.addr, &lcd_frame_seg, 1);
+	#endif
+}
+
+/*
+ *	---------------------LCD_Delay--------------------
+ *	Local function to give the controller time to run the last command.
+ *	With LCD_USE_I2C_QUEUE the frame may still be waiting in the queue,
+ *	so the delay only starts once it is on the wire
+ *	Input: Milliseconds to wait
+ *	Output: None
+ */
+static void LCD_Delay(uint32_t ms){
+	
+	#ifdef LCD_USE_I2C_QUEUE
+	if(lcd_frame_last != 0)
+		while(!lcd_frame_last->xfer.done)
+			I2C_SPIN();
+	#endif
+	
+	DELAY_1MS(ms);
+}
 
 /*
  *	-------------------LCD_Send_CMD------------------
@@ -24,7 +133,7 @@ static void LCD_Send_CMD(uint8_t cmd){
 	
 	/* Temp Variables to hold upper and lower value */
 	uint8_t cmd_upper, cmd_lower;
-	uint8_t cmd_array[4];								//Command Array to Burst Transmit
+	uint8_t* cmd_array = LCD_Frame_Get();	//Frame to Transmit, filled in place
 	
 	/* Seperate Upper and Lower Nibble */
 	cmd_upper = (cmd & UPPER_NIBBLE_MSK);        // Get upper 4 bits
@@ -36,8 +145,30 @@ static void LCD_Send_CMD(uint8_t cmd){
 	cmd_array[2] = cmd_lower | (BACKLIGHT|EN_Pin);    // EN high
 	cmd_array[3] = cmd_lower | BACKLIGHT;             // EN low
 	
-	/* I2C Burst Transmit Command Array to LCD */
-	I2C0_Burst_Transmit(LCD_WRITE_ADDR, PCF8574A_REG, cmd_array, sizeof(cmd_array));
+	/* I2C Transmit Command Frame to LCD */
+	LCD_Frame_Send();
+}
+
+/*
+ *	------------------LCD_Send_Nibble----------------
+ *	Local function to clock only the upper nibble of a command in. The
+ *	wake-up sequence runs while the controller is still in 8-bit mode,
+ *	where every EN pulse is a whole command, so a second nibble would
+ *	leave the 4-bit pairing one nibble off
+ *	Input: Command whose upper nibble is sent
+ *	Output: None
+ */
+static void LCD_Send_Nibble(uint8_t cmd){
+	
+	uint8_t* cmd_array = LCD_Frame_Get();	//Frame to Transmit, filled in place
+	
+	/* One EN pulse, the rest of the frame holds the pins still */
+	cmd_array[0] = (cmd & UPPER_NIBBLE_MSK) | (BACKLIGHT|EN_Pin);
+	cmd_array[1] = (cmd & UPPER_NIBBLE_MSK) | BACKLIGHT;
+	cmd_array[2] = (cmd & UPPER_NIBBLE_MSK) | BACKLIGHT;
+	cmd_array[3] = (cmd & UPPER_NIBBLE_MSK) | BACKLIGHT;
+	
+	LCD_Frame_Send();
 }
 
 /*
@@ -50,7 +181,7 @@ static void LCD_Send_Data(uint8_t data){
 	
 	/* Temp Variables to hold upper and lower value */
 	uint8_t data_upper, data_lower;
-	uint8_t data_array[4];							//Data Array to Burst Transmit
+	uint8_t* data_array = LCD_Frame_Get();	//Frame to Transmit, filled in place
 	
 	/* Seperate Upper and Lower Nibble */
 	data_upper = (data & UPPER_NIBBLE_MSK);        // Get upper 4 bits
@@ -63,8 +194,8 @@ static void LCD_Send_Data(uint8_t data){
 	data_array[2] = data_lower | (BACKLIGHT|EN_Pin|RS_Pin);
 	data_array[3] = data_lower | (BACKLIGHT|RS_Pin);
 	
-	/* I2C Burst Transmit Data Array to LCD */
-	I2C0_Burst_Transmit(LCD_WRITE_ADDR, PCF8574A_REG, data_array, sizeof(data_array));
+	/* I2C Transmit Data Frame to LCD */
+	LCD_Frame_Send();
 }
 
 /*
@@ -74,38 +205,41 @@ static void LCD_Send_Data(uint8_t data){
  *	Output: None
  */
 void LCD_Init(void) {
+    /* Talk to whichever expander address the bus scan found */
+    I2C_Scan_Bind(LCD_BUS, &LCD_DEVICE);
+    
     /* Initial delay for LCD to wake up */
     DELAY_1MS(50);
     
     /* 4-bit initialization sequence */
-    LCD_Send_CMD(INIT_REG_CMD);    // 0x30
-    DELAY_1MS(5);
-    LCD_Send_CMD(INIT_REG_CMD);    // 0x30
-    DELAY_1MS(1);
-    LCD_Send_CMD(INIT_REG_CMD);    // 0x30
-    DELAY_1MS(1);
-    LCD_Send_CMD(INIT_FUNC_CMD);   // 0x20
-    DELAY_1MS(1);
+    LCD_Send_Nibble(INIT_REG_CMD);    // 0x30
+    LCD_Delay(5);
+    LCD_Send_Nibble(INIT_REG_CMD);    // 0x30
+    LCD_Delay(1);
+    LCD_Send_Nibble(INIT_REG_CMD);    // 0x30
+    LCD_Delay(1);
+    LCD_Send_Nibble(INIT_FUNC_CMD);   // 0x20
+    LCD_Delay(1);
     
     /* Configure LCD operation mode */
     LCD_Send_CMD(FUNC_MODE|FUNC_4_BIT|FUNC_2_ROW|FUNC_5_7);
-    DELAY_1MS(1);
+    LCD_Delay(1);
     
     /* Display control */
     LCD_Send_CMD(DISP_CMD|DISP_OFF);
-    DELAY_1MS(1);
+    LCD_Delay(1);
     
     /* Clear display */
     LCD_Send_CMD(CLEAR_DISP_CMD);
-    DELAY_1MS(5);
+    LCD_Delay(5);
     
     /* Entry mode set */
     LCD_Send_CMD(ENTRY_MODE_CMD|ENTRY_INC_CURSOR);
-    DELAY_1MS(1);
+    LCD_Delay(1);
     
     /* Turn on display */
     LCD_Send_CMD(DISP_CMD|DISP_ON|DISP_CURSOR_ON|DISP_BLINK_ON);
-    DELAY_1MS(2);
+    LCD_Delay(2);
     
     /* Ensure display is clear */
     LCD_Clear();
@@ -122,9 +256,9 @@ void LCD_Init(void) {
  */
 void LCD_Clear(void) {
     LCD_Send_CMD(CLEAR_DISP_CMD);
-    DELAY_1MS(5);  // Clear needs longer delay
+    LCD_Delay(5);  // Clear needs longer delay
     LCD_Send_CMD(RETURN_HOME_CMD);
-    DELAY_1MS(2);
+    LCD_Delay(2);
 }
 
 
@@ -152,7 +286,7 @@ void LCD_Set_Cursor(uint8_t row, uint8_t col){
 	
 	/* Send Command to set Row and Column */
 	LCD_Send_CMD(col);
-	DELAY_1MS(2);
+	LCD_Delay(2);
 	
 }
 
@@ -164,7 +298,7 @@ void LCD_Set_Cursor(uint8_t row, uint8_t col){
  */
 void LCD_Reset_Cursor(void){
 	LCD_Send_CMD(RETURN_HOME_CMD);
-	DELAY_1MS(1);
+	LCD_Delay(1);
 }
 
 /*
@@ -175,7 +309,7 @@ void LCD_Reset_Cursor(void){
  */
 void LCD_Print_Char(uint8_t data){
 	LCD_Send_Data(data);
-	DELAY_1MS(1);
+	LCD_Delay(1);
 }
 
 /*
@@ -187,7 +321,7 @@ void LCD_Print_Char(uint8_t data){
 void LCD_Print_Str(uint8_t* str) {
     while(*str) {
         LCD_Send_Data(*str++);
-        DELAY_1MS(2);  
+        LCD_Delay(2);  
     }
 }
 
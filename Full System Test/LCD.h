@@ -13,9 +13,16 @@
 #define LCD_H_
 #include "util.h"
 
+/* Comment out to send LCD frames with blocking I2C_Burst_Transmit */
+#define LCD_USE_I2C_QUEUE
+
+/* Bus the PCF8574A backpack is wired to (I2C1 = PA6 SCL / PA7 SDA) so
+	 display refreshes run alongside sensor sampling on I2C0.
+	 Use I2C_BUS0 for the original single bus wiring on PB2/PB3 */
+#define LCD_BUS							I2C_BUS1
+
 /*************PCF8574A Register*************/
-#define LCD_WRITE_ADDR			(0x3FU)
-#define PCF8574A_REG				(0x00U)
+#define LCD_WRITE_ADDR			(0x3FU)	// Default, LCD_Init binds to the scanned address
 
 /**************LCD CMD Register*************/
 #define INIT_REG_CMD				(0x30U)
@@ -58,8 +65,15 @@
 #define ROW1								(0U)
 #define ROW2								(1U)
 #define LCD_ROW_SIZE				(16)
+#define LCD_FRAME_SIZE			(4)		// Bytes per nibble pair sent to PCF8574A
+#define LCD_FRAME_POOL_SIZE	(8)		// Display frames that can wait in the I2C queue
 
 #include <stdint.h>
+#include "I2C.h"
+
+/* Bus descriptor, PCF8574A is only specified for Standard mode (100kHz).
+	 addr is bound to the address found at boot by LCD_Init */
+extern I2C_DEVICE_t LCD_DEVICE;
 
 /*
  *	-------------------LCD_Init------------------
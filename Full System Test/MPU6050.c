@@ -11,6 +11,8 @@
  
 #include "MPU6050.h"
 #include "I2C.h"
+#include "I2CCache.h"
+#include "I2CScan.h"
 #include "UART0.h"
 #include "tm4c123gh6pm.h"
 #include <stdio.h>
@@ -27,6 +29,10 @@
 #define GYRO_LSB_2_VALUE		(32.8)
 #define GYRO_LSB_3_VALUE		(16.4)
 
+static const uint8_t MPU6050_Alt_Addr[] = {MPU6050_ADDR_AD0_HIGH};
+I2C_DEVICE_t MPU6050_DEVICE = {.name = "MPU6050", .addr = MPU6050_ADDR_AD0_LOW, .max_speed = I2C_SPEED_FAST,
+	.alt_addr = MPU6050_Alt_Addr, .alt_count = sizeof(MPU6050_Alt_Addr)};
+
 
 /*
  *	-------------------MPU6050_Init---------------------
@@ -39,20 +45,15 @@ void MPU6050_Init(void){
 	uint8_t ret;
 	char stringBuf[10];
 	
-	//If check does not equal to their respected address, MPU is not detected
-	#ifndef USE_HIGH
-	ret = I2C0_Receive(MPU6050_ADDR_AD0_LOW, WHO_AM_I);
-	if(ret != MPU6050_ADDR_AD0_LOW){
-		UART0_OutString("MPU6050 has not been Detected\r\n");
-		return;
-	}
-	#else
-	ret = I2C0_Receive(MPU6050_ADDR_AD0_HIGH, WHO_AM_I);
-	if(ret != MPU6050_ADDR_AD0_HIGH){
+	//Use whichever AD0 strapping the bus scan found, AD0 low if none
+	I2C_Scan_Bind(MPU6050_BUS, &MPU6050_DEVICE);
+	
+	//If check does not equal the device ID, MPU is not detected
+	ret = I2C0_Receive(MPU6050_DEVICE.addr, WHO_AM_I);
+	if(ret != MPU6050_ID){
 		UART0_OutString("MPU6050 has not been Detected\r\n");
 		return;
 	}
-	#endif
 	
 	//Print ID out to terminal
 	sprintf(stringBuf, "ID: %x\r\n", ret);
@@ -61,40 +62,47 @@ void MPU6050_Init(void){
 	UART0_OutString("MPU6050 has been Detected\r\n");
 	UART0_OutString("MPU6050 is initializing\r\n");
 	
-	/* Reset the MPU6050 Module */
-	ret = I2C0_Transmit(MPU6050_ADDR_AD0_LOW, PWR_MGMT_1, PWR_DEVICE_RESET);
+	/* Configuration only changes here, shadow it so scale lookups stay off the bus */
+	I2C_Cache_Declare(MPU6050_BUS, MPU6050_DEVICE.addr, SMPLRT_DIV);
+	I2C_Cache_Declare(MPU6050_BUS, MPU6050_DEVICE.addr, CONFIG);
+	I2C_Cache_Declare(MPU6050_BUS, MPU6050_DEVICE.addr, GYRO_CONFIG);
+	I2C_Cache_Declare(MPU6050_BUS, MPU6050_DEVICE.addr, ACCEL_CONFIG);
+	
+	/* Reset the MPU6050 Module, every register goes back to its default */
+	ret = I2C0_Transmit(MPU6050_DEVICE.addr, PWR_MGMT_1, PWR_DEVICE_RESET);
+	I2C_Cache_Invalidate(MPU6050_BUS, MPU6050_DEVICE.addr);
 	UART0_OutString("Reset MPU6050\r\n");
 	
 	/* 0 to wake up sensor */
-	ret = I2C0_Transmit(MPU6050_ADDR_AD0_LOW, PWR_MGMT_1, PWR_CLK_SEL_INTERNAL);
+	ret = I2C0_Transmit(MPU6050_DEVICE.addr, PWR_MGMT_1, PWR_CLK_SEL_INTERNAL);
 	if(ret != 0)
 		UART0_OutString("Error On Transmit\r\n");
 	else
 		UART0_OutString("Sensor is awake\r\n");
 	
 	/* Set Data Rate to 1kHz */
-	ret = I2C0_Transmit(MPU6050_ADDR_AD0_LOW, SMPLRT_DIV, SMPLRT_DIV_8);
+	ret = I2C_Cache_Write(MPU6050_BUS, MPU6050_DEVICE.addr, SMPLRT_DIV, SMPLRT_DIV_8);
 	if(ret != 0)
 		UART0_OutString("Error On Transmit\r\n");
 	else
 		UART0_OutString("Data Rate is 1kHz\r\n");
 	
 	/* Default Configuration */
-	ret = I2C0_Transmit(MPU6050_ADDR_AD0_LOW, CONFIG, CONFIG_DFPL_0);
+	ret = I2C_Cache_Write(MPU6050_BUS, MPU6050_DEVICE.addr, CONFIG, CONFIG_DFPL_0);
 	if(ret != 0)
 		UART0_OutString("Error On Transmit\r\n");
 	else
 		UART0_OutString("Default Configuration\r\n");
 	
 	/* Default config for Accelerometer */
-	ret = I2C0_Transmit(MPU6050_ADDR_AD0_LOW, ACCEL_CONFIG, ACCEL_AFS_SEL_0);
+	ret = I2C_Cache_Write(MPU6050_BUS, MPU6050_DEVICE.addr, ACCEL_CONFIG, ACCEL_AFS_SEL_0);
 	if(ret != 0)
 		UART0_OutString("Error On Transmit\r\n");
 	else
 		UART0_OutString("Default Accelerometer Configuration\r\n");
 	
 	/* Default config for Gyroscope */
-	ret = I2C0_Transmit(MPU6050_ADDR_AD0_LOW, GYRO_CONFIG, GYRO_FS_SEL_0);
+	ret = I2C_Cache_Write(MPU6050_BUS, MPU6050_DEVICE.addr, GYRO_CONFIG, GYRO_FS_SEL_0);
 	if(ret != 0)
 		UART0_OutString("Error On Transmit\r\n");
 	else
@@ -111,28 +119,16 @@ void MPU6050_Init(void){
  */
 void MPU6050_Get_Accel(MPU6050_ACCEL_t* Accel_Instance){
 	
-	/* Local Variables */
-	uint8_t ACCEL_X_LOW;
-	uint8_t ACCEL_X_HIGH;
-	uint8_t ACCEL_Y_LOW;
-	uint8_t ACCEL_Y_HIGH;
-	uint8_t ACCEL_Z_LOW;
-	uint8_t ACCEL_Z_HIGH;
+	uint8_t accel_buf[6];								//ACCEL_XOUT_H to ACCEL_ZOUT_L
 	
-	/* Grab 16-bit Accel data of each axis by reading ACCEL data register using I2C*/
-	//CODE_FILL
-	ACCEL_X_LOW = I2C0_Receive(MPU6050_ADDR_AD0_LOW, ACCEL_XOUT_L);
-	ACCEL_X_HIGH = I2C0_Receive(MPU6050_ADDR_AD0_LOW, ACCEL_XOUT_H); 
-	ACCEL_Y_LOW = I2C0_Receive(MPU6050_ADDR_AD0_LOW, ACCEL_YOUT_L);
-	ACCEL_Y_HIGH = I2C0_Receive(MPU6050_ADDR_AD0_LOW, ACCEL_YOUT_H);
-	ACCEL_Z_LOW = I2C0_Receive(MPU6050_ADDR_AD0_LOW, ACCEL_ZOUT_L);
-	ACCEL_Z_HIGH = I2C0_Receive(MPU6050_ADDR_AD0_LOW, ACCEL_ZOUT_H);
+	/* Grab 16-bit Accel data of each axis with one burst read starting at ACCEL_XOUT_H */
+	if(I2C0_Burst_Receive(MPU6050_DEVICE.addr, ACCEL_XOUT_H, accel_buf, sizeof(accel_buf)) != I2C_OK)
+		return;																//Keep last good sample on bus error
 	
-	/* Concatanate and Save Into Accelerometer Struct Instance */
-	//CODE_FILL
-	Accel_Instance->Ax_RAW = (ACCEL_X_HIGH<<8)|ACCEL_X_LOW;
-	Accel_Instance->Ay_RAW = (ACCEL_Y_HIGH<<8)|ACCEL_Y_LOW;
-	Accel_Instance->Az_RAW = (ACCEL_Z_HIGH<<8)|ACCEL_Z_LOW;
+	/* Concatanate and Save Into Accelerometer Struct Instance (High byte first) */
+	Accel_Instance->Ax_RAW = (int16_t)((accel_buf[0]<<8)|accel_buf[1]);
+	Accel_Instance->Ay_RAW = (int16_t)((accel_buf[2]<<8)|accel_buf[3]);
+	Accel_Instance->Az_RAW = (int16_t)((accel_buf[4]<<8)|accel_buf[5]);
 }
 
 /*
@@ -143,28 +139,16 @@ void MPU6050_Get_Accel(MPU6050_ACCEL_t* Accel_Instance){
  */
 void MPU6050_Get_Gyro(MPU6050_GYRO_t* Gyro_Instance){
 		
-	/* Local Variables */
-	uint8_t GYRO_X_LOW;
-	uint8_t GYRO_X_HIGH;
-	uint8_t GYRO_Y_LOW;
-	uint8_t GYRO_Y_HIGH;
-	uint8_t GYRO_Z_LOW;
-	uint8_t GYRO_Z_HIGH;
+	uint8_t gyro_buf[6];									//GYRO_XOUT_H to GYRO_ZOUT_L
 	
-	/* Grab 16-but Gyro Data of each Axis y reading GYRO data register using I2C*/
-	//CODE_FILL
-	GYRO_X_LOW = I2C0_Receive(MPU6050_ADDR_AD0_LOW, GYRO_XOUT_L);
-	GYRO_X_HIGH = I2C0_Receive(MPU6050_ADDR_AD0_LOW,GYRO_XOUT_H); 
-	GYRO_Y_LOW = I2C0_Receive(MPU6050_ADDR_AD0_LOW, GYRO_YOUT_L);
-	GYRO_Y_HIGH = I2C0_Receive(MPU6050_ADDR_AD0_LOW,GYRO_YOUT_H);
-	GYRO_Z_LOW = I2C0_Receive(MPU6050_ADDR_AD0_LOW, GYRO_ZOUT_L);
-	GYRO_Z_HIGH = I2C0_Receive(MPU6050_ADDR_AD0_LOW,GYRO_ZOUT_H);
+	/* Grab 16-bit Gyro data of each axis with one burst read starting at GYRO_XOUT_H */
+	if(I2C0_Burst_Receive(MPU6050_DEVICE.addr, GYRO_XOUT_H, gyro_buf, sizeof(gyro_buf)) != I2C_OK)
+		return;																//Keep last good sample on bus error
 	
-	/* Concatanate and Save Into Gyro Struct Instance */
-	//CODE_FILL
-	Gyro_Instance->Gx_RAW = (GYRO_X_HIGH<<8)|GYRO_X_LOW;
-	Gyro_Instance->Gy_RAW = (GYRO_Y_HIGH<<8)|GYRO_Y_LOW;
-	Gyro_Instance->Gz_RAW = (GYRO_Z_HIGH<<8)|GYRO_Z_LOW;
+	/* Concatanate and Save Into Gyro Struct Instance (High byte first) */
+	Gyro_Instance->Gx_RAW = (int16_t)((gyro_buf[0]<<8)|gyro_buf[1]);
+	Gyro_Instance->Gy_RAW = (int16_t)((gyro_buf[2]<<8)|gyro_buf[3]);
+	Gyro_Instance->Gz_RAW = (int16_t)((gyro_buf[4]<<8)|gyro_buf[5]);
 }
 
 /*
@@ -176,14 +160,11 @@ void MPU6050_Get_Gyro(MPU6050_GYRO_t* Gyro_Instance){
  */
 void MPU6050_Process_Accel(MPU6050_ACCEL_t* Accel_Instance){
 	
-	char LSB_Sensitivity;
+	uint8_t LSB_Sensitivity;
 	
-	//Read LSB Sensitivity Setting from ACCEL_CONFIG Register
-	#ifndef USE_HIGH
-		LSB_Sensitivity = I2C0_Receive(MPU6050_ADDR_AD0_LOW, ACCEL_CONFIG);
-	#else
-		LSB_Sensitivity = I2C0_Receive(MPU6050_ADDR_AD0_HIGH, ACCEL_CONFIG);
-	#endif
+	//Read LSB Sensitivity Setting from ACCEL_CONFIG Register (shadowed, no bus traffic)
+	if(I2C_Cache_Read(MPU6050_BUS, MPU6050_DEVICE.addr, ACCEL_CONFIG, &LSB_Sensitivity) != I2C_OK)
+		return;
 	
 	//Based on setting, process raw data accordingly
 	switch(LSB_Sensitivity){
@@ -219,14 +200,11 @@ void MPU6050_Process_Accel(MPU6050_ACCEL_t* Accel_Instance){
  */
 void MPU6050_Process_Gyro(MPU6050_GYRO_t* Gyro_Instance){
 	
-	char LSB_Sensitivity;
+	uint8_t LSB_Sensitivity;
 	
-	//Read LSB Sensitivity Setting from GYRO_CONFIG Register
-	#ifndef USE_HIGH
-		LSB_Sensitivity = I2C0_Receive(MPU6050_ADDR_AD0_LOW, GYRO_CONFIG);
-	#else
-		LSB_Sensitivity = I2C0_Receive(MPU6050_ADDR_AD0_HIGH, GYRO_CONFIG);
-	#endif
+	//Read LSB Sensitivity Setting from GYRO_CONFIG Register (shadowed, no bus traffic)
+	if(I2C_Cache_Read(MPU6050_BUS, MPU6050_DEVICE.addr, GYRO_CONFIG, &LSB_Sensitivity) != I2C_OK)
+		return;
 	
 	//Based on setting, process raw data accordingly
 	switch(LSB_Sensitivity){
@@ -284,6 +262,6 @@ void MPU6050_Get_Angle(MPU6050_ACCEL_t* Accel_Instance, MPU6050_GYRO_t* Gyro_Ins
 
 /* Used for Debugging Purposes */
 uint8_t MPU6050_Read_Reg(uint8_t reg){
-	return I2C0_Receive(MPU6050_ADDR_AD0_LOW, reg);
+	return I2C0_Receive(MPU6050_DEVICE.addr, reg);
 }
 
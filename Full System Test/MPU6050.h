@@ -15,6 +15,7 @@
 
 #include <stdint.h> // Standard integer types
 #include "util.h"	// Utility functions and macros
+#include "I2C.h"	// Device descriptor
 
 // NOTE: There will be no self-test regs
 
@@ -28,14 +29,11 @@ incur any penalties but will be a waste of time)
 
 /* List of MPU6050 Register Macros */
 
-// #define USE_HIGH // Uncomment if AD0 is pulled high
-
-/**********************************************************/
-#ifndef USE_HIGH
+/* AD0 strapping is picked up by the boot-time bus scan, see I2CScan.h */
 #define MPU6050_ADDR_AD0_LOW (0x68) // I2C address when AD0 is low
-#else
 #define MPU6050_ADDR_AD0_HIGH (0x69) // I2C address when AD0 is high
-#endif
+
+#define MPU6050_BUS I2C_BUS0 // Bus the IMU is wired to
 
 /*************Sampling Rate Register*************/
 #define SMPLRT_DIV (0x19)	// Sample rate divider register address
@@ -138,6 +136,7 @@ incur any penalties but will be a waste of time)
 #define PWR_CLK_SEL_INTERNAL (0x01) // Clock source selection: internal
 #define PWR_DEVICE_RESET (0x80)		// Device reset bit
 #define WHO_AM_I (0x75)				// Who am I register (device ID)
+#define MPU6050_ID (0x68)			// WHO_AM_I value, the same for either AD0 strapping
 /**********************************************************/
 
 #define PWR_MGMT_2 (0x6C)	 // Power management 2 register
@@ -192,6 +191,10 @@ typedef struct
 	float ArZ; // Tilt angle for Z-axis
 } MPU6050_ANGLE_t;
 
+/* Bus descriptor, MPU6050 is rated for Fast-mode (400kHz). addr is
+	 bound to the address found at boot by MPU6050_Init */
+extern I2C_DEVICE_t MPU6050_DEVICE;
+
 /*
  *	-------------------MPU6050_Init---------------------
  *	Basic Initialization Function for MPU6050 @ default settings
@@ -11,11 +11,19 @@
 
 #include "ModuleTest.h"
 #include "TCS34727.h"
+#include "TCS34727Filter.h"
 #include "MPU6050.h"
 #include "UART0.h"
 #include "Servo.h"
 #include "LCD.h"
 #include "I2C.h"
+#include "I2CAsync.h"
+#include "I2CTrace.h"
+#include "I2CStats.h"
+#include "I2CCache.h"
+#include "I2CSlave.h"
+#include "I2CBench.h"
+#include "EEPROM.h"
 #include "util.h"
 #include "ButtonLED.h"
 #include "tm4c123gh6pm.h"
@@ -41,7 +49,7 @@ static SERVO_STATE servo_state = SERVO_STATE_0;
 static char printBuf[100];
 static char angleBuf[LCD_ROW_SIZE];
 static char colorBuf[LCD_ROW_SIZE];
-static char colorString[6];
+static char colorString[8];
 const uint8_t color_wheel[] = {RED, GREEN, BLUE, YELLOW, CYAN, PURPLE, WHITE, DARK};
 const int color_wheel_size = 8; // Number of colors in the color wheel
 uint8_t ledColorIndex = 0;
@@ -49,9 +57,25 @@ unsigned volatile long currentColor = RED; // Current LED color
 extern volatile uint8_t mode;
 extern volatile bool firstRun;
 
+/* Names of COLOR_DETECTED for the console */
+static const char* const color_names[] = {"RED", "GREEN", "BLUE", "NOTHING", "YELLOW", "CYAN", "PURPLE", "WHITE", "BLACK"};
+
+/* Color calibration, references are captured in this order */
+static const COLOR_DETECTED cal_order[] = {BLACK_DETECT, WHITE_DETECT, RED_DETECT, GREEN_DETECT, BLUE_DETECT};
+#define CAL_STEPS (sizeof(cal_order) / sizeof(cal_order[0]))
+static TCS34727_PALETTE_t cal_refs[CAL_STEPS];
+static uint8_t cal_count = 0;
+static volatile bool calRequest = false;
+
 /* RGB Color Struct Instance */
 RGB_COLOR_HANDLE_t RGB_COLOR;
 
+#ifndef TCS34727_USE_INT
+/* Noise filter on the color samples of the full system test, threshold mode already waits out noise */
+static TCS34727_FILTER_t colorFilter;
+static bool colorFilterReady = false;
+#endif
+
 /* MPU6050 Struct Instance */
 MPU6050_ACCEL_t Accel_Instance;
 MPU6050_GYRO_t Gyro_Instance;
@@ -77,11 +101,50 @@ static void Test_I2C(void)
 {
 
 	// Command byte should be: Command bit (0x80) | Register address (0x12)
-	uint8_t sensorId = I2C0_Receive(TCS34727_ADDR, TCS34727_CMD | TCS34727_ID_R_ADDR);
+	uint8_t sensorId = I2C_Dev_Receive(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD | TCS34727_ID_R_ADDR);
 
 	sprintf(printBuf, " Sensor ID: 0x%x\r\n", sensorId);
 	UART0_OutString(printBuf);
 
+	/* Report bus rate and the payload throughput it allows (9 clocks per byte) */
+	uint32_t sclHz = I2C0_GetSpeed();
+	sprintf(printBuf, " I2C0 SCL: %lu Hz, max %lu bytes/s\r\n", (unsigned long)sclHz, (unsigned long)(sclHz / I2C_BITS_PER_BYTE));
+	UART0_OutString(printBuf);
+
+	/* Report bus faults and what recovering from them cost */
+	I2C_BUS_STATS_t busStats;
+	I2C0_Get_Bus_Stats(&busStats);
+	sprintf(printBuf, " Timeouts: %lu Retries: %lu Recoveries: %lu (max %lu cycles)\r\n", (unsigned long)busStats.timeouts,
+			(unsigned long)busStats.retries, (unsigned long)busStats.recoveries, (unsigned long)busStats.recovery_cycles_max);
+	UART0_OutString(printBuf);
+
+	/* Report how many register reads the shadow cache kept off the bus */
+	I2C_CACHE_STATS_t cacheStats;
+	I2C_Cache_Get_Stats(&cacheStats);
+	sprintf(printBuf, " Cache: %lu hits %lu misses %lu writes\r\n", (unsigned long)cacheStats.hits,
+			(unsigned long)cacheStats.misses, (unsigned long)cacheStats.writes);
+	UART0_OutString(printBuf);
+
+	/* Report queue counters for sensor and display class, the LCD has its own bus */
+	I2C_QUEUE_STATS_t queueStats;
+	for (uint8_t prio = 0; prio < I2C_PRIO_COUNT; prio++)
+	{
+		I2C_BUS_t *bus = (prio == I2C_PRIO_DISPLAY) ? LCD_BUS : I2C_BUS0;
+		I2C_Queue_Get_Stats(bus, (I2C_PRIO)prio, &queueStats);
+		sprintf(printBuf, " I2C%u Queue %u: sent %lu depth %u max %u wait max %lu cycles\r\n", bus->module, prio,
+				(unsigned long)queueStats.submitted, queueStats.depth, queueStats.max_depth, (unsigned long)queueStats.wait_max);
+		UART0_OutString(printBuf);
+	}
+
+#ifdef I2C_SLAVE_ENABLE
+	/* Report what the external controller pulled from the slave map */
+	I2C_SLAVE_STATS_t slaveStats;
+	I2C_Slave_Get_Stats(&slaveStats);
+	sprintf(printBuf, " Slave: %lu reads %lu bytes %lu published %lu skipped\r\n", (unsigned long)slaveStats.reads,
+			(unsigned long)slaveStats.bytes, (unsigned long)slaveStats.published, (unsigned long)slaveStats.skipped);
+	UART0_OutString(printBuf);
+#endif
+
 	DELAY_1MS(1000);
 }
 
@@ -112,20 +175,94 @@ static void Test_MPU6050(void)
 	DELAY_1MS(250);
 }
 
+/* Palette color of the last sample, unknown when the classifier is not sure */
+static COLOR_DETECTED Classify_Color(void)
+{
+	uint8_t confidence;
+	COLOR_DETECTED color = TCS34727_Classify(&RGB_COLOR, &confidence);
+
+	return (confidence < TCS34727_CONF_MIN) ? NOTHING_DETECT : color;
+}
+
+/* Fits the calibration to the references captured so far, applies and stores it */
+static void Test_Cal_Done(void)
+{
+	TCS34727_CAL_t cal;
+	uint8_t ret;
+
+	if (!TCS34727_Cal_Fit(cal_refs, cal_count, &cal))
+	{
+		UART0_OutString("Calibration failed, start again with BLACK");
+		UART0_OutCRLF();
+		cal_count = 0;
+		return;
+	}
+
+	TCS34727_Set_Cal(&cal);
+	ret = TCS34727_Cal_Save();
+	sprintf(printBuf, "Calibration from %u references, %s", cal_count, (ret == EEPROM_OK) ? "saved" : "not saved");
+	UART0_OutString(printBuf);
+	UART0_OutCRLF();
+	cal_count = 0;
+}
+
+/* Captures the next reference of cal_order, fits after the last one */
+static void Test_Cal_Step(void)
+{
+	if (TCS34727_Cal_Capture(cal_order[cal_count], &cal_refs[cal_count]) != I2C_OK)
+	{
+		UART0_OutString("Calibration read failed");
+		UART0_OutCRLF();
+		return;
+	}
+
+	sprintf(printBuf, "%s: %lu %lu %lu %lu", color_names[cal_order[cal_count]],
+		(unsigned long)cal_refs[cal_count].R_NORM, (unsigned long)cal_refs[cal_count].G_NORM,
+		(unsigned long)cal_refs[cal_count].B_NORM, (unsigned long)cal_refs[cal_count].C_NORM);
+	UART0_OutString(printBuf);
+	UART0_OutCRLF();
+
+	if (++cal_count == CAL_STEPS)
+	{
+		Test_Cal_Done();
+		return;
+	}
+	sprintf(printBuf, "Hold %s over the sensor and press SW2 or 'k'", color_names[cal_order[cal_count]]);
+	UART0_OutString(printBuf);
+	UART0_OutCRLF();
+}
+
 static void Test_TCS34727(void)
 {
 
-	/* Grab Raw Color Data From Sensor */
-	RGB_COLOR.R_RAW = TCS34727_GET_RAW_RED();
-	RGB_COLOR.B_RAW = TCS34727_GET_RAW_BLUE();
-	RGB_COLOR.G_RAW = TCS34727_GET_RAW_GREEN();
-	RGB_COLOR.C_RAW = TCS34727_GET_RAW_CLEAR();
+	/* Calibration step asked for with SW2 */
+	if (calRequest)
+	{
+		calRequest = false;
+		Test_Cal_Step();
+	}
+
+#ifdef TCS34727_USE_INT
+	/* Nothing to do until the INT line says the scene changed */
+	if(!TCS34727_Changed())
+		return;
+	TCS34727_Read_Change(&RGB_COLOR);
+#else
+	/* Grab Raw Color Data From Sensor, all four channels in one burst */
+	if (TCS34727_Read_RGBC(&RGB_COLOR) != I2C_OK)
+	{
+		UART0_OutString("Color read failed");
+		UART0_OutCRLF();
+		DELAY_1MS(250);
+		return;
+	}
+#endif
 
 	/* Process Raw Color Data to RGB Value */
-	TCS34727_GET_RGB(&RGB_COLOR);
+	TCS34727_GET_RGB_Fixed(&RGB_COLOR);
 
 	/* Change Onboard RGB LED Color to Detected Color */
-	switch (Detect_Color(&RGB_COLOR))
+	switch (Classify_Color())
 	{
 	case RED_DETECT:
 		LEDs = RED;
@@ -136,15 +273,36 @@ static void Test_TCS34727(void)
 	case BLUE_DETECT:
 		LEDs = BLUE;
 		break;
+	case YELLOW_DETECT:
+		LEDs = YELLOW;
+		break;
+	case CYAN_DETECT:
+		LEDs = CYAN;
+		break;
+	case PURPLE_DETECT:
+		LEDs = PURPLE;
+		break;
+	case WHITE_DETECT:
+		LEDs = WHITE;
+		break;
+	case BLACK_DETECT:
 	case NOTHING_DETECT:
 		LEDs = DARK;
 		break;
 	}
 	/* Format String to Print RGB value*/
-	sprintf(printBuf, "R: %0.2f G: %0.2f B: %0.2f", (float)RGB_COLOR.R, (float)RGB_COLOR.G, (float)RGB_COLOR.B);
+	sprintf(printBuf, "R: %u G: %u B: %u", RGB_COLOR.R_INT, RGB_COLOR.G_INT, RGB_COLOR.B_INT);
 	UART0_OutString(printBuf);
 	UART0_OutCRLF();
 
+	/* Illuminance and color temperature, to compare lighting between runs */
+	if (TCS34727_Get_Lux_CCT(&RGB_COLOR))
+	{
+		sprintf(printBuf, "Lux: %lu.%03lu CCT: %uK", (unsigned long)(RGB_COLOR.LUX_MILLI / 1000), (unsigned long)(RGB_COLOR.LUX_MILLI % 1000), RGB_COLOR.CCT);
+		UART0_OutString(printBuf);
+		UART0_OutCRLF();
+	}
+
 	DELAY_1MS(250);
 }
 
@@ -214,6 +372,36 @@ static void Test_LCD(void) {
 }
 
 
+#ifdef I2C_SLAVE_ENABLE
+/* Hands the latest full system sample to the I2C slave data server */
+static void Publish_Sample(COLOR_DETECTED color)
+{
+    I2C_SLAVE_MAP_t sample = {0};
+
+    sample.rgbc[0] = RGB_COLOR.R_RAW;
+    sample.rgbc[1] = RGB_COLOR.G_RAW;
+    sample.rgbc[2] = RGB_COLOR.B_RAW;
+    sample.rgbc[3] = RGB_COLOR.C_RAW;
+    sample.color = color;
+
+    sample.accel[0] = Accel_Instance.Ax_RAW;
+    sample.accel[1] = Accel_Instance.Ay_RAW;
+    sample.accel[2] = Accel_Instance.Az_RAW;
+    sample.gyro[0] = Gyro_Instance.Gx_RAW;
+    sample.gyro[1] = Gyro_Instance.Gy_RAW;
+    sample.gyro[2] = Gyro_Instance.Gz_RAW;
+
+    /* Hundredths of a degree, +-180 deg fits an int16 */
+    sample.angle[0] = (int16_t)(Angle_Instance.ArX * 100.0f);
+    sample.angle[1] = (int16_t)(Angle_Instance.ArY * 100.0f);
+    sample.angle[2] = (int16_t)(Angle_Instance.ArZ * 100.0f);
+    sample.servo = (int16_t)Angle_Instance.ArX;
+
+    /* Dropped only while a host read of the older sample is in flight */
+    I2C_Slave_Publish(&sample);
+}
+#endif
+
 static void Test_Full_System(void)
 {
     // Step 1: Grab Accelerometer and Gyroscope Raw Data
@@ -230,17 +418,25 @@ static void Test_Full_System(void)
     // Step 4: Drive Servo Accordingly to Tilt Angle on X-Axis
     Drive_Servo((int16_t)Angle_Instance.ArX);
 
-    // Step 5: Grab Raw Color Data From Sensor
-    RGB_COLOR.R_RAW = TCS34727_GET_RAW_RED();
-    RGB_COLOR.G_RAW = TCS34727_GET_RAW_GREEN();
-    RGB_COLOR.B_RAW = TCS34727_GET_RAW_BLUE();
-    RGB_COLOR.C_RAW = TCS34727_GET_RAW_CLEAR();
+#ifdef TCS34727_USE_INT
+    // Step 5: Grab Raw Color Data only when the sensor flagged a new scene, else keep the last
+    if(TCS34727_Changed())
+        TCS34727_Read_Change(&RGB_COLOR);
+#else
+    // Step 5: Grab Raw Color Data From Sensor, all channels from one integration
+    TCS34727_Read_RGBC(&RGB_COLOR);
+
+    // Step 5b: Filter out sample to sample noise, RAW becomes the filtered counts
+    if (!colorFilterReady)
+        colorFilterReady = TCS34727_Filter_Init(&colorFilter, COLOR_FILTER_TYPE, COLOR_FILTER_N);
+    TCS34727_Filter_Update(&colorFilter, &RGB_COLOR);
+#endif
 
     // Step 6: Process Raw Color Data to RGB Value
-    TCS34727_GET_RGB(&RGB_COLOR);
+    TCS34727_GET_RGB_Fixed(&RGB_COLOR);
 
     // Step 7: Change Onboard RGB LED Color to Detected Color
-    int detectedColor = Detect_Color(&RGB_COLOR);
+    int detectedColor = Classify_Color();
     switch (detectedColor)
     {
     case RED_DETECT:
@@ -255,14 +451,39 @@ static void Test_Full_System(void)
         LEDs = BLUE;
         strcpy(colorString, "BLUE");
         break;
+    case YELLOW_DETECT:
+        LEDs = YELLOW;
+        strcpy(colorString, "YELLOW");
+        break;
+    case CYAN_DETECT:
+        LEDs = CYAN;
+        strcpy(colorString, "CYAN");
+        break;
+    case PURPLE_DETECT:
+        LEDs = PURPLE;
+        strcpy(colorString, "PURPLE");
+        break;
+    case WHITE_DETECT:
+        LEDs = WHITE;
+        strcpy(colorString, "WHITE");
+        break;
+    case BLACK_DETECT:
+        LEDs = DARK;
+        strcpy(colorString, "BLACK");
+        break;
     case NOTHING_DETECT:
         LEDs = DARK;
         strcpy(colorString, "NA");
         break;
     }
 
+#ifdef I2C_SLAVE_ENABLE
+    // Step 7b: Make the new sample readable over the I2C slave map
+    Publish_Sample((COLOR_DETECTED)detectedColor);
+#endif
+
     // Step 8: Format String to Print RGB value
-    sprintf(printBuf, "R: %0.2f G: %0.2f B: %0.2f", (float)RGB_COLOR.R, (float)RGB_COLOR.G, (float)RGB_COLOR.B);
+    sprintf(printBuf, "R: %u G: %u B: %u", RGB_COLOR.R_INT, RGB_COLOR.G_INT, RGB_COLOR.B_INT);
     UART0_OutString(printBuf);
     UART0_OutCRLF();
 
@@ -286,9 +507,168 @@ static void Test_Full_System(void)
     DELAY_1MS(20);
 }
 
+/* Loopback benchmark of the bare I2C peripheral, no sensors involved */
+static void Test_I2C_Bench(void)
+{
+	static bool benchReady = false;
+	static const uint32_t speeds[] = {I2C_SPEED_STANDARD, I2C_SPEED_FAST, I2C_SPEED_FAST_PLUS};
+	I2C_BENCH_RESULT_t result;
+	uint32_t sysclk = SYSCLK_Get_Hz();
+
+	if (!benchReady)
+	{
+		I2C_Bench_Init(I2C_BENCH_BUS);
+		benchReady = true;
+	}
+
+	sprintf(printBuf, "I2C%u loopback, %u x %u byte bursts\r\n", I2C_BENCH_BUS->module, I2C_BENCH_REPS, I2C_BENCH_LEN);
+	UART0_OutString(printBuf);
+
+	for (uint8_t speed = 0; speed < sizeof(speeds) / sizeof(speeds[0]); speed++)
+	{
+		for (uint8_t benchMode = I2C_BENCH_POLLED; benchMode <= I2C_BENCH_IRQ; benchMode++)
+		{
+			for (uint8_t dir = I2C_XFER_WRITE; dir <= I2C_XFER_READ; dir++)
+			{
+				I2C_Bench_Run(I2C_BENCH_BUS, speeds[speed], (I2C_BENCH_MODE)benchMode, (I2C_XFER_DIR)dir, &result);
+				I2C_Bench_Format(&result, sysclk, printBuf);
+				UART0_OutString(printBuf);
+			}
+		}
+	}
+}
+
+/* Distance of a fixed-point channel from the float one, truncated and capped at 255 */
+static uint8_t Norm_Diff(float value, uint8_t fixed)
+{
+	uint8_t truncated = (value >= 255.0f) ? 255 : (uint8_t)value;
+
+	return (truncated > fixed) ? truncated - fixed : fixed - truncated;
+}
+
+/* Cycle count of the float and fixed-point color normalization on the last sample */
+static void Test_Norm_Bench(void)
+{
+	RGB_COLOR_HANDLE_t sample = RGB_COLOR;
+	uint32_t start, floatCycles, fixedCycles;
+	uint8_t maxDiff;
+
+	start = CYCCNT_Get();
+	for (uint16_t rep = 0; rep < NORM_BENCH_REPS; rep++)
+		TCS34727_GET_RGB(&sample);
+	floatCycles = CYCCNT_Get() - start;
+
+	start = CYCCNT_Get();
+	for (uint16_t rep = 0; rep < NORM_BENCH_REPS; rep++)
+		TCS34727_GET_RGB_Fixed(&sample);
+	fixedCycles = CYCCNT_Get() - start;
+
+	/* Fixed point may sit one below the truncated float */
+	maxDiff = Norm_Diff(sample.R, sample.R_INT);
+	if (Norm_Diff(sample.G, sample.G_INT) > maxDiff) maxDiff = Norm_Diff(sample.G, sample.G_INT);
+	if (Norm_Diff(sample.B, sample.B_INT) > maxDiff) maxDiff = Norm_Diff(sample.B, sample.B_INT);
+
+	sprintf(printBuf, "RGBC %u %u %u %u, cycles/call float %lu fixed %lu, diff %u\r\n",
+		sample.R_RAW, sample.G_RAW, sample.B_RAW, sample.C_RAW,
+		(unsigned long)(floatCycles / NORM_BENCH_REPS), (unsigned long)(fixedCycles / NORM_BENCH_REPS), maxDiff);
+	UART0_OutString(printBuf);
+}
+
+/* Classifies the last sample and prints it as a line tools/tcs34727_lut_gen.py --check
+   reads once the first field is set to the real color, with the cycles it took */
+static void Test_Classify_Bench(void)
+{
+	COLOR_DETECTED color;
+	uint8_t confidence;
+	uint32_t start, cycles;
+
+	start = CYCCNT_Get();
+	for (uint16_t rep = 0; rep < NORM_BENCH_REPS; rep++)
+		color = TCS34727_Classify(&RGB_COLOR, &confidence);
+	cycles = CYCCNT_Get() - start;
+
+	sprintf(printBuf, "%s,%u,%u,%u,%u,%lu,%u,%lu\r\n", color_names[color],
+		RGB_COLOR.R_RAW, RGB_COLOR.G_RAW, RGB_COLOR.B_RAW, RGB_COLOR.C_RAW,
+		(unsigned long)TCS34727_Get_Exposure(), confidence, (unsigned long)(cycles / NORM_BENCH_REPS));
+	UART0_OutString(printBuf);
+}
+
+/* Lux and CCT of the last sample with the cycles one call takes */
+static void Test_Lux_Bench(void)
+{
+	RGB_COLOR_HANDLE_t sample = RGB_COLOR;
+	uint32_t start, cycles;
+	uint8_t valid = 0;
+
+	start = CYCCNT_Get();
+	for (uint16_t rep = 0; rep < NORM_BENCH_REPS; rep++)
+		valid = TCS34727_Get_Lux_CCT(&sample);
+	cycles = CYCCNT_Get() - start;
+
+	sprintf(printBuf, "RGBC %u %u %u %u, %s lux %lu.%03lu CCT %uK, cycles/call %lu\r\n",
+		sample.R_RAW, sample.G_RAW, sample.B_RAW, sample.C_RAW, valid ? "valid" : "invalid",
+		(unsigned long)(sample.LUX_MILLI / 1000), (unsigned long)(sample.LUX_MILLI % 1000), sample.CCT,
+		(unsigned long)(cycles / NORM_BENCH_REPS));
+	UART0_OutString(printBuf);
+}
+
+/* Handles a console command if one was typed, never waits for input */
+static void Console_Poll(void)
+{
+	switch (UART0_InCharNonBlocking())
+	{
+	case CMD_STATS_PRINT:
+		I2C_Stats_Print();
+		break;
+
+	case CMD_STATS_RESET:
+		I2C_Stats_Reset();
+		break;
+
+	case CMD_BENCH:
+		Test_I2C_Bench();
+		break;
+
+	case CMD_NORM_BENCH:
+		Test_Norm_Bench();
+		break;
+
+	case CMD_CLASSIFY:
+		Test_Classify_Bench();
+		break;
+
+	case CMD_LUX:
+		Test_Lux_Bench();
+		break;
+
+	case CMD_CAL_STEP:
+		Test_Cal_Step();
+		break;
+
+	case CMD_CAL_DONE:
+		Test_Cal_Done();
+		break;
+
+#ifdef I2C_TRACE_ENABLE
+	case CMD_TRACE_DUMP:
+		I2C_Trace_Dump();
+		break;
+
+	case CMD_TRACE_CLEAR:
+		I2C_Trace_Clear();
+		break;
+#endif
+
+	default:
+		break;
+	}
+}
+
 void Module_Test(MODULE_TEST_NAME test)
 {
 
+	Console_Poll();
+
 	switch (test)
 	{
 	case DELAY_TEST:
@@ -352,12 +732,14 @@ void GPIOPortF_Handler(void)
 		}
 		else if (mode == I2C_TEST)
 		{
+			GPIO_PORTF_IM_R |= SW2_PIN; // arm interrupt on PF4, calibration step
 			mode = TCS34727_TEST; // color sensor
 			firstRun = false;
 			
 		}
 		else if (mode == TCS34727_TEST)
 		{
+			GPIO_PORTF_IM_R &= ~SW2_PIN; // disarm interrupt on PF4
 			mode = MPU6050_TEST;	//gyro	
 			firstRun = false;
 		}
@@ -398,6 +780,11 @@ void GPIOPortF_Handler(void)
 			currentColor = color_wheel[ledColorIndex];
 			LEDs = currentColor;
 		}
+		else if (mode == TCS34727_TEST)
+		{
+			// calibration step, done by Test_TCS34727 outside the handler
+			calRequest = true;
+		}
 		PORTF_FLAGS |= SW2_PIN; // Clear interrupt flag
 	}
 }
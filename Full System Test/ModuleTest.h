@@ -9,6 +9,24 @@
  *
  */
  
+/* Console Commands, single characters typed on UART0 */
+#define CMD_TRACE_DUMP		't'		// Binary dump of the I2C trace ring
+#define CMD_TRACE_CLEAR		'T'		// Empty the I2C trace ring
+#define CMD_STATS_PRINT		's'		// Print per device I2C statistics
+#define CMD_STATS_RESET		'S'		// Clear per device I2C statistics
+#define CMD_BENCH			'b'		// I2C loopback throughput benchmark
+#define CMD_NORM_BENCH		'n'		// Float vs fixed-point color normalization cycles
+#define CMD_CLASSIFY		'c'		// Palette class of the last sample, as a CSV line with cycles
+#define CMD_LUX				'l'		// Lux and CCT of the last sample with cycles
+#define CMD_CAL_STEP		'k'		// Capture the next calibration reference, SW2 in the color sensor test too
+#define CMD_CAL_DONE		'K'		// Fit and store the calibration from the references so far
+
+#define NORM_BENCH_REPS		100		// Calls timed per normalization path, classification and lux
+
+/* Color sample filter of the full system test, see TCS34727Filter.h */
+#define COLOR_FILTER_TYPE	TCS34727_FILTER_MEDIAN
+#define COLOR_FILTER_N		5		// Window, or the EMA shift
+
 typedef enum{
 	DELAY_TEST,
 	UART_TEST,
@@ -0,0 +1,437 @@
+/*
+ * SoftI2C.c
+ *
+ *	Main implementation of the bit-banged I2C master
+ *
+ * Created on: October 17th, 2026
+ *
+ */
+
+#include "SoftI2C.h"
+#include "tm4c123gh6pm.h"
+#include "util.h"
+
+/* Soft Bus Handles, PB0/PB1 are not used by anything else on the board */
+SOFT_I2C_t Soft_I2C[SOFT_I2C_COUNT] = {
+	{.gpio_base = GPIOB_BASE_ADDR, .gpio_port = SYSCTL_RCGCGPIO_R1, .scl_pin = 0x01, .sda_pin = 0x02}		// PB0/PB1
+};
+
+/* Both lines are released by making them inputs, DATA stays 0 so an
+	 output always pulls low. Each level read goes through the pin's own
+	 bit-specific DATA address */
+#define SCL_LOW(bus)        (SOFT_I2C_GPIO_REG(bus, GPIO_DIR_OFFSET) |= (bus)->scl_pin)
+#define SCL_RELEASE(bus)    (SOFT_I2C_GPIO_REG(bus, GPIO_DIR_OFFSET) &= ~(bus)->scl_pin)
+#define SDA_LOW(bus)        (SOFT_I2C_GPIO_REG(bus, GPIO_DIR_OFFSET) |= (bus)->sda_pin)
+#define SDA_RELEASE(bus)    (SOFT_I2C_GPIO_REG(bus, GPIO_DIR_OFFSET) &= ~(bus)->sda_pin)
+#define SCL_READ(bus)       (SOFT_I2C_GPIO_REG(bus, (uint32_t)(bus)->scl_pin << 2) != 0)
+#define SDA_READ(bus)       (SOFT_I2C_GPIO_REG(bus, (uint32_t)(bus)->sda_pin << 2) != 0)
+
+/*
+ *	-------------------Soft_Wait----------------------
+ *	Local function to wait until a phase has run since the last edge
+ *	Input: Soft Bus, Phase length in cycles
+ *	Output: None
+ */
+static void Soft_Wait(SOFT_I2C_t* bus, uint32_t cycles){
+	while((CYCCNT_Get() - bus->edge) < cycles);
+}
+
+/*
+ *	------------------Soft_SCL_Low--------------------
+ *	Local function ending a high phase
+ *	Input: Soft Bus
+ *	Output: None
+ */
+static void Soft_SCL_Low(SOFT_I2C_t* bus){
+	Soft_Wait(bus, bus->high_cycles);
+	SCL_LOW(bus);
+	bus->edge = CYCCNT_Get();
+}
+
+/*
+ *	------------------Soft_SCL_High-------------------
+ *	Local function ending a low phase. The high phase is timed from
+ *	when SCL is seen high, so a slave stretching the clock only delays it
+ *	Input: Soft Bus
+ *	Output: I2C_OK, or I2C_ERR_TIMEOUT if SCL is held low too long
+ */
+static uint8_t Soft_SCL_High(SOFT_I2C_t* bus){
+
+	uint32_t start;
+
+	Soft_Wait(bus, bus->low_cycles);
+	SCL_RELEASE(bus);
+
+	/* Covers the rise time as well as a slave holding SCL */
+	start = CYCCNT_Get();
+	while(!SCL_READ(bus)){
+		if((CYCCNT_Get() - start) > bus->timeout_cycles)
+			return I2C_ERR_TIMEOUT;
+	}
+
+	bus->edge = CYCCNT_Get();
+	return I2C_OK;
+}
+
+/*
+ *	-------------------Soft_Start---------------------
+ *	Local function for a START, or a repeated START when SCL is low.
+ *	Leaves SCL low
+ *	Input: Soft Bus
+ *	Output: I2C_OK, or I2C_ERR_TIMEOUT
+ */
+static uint8_t Soft_Start(SOFT_I2C_t* bus){
+
+	uint8_t error;
+
+	SDA_RELEASE(bus);
+	error = Soft_SCL_High(bus);
+	if(error != I2C_OK)
+		return error;
+
+	/* SDA falls while SCL is high. Setup and hold are a low phase each,
+		 the high phase is shorter than tSU;STA in standard mode */
+	Soft_Wait(bus, bus->low_cycles);
+	SDA_LOW(bus);
+	bus->edge = CYCCNT_Get();
+	Soft_Wait(bus, bus->low_cycles);
+	SCL_LOW(bus);
+	bus->edge = CYCCNT_Get();
+
+	return I2C_OK;
+}
+
+/*
+ *	--------------------Soft_Stop---------------------
+ *	Local function for a STOP, entered with SCL low. Setup is a low
+ *	phase, and the bus is left free for another one (tBUF)
+ *	Input: Soft Bus
+ *	Output: I2C_OK, or I2C_ERR_TIMEOUT
+ */
+static uint8_t Soft_Stop(SOFT_I2C_t* bus){
+
+	uint8_t error;
+
+	SDA_LOW(bus);
+	error = Soft_SCL_High(bus);
+
+	/* Let go of SDA either way so a stuck slave does not leave us driving it */
+	Soft_Wait(bus, bus->low_cycles);
+	SDA_RELEASE(bus);
+	bus->edge = CYCCNT_Get();
+	Soft_Wait(bus, bus->low_cycles);
+
+	return error;
+}
+
+/*
+ *	--------------------Soft_Bit----------------------
+ *	Local function clocking one bit out and sampling the line at the
+ *	end of the high phase. A 1 releases SDA so the slave can drive it
+ *	Input: Soft Bus, Bit to send, Bit seen on the bus
+ *	Output: I2C_OK, or I2C_ERR_TIMEOUT
+ */
+static uint8_t Soft_Bit(SOFT_I2C_t* bus, uint8_t bit, uint8_t* seen){
+
+	uint8_t error;
+
+	/* SDA only ever changes while SCL is low */
+	if(bit)
+		SDA_RELEASE(bus);
+	else
+		SDA_LOW(bus);
+
+	error = Soft_SCL_High(bus);
+	if(error != I2C_OK)
+		return error;
+
+	Soft_Wait(bus, bus->high_cycles);
+	*seen = SDA_READ(bus);
+	Soft_SCL_Low(bus);
+
+	return I2C_OK;
+}
+
+/*
+ *	-----------------Soft_Write_Byte------------------
+ *	Local function sending a byte MSB first and reading the ACK bit
+ *	Input: Soft Bus, Byte, NACK error to report
+ *	Output: I2C_OK, the NACK error, or I2C_ERR_TIMEOUT
+ */
+static uint8_t Soft_Write_Byte(SOFT_I2C_t* bus, uint8_t byte, uint8_t nack){
+
+	uint8_t bit;
+	uint8_t seen;
+	uint8_t error;
+
+	for(bit = 0; bit < 8; bit++){
+		error = Soft_Bit(bus, byte & 0x80, &seen);
+		if(error != I2C_OK)
+			return error;
+		byte <<= 1;
+	}
+
+	error = Soft_Bit(bus, 1, &seen);
+	if(error != I2C_OK)
+		return error;
+
+	return seen ? nack : I2C_OK;
+}
+
+/*
+ *	-----------------Soft_Read_Byte-------------------
+ *	Local function reading a byte MSB first and answering it
+ *	Input: Soft Bus, Byte read, 1 to ACK (more to come), 0 to NACK
+ *	Output: I2C_OK, or I2C_ERR_TIMEOUT
+ */
+static uint8_t Soft_Read_Byte(SOFT_I2C_t* bus, uint8_t* byte, uint8_t ack){
+
+	uint8_t bit;
+	uint8_t seen;
+	uint8_t error;
+	uint8_t value = 0;
+
+	for(bit = 0; bit < 8; bit++){
+		error = Soft_Bit(bus, 1, &seen);
+		if(error != I2C_OK)
+			return error;
+		value = (value << 1) | seen;
+	}
+
+	*byte = value;
+	return Soft_Bit(bus, !ack, &seen);
+}
+
+/*
+ *	-----------------Soft_Calibrate-------------------
+ *	Local function timing the edge primitives with no phase wait. The
+ *	SCL rise time of the board ends up in it too. SDA stays released,
+ *	so the pulses are not a START or STOP to anyone
+ *	Input: Soft Bus
+ *	Output: Cycles one edge costs
+ */
+static uint32_t Soft_Calibrate(SOFT_I2C_t* bus){
+
+	uint8_t loop;
+	uint32_t start;
+
+	bus->low_cycles = 0;
+	bus->high_cycles = 0;
+	bus->edge = CYCCNT_Get();
+
+	start = CYCCNT_Get();
+	for(loop = 0; loop < SOFT_I2C_CAL_LOOPS; loop++){
+		Soft_SCL_Low(bus);
+		if(Soft_SCL_High(bus) != I2C_OK)
+			return 0;
+	}
+
+	return (CYCCNT_Get() - start) / (2 * SOFT_I2C_CAL_LOOPS);
+}
+
+/*
+ *	------------------SoftI2C_Init-------------------
+ *	Turns on the port clock, releases both lines, calibrates the edge
+ *	overhead and sets 100kHz
+ *	Input: Soft Bus
+ *	Output: None
+ */
+void SoftI2C_Init(SOFT_I2C_t* bus){
+
+	uint8_t pin;
+	uint8_t pins = bus->scl_pin | bus->sda_pin;
+	uint32_t pctl = 0;
+
+	for(pin = 0; pin < 8; pin++){
+		if(pins & (1U << pin))
+			pctl |= 0xFU << (pin * 4);
+	}
+
+	SYSCTL_RCGCGPIO_R |= bus->gpio_port;								//Enable GPIO Port System Clock
+	while((SYSCTL_PRGPIO_R & bus->gpio_port) == 0);
+
+	/* Plain GPIO, both lines released (inputs) with 0 waiting in DATA */
+	SOFT_I2C_GPIO_REG(bus, GPIO_DIR_OFFSET)   &= ~pins;
+	SOFT_I2C_GPIO_REG(bus, GPIO_AFSEL_OFFSET) &= ~pins;
+	SOFT_I2C_GPIO_REG(bus, GPIO_PCTL_OFFSET)  &= ~pctl;
+	SOFT_I2C_GPIO_REG(bus, GPIO_AMSEL_OFFSET) &= ~pins;
+	SOFT_I2C_GPIO_REG(bus, GPIO_PUR_OFFSET)   |= pins;				//Weak pull-up, external resistors still needed above 100kHz
+	SOFT_I2C_GPIO_REG(bus, GPIO_DEN_OFFSET)   |= pins;
+	SOFT_I2C_GPIO_REG(bus, (uint32_t)pins << 2) = 0;
+
+	if(!(DWT_CTRL_R & DWT_CYCCNTENA))
+		CYCCNT_Init();
+	bus->timeout_cycles = (SYSCLK_Get_Hz() / 1000000) * I2C_TIMEOUT_DEFAULT_US;
+
+	bus->overhead = Soft_Calibrate(bus);
+	SoftI2C_SetSpeed(bus, I2C_SPEED_STANDARD);
+}
+
+/*
+ *	-----------------SoftI2C_SetSpeed----------------
+ *	Splits the SCL period SOFT_I2C_LOW_PCT low, the rest high, rounded
+ *	so SCL never runs faster than asked, and takes the edge overhead
+ *	off each phase
+ *	Input: Soft Bus, Requested SCL rate in Hz
+ *	Output: SCL rate expected in Hz, 0 if out of range
+ */
+uint32_t SoftI2C_SetSpeed(SOFT_I2C_t* bus, uint32_t scl_hz){
+
+	uint32_t sys_clk = SYSCLK_Get_Hz();
+	uint32_t period;
+	uint32_t low;
+	uint32_t high;
+
+	/* Asserting Param */
+	if(scl_hz == 0 || scl_hz > SOFT_I2C_MAX_SPEED)
+		return 0;
+
+	period = (sys_clk + scl_hz - 1) / scl_hz;
+	low = (period * SOFT_I2C_LOW_PCT + 99) / 100;
+	high = period - low;
+
+	/* Phases shorter than an edge costs cannot be made any shorter */
+	bus->low_cycles = (low > bus->overhead) ? low - bus->overhead : 0;
+	bus->high_cycles = (high > bus->overhead) ? high - bus->overhead : 0;
+
+	return sys_clk / (bus->low_cycles + bus->high_cycles + 2 * bus->overhead);
+}
+
+/*
+ *	-------------SoftI2C_SetSpeed_For_Devices----------
+ *	Runs the soft bus at the fastest rate every listed device on it allows
+ *	Input: Soft Bus, Array of device descriptors, Number of devices
+ *	Output: SCL rate expected in Hz, 0 if out of range
+ */
+uint32_t SoftI2C_SetSpeed_For_Devices(SOFT_I2C_t* bus, const I2C_DEVICE_t* const devices[], uint8_t count){
+
+	uint8_t i;
+	uint32_t scl_hz = SOFT_I2C_MAX_SPEED;
+
+	for(i = 0; i < count; i++){
+		if(devices[i] != 0 && devices[i]->soft == bus && devices[i]->max_speed < scl_hz)
+			scl_hz = devices[i]->max_speed;
+	}
+
+	return SoftI2C_SetSpeed(bus, scl_hz);
+}
+
+/*
+ *	--------------SoftI2C_Burst_Receive--------------
+ *	Register write, repeated START, then size bytes read, the last one
+ *	NACKed. A STOP is sent whatever happens
+ *	Input: Soft Bus, Slave address, Slave Register Address, Data Buffer, Size of Receive
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t SoftI2C_Burst_Receive(SOFT_I2C_t* bus, uint8_t slave_addr, uint8_t slave_reg_addr, uint8_t* data, uint32_t size){
+
+	uint32_t i;
+	uint8_t error;
+
+	/* Asserting Param */
+	if(data == 0 || size == 0)
+		return I2C_ERR_PARAM;
+
+	bus->edge = CYCCNT_Get();
+
+	error = Soft_Start(bus);
+	if(error == I2C_OK)
+		error = Soft_Write_Byte(bus, slave_addr << 1, I2C_MCS_ERROR|I2C_MCS_ADRACK);
+	if(error == I2C_OK)
+		error = Soft_Write_Byte(bus, slave_reg_addr, I2C_MCS_ERROR|I2C_MCS_DATACK);
+	if(error == I2C_OK)
+		error = Soft_Start(bus);
+	if(error == I2C_OK)
+		error = Soft_Write_Byte(bus, (slave_addr << 1) | 1, I2C_MCS_ERROR|I2C_MCS_ADRACK);
+
+	for(i = 0; i < size && error == I2C_OK; i++)
+		error = Soft_Read_Byte(bus, &data[i], i < size - 1);
+
+	if(Soft_Stop(bus) != I2C_OK && error == I2C_OK)
+		error = I2C_ERR_TIMEOUT;
+
+	return error;
+}
+
+/*
+ *	--------------SoftI2C_Burst_Transmit-------------
+ *	Register address then size bytes in one write. A STOP is sent
+ *	whatever happens
+ *	Input: Soft Bus, Slave address, Slave Register Address, Data Buffer, Size of Transmit
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t SoftI2C_Burst_Transmit(SOFT_I2C_t* bus, uint8_t slave_addr, uint8_t slave_reg_addr, uint8_t* data, uint32_t size){
+
+	uint32_t i;
+	uint8_t error;
+
+	/* Asserting Param */
+	if(data == 0 || size == 0)
+		return I2C_ERR_PARAM;
+
+	bus->edge = CYCCNT_Get();
+
+	error = Soft_Start(bus);
+	if(error == I2C_OK)
+		error = Soft_Write_Byte(bus, slave_addr << 1, I2C_MCS_ERROR|I2C_MCS_ADRACK);
+	if(error == I2C_OK)
+		error = Soft_Write_Byte(bus, slave_reg_addr, I2C_MCS_ERROR|I2C_MCS_DATACK);
+
+	for(i = 0; i < size && error == I2C_OK; i++)
+		error = Soft_Write_Byte(bus, data[i], I2C_MCS_ERROR|I2C_MCS_DATACK);
+
+	if(Soft_Stop(bus) != I2C_OK && error == I2C_OK)
+		error = I2C_ERR_TIMEOUT;
+
+	return error;
+}
+
+/*
+ *	-----------------SoftI2C_Receive-----------------
+ *	Input: Soft Bus, Slave address & Slave Register Address
+ *	Output: Byte received, or the error in its place like I2C0_Receive
+ */
+uint8_t SoftI2C_Receive(SOFT_I2C_t* bus, uint8_t slave_addr, uint8_t slave_reg_addr){
+
+	uint8_t data;
+	uint8_t error;
+
+	error = SoftI2C_Burst_Receive(bus, slave_addr, slave_reg_addr, &data, 1);
+
+	if(error != 0)
+		return error;
+	else
+		return data;
+}
+
+/*
+ *	-----------------SoftI2C_Transmit----------------
+ *	Input: Soft Bus, Slave address, Slave Register Address, Data to Transmit
+ *	Output: Any Errors if detected, otherwise 0
+ */
+uint8_t SoftI2C_Transmit(SOFT_I2C_t* bus, uint8_t slave_addr, uint8_t slave_reg_addr, uint8_t data){
+	return SoftI2C_Burst_Transmit(bus, slave_addr, slave_reg_addr, &data, 1);
+}
+
+/*
+ *	-----------------SoftI2C_Command-----------------
+ *	Input: Soft Bus, Slave address, Command byte
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t SoftI2C_Command(SOFT_I2C_t* bus, uint8_t slave_addr, uint8_t cmd){
+
+	uint8_t error;
+
+	bus->edge = CYCCNT_Get();
+
+	error = Soft_Start(bus);
+	if(error == I2C_OK)
+		error = Soft_Write_Byte(bus, slave_addr << 1, I2C_MCS_ERROR|I2C_MCS_ADRACK);
+	if(error == I2C_OK)
+		error = Soft_Write_Byte(bus, cmd, I2C_MCS_ERROR|I2C_MCS_DATACK);
+
+	if(Soft_Stop(bus) != I2C_OK && error == I2C_OK)
+		error = I2C_ERR_TIMEOUT;
+
+	return error;
+}
@@ -0,0 +1,119 @@
+/*
+ * SoftI2C.h
+ *
+ *	Provides a bit-banged I2C master on any two GPIO pins, for buses
+ *	beyond the hardware modules brought out on the carrier board.
+ *	Same call shape as the I2C0_* functions, timed from the cycle
+ *	counter, up to 400kHz, and it waits for slaves stretching SCL.
+ *	A device is moved onto a soft bus by pointing the soft field of its
+ *	descriptor at it, drivers that use the I2C_Dev_* calls follow
+ *
+ * Created on: October 17th, 2026
+ *
+ */
+
+#ifndef SOFTI2C_H_
+#define SOFTI2C_H_
+
+#include <stdint.h>
+#include "I2C.h"
+
+/* List of Macros */
+#define SOFT_I2C_COUNT      1           // Soft buses defined in SoftI2C.c
+#define SOFT_I2C_MAX_SPEED  I2C_SPEED_FAST
+#define SOFT_I2C_LOW_PCT    55          // Share of the SCL period spent low, keeps tLOW in spec at 400kHz
+#define SOFT_I2C_CAL_LOOPS  16          // Edges timed to calibrate the per edge overhead
+#define GPIO_PUR_OFFSET     0x510
+
+//Pins are open drain by direction: input lets the pull-up raise the
+//line, output drives the 0 held in DATA. Bit-specific DATA addressing
+//reads one pin without touching the rest of the port
+#ifndef SOFT_I2C_GPIO_REG
+#define SOFT_I2C_GPIO_REG(bus, off) (*((volatile unsigned long *)((bus)->gpio_base + (off))))
+#endif
+
+/* Soft Bus
+	 The first block is fixed by the wiring, the rest is owned by the
+	 driver. PD7 and PF0 need unlocking first and are not supported */
+struct SOFT_I2C{
+	uint32_t gpio_base;									// GPIO port (APB)
+	uint8_t gpio_port;									// Port bit in RCGCGPIO/PRGPIO
+	uint8_t scl_pin;										// SCL pin mask
+	uint8_t sda_pin;										// SDA pin mask
+
+	uint32_t low_cycles;								// SCL low phase, overhead already taken off
+	uint32_t high_cycles;								// SCL high phase, overhead already taken off
+	uint32_t overhead;									// Calibrated cycles between a deadline and the pin change
+	uint32_t timeout_cycles;						// Longest clock stretch accepted
+	uint32_t edge;											// Cycle count of the last SCL/SDA change
+};
+
+extern SOFT_I2C_t Soft_I2C[SOFT_I2C_COUNT];
+#define SOFT_I2C_BUS0       (&Soft_I2C[0])   // PB0 (SCL) / PB1 (SDA), external pull-ups
+
+/*
+ *	------------------SoftI2C_Init-------------------
+ *	Turns on the port clock, releases both lines, calibrates the edge
+ *	overhead and sets 100kHz. Calling it again is harmless
+ *	Input: Soft Bus
+ *	Output: None
+ */
+void SoftI2C_Init(SOFT_I2C_t* bus);
+
+/*
+ *	-----------------SoftI2C_SetSpeed----------------
+ *	Picks the low and high phase lengths for an SCL rate. Rates the
+ *	CPU cannot keep up with are clamped to the fastest it can do
+ *	Input: Soft Bus, Requested SCL rate in Hz (at most SOFT_I2C_MAX_SPEED)
+ *	Output: SCL rate expected in Hz, 0 if out of range
+ */
+uint32_t SoftI2C_SetSpeed(SOFT_I2C_t* bus, uint32_t scl_hz);
+
+/*
+ *	-------------SoftI2C_SetSpeed_For_Devices----------
+ *	Runs the soft bus at the fastest rate every listed device on it
+ *	allows. Devices on other buses are skipped
+ *	Input: Soft Bus, Array of device descriptors, Number of devices
+ *	Output: SCL rate expected in Hz, 0 if out of range
+ */
+uint32_t SoftI2C_SetSpeed_For_Devices(SOFT_I2C_t* bus, const I2C_DEVICE_t* const devices[], uint8_t count);
+
+/*
+ *	--------------SoftI2C_Burst_Receive--------------
+ *	Register write, repeated START, then size bytes read
+ *	Input: Soft Bus, Slave address, Slave Register Address, Data Buffer, Size of Receive
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t SoftI2C_Burst_Receive(SOFT_I2C_t* bus, uint8_t slave_addr, uint8_t slave_reg_addr, uint8_t* data, uint32_t size);
+
+/*
+ *	--------------SoftI2C_Burst_Transmit-------------
+ *	Register address then size bytes in one write
+ *	Input: Soft Bus, Slave address, Slave Register Address, Data Buffer, Size of Transmit
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t SoftI2C_Burst_Transmit(SOFT_I2C_t* bus, uint8_t slave_addr, uint8_t slave_reg_addr, uint8_t* data, uint32_t size);
+
+/*
+ *	-----------------SoftI2C_Receive-----------------
+ *	Input: Soft Bus, Slave address & Slave Register Address
+ *	Output: Byte received, or the error in its place like I2C0_Receive
+ */
+uint8_t SoftI2C_Receive(SOFT_I2C_t* bus, uint8_t slave_addr, uint8_t slave_reg_addr);
+
+/*
+ *	-----------------SoftI2C_Transmit----------------
+ *	Input: Soft Bus, Slave address, Slave Register Address, Data to Transmit
+ *	Output: Any Errors if detected, otherwise 0
+ */
+uint8_t SoftI2C_Transmit(SOFT_I2C_t* bus, uint8_t slave_addr, uint8_t slave_reg_addr, uint8_t data);
+
+/*
+ *	-----------------SoftI2C_Command-----------------
+ *	Single byte write, for parts that act on a command byte alone
+ *	Input: Soft Bus, Slave address, Command byte
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t SoftI2C_Command(SOFT_I2C_t* bus, uint8_t slave_addr, uint8_t cmd);
+
+#endif //SOFTI2C_H_
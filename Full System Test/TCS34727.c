@@ -10,12 +10,59 @@
  */
 
 #include "TCS34727.h"
+#include "EEPROM.h"
 #include "I2C.h"
+#include "I2CAsync.h"
+#include "I2CScan.h"
+#include "SoftI2C.h"
 #include "UART0.h"
 #include "util.h"
 #include <stdio.h>
+#include <string.h>
 #include "tm4c123gh6pm.h"
 
+I2C_DEVICE_t TCS34727_DEVICE = {.name = "TCS34727", .addr = TCS34727_ADDR, .max_speed = I2C_SPEED_FAST,
+	.soft = TCS34727_SOFT};
+
+/* RGBC cycle tracking, the integration time follows the ATIME written */
+static uint8_t tcs_atime = TCS34727_ATIME_2_4_MS;
+static uint8_t tcs_again = TCS34727_CTRL_AGAIN_4X;
+static const uint8_t tcs_gain_x[4] = {1, 4, 16, 60};			//Nominal gain of each AGAIN value
+static uint32_t tcs_aen_at;										//CYCCNT when AEN was set
+static uint32_t tcs_ready_at;									//CYCCNT when the last result was seen
+
+/* Lux scale of the exposure it was worked out for */
+static uint32_t tcs_lux_exposure;
+static uint64_t tcs_lux_scale;									//mlux per count of G'', Q16
+
+/* Calibration in use */
+static TCS34727_CAL_t tcs_cal;
+static uint8_t tcs_cal_on;
+
+/* Threshold mode */
+static uint8_t tcs_band_pct = TCS34727_THRESH_BAND_PCT;
+static volatile uint8_t tcs_int_pending;						//Set by the INT line, cleared by TCS34727_Read_Change
+
+/*	------------------TCS34727_Cycles-----------------
+ *	Local function converting a time to core clock cycles
+ *	Input: Time in us
+ *	Output: Core clock cycles
+ */
+static uint32_t TCS34727_Cycles(uint32_t us){
+	return (SYSCLK_Get_Hz() / 1000000) * us;
+}
+
+/*	----------------TCS34727_Wait_Until---------------
+ *	Local function waiting until a number of cycles have passed
+ *	since a CYCCNT reading, the bus stays free meanwhile
+ *	Input: CYCCNT reading, Cycles after it
+ *	Output: none
+ */
+static void TCS34727_Wait_Until(uint32_t from, uint32_t cycles){
+	while((CYCCNT_Get() - from) < cycles)
+		I2C_SPIN();
+}
+
 /*	-------------------TCS34727_Init------------------
  *	Basic Initialization Function for TCS34727 at default settings
  *	Input: none
@@ -25,8 +72,13 @@ void TCS34727_Init(void){
 	uint8_t ret;																//Temp Variable to hold return values
 	char printBuf[20];													//String buffer to print
 	
+	/* Fixed address part, binding just marks it known in the scan table.
+		 A soft bus is not scanned, I2CMain brings it up */
+	if(TCS34727_DEVICE.soft == 0)
+		I2C_Scan_Bind(TCS34727_BUS, &TCS34727_DEVICE);
+	
 	/* Check if RGB Color Sensor has been detected */
-	ret = I2C0_Receive(TCS34727_ADDR, TCS34727_CMD|TCS34727_ID_R_ADDR);
+	ret = I2C_Dev_Receive(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD|TCS34727_ID_R_ADDR);
 	
 	//Print ID or Error to Terminal
 	sprintf(printBuf, "ID: %x\r\n", ret);
@@ -39,43 +91,56 @@ void TCS34727_Init(void){
 	UART0_OutString("TCS34727 has been Detected\r\n");
 	
 	/* Set Integration Time to 2.4ms in timing register */
-	ret = I2C0_Transmit(TCS34727_ADDR, TCS34727_CMD|TCS34727_TIMING_R_ADDR, TCS34727_ATIME_2_4_MS);
+	ret = I2C_Dev_Transmit(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD|TCS34727_TIMING_R_ADDR, TCS34727_ATIME_2_4_MS);
 	if(ret != 0)
 		UART0_OutString("Error on Transmit\r\n");
-	else
+	else{
+		tcs_atime = TCS34727_ATIME_2_4_MS;
 		UART0_OutString("TCS34727 Integration Time Set\r\n");
+	}
 	
-	// Necessary Delay when setting integration time/wait time. 
-	// This varies for which integration time is choosen.
-	// This project chooses 2.4ms.
-	DELAY_1MS(3);
-	
-	/* Setting Gain to 1X gain */
-	ret = I2C0_Transmit(TCS34727_ADDR, TCS34727_CMD|TCS34727_CTRL_R_ADDR, TCS34727_CTRL_AGAIN_1);
+	/* Setting Gain to 4X gain */
+	ret = I2C_Dev_Transmit(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD|TCS34727_CTRL_R_ADDR, TCS34727_CTRL_AGAIN_4X);
 	if(ret != 0)
 		UART0_OutString("Error on Transmit\r\n");
-	else
+	else{
+		tcs_again = TCS34727_CTRL_AGAIN_4X;
 		UART0_OutString("TCS34727 Gain Set\r\n");
+	}
 	
 	/* Powering On Sensor at Enable register */
-	ret = I2C0_Transmit(TCS34727_ADDR, TCS34727_CMD|TCS34727_ENABLE_R_ADDR, TCS34727_ENABLE_PON);
+	ret = I2C_Dev_Transmit(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD|TCS34727_ENABLE_R_ADDR, TCS34727_ENABLE_PON);
 	if(ret != 0)
 		UART0_OutString("Error on Transmit\r\n");
 	else
 		UART0_OutString("TCS34727 Power On\r\n");
 
-	//Nessessary Delay When Powering On Module
-	DELAY_1MS(3);
+	//Oscillator Warm-up When Powering On Module
+	TCS34727_Wait_Until(CYCCNT_Get(), TCS34727_Cycles(TCS34727_PON_WARMUP_US));
+	
+	/* Flag every finished RGBC cycle in AINT so a new result can be told apart */
+	ret = I2C_Dev_Transmit(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD|TCS34727_PERS_R_ADDR, TCS34727_PERS_EVERY);
+	if(ret != 0)
+		UART0_OutString("Error on Transmit\r\n");
 	
 	/* Enabling RGBC 2-Channel ADC at Enable register */
-	ret = I2C0_Transmit(TCS34727_ADDR, TCS34727_CMD|TCS34727_ENABLE_R_ADDR, TCS34727_ENABLE_PON |TCS34727_ENABLE_AEN);
+	ret = I2C_Dev_Transmit(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD|TCS34727_ENABLE_R_ADDR, TCS34727_ENABLE_PON|TCS34727_ENABLE_AEN|TCS34727_ENABLE_AIEN);
+	tcs_aen_at = CYCCNT_Get();
 	if(ret != 0)
 		UART0_OutString("Error on Transmit\r\n");
 	else
 		UART0_OutString("TCS34727 RGBC On\r\n");
 	
-	//Integration Time Delay when Activating. Varies with Integration Time Choosen by User
-	DELAY_1MS(3);
+	//First Result Takes One Integration Time, Found by AVALID
+	if(TCS34727_Wait_Valid() != I2C_OK)
+		UART0_OutString("TCS34727 No RGBC Result\r\n");
+	
+	#ifdef TCS34727_USE_INT
+	/* Wake on color change only */
+	TCS34727_INT_Init();
+	if(TCS34727_Threshold_Mode(TCS34727_PERS_3, TCS34727_THRESH_BAND_PCT) != I2C_OK)
+		UART0_OutString("TCS34727 Threshold Mode Failed\r\n");
+	#endif
 	
 	UART0_OutString("TCS34727 Color Sensor Initialized\r\n");
 	
@@ -92,15 +157,12 @@ uint16_t TCS34727_GET_RAW_CLEAR(void){
 	uint16_t CLEAR_DATA;
 	
 	/* Use I2C to grab both HIGH and LOW data */
-	CLEAR_LOW = I2C0_Receive(TCS34727_ADDR, TCS34727_CMD|TCS34727_CDATAL_R_ADDR);
-	CLEAR_HIGH = I2C0_Receive(TCS34727_ADDR, TCS34727_CMD|TCS34727_CDATAH_R_ADDR);
+	CLEAR_LOW = I2C_Dev_Receive(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD|TCS34727_CDATAL_R_ADDR);
+	CLEAR_HIGH = I2C_Dev_Receive(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD|TCS34727_CDATAH_R_ADDR);
 	
 	/* Concatanate into 16-bit value */
 	CLEAR_DATA = (CLEAR_HIGH << 8) | CLEAR_LOW;
 	
-	//Integration Time Delay
-	DELAY_1MS(3);
-	
 	return CLEAR_DATA;
 }
 
@@ -115,16 +177,12 @@ uint16_t TCS34727_GET_RAW_RED(void){
 	uint16_t RED_DATA;
 	
 	/* Use I2C to grab both HIGH and LOW data */
-	RED_LOW = I2C0_Receive(TCS34727_ADDR, TCS34727_CMD|TCS34727_RDATAL_R_ADDR);
-	RED_HIGH = I2C0_Receive(TCS34727_ADDR, TCS34727_CMD|TCS34727_RDATAH_R_ADDR);
-	RED_DATA = (RED_HIGH << 8) | RED_LOW;
+	RED_LOW = I2C_Dev_Receive(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD|TCS34727_RDATAL_R_ADDR);
+	RED_HIGH = I2C_Dev_Receive(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD|TCS34727_RDATAH_R_ADDR);
 	
 	/* Concatenate into 16-bit value */
 	RED_DATA = (RED_HIGH << 8) | RED_LOW;
 	
-	//Integration Time Delay
-	DELAY_1MS(3);
-	
 	return RED_DATA;
 }
 
@@ -139,15 +197,12 @@ uint16_t TCS34727_GET_RAW_GREEN(void){
 	uint16_t GREEN_DATA;
 	
 	/* Use I2C to grab both HIGH and LOW data */
-	GREEN_LOW = I2C0_Receive(TCS34727_ADDR, TCS34727_CMD|TCS34727_GDATAL_R_ADDR);
-	GREEN_HIGH = I2C0_Receive(TCS34727_ADDR, TCS34727_CMD|TCS34727_GDATAH_R_ADDR);
+	GREEN_LOW = I2C_Dev_Receive(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD|TCS34727_GDATAL_R_ADDR);
+	GREEN_HIGH = I2C_Dev_Receive(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD|TCS34727_GDATAH_R_ADDR);
 	
 	/* Concatenate into 16-bit value */
 	GREEN_DATA = (GREEN_HIGH << 8) | GREEN_LOW;
 	
-	//Integration Time Delay
-	DELAY_1MS(3);
-	
 	return GREEN_DATA;
 }
 
@@ -160,20 +215,445 @@ uint16_t TCS34727_GET_RAW_BLUE(void){
 	uint8_t BLUE_LOW;
 	uint8_t BLUE_HIGH;
 	uint16_t BLUE_DATA;
+	
 	/* Use I2C to grab both HIGH and LOW data */
-	BLUE_LOW = I2C0_Receive(TCS34727_ADDR, TCS34727_CMD|TCS34727_BDATAL_R_ADDR);
-	BLUE_HIGH = I2C0_Receive(TCS34727_ADDR, TCS34727_CMD|TCS34727_BDATAH_R_ADDR);
+	BLUE_LOW = I2C_Dev_Receive(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD|TCS34727_BDATAL_R_ADDR);
+	BLUE_HIGH = I2C_Dev_Receive(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD|TCS34727_BDATAH_R_ADDR);
 	
 	/* Concatenate into 16-bit value */
 	BLUE_DATA = (BLUE_HIGH << 8) | BLUE_LOW;
-	//CODE_FILL
-	
-	//Integration Time Delay
-	DELAY_1MS(3);
 	
 	return BLUE_DATA;
 }
 
+#ifdef TCS34727_USE_I2C_QUEUE
+/*	-------------TCS34727_Queue_Receive--------------
+ *	Local function reading through the TCS34727_BUS queue at sensor
+ *	priority, so it only waits for the transfer already on the bus and
+ *	goes ahead of queued LCD frames. A transfer that outlives the polled
+ *	deadline is ended through I2C_Async_Acquire and the bus recovered
+ *	before the queue goes on. Parts on a soft bus are read directly
+ *	Input: Register command, Data Buffer, Size of Receive
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+static uint8_t TCS34727_Queue_Receive(uint8_t reg_cmd, uint8_t* data, uint32_t size){
+	I2C_XFER_t xfer = {0};
+	uint32_t start = CYCCNT_Get();
+	uint8_t ret;
+	
+	if(TCS34727_DEVICE.soft != 0)
+		return I2C_Dev_Burst_Receive(TCS34727_BUS, &TCS34727_DEVICE, reg_cmd, data, size);
+	
+	xfer.slave_addr = TCS34727_DEVICE.addr;
+	xfer.slave_reg_addr = reg_cmd;
+	xfer.dir = I2C_XFER_READ;
+	xfer.data = data;
+	xfer.size = size;
+	
+	ret = I2C_Queue_Submit(TCS34727_BUS, &xfer, I2C_PRIO_SENSOR);
+	if(ret != I2C_OK)
+		return ret;
+	
+	while(!xfer.done){
+		if((CYCCNT_Get() - start) > TCS34727_BUS->timeout_cycles * (size + 2)){
+			/* Acquire ends the stuck transfer, the bus still needs freeing
+				 before the queue may start anything on it */
+			I2C_Async_Acquire(TCS34727_BUS);
+			I2C_Recover(TCS34727_BUS);
+			I2C_Async_Release(TCS34727_BUS);
+			if(xfer.done)
+				return I2C_ERR_TIMEOUT;
+			
+			/* Ours was still queued behind it, it now runs on the freed bus */
+			start = CYCCNT_Get();
+		}
+		I2C_SPIN();
+	}
+	
+	return xfer.status;
+}
+#endif
+
+/*	----------------TCS34727_Read_RGBC---------------
+ *	Read all four channels in one auto-increment burst
+ *	Input: RGB Color User Instance Struct
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t TCS34727_Read_RGBC(RGB_COLOR_HANDLE_t* RGB_COLOR_Instance){
+	uint8_t rgbc_buf[TCS34727_RGBC_BYTES];			//CDATAL to BDATAH
+	uint8_t ret;
+	
+	/* One burst from CDATAL, the command auto-increments through BDATAH */
+	#ifdef TCS34727_USE_I2C_QUEUE
+	ret = TCS34727_Queue_Receive(TCS34727_CMD|TCS34727_CMD_AUTO_INC|TCS34727_CDATAL_R_ADDR, rgbc_buf, sizeof(rgbc_buf));
+	#else
+	ret = I2C_Dev_Burst_Receive(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD|TCS34727_CMD_AUTO_INC|TCS34727_CDATAL_R_ADDR, rgbc_buf, sizeof(rgbc_buf));
+	#endif
+	if(ret != I2C_OK)
+		return ret;																//Keep last good sample on bus error
+	
+	/* Concatanate into 16-bit values (Low byte first) */
+	RGB_COLOR_Instance->C_RAW = (rgbc_buf[1] << 8) | rgbc_buf[0];
+	RGB_COLOR_Instance->R_RAW = (rgbc_buf[3] << 8) | rgbc_buf[2];
+	RGB_COLOR_Instance->G_RAW = (rgbc_buf[5] << 8) | rgbc_buf[4];
+	RGB_COLOR_Instance->B_RAW = (rgbc_buf[7] << 8) | rgbc_buf[6];
+	
+	return I2C_OK;
+}
+
+/*	------------TCS34727_Read_RGBC_Next--------------
+ *	Read the next RGBC result, one call per integration cycle
+ *	Input: RGB Color User Instance Struct
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t TCS34727_Read_RGBC_Next(RGB_COLOR_HANDLE_t* RGB_COLOR_Instance){
+	uint32_t period = TCS34727_Cycles(TCS34727_Get_Integration_Us());
+	uint32_t margin = period / 100 * TCS34727_TIMING_MARGIN_PCT;
+	uint32_t start = tcs_ready_at;								//Polls run from start + wait
+	uint32_t wait = period - margin;							//to start + period + margin
+	uint32_t poll_at;
+	uint8_t polls = 0;
+	uint8_t status;
+	uint8_t ret;
+	
+	/* More than a cycle late AINT may be from any cycle since, clear it and
+	   poll for the next one so the end of a cycle is known again */
+	if((CYCCNT_Get() - tcs_ready_at) > 2*period){
+		ret = I2C_Dev_Command(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD|TCS34727_CMD_SPECIAL|TCS34727_SF_CLEAR_INT);
+		if(ret != I2C_OK)
+			return ret;
+		start = CYCCNT_Get();
+		wait = 0;
+	}
+	
+	/* The next cycle cannot end sooner than one integration after the last result */
+	TCS34727_Wait_Until(start, wait);
+	
+	/* Poll STATUS alone, the short read keeps the poll close to the end of the cycle */
+	do{
+		poll_at = CYCCNT_Get();
+		ret = I2C_Dev_Burst_Receive(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD|TCS34727_STATUS_R_ADDR, &status, 1);
+		if(ret != I2C_OK)
+			return ret;
+		
+		if(status & TCS34727_STATUS_AINT){
+			/* The cycle ended before this poll. Hit on the first poll it may have ended
+			   well before, keep to the integration time then so late calls do not slip */
+			if(polls == 0 && wait != 0 && (poll_at - start) > period)
+				tcs_ready_at = start + period;
+			else
+				tcs_ready_at = poll_at;
+			
+			ret = TCS34727_Read_RGBC(RGB_COLOR_Instance);
+			if(ret != I2C_OK)
+				return ret;
+			
+			/* Rearm AINT for the next cycle, a cycle ending before this is lost */
+			return I2C_Dev_Command(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD|TCS34727_CMD_SPECIAL|TCS34727_SF_CLEAR_INT);
+		}
+		polls++;
+	} while((poll_at - start) < period + margin);
+	
+	return I2C_ERR_TIMEOUT;
+}
+
+/*	---------------TCS34727_Wait_Valid---------------
+ *	Wait for the first result after AEN by polling AVALID
+ *	Input: none
+ *	Output: I2C_OK once AVALID is set, otherwise I2C_ERR_* status code
+ */
+uint8_t TCS34727_Wait_Valid(void){
+	uint32_t period = TCS34727_Cycles(TCS34727_Get_Integration_Us());
+	uint32_t margin = period / 100 * TCS34727_TIMING_MARGIN_PCT;
+	uint32_t poll_at;
+	uint8_t status;
+	uint8_t ret;
+	
+	/* No result before the first integration can have ended */
+	TCS34727_Wait_Until(tcs_aen_at, period - margin);
+	
+	do{
+		poll_at = CYCCNT_Get();
+		ret = I2C_Dev_Burst_Receive(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD|TCS34727_STATUS_R_ADDR, &status, 1);
+		if(ret != I2C_OK)
+			return ret;
+		
+		if(status & TCS34727_STATUS_AVALID){
+			tcs_ready_at = poll_at;
+			return I2C_OK;
+		}
+	} while((poll_at - tcs_aen_at) < period + margin);
+	
+	return I2C_ERR_TIMEOUT;
+}
+
+/*	------------TCS34727_Set_Band------------------
+ *	Local function centering the clear channel thresholds on a reading
+ *	Input: Clear count
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+static uint8_t TCS34727_Set_Band(uint16_t clear){
+	uint32_t band = (uint32_t)clear * tcs_band_pct / 100;
+	uint32_t high;
+	
+	/* Near dark a percentage is less than the noise */
+	if(band < MIN_RAW_VALUE)
+		band = MIN_RAW_VALUE;
+	
+	high = clear + band;
+	if(high > 0xFFFF)
+		high = 0xFFFF;
+	
+	return TCS34727_Set_Thresholds(clear > band ? clear - band : 0, high);
+}
+
+/*	------------TCS34727_Threshold_Mode--------------
+ *	Stop sampling every cycle, AINT only on a change of scene
+ *	Input: Persistence, Band half width in percent
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t TCS34727_Threshold_Mode(uint8_t pers, uint8_t band_pct){
+	RGB_COLOR_HANDLE_t scene;
+	uint8_t ret;
+	
+	tcs_band_pct = band_pct;
+	
+	ret = TCS34727_Read_RGBC(&scene);
+	if(ret != I2C_OK)
+		return ret;
+	
+	ret = TCS34727_Set_Band(scene.C_RAW);
+	if(ret != I2C_OK)
+		return ret;
+	
+	ret = I2C_Dev_Transmit(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD|TCS34727_PERS_R_ADDR, pers);
+	if(ret != I2C_OK)
+		return ret;
+	
+	/* AINT left from every cycle mode would hold INT low, no edge would come */
+	tcs_int_pending = 0;
+	return I2C_Dev_Command(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD|TCS34727_CMD_SPECIAL|TCS34727_SF_CLEAR_INT);
+}
+
+/*	-------------TCS34727_Cycle_Mode-----------------
+ *	Back to AINT on every cycle
+ *	Input: none
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t TCS34727_Cycle_Mode(void){
+	uint8_t ret;
+	
+	ret = I2C_Dev_Transmit(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD|TCS34727_PERS_R_ADDR, TCS34727_PERS_EVERY);
+	if(ret != I2C_OK)
+		return ret;
+	
+	/* Cycle timing is unknown now, TCS34727_Read_RGBC_Next resyncs */
+	tcs_ready_at = CYCCNT_Get() - 3*TCS34727_Cycles(TCS34727_Get_Integration_Us());
+	
+	return I2C_OK;
+}
+
+/*	-----------TCS34727_Set_Thresholds---------------
+ *	Input: Clear channel low and high threshold in counts
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t TCS34727_Set_Thresholds(uint16_t low, uint16_t high){
+	uint8_t thresh_buf[TCS34727_THRESH_BYTES];		//AILTL, AILTH, AIHTL, AIHTH
+	
+	thresh_buf[0] = low & 0xFF;
+	thresh_buf[1] = low >> 8;
+	thresh_buf[2] = high & 0xFF;
+	thresh_buf[3] = high >> 8;
+	
+	return I2C_Dev_Burst_Transmit(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD|TCS34727_CMD_AUTO_INC|TCS34727_AILTL_R_ADDR, thresh_buf, sizeof(thresh_buf));
+}
+
+/*	--------------TCS34727_INT_Init------------------
+ *	PE0 as input with pull-up, falling edge interrupt for the INT line
+ *	Input: none
+ *	Output: none
+ */
+void TCS34727_INT_Init(void){
+	
+	SYSCTL_RCGCGPIO_R |= TCS34727_INT_GPIO_PORT;																							//Activate Port E clock
+	while((SYSCTL_PRGPIO_R & TCS34727_INT_GPIO_PORT) == 0){};
+	
+	GPIO_REG(TCS34727_INT_GPIO_BASE, GPIO_DIR_OFFSET)   &= ~TCS34727_INT_PIN;										//Input
+	GPIO_REG(TCS34727_INT_GPIO_BASE, GPIO_AFSEL_OFFSET) &= ~TCS34727_INT_PIN;										//No alternate function
+	GPIO_REG(TCS34727_INT_GPIO_BASE, GPIO_AMSEL_OFFSET) &= ~TCS34727_INT_PIN;										//Disable analog function
+	GPIO_REG(TCS34727_INT_GPIO_BASE, GPIO_PCTL_OFFSET)  &= ~0x0000000F;													//GPIO on PE0
+	GPIO_REG(TCS34727_INT_GPIO_BASE, GPIO_PUR_OFFSET)   |= TCS34727_INT_PIN;										//INT is open drain
+	GPIO_REG(TCS34727_INT_GPIO_BASE, GPIO_DEN_OFFSET)   |= TCS34727_INT_PIN;										//Enable digital
+	
+	GPIO_REG(TCS34727_INT_GPIO_BASE, GPIO_IS_OFFSET)    &= ~TCS34727_INT_PIN;										//Edge sensitive
+	GPIO_REG(TCS34727_INT_GPIO_BASE, GPIO_IBE_OFFSET)   &= ~TCS34727_INT_PIN;										//One edge
+	GPIO_REG(TCS34727_INT_GPIO_BASE, GPIO_IEV_OFFSET)   &= ~TCS34727_INT_PIN;										//Falling, INT asserts low
+	GPIO_REG(TCS34727_INT_GPIO_BASE, GPIO_ICR_OFFSET)    = TCS34727_INT_PIN;										//Clear flag
+	GPIO_REG(TCS34727_INT_GPIO_BASE, GPIO_IM_OFFSET)    |= TCS34727_INT_PIN;										//Arm interrupt
+	
+	NVIC_PRI1_R = (NVIC_PRI1_R & 0xFFFFFF1F) | (TCS34727_INT_PRI << 5);												//Priority of IRQ 4
+	NVIC_EN0_R |= 1UL << TCS34727_INT_IRQ;																										//Enable IRQ 4 in NVIC
+}
+
+/*	---------------TCS34727_Changed------------------
+ *	Input: none
+ *	Output: 1 if the INT line fired since the last TCS34727_Read_Change
+ */
+uint8_t TCS34727_Changed(void){
+	return tcs_int_pending;
+}
+
+/*	-------------TCS34727_Read_Change----------------
+ *	Read the new scene, center the band on it and clear AINT
+ *	Input: RGB Color User Instance Struct
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t TCS34727_Read_Change(RGB_COLOR_HANDLE_t* RGB_COLOR_Instance){
+	uint8_t ret;
+	
+	/* An edge during the reads below sets it again, one more read at worst */
+	tcs_int_pending = 0;
+	
+	ret = TCS34727_Read_RGBC(RGB_COLOR_Instance);
+	if(ret != I2C_OK)
+		return ret;
+	
+	ret = TCS34727_Set_Band(RGB_COLOR_Instance->C_RAW);
+	if(ret != I2C_OK)
+		return ret;
+	
+	return I2C_Dev_Command(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD|TCS34727_CMD_SPECIAL|TCS34727_SF_CLEAR_INT);
+}
+
+/*	-------------GPIOPortE_Handler-------------------
+ *	INT line fell, the bus is left to the main loop
+ *	Input: none
+ *	Output: none
+ */
+void GPIOPortE_Handler(void){
+	GPIO_REG(TCS34727_INT_GPIO_BASE, GPIO_ICR_OFFSET) = TCS34727_INT_PIN;
+	tcs_int_pending = 1;
+}
+
+/*	-------------TCS34727_Set_Exposure---------------
+ *	Program integration time and gain, restart the RGBC cycle
+ *	Input: ATIME register value, AGAIN
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t TCS34727_Set_Exposure(uint8_t atime, uint8_t again){
+	uint8_t ret;
+	
+	ret = I2C_Dev_Transmit(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD|TCS34727_TIMING_R_ADDR, atime);
+	if(ret != I2C_OK)
+		return ret;
+	tcs_atime = atime;
+	
+	ret = I2C_Dev_Transmit(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD|TCS34727_CTRL_R_ADDR, again);
+	if(ret != I2C_OK)
+		return ret;
+	tcs_again = again;
+	
+	/* The cycle in progress would finish at the old setting, start a new one */
+	ret = I2C_Dev_Transmit(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD|TCS34727_ENABLE_R_ADDR, TCS34727_ENABLE_PON|TCS34727_ENABLE_AIEN);
+	if(ret != I2C_OK)
+		return ret;
+	ret = I2C_Dev_Transmit(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD|TCS34727_ENABLE_R_ADDR, TCS34727_ENABLE_PON|TCS34727_ENABLE_AEN|TCS34727_ENABLE_AIEN);
+	tcs_aen_at = CYCCNT_Get();
+	tcs_ready_at = tcs_aen_at;
+	if(ret != I2C_OK)
+		return ret;
+	
+	/* AINT from the old setting would pass for the first new result */
+	return I2C_Dev_Command(TCS34727_BUS, &TCS34727_DEVICE, TCS34727_CMD|TCS34727_CMD_SPECIAL|TCS34727_SF_CLEAR_INT);
+}
+
+/*	-------------TCS34727_AE_Step--------------------
+ *	Local function choosing the exposure for the next reading from
+ *	the clear count of this one. The light it implies (counts per step
+ *	at 1x, Q8) decides the highest gain that stays under the headroom
+ *	in one step, then the fewest steps reaching the SNR target
+ *	Input: Clear count of the last reading
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+static uint8_t TCS34727_AE_Step(uint16_t clear){
+	uint32_t steps = 256 - tcs_atime;
+	uint32_t full = steps * TCS34727_FULL_SCALE_STEP;
+	uint32_t high;
+	uint32_t light;												//Clear counts per step at 1x, Q8
+	uint32_t next_steps;
+	uint8_t again;
+	
+	if(full > 0xFFFF)
+		full = 0xFFFF;
+	high = full * TCS34727_AE_MAX_PCT / 100;
+	
+	light = ((uint32_t)clear << 8) / (steps * tcs_gain_x[tcs_again]);
+	if(clear >= full)
+		light *= 4;													//Saturated, only a lower bound
+	if(light == 0)
+		light = 1;
+	
+	/* Highest gain a single step can take without passing the headroom */
+	for(again = TCS34727_CTRL_AGAIN_60X; again > TCS34727_CTRL_AGAIN_1X; again--){
+		if(light * tcs_gain_x[again] <= ((uint32_t)TCS34727_FULL_SCALE_STEP * TCS34727_AE_MAX_PCT / 100) << 8)
+			break;
+	}
+	
+	/* Fewest steps that reach the SNR target at that gain */
+	next_steps = (((uint32_t)TCS34727_AE_MIN_COUNT << 8) + light * tcs_gain_x[again] - 1) / (light * tcs_gain_x[again]);
+	if(next_steps < 1)
+		next_steps = 1;
+	if(next_steps > TCS34727_ATIME_STEPS_MAX)
+		next_steps = TCS34727_ATIME_STEPS_MAX;
+	
+	/* In band, keep it unless the integration can at least halve */
+	if(clear >= TCS34727_AE_MIN_COUNT && clear <= high && 2*next_steps > steps)
+		return I2C_OK;
+	if(next_steps == steps && again == tcs_again)
+		return I2C_OK;
+	
+	return TCS34727_Set_Exposure(256 - next_steps, again);
+}
+
+/*	-------------TCS34727_Read_RGBC_Auto-------------
+ *	Read the next result, normalize it and adjust the exposure
+ *	Input: RGB Color User Instance Struct
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t TCS34727_Read_RGBC_Auto(RGB_COLOR_HANDLE_t* RGB_COLOR_Instance){
+	uint32_t exposure;
+	uint8_t ret;
+	
+	ret = TCS34727_Read_RGBC_Next(RGB_COLOR_Instance);
+	if(ret != I2C_OK)
+		return ret;
+	
+	/* Scale to 256 steps at 1x, rounded */
+	exposure = TCS34727_Get_Exposure();
+	RGB_COLOR_Instance->R_NORM = ((uint32_t)RGB_COLOR_Instance->R_RAW * TCS34727_NORM_STEPS + exposure / 2) / exposure;
+	RGB_COLOR_Instance->G_NORM = ((uint32_t)RGB_COLOR_Instance->G_RAW * TCS34727_NORM_STEPS + exposure / 2) / exposure;
+	RGB_COLOR_Instance->B_NORM = ((uint32_t)RGB_COLOR_Instance->B_RAW * TCS34727_NORM_STEPS + exposure / 2) / exposure;
+	RGB_COLOR_Instance->C_NORM = ((uint32_t)RGB_COLOR_Instance->C_RAW * TCS34727_NORM_STEPS + exposure / 2) / exposure;
+	
+	return TCS34727_AE_Step(RGB_COLOR_Instance->C_RAW);
+}
+
+/*	-------------TCS34727_Get_Exposure---------------
+ *	Input: none
+ *	Output: Integration steps times gain
+ */
+uint32_t TCS34727_Get_Exposure(void){
+	return (256 - tcs_atime) * tcs_gain_x[tcs_again & 0x03];
+}
+
+/*	-----------TCS34727_Get_Integration_Us-----------
+ *	Input: none
+ *	Output: Integration time of one RGBC cycle in us
+ */
+uint32_t TCS34727_Get_Integration_Us(void){
+	return (256 - tcs_atime) * TCS34727_ATIME_STEP_US;
+}
+
 /*	---------------TCS34727_GET_RGB------------------
  *	Normalize RAW data into RGB range (0-255)
  *	Input: RGB Color Struct User Instance
@@ -198,24 +678,424 @@ void TCS34727_GET_RGB(RGB_COLOR_HANDLE_t* RGB_COLOR_Instance){
 	
 }
 
+/*	------------------TCS34727_Scale-----------------
+ *	Local function scaling one channel by the reciprocal of C_RAW.
+ *	RAW < C_RAW keeps the product under 255 << TCS34727_RGB_Q
+ *	Input: RAW channel, C_RAW, Q16 of 255 / C_RAW
+ *	Output: Channel in 0-255
+ */
+static uint8_t TCS34727_Scale(uint16_t raw, uint16_t clear, uint32_t recip){
+	if(raw >= clear)
+		return TCS34727_RGB_MAX;
+
+	return ((uint32_t)raw * recip) >> TCS34727_RGB_Q;
+}
+
+/*	------------TCS34727_GET_RGB_Fixed---------------
+ *	Normalize RAW data into RGB range (0-255) without floating point.
+ *	The reciprocal is truncated, so a channel comes out at most
+ *	raw / 65536 < 1 below the exact value before it is truncated too
+ *	Input: RGB Color Struct User Instance
+ *	Output: none
+ */
+void TCS34727_GET_RGB_Fixed(RGB_COLOR_HANDLE_t* RGB_COLOR_Instance){
+	uint16_t clear;
+	uint32_t recip;
+
+	TCS34727_Correct(RGB_COLOR_Instance);
+	clear = RGB_COLOR_Instance->C_CAL;
+
+	/* Prevent Dividing by 0 */
+	if(clear == 0){
+		RGB_COLOR_Instance->R_INT = RGB_COLOR_Instance->G_INT = RGB_COLOR_Instance->B_INT = 0;
+		return;
+	}
+
+	/* The only division, shared by the three channels */
+	recip = ((uint32_t)TCS34727_RGB_MAX << TCS34727_RGB_Q) / clear;
+
+	RGB_COLOR_Instance->R_INT = TCS34727_Scale(RGB_COLOR_Instance->R_CAL, clear, recip);
+	RGB_COLOR_Instance->G_INT = TCS34727_Scale(RGB_COLOR_Instance->G_CAL, clear, recip);
+	RGB_COLOR_Instance->B_INT = TCS34727_Scale(RGB_COLOR_Instance->B_CAL, clear, recip);
+}
+
 /*	-----------------Detect_Color--------------------
- *	Detect which color is more prominant and returns that color
+ *	Detect which color is more prominant and returns that color.
+ *	Same answer as comparing R, G, B: scaling by 255 / C_RAW keeps the
+ *	order of the RAW channels
  *	Input: RGB Color User Instance Struct
  *	Output: COLOR_DETECTED enum value
  */
 COLOR_DETECTED Detect_Color(RGB_COLOR_HANDLE_t* RGB_COLOR_Instance){
+    // No clear count, GET_RGB zeroes every channel
+    if(RGB_COLOR_Instance->C_RAW == 0){
+        return NOTHING_DETECT;
+    }
     // Red is the most prominent color
-    if(RGB_COLOR_Instance->R > RGB_COLOR_Instance->G && RGB_COLOR_Instance->R > RGB_COLOR_Instance->B && RGB_COLOR_Instance->R_RAW > MIN_RAW_VALUE){
+    if(RGB_COLOR_Instance->R_RAW > RGB_COLOR_Instance->G_RAW && RGB_COLOR_Instance->R_RAW > RGB_COLOR_Instance->B_RAW && RGB_COLOR_Instance->R_RAW > MIN_RAW_VALUE){
         return RED_DETECT;
     }
     // Green is the most prominent color
-    else if(RGB_COLOR_Instance->G > RGB_COLOR_Instance->R && RGB_COLOR_Instance->G > RGB_COLOR_Instance->B && RGB_COLOR_Instance->G_RAW > MIN_RAW_VALUE){
+    else if(RGB_COLOR_Instance->G_RAW > RGB_COLOR_Instance->R_RAW && RGB_COLOR_Instance->G_RAW > RGB_COLOR_Instance->B_RAW && RGB_COLOR_Instance->G_RAW > MIN_RAW_VALUE){
         return GREEN_DETECT;
     }
     // Blue is the most prominent color
-    else if(RGB_COLOR_Instance->B > RGB_COLOR_Instance->R && RGB_COLOR_Instance->B > RGB_COLOR_Instance->G && RGB_COLOR_Instance->B_RAW > MIN_RAW_VALUE){
+    else if(RGB_COLOR_Instance->B_RAW > RGB_COLOR_Instance->R_RAW && RGB_COLOR_Instance->B_RAW > RGB_COLOR_Instance->G_RAW && RGB_COLOR_Instance->B_RAW > MIN_RAW_VALUE){
         return BLUE_DETECT;
     }
     // No color is detected
     return NOTHING_DETECT;		
-}
\ No newline at end of file
+}
+
+/*	-------------TCS34727_Get_Lux_CCT----------------
+ *	Illuminance and correlated color temperature of the RGBC sample
+ *	Input: RGB Color User Instance Struct, read at the current exposure
+ *	Output: 1 if valid, 0 if the clear channel saturated or no light
+ */
+uint8_t TCS34727_Get_Lux_CCT(RGB_COLOR_HANDLE_t* RGB_COLOR_Instance){
+	uint32_t exposure = TCS34727_Get_Exposure();
+	uint32_t steps = 256 - tcs_atime;
+	uint32_t saturation = steps * TCS34727_FULL_SCALE_STEP;
+	int32_t ir2, r2, g2, b2;
+	int64_t gpp;
+	uint32_t cct;
+	uint64_t mlux;
+
+	RGB_COLOR_Instance->LUX_MILLI = 0;
+	RGB_COLOR_Instance->CCT = 0;
+
+	/* 1 lux = ATIME_ms * AGAINx / (GA * DF) counts, per mlux in Q16 */
+	if(exposure != tcs_lux_exposure){
+		tcs_lux_scale = (((uint64_t)TCS34727_LUX_GA_X100 * TCS34727_LUX_DF * 10000) << TCS34727_LUX_SCALE_Q)
+			/ ((uint64_t)exposure * TCS34727_ATIME_STEP_US);
+		tcs_lux_exposure = exposure;
+	}
+
+	/* Saturated readings are not linear, short integrations ripple below full scale */
+	if(saturation > 0xFFFF)
+		saturation = 0xFFFF;
+	if(steps < TCS34727_RIPPLE_STEPS)
+		saturation -= saturation / 4;
+	if(RGB_COLOR_Instance->C_RAW >= saturation)
+		return 0;
+
+	/* IR rejection, the clear channel sees IR the filtered ones pass too.
+	   In half counts, IR is half of R + G + B - C */
+	ir2 = (int32_t)RGB_COLOR_Instance->R_RAW + RGB_COLOR_Instance->G_RAW + RGB_COLOR_Instance->B_RAW - RGB_COLOR_Instance->C_RAW;
+	if(ir2 < 0)
+		ir2 = 0;
+	r2 = 2 * RGB_COLOR_Instance->R_RAW - ir2;
+	g2 = 2 * RGB_COLOR_Instance->G_RAW - ir2;
+	b2 = 2 * RGB_COLOR_Instance->B_RAW - ir2;
+
+	/* G'' in Q16 half counts */
+	gpp = (int64_t)TCS34727_LUX_R_COEF * r2 + (int64_t)TCS34727_LUX_G_COEF * g2 + (int64_t)TCS34727_LUX_B_COEF * b2;
+	if(gpp <= 0 || r2 <= 0)
+		return 0;
+
+	/* Down to TCS34727_LUX_GPP_Q counts so the product with the scale fits 64 bits */
+	mlux = ((uint64_t)(gpp >> (TCS34727_LUX_COEF_Q + 1 - TCS34727_LUX_GPP_Q)) * tcs_lux_scale) >> (TCS34727_LUX_GPP_Q + TCS34727_LUX_SCALE_Q);
+	RGB_COLOR_Instance->LUX_MILLI = (mlux > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32_t)mlux;
+	cct = (uint32_t)(TCS34727_CT_COEF * (b2 > 0 ? b2 : 0)) / r2 + TCS34727_CT_OFFSET;
+	RGB_COLOR_Instance->CCT = (cct > 0xFFFF) ? 0xFFFF : cct;
+
+	return 1;
+}
+
+/*	---------------TCS34727_Classify-----------------
+ *	Palette classifier, one table lookup in TCS34727_COLOR_LUT
+ *	Input: RGB Color User Instance Struct, Confidence out (0-15)
+ *	Output: COLOR_DETECTED enum value of the nearest palette color
+ */
+COLOR_DETECTED TCS34727_Classify(RGB_COLOR_HANDLE_t* RGB_COLOR_Instance, uint8_t* confidence){
+	uint32_t sum, recip, light, exposure;
+	uint8_t r, g, l, entry;
+
+	TCS34727_Correct(RGB_COLOR_Instance);
+	sum = (uint32_t)RGB_COLOR_Instance->R_CAL + RGB_COLOR_Instance->G_CAL + RGB_COLOR_Instance->B_CAL;
+	if(RGB_COLOR_Instance->C_CAL <= MIN_RAW_VALUE || sum == 0){
+		*confidence = 0;
+		return NOTHING_DETECT;
+	}
+
+	/* Chromaticity bins, one division shared by both */
+	recip = ((uint32_t)TCS34727_LUT_CHROMA << TCS34727_RGB_Q) / sum;
+	r = ((uint32_t)RGB_COLOR_Instance->R_CAL * recip) >> TCS34727_RGB_Q;
+	g = ((uint32_t)RGB_COLOR_Instance->G_CAL * recip) >> TCS34727_RGB_Q;
+	if(r >= TCS34727_LUT_CHROMA)
+		r = TCS34727_LUT_CHROMA - 1;
+	if(g >= TCS34727_LUT_CHROMA)
+		g = TCS34727_LUT_CHROMA - 1;
+
+	/* Brightness bin, C_NORM >= edge multiplied out so the exposure is not divided */
+	light = (uint32_t)RGB_COLOR_Instance->C_CAL * TCS34727_NORM_STEPS;
+	exposure = TCS34727_Get_Exposure();
+	for(l = 0; l < TCS34727_LUT_LIGHT - 1; l++){
+		if(light < (uint64_t)TCS34727_LUT_LIGHT_EDGE[l] * exposure)
+			break;
+	}
+
+	entry = TCS34727_COLOR_LUT[l][r][g];
+	*confidence = entry & TCS34727_LUT_CONF_MASK;
+	return (COLOR_DETECTED)(entry >> TCS34727_LUT_CLASS_SHIFT);
+}
+
+/*	-------------TCS34727_Cal_Channel----------------
+ *	Local function clamping a Q12 sum to a 16-bit channel
+ *	Input: Sum in Q12
+ *	Output: Rounded channel, 0-65535
+ */
+static uint16_t TCS34727_Cal_Channel(int64_t acc){
+	if(acc <= 0)
+		return 0;
+	acc = (acc + (1 << (TCS34727_CAL_Q - 1))) >> TCS34727_CAL_Q;
+	return (acc > 0xFFFF) ? 0xFFFF : (uint16_t)acc;
+}
+
+/*	----------------TCS34727_Correct-----------------
+ *	Applies the calibration in use to the RAW channels
+ *	Input: RGB Color User Instance Struct, read at the current exposure
+ *	Output: none, fills R_CAL - C_CAL
+ */
+void TCS34727_Correct(RGB_COLOR_HANDLE_t* RGB_COLOR_Instance){
+	const uint16_t raw[3] = {RGB_COLOR_Instance->R_RAW, RGB_COLOR_Instance->G_RAW, RGB_COLOR_Instance->B_RAW};
+	uint16_t* out[3] = {&RGB_COLOR_Instance->R_CAL, &RGB_COLOR_Instance->G_CAL, &RGB_COLOR_Instance->B_CAL};
+	int64_t exposure;
+	uint8_t i;
+
+	if(!tcs_cal_on){
+		RGB_COLOR_Instance->R_CAL = RGB_COLOR_Instance->R_RAW;
+		RGB_COLOR_Instance->G_CAL = RGB_COLOR_Instance->G_RAW;
+		RGB_COLOR_Instance->B_CAL = RGB_COLOR_Instance->B_RAW;
+		RGB_COLOR_Instance->C_CAL = RGB_COLOR_Instance->C_RAW;
+		return;
+	}
+
+	/* Offsets are per TCS34727_NORM_STEPS at 1x, in Q12 at this exposure */
+	exposure = (int64_t)TCS34727_Get_Exposure() * ((1 << TCS34727_CAL_Q) / TCS34727_NORM_STEPS);
+	for(i = 0; i < 3; i++){
+		*out[i] = TCS34727_Cal_Channel(tcs_cal.OFFSET[i] * exposure
+			+ (int64_t)tcs_cal.M[i][0] * raw[0] + (int64_t)tcs_cal.M[i][1] * raw[1] + (int64_t)tcs_cal.M[i][2] * raw[2]);
+	}
+	RGB_COLOR_Instance->C_CAL = TCS34727_Cal_Channel(tcs_cal.OFFSET[3] * exposure + (int64_t)tcs_cal.C_GAIN * RGB_COLOR_Instance->C_RAW);
+}
+
+/*	----------------TCS34727_Set_Cal-----------------
+ *	Input: Calibration to apply from now on, 0 to go back to RAW
+ *	Output: none
+ */
+void TCS34727_Set_Cal(const TCS34727_CAL_t* cal){
+	if(cal != 0)
+		tcs_cal = *cal;
+	tcs_cal_on = (cal != 0);
+}
+
+/*	----------------TCS34727_Get_Cal-----------------
+ *	Input: none
+ *	Output: Calibration in use, 0 if none
+ */
+const TCS34727_CAL_t* TCS34727_Get_Cal(void){
+	return tcs_cal_on ? &tcs_cal : 0;
+}
+
+/*	--------------TCS34727_Cal_Capture---------------
+ *	Reference reading of a palette color held in front of the sensor
+ *	Input: Color of the reference, Reference out
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t TCS34727_Cal_Capture(COLOR_DETECTED color, TCS34727_PALETTE_t* ref){
+	RGB_COLOR_HANDLE_t reading;
+	uint32_t sum[4] = {0, 0, 0, 0};
+	uint8_t i, ret;
+
+	for(i = 0; i < TCS34727_CAL_SETTLE + TCS34727_CAL_READINGS; i++){
+		ret = TCS34727_Read_RGBC_Auto(&reading);
+		if(ret != I2C_OK)
+			return ret;
+		if(i < TCS34727_CAL_SETTLE)
+			continue;
+		sum[0] += reading.R_NORM;
+		sum[1] += reading.G_NORM;
+		sum[2] += reading.B_NORM;
+		sum[3] += reading.C_NORM;
+	}
+
+	ref->color = color;
+	ref->R_NORM = (sum[0] + TCS34727_CAL_READINGS / 2) / TCS34727_CAL_READINGS;
+	ref->G_NORM = (sum[1] + TCS34727_CAL_READINGS / 2) / TCS34727_CAL_READINGS;
+	ref->B_NORM = (sum[2] + TCS34727_CAL_READINGS / 2) / TCS34727_CAL_READINGS;
+	ref->C_NORM = (sum[3] + TCS34727_CAL_READINGS / 2) / TCS34727_CAL_READINGS;
+	return I2C_OK;
+}
+
+/*	-------------TCS34727_Palette_Find---------------
+ *	Local function finding a color in a list of palette entries
+ *	Input: List, Number of entries, Color
+ *	Output: First entry of that color, 0 if none
+ */
+static const TCS34727_PALETTE_t* TCS34727_Palette_Find(const TCS34727_PALETTE_t* list, uint8_t count, COLOR_DETECTED color){
+	uint8_t i;
+
+	for(i = 0; i < count; i++){
+		if(list[i].color == color)
+			return &list[i];
+	}
+	return 0;
+}
+
+/*	---------------TCS34727_Cal_Q12------------------
+ *	Local function converting a coefficient to Q12
+ *	Input: Coefficient, Q12 out
+ *	Output: 1 if it is inside +-TCS34727_CAL_M_MAX, else 0
+ */
+static uint8_t TCS34727_Cal_Q12(float value, int16_t* q){
+	if(value > TCS34727_CAL_M_MAX || value < -TCS34727_CAL_M_MAX || value != value)
+		return 0;
+	*q = (int16_t)(value * (1 << TCS34727_CAL_Q) + (value < 0 ? -0.5f : 0.5f));
+	return 1;
+}
+
+/*	----------------TCS34727_Cal_Fit-----------------
+ *	Fits the correction that takes the references to the palette centroids
+ *	Input: References, Number of references, Calibration out
+ *	Output: 1 on success, 0 without BLACK and WHITE or if out of range
+ */
+uint8_t TCS34727_Cal_Fit(const TCS34727_PALETTE_t* refs, uint8_t count, TCS34727_CAL_t* cal){
+	const TCS34727_PALETTE_t* black = TCS34727_Palette_Find(refs, count, BLACK_DETECT);
+	const TCS34727_PALETTE_t* white = TCS34727_Palette_Find(refs, count, WHITE_DETECT);
+	const TCS34727_PALETTE_t* black_t = TCS34727_Palette_Find(TCS34727_PALETTE, TCS34727_PALETTE_SIZE, BLACK_DETECT);
+	const TCS34727_PALETTE_t* white_t = TCS34727_Palette_Find(TCS34727_PALETTE, TCS34727_PALETTE_SIZE, WHITE_DETECT);
+	const TCS34727_PALETTE_t* target;
+	float dd[3][3] = {{0}}, ed[3][3] = {{0}}, inv[3][3], m[3][3] = {{0}};
+	float d[3], e[3], weight, det, gain;
+	uint8_t i, j, k, used = 0;
+
+	if(black == 0 || white == 0 || black_t == 0 || white_t == 0)
+		return 0;
+
+	/* Sums of the least squares fit, references and targets taken from black */
+	for(k = 0; k < count; k++){
+		target = TCS34727_Palette_Find(TCS34727_PALETTE, TCS34727_PALETTE_SIZE, refs[k].color);
+		if(target == 0 || refs[k].color == BLACK_DETECT)
+			continue;
+		d[0] = (float)refs[k].R_NORM - black->R_NORM;
+		d[1] = (float)refs[k].G_NORM - black->G_NORM;
+		d[2] = (float)refs[k].B_NORM - black->B_NORM;
+		e[0] = (float)target->R_NORM - black_t->R_NORM;
+		e[1] = (float)target->G_NORM - black_t->G_NORM;
+		e[2] = (float)target->B_NORM - black_t->B_NORM;
+		weight = (refs[k].color == WHITE_DETECT) ? TCS34727_CAL_WHITE_WEIGHT : 1;
+		for(i = 0; i < 3; i++){
+			for(j = 0; j < 3; j++){
+				dd[i][j] += weight * d[i] * d[j];
+				ed[i][j] += weight * e[i] * d[j];
+			}
+		}
+		used++;
+	}
+
+	/* M = ED' (DD')^-1 when there are enough colors to pin down all nine entries */
+	inv[0][0] = dd[1][1] * dd[2][2] - dd[1][2] * dd[2][1];
+	inv[0][1] = dd[0][2] * dd[2][1] - dd[0][1] * dd[2][2];
+	inv[0][2] = dd[0][1] * dd[1][2] - dd[0][2] * dd[1][1];
+	inv[1][0] = dd[1][2] * dd[2][0] - dd[1][0] * dd[2][2];
+	inv[1][1] = dd[0][0] * dd[2][2] - dd[0][2] * dd[2][0];
+	inv[1][2] = dd[0][2] * dd[1][0] - dd[0][0] * dd[1][2];
+	inv[2][0] = dd[1][0] * dd[2][1] - dd[1][1] * dd[2][0];
+	inv[2][1] = dd[0][1] * dd[2][0] - dd[0][0] * dd[2][1];
+	inv[2][2] = dd[0][0] * dd[1][1] - dd[0][1] * dd[1][0];
+	det = dd[0][0] * inv[0][0] + dd[0][1] * inv[1][0] + dd[0][2] * inv[2][0];
+
+	if(used >= 3 && det > 1e-6f * dd[0][0] * dd[1][1] * dd[2][2]){
+		for(i = 0; i < 3; i++)
+			for(j = 0; j < 3; j++)
+				m[i][j] = (ed[i][0] * inv[0][j] + ed[i][1] * inv[1][j] + ed[i][2] * inv[2][j]) / det;
+	}
+	else{
+		/* White balance only */
+		if(white->R_NORM <= black->R_NORM || white->G_NORM <= black->G_NORM || white->B_NORM <= black->B_NORM)
+			return 0;
+		m[0][0] = ((float)white_t->R_NORM - black_t->R_NORM) / ((float)white->R_NORM - black->R_NORM);
+		m[1][1] = ((float)white_t->G_NORM - black_t->G_NORM) / ((float)white->G_NORM - black->G_NORM);
+		m[2][2] = ((float)white_t->B_NORM - black_t->B_NORM) / ((float)white->B_NORM - black->B_NORM);
+	}
+
+	for(i = 0; i < 3; i++)
+		for(j = 0; j < 3; j++)
+			if(!TCS34727_Cal_Q12(m[i][j], &cal->M[i][j]))
+				return 0;
+
+	/* Offsets from the matrix as stored, so black lands on its target exactly */
+	for(i = 0; i < 3; i++){
+		float black_out = (cal->M[i][0] * (float)black->R_NORM + cal->M[i][1] * (float)black->G_NORM
+			+ cal->M[i][2] * (float)black->B_NORM) / (1 << TCS34727_CAL_Q);
+		float black_want = (i == 0) ? black_t->R_NORM : (i == 1) ? black_t->G_NORM : black_t->B_NORM;
+		cal->OFFSET[i] = (int32_t)(black_want - black_out + (black_want >= black_out ? 0.5f : -0.5f));
+	}
+
+	/* Clear channel, two points */
+	if(white->C_NORM <= black->C_NORM)
+		return 0;
+	gain = ((float)white_t->C_NORM - black_t->C_NORM) / ((float)white->C_NORM - black->C_NORM);
+	if(gain <= 0 || gain >= 0xFFFF >> TCS34727_CAL_Q)
+		return 0;
+	cal->C_GAIN = (uint16_t)(gain * (1 << TCS34727_CAL_Q) + 0.5f);
+	cal->OFFSET[3] = (int32_t)((float)black_t->C_NORM - (float)cal->C_GAIN * black->C_NORM / (1 << TCS34727_CAL_Q));
+
+	return 1;
+}
+
+/* EEPROM record: magic, version, the calibration, check word */
+#define TCS34727_CAL_WORDS ((sizeof(TCS34727_CAL_t) + 3) / 4)
+
+/*	---------------TCS34727_Cal_Check----------------
+ *	Local function computing the check word of a record
+ *	Input: Record words before the check word
+ *	Output: Check word
+ */
+static uint32_t TCS34727_Cal_Check(const uint32_t* words){
+	uint32_t check = 0;
+	uint8_t i;
+
+	for(i = 0; i < TCS34727_CAL_WORDS + 2; i++)
+		check = ((check << 5) | (check >> 27)) ^ words[i];
+	return ~check;
+}
+
+/*	----------------TCS34727_Cal_Save----------------
+ *	Stores the calibration in use to the EEPROM, with a check word
+ *	Input: none
+ *	Output: EEPROM_OK or EEPROM_ERR_* status code, EEPROM_ERR_PARAM if none
+ */
+uint8_t TCS34727_Cal_Save(void){
+	uint32_t record[TCS34727_CAL_WORDS + 3] = {0};
+
+	if(!tcs_cal_on)
+		return EEPROM_ERR_PARAM;
+
+	record[0] = TCS34727_CAL_MAGIC;
+	record[1] = TCS34727_CAL_VERSION;
+	memcpy(&record[2], &tcs_cal, sizeof(tcs_cal));
+	record[TCS34727_CAL_WORDS + 2] = TCS34727_Cal_Check(record);
+	return EEPROM_Write(TCS34727_CAL_EEPROM_ADDR, record, TCS34727_CAL_WORDS + 3);
+}
+
+/*	----------------TCS34727_Cal_Load----------------
+ *	Applies the calibration stored in the EEPROM
+ *	Input: none
+ *	Output: 1 if a valid calibration was loaded, 0 if there is none
+ */
+uint8_t TCS34727_Cal_Load(void){
+	uint32_t record[TCS34727_CAL_WORDS + 3];
+	TCS34727_CAL_t cal;
+
+	if(EEPROM_Read(TCS34727_CAL_EEPROM_ADDR, record, TCS34727_CAL_WORDS + 3) != EEPROM_OK)
+		return 0;
+	if(record[0] != TCS34727_CAL_MAGIC || record[1] != TCS34727_CAL_VERSION
+		|| record[TCS34727_CAL_WORDS + 2] != TCS34727_Cal_Check(record))
+		return 0;
+
+	memcpy(&cal, &record[2], sizeof(cal));
+	TCS34727_Set_Cal(&cal);
+	return 1;
+}
@@ -16,6 +16,7 @@
 
 #include <stdint.h>
 #include "util.h"
+#include "I2C.h"
 
 /* List of Fill In Macros (Not all need to be filled)
 
@@ -31,9 +32,27 @@ Comment Out All Macros that are not used
 
 // Macros of TCS34727 device Address (Based on Datasheet)
 #define TCS34727_ADDR (0x29) // 7-bit address
+#define TCS34727_BUS I2C_BUS0 // Bus the color sensor is wired to
+#define TCS34727_SOFT 0 // Soft bus instead (e.g. SOFT_I2C_BUS0), 0 to use TCS34727_BUS
+
+/* Comment out to read RGBC with the blocking burst instead of the I2C queue */
+#define TCS34727_USE_I2C_QUEUE
+
+/* Comment in to read color only when the INT line says the scene changed */
+//#define TCS34727_USE_INT
+
+// INT line (open drain, active low) on PE0
+#define TCS34727_INT_GPIO_BASE GPIOE_BASE_ADDR
+#define TCS34727_INT_GPIO_PORT SYSCTL_RCGCGPIO_R4
+#define TCS34727_INT_PIN (0x01)
+#define TCS34727_INT_IRQ (4) // GPIO Port E
+#define TCS34727_INT_PRI (5)
 
 /*************Command Register*************/
 #define TCS34727_CMD (0x80) // define the bit that indicates a command register
+#define TCS34727_CMD_AUTO_INC (0x20) // Command type: register address increments after each byte
+#define TCS34727_CMD_SPECIAL (0x60) // Command type: special function in the low bits
+#define TCS34727_SF_CLEAR_INT (0x06) // Special function: clear the RGBC interrupt
 
 /*************Enable Registers*************/
 #define TCS34727_ENABLE_R_ADDR (0x00) // enable register address
@@ -45,14 +64,84 @@ Comment Out All Macros that are not used
 /**********RGBC Timing Registers***********/
 #define TCS34727_TIMING_R_ADDR (0x01) // Define RGBC timing register address
 #define TCS34727_ATIME_2_4_MS (0xFF)  // Set atime to 2.4ms
+#define TCS34727_ATIME_STEP_US (2400) // Integration time per ATIME step, (256 - ATIME) steps
+#define TCS34727_PON_WARMUP_US (2400) // Oscillator warm-up after PON before AEN
+#define TCS34727_TIMING_MARGIN_PCT (10) // Internal oscillator tolerance on the nominal times
+
+/*********Interrupt Threshold Registers*********/
+#define TCS34727_AILTL_R_ADDR (0x04) // Clear channel low threshold, AILTH follows
+#define TCS34727_AIHTL_R_ADDR (0x06) // Clear channel high threshold, AIHTH follows
+#define TCS34727_THRESH_BYTES (4) // AILTL - AIHTH
+#define TCS34727_THRESH_BAND_PCT (20) // Change of the clear channel that counts as a new scene
+
+/************Persistence Register**********/
+#define TCS34727_PERS_R_ADDR (0x0C)
+#define TCS34727_PERS_EVERY (0x00) // Every RGBC cycle raises AINT
+#define TCS34727_PERS_1 (0x01) // Else AINT after that many cycles in a row outside the thresholds
+#define TCS34727_PERS_2 (0x02)
+#define TCS34727_PERS_3 (0x03)
+#define TCS34727_PERS_5 (0x04)
+#define TCS34727_PERS_10 (0x05)
+#define TCS34727_PERS_20 (0x07)
+#define TCS34727_PERS_60 (0x0F)
 
 /************Control Registers*************/
 #define TCS34727_CTRL_R_ADDR (0x0F) // Define control register address
-#define TCS34727_CTRL_AGAIN_1 (0x01) //
+#define TCS34727_CTRL_AGAIN_1X (0x00)
+#define TCS34727_CTRL_AGAIN_4X (0x01)
+#define TCS34727_CTRL_AGAIN_16X (0x02)
+#define TCS34727_CTRL_AGAIN_60X (0x03)
+
+/************Automatic Exposure*************/
+#define TCS34727_ATIME_STEPS_MAX (256) // ATIME 0x00, 614 ms
+#define TCS34727_FULL_SCALE_STEP (1024) // Clear counts per step at saturation, 65535 at most
+#define TCS34727_AE_MIN_COUNT (256) // SNR target: fewest clear counts a reading may have
+#define TCS34727_AE_MAX_PCT (80) // Most of full scale a reading may use, headroom to saturation
+#define TCS34727_NORM_STEPS (256) // Normalized counts are per 256 steps at 1x gain
+
+/************Color Normalization************/
+#define TCS34727_RGB_MAX (255) // Top of the normalized RGB range
+#define TCS34727_RGB_Q (16) // Fraction bits of the reciprocal of C_RAW, 255 << 16 still fits 32 bits
+
+/************Lux and CCT, ams DN40**********/
+#define TCS34727_LUX_COEF_Q (16) // Fraction bits of the lux coefficients
+#define TCS34727_LUX_R_COEF (8913) // 0.136 in Q16
+#define TCS34727_LUX_G_COEF (65536) // 1.000 in Q16
+#define TCS34727_LUX_B_COEF (-29098) // -0.444 in Q16
+#define TCS34727_LUX_GPP_Q (8) // Fraction bits of G'' kept for the scale multiply
+#define TCS34727_LUX_DF (310) // Device factor
+#define TCS34727_LUX_GA_X100 (100) // Glass attenuation x100, open air. Up to 400 keeps the 64-bit product in range
+#define TCS34727_LUX_SCALE_Q (16) // Fraction bits of the mlux per count scale
+#define TCS34727_CT_COEF (3810) // CCT = CT_COEF * B' / R' + CT_OFFSET
+#define TCS34727_CT_OFFSET (1391)
+#define TCS34727_RIPPLE_STEPS (64) // Below 150 ms the clear channel saturates at 75% of full scale
+
+/************Color Calibration**************/
+#define TCS34727_CAL_Q (12) // Fraction bits of the correction matrix and clear gain
+#define TCS34727_CAL_M_MAX (7) // Largest matrix entry magnitude, keeps Q12 inside int16
+#define TCS34727_CAL_SETTLE (4) // Readings automatic exposure gets before a reference is taken
+#define TCS34727_CAL_READINGS (8) // Readings averaged into one reference
+#define TCS34727_CAL_WHITE_WEIGHT (4) // Weight of the white reference in the matrix fit
+#define TCS34727_CAL_EEPROM_ADDR (0) // Word address of the stored calibration, block 0
+#define TCS34727_CAL_MAGIC (0x4C414354) // "TCAL"
+#define TCS34727_CAL_VERSION (1)
+
+/************Palette Classifier*************/
+#define TCS34727_LUT_CHROMA (16) // Bins of r = R/(R+G+B) and of g = G/(R+G+B)
+#define TCS34727_LUT_LIGHT (4) // Bins of brightness, C_NORM against TCS34727_LUT_LIGHT_EDGE
+#define TCS34727_LUT_CLASS_SHIFT (4) // LUT entry: class in the high nibble
+#define TCS34727_LUT_CONF_MASK (0x0F) // LUT entry: confidence in the low nibble
+#define TCS34727_CONF_MAX (15) // Confidence at a palette centroid
+#define TCS34727_CONF_MIN (4) // Below this the test loop treats a color as unknown
 
 /**************ID Registers****************/
 #define TCS34727_ID_R_ADDR (0x12)
 
+/**************Status Register*************/
+#define TCS34727_STATUS_R_ADDR (0x13)
+#define TCS34727_STATUS_AVALID (0x01) // An integration has completed since AEN
+#define TCS34727_STATUS_AINT (0x10) // RGBC interrupt, every cycle at TCS34727_PERS_EVERY
+
 /***********Color Data Register address definitions ***********/
 #define TCS34727_CDATAL_R_ADDR (0x14)
 #define TCS34727_CDATAH_R_ADDR (0x15)
@@ -62,6 +151,7 @@ Comment Out All Macros that are not used
 #define TCS34727_GDATAH_R_ADDR (0x19)
 #define TCS34727_BDATAL_R_ADDR (0x1A)
 #define TCS34727_BDATAH_R_ADDR (0x1B)
+#define TCS34727_RGBC_BYTES (8) // CDATAL - BDATAH
 
 /*************TCS34727 device ID Values**************/
 #define TCS34727_ID (0x4D)
@@ -75,9 +165,24 @@ typedef enum
 	RED_DETECT = 0,
 	GREEN_DETECT = 1,
 	BLUE_DETECT = 2,
-	NOTHING_DETECT = 3
+	NOTHING_DETECT = 3,
+	YELLOW_DETECT = 4,
+	CYAN_DETECT = 5,
+	PURPLE_DETECT = 6,
+	WHITE_DETECT = 7,
+	BLACK_DETECT = 8
 } COLOR_DETECTED;
 
+/* Palette centroid, what a part of that color reads at TCS34727_NORM_STEPS and 1x */
+typedef struct
+{
+	COLOR_DETECTED color;
+	uint32_t R_NORM;
+	uint32_t G_NORM;
+	uint32_t B_NORM;
+	uint32_t C_NORM;
+} TCS34727_PALETTE_t;
+
 /* Data Struct to store RGB color values */
 typedef struct
 {
@@ -89,8 +194,47 @@ typedef struct
 	float R;
 	float G;
 	float B;
+
+	/* RAW through the calibration, equal to RAW while there is none, see TCS34727_Correct */
+	uint16_t R_CAL;
+	uint16_t G_CAL;
+	uint16_t B_CAL;
+	uint16_t C_CAL;
+
+	/* *_CAL / C_CAL scaled to 0-255 in integer math, see TCS34727_GET_RGB_Fixed */
+	uint8_t R_INT;
+	uint8_t G_INT;
+	uint8_t B_INT;
+
+	/* RAW scaled to TCS34727_NORM_STEPS at 1x gain, comparable across exposures */
+	uint32_t R_NORM;
+	uint32_t G_NORM;
+	uint32_t B_NORM;
+	uint32_t C_NORM;
+
+	/* Illuminance in millilux and correlated color temperature in K, see TCS34727_Get_Lux_CCT */
+	uint32_t LUX_MILLI;
+	uint16_t CCT;
 } RGB_COLOR_HANDLE_t;
 
+/* Bus descriptor, TCS3472x is rated for Fast-mode (400kHz) */
+extern I2C_DEVICE_t TCS34727_DEVICE;
+
+/* Color correction, fitted by TCS34727_Cal_Fit
+	 corrected = M * RAW + OFFSET * exposure / TCS34727_NORM_STEPS, clear on its own */
+typedef struct
+{
+	int16_t M[3][3];										// R, G, B rows, Q12
+	uint16_t C_GAIN;										// Q12
+	int32_t OFFSET[4];									// R, G, B, C in *_NORM units
+} TCS34727_CAL_t;
+
+/* Palette classifier tables, generated into TCS34727LUT.c by tools/tcs34727_lut_gen.py */
+extern const uint8_t TCS34727_COLOR_LUT[TCS34727_LUT_LIGHT][TCS34727_LUT_CHROMA][TCS34727_LUT_CHROMA];
+extern const uint32_t TCS34727_LUT_LIGHT_EDGE[TCS34727_LUT_LIGHT - 1];
+extern const TCS34727_PALETTE_t TCS34727_PALETTE[];
+extern const uint8_t TCS34727_PALETTE_SIZE;
+
 /*	-------------------TCS34727_Init------------------
  *	Basic Initialization Function for TCS34727 at default settings
  *	Input: none
@@ -126,6 +270,112 @@ uint16_t TCS34727_GET_RAW_GREEN(void);
  */
 uint16_t TCS34727_GET_RAW_BLUE(void);
 
+/*	----------------TCS34727_Read_RGBC---------------
+ *	Read all four channels in one auto-increment burst. The part
+ *	latches each high byte when its low byte is read, so the four
+ *	values always come from the same integration cycle
+ *	Input: RGB Color User Instance Struct, RAW fields are filled
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code and the
+ *	        RAW fields are left as they were
+ */
+uint8_t TCS34727_Read_RGBC(RGB_COLOR_HANDLE_t *RGB_COLOR_Instance);
+
+/*	------------TCS34727_Read_RGBC_Next--------------
+ *	Read the next RGBC result, one call per integration cycle. Sleeps
+ *	until the cycle after the last result can have ended (timed from
+ *	ATIME), then polls STATUS until AINT shows the new result, reads
+ *	the channels in one burst and clears AINT. Each result is returned
+ *	once, so calling this in a loop samples at the integration rate
+ *	Input: RGB Color User Instance Struct, RAW fields are filled
+ *	Output: I2C_OK on success, I2C_ERR_TIMEOUT if no result came within
+ *	        one integration time plus margin, otherwise I2C_ERR_* status code
+ */
+uint8_t TCS34727_Read_RGBC_Next(RGB_COLOR_HANDLE_t *RGB_COLOR_Instance);
+
+/*	---------------TCS34727_Wait_Valid---------------
+ *	Wait for the first result after AEN by polling AVALID. The bus is
+ *	left alone until the integration time from ATIME has nearly gone
+ *	Input: none
+ *	Output: I2C_OK once AVALID is set, I2C_ERR_TIMEOUT if it is not set
+ *	        within one integration time plus margin, otherwise I2C_ERR_* status code
+ */
+uint8_t TCS34727_Wait_Valid(void);
+
+/*	------------TCS34727_Threshold_Mode--------------
+ *	Stop sampling every cycle, AINT (and the INT line) only comes when
+ *	the clear channel leaves a band around the current scene for the
+ *	given number of cycles. Takes one reading to center the band on
+ *	Input: Persistence (TCS34727_PERS_1 - TCS34727_PERS_60), Band half
+ *	       width in percent of the current clear count
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t TCS34727_Threshold_Mode(uint8_t pers, uint8_t band_pct);
+
+/*	-------------TCS34727_Cycle_Mode-----------------
+ *	Back to AINT on every cycle for TCS34727_Read_RGBC_Next
+ *	Input: none
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t TCS34727_Cycle_Mode(void);
+
+/*	-----------TCS34727_Set_Thresholds---------------
+ *	Input: Clear channel low and high threshold in counts
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t TCS34727_Set_Thresholds(uint16_t low, uint16_t high);
+
+/*	--------------TCS34727_INT_Init------------------
+ *	PE0 as input with pull-up, falling edge interrupt for the INT line
+ *	Input: none
+ *	Output: none
+ */
+void TCS34727_INT_Init(void);
+
+/*	---------------TCS34727_Changed------------------
+ *	Input: none
+ *	Output: 1 if the INT line fired since the last TCS34727_Read_Change
+ */
+uint8_t TCS34727_Changed(void);
+
+/*	-------------TCS34727_Read_Change----------------
+ *	Read the new scene after TCS34727_Changed, center the band on it
+ *	and clear AINT so the next change can be seen
+ *	Input: RGB Color User Instance Struct, RAW fields are filled
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t TCS34727_Read_Change(RGB_COLOR_HANDLE_t *RGB_COLOR_Instance);
+
+/*	-------------TCS34727_Set_Exposure---------------
+ *	Program integration time and gain, and restart the RGBC cycle so
+ *	the next result is taken entirely at the new setting
+ *	Input: ATIME register value, AGAIN (TCS34727_CTRL_AGAIN_1X - 60X)
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t TCS34727_Set_Exposure(uint8_t atime, uint8_t again);
+
+/*	-------------TCS34727_Read_RGBC_Auto-------------
+ *	TCS34727_Read_RGBC_Next with automatic exposure. The NORM fields
+ *	get the reading at a common scale, then ATIME/AGAIN are moved so
+ *	the next clear count lands between TCS34727_AE_MIN_COUNT and
+ *	TCS34727_AE_MAX_PCT of full scale with the shortest integration
+ *	that can: gain is raised first, integration time only after that
+ *	Input: RGB Color User Instance Struct, RAW and NORM fields are filled
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t TCS34727_Read_RGBC_Auto(RGB_COLOR_HANDLE_t *RGB_COLOR_Instance);
+
+/*	-------------TCS34727_Get_Exposure---------------
+ *	Input: none
+ *	Output: Integration steps times gain of the current setting
+ */
+uint32_t TCS34727_Get_Exposure(void);
+
+/*	-----------TCS34727_Get_Integration_Us-----------
+ *	Input: none
+ *	Output: Integration time of one RGBC cycle at the ATIME written, in us
+ */
+uint32_t TCS34727_Get_Integration_Us(void);
+
 /*	---------------TCS34727_GET_RGB------------------
  *	Normalize RAW data into RGB range (0-255)
  *	Input: RGB Color User Instance Struct
@@ -133,11 +383,105 @@ uint16_t TCS34727_GET_RAW_BLUE(void);
  */
 void TCS34727_GET_RGB(RGB_COLOR_HANDLE_t *RGB_COLOR_Instance);
 
+/*	------------TCS34727_GET_RGB_Fixed---------------
+ *	Normalize RAW data into RGB range (0-255) without floating point.
+ *	Runs TCS34727_Correct, then one Q16 reciprocal of C_CAL and a
+ *	multiply and shift per channel. Without a calibration each of
+ *	R_INT, G_INT, B_INT is (int) of the float from TCS34727_GET_RGB
+ *	or one less, and 255 where RAW >= C_RAW
+ *	Input: RGB Color User Instance Struct
+ *	Output: none
+ */
+void TCS34727_GET_RGB_Fixed(RGB_COLOR_HANDLE_t *RGB_COLOR_Instance);
+
 /*	-----------------Detect_Color--------------------
- *	Detect which color is more prominant and returns that color
+ *	Detect which color is more prominant and returns that color.
+ *	Compares the RAW channels, which are in the same order as R, G, B
+ *	since all three share the 255 / C_RAW scale, so neither GET_RGB
+ *	has to run first. Red, green and blue only, TCS34727_Classify
+ *	tells the whole palette apart
  *	Input: RGB Color User Instance Struct
  *	Output: COLOR_DETECTED enum value
  */
 COLOR_DETECTED Detect_Color(RGB_COLOR_HANDLE_t *RGB_COLOR_Instance);
 
+/*	-------------TCS34727_Get_Lux_CCT----------------
+ *	Illuminance and correlated color temperature of the RGBC sample
+ *	(ams DN40) in integer math. The IR part is taken out of every
+ *	channel once, in half counts so it stays exact, lux uses Q16
+ *	coefficients and a per exposure scale that is only worked out
+ *	again when ATIME or AGAIN changed
+ *	Input: RGB Color User Instance Struct, read at the current exposure
+ *	Output: 1 if valid, 0 if the clear channel saturated or no light
+ *	(LUX_MILLI and CCT are then 0)
+ */
+uint8_t TCS34727_Get_Lux_CCT(RGB_COLOR_HANDLE_t *RGB_COLOR_Instance);
+
+/*	---------------TCS34727_Classify-----------------
+ *	Palette classifier, one table lookup in TCS34727_COLOR_LUT. The
+ *	index is the chromaticity of R, G, B and the brightness of C
+ *	at the exposure it was read with, so it works after any of the
+ *	read functions. The channels go through TCS34727_Correct first.
+ *	Too dark to tell gives NOTHING_DETECT at 0
+ *	Input: RGB Color User Instance Struct, Confidence out (0-15)
+ *	Output: COLOR_DETECTED enum value of the nearest palette color
+ */
+COLOR_DETECTED TCS34727_Classify(RGB_COLOR_HANDLE_t *RGB_COLOR_Instance, uint8_t *confidence);
+
+/*	----------------TCS34727_Correct-----------------
+ *	Applies the calibration set with TCS34727_Set_Cal to the RAW
+ *	channels, in Q12 with 64-bit sums, offsets scaled to the current
+ *	exposure. Copies RAW while there is no calibration
+ *	Input: RGB Color User Instance Struct, read at the current exposure
+ *	Output: none, fills R_CAL - C_CAL
+ */
+void TCS34727_Correct(RGB_COLOR_HANDLE_t *RGB_COLOR_Instance);
+
+/*	----------------TCS34727_Set_Cal-----------------
+ *	Input: Calibration to apply from now on, 0 to go back to RAW
+ *	Output: none
+ */
+void TCS34727_Set_Cal(const TCS34727_CAL_t *cal);
+
+/*	----------------TCS34727_Get_Cal-----------------
+ *	Input: none
+ *	Output: Calibration in use, 0 if none
+ */
+const TCS34727_CAL_t* TCS34727_Get_Cal(void);
+
+/*	--------------TCS34727_Cal_Capture---------------
+ *	Reference reading of a palette color held in front of the sensor.
+ *	Lets automatic exposure settle, then averages the *_NORM channels
+ *	of TCS34727_CAL_READINGS readings
+ *	Input: Color of the reference, Reference out
+ *	Output: I2C_OK on success, otherwise I2C_ERR_* status code
+ */
+uint8_t TCS34727_Cal_Capture(COLOR_DETECTED color, TCS34727_PALETTE_t *ref);
+
+/*	----------------TCS34727_Cal_Fit-----------------
+ *	Fits the correction that takes the references to the palette
+ *	centroids. BLACK and WHITE are needed and fix the offsets and
+ *	the white balance. With two or more other palette colors the 3x3
+ *	matrix is a least squares fit over them and white (weighted
+ *	TCS34727_CAL_WHITE_WEIGHT), else it is the diagonal white gains.
+ *	Float math, it runs once per calibration
+ *	Input: References, Number of references, Calibration out
+ *	Output: 1 on success, 0 without BLACK and WHITE or if out of range
+ */
+uint8_t TCS34727_Cal_Fit(const TCS34727_PALETTE_t *refs, uint8_t count, TCS34727_CAL_t *cal);
+
+/*	----------------TCS34727_Cal_Save----------------
+ *	Stores the calibration in use to the EEPROM, with a check word
+ *	Input: none
+ *	Output: EEPROM_OK or EEPROM_ERR_* status code, EEPROM_ERR_PARAM if none
+ */
+uint8_t TCS34727_Cal_Save(void);
+
+/*	----------------TCS34727_Cal_Load----------------
+ *	Applies the calibration stored in the EEPROM, EEPROM_Init first
+ *	Input: none
+ *	Output: 1 if a valid calibration was loaded, 0 if there is none
+ */
+uint8_t TCS34727_Cal_Load(void);
+
 #endif
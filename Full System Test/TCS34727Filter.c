@@ -0,0 +1,168 @@
+/*
+ * TCS34727Filter.c
+ *
+ *	Moving average, EMA and median of N filters for TCS34727 samples
+ *
+ * Created on: October 17th, 2026
+ *
+ */
+
+#include "TCS34727Filter.h"
+#include <string.h>
+
+/*	-------------TCS34727_Filter_Find----------------
+ *	Local function, binary search of a sorted window
+ *	Input: Sorted window, Entries in it, Value
+ *	Output: Index of the first entry not below the value
+ */
+static uint8_t TCS34727_Filter_Find(const uint16_t* sorted, uint8_t size, uint16_t value){
+	uint8_t lo = 0, hi = size;
+
+	while(lo < hi){
+		uint8_t mid = (lo + hi) >> 1;
+		if(sorted[mid] < value)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/*	------------TCS34727_Filter_Median---------------
+ *	Local function, moves one channel's sorted window along
+ *	Input: Sorted window, Entries before the sample, Sample leaving
+ *				 (when the window is full), New sample
+ *	Output: Median of the window after the sample
+ */
+static uint16_t TCS34727_Filter_Median(uint16_t* sorted, uint8_t size, uint8_t full, uint16_t out, uint16_t in){
+	uint8_t from, to;
+
+	if(!full){
+		to = TCS34727_Filter_Find(sorted, size, in);
+		for(from = size; from > to; from--)
+			sorted[from] = sorted[from - 1];
+		sorted[to] = in;
+		size++;
+	}
+	else{
+		/* The entries between the leaving and the new sample close the gap */
+		from = TCS34727_Filter_Find(sorted, size, out);
+		to = TCS34727_Filter_Find(sorted, size, in);
+		if(to > from){
+			for(to--; from < to; from++)
+				sorted[from] = sorted[from + 1];
+		}
+		else{
+			for(; from > to; from--)
+				sorted[from] = sorted[from - 1];
+		}
+		sorted[to] = in;
+	}
+
+	return sorted[size >> 1];
+}
+
+/*	-------------TCS34727_Filter_Init----------------
+ *	Input: Filter, Type, Window or EMA shift
+ *	Output: 1 on success, 0 if N is out of range for the type
+ */
+uint8_t TCS34727_Filter_Init(TCS34727_FILTER_t* filter, TCS34727_FILTER_TYPE_t type, uint8_t n){
+	switch(type){
+	case TCS34727_FILTER_NONE:
+		n = 1;
+		break;
+	case TCS34727_FILTER_AVG:
+	case TCS34727_FILTER_MEDIAN:
+		if(n < 1 || n > TCS34727_FILTER_MAX_N)
+			return 0;
+		break;
+	case TCS34727_FILTER_EMA:
+		if(n < 1 || n > TCS34727_FILTER_EMA_MAX_SHIFT)
+			return 0;
+		break;
+	default:
+		return 0;
+	}
+
+	filter->type = type;
+	filter->n = n;
+	TCS34727_Filter_Reset(filter);
+	return 1;
+}
+
+/*	-------------TCS34727_Filter_Reset---------------
+ *	Input: Filter
+ *	Output: none
+ */
+void TCS34727_Filter_Reset(TCS34727_FILTER_t* filter){
+	filter->count = 0;
+	filter->head = 0;
+	filter->exposure = 0;
+	memset(filter->acc, 0, sizeof(filter->acc));
+}
+
+/*	------------TCS34727_Filter_Update---------------
+ *	Adds a sample and replaces its RAW channels with the filtered ones
+ *	Input: Filter, RGB Color User Instance Struct with a new reading
+ *	Output: 1 once the window is full (EMA: 2^N samples), else 0
+ */
+uint8_t TCS34727_Filter_Update(TCS34727_FILTER_t* filter, RGB_COLOR_HANDLE_t* RGB_COLOR_Instance){
+	uint16_t* raw[TCS34727_FILTER_CHANNELS] = {&RGB_COLOR_Instance->R_RAW, &RGB_COLOR_Instance->G_RAW,
+		&RGB_COLOR_Instance->B_RAW, &RGB_COLOR_Instance->C_RAW};
+	uint32_t exposure = TCS34727_Get_Exposure();
+	uint8_t full, size, taken, ch;
+	uint16_t in;
+
+	if(filter->type == TCS34727_FILTER_NONE)
+		return 1;
+
+	if(exposure != filter->exposure){
+		TCS34727_Filter_Reset(filter);
+		filter->exposure = exposure;
+	}
+
+	full = (filter->count >= filter->n);
+	size = full ? filter->n : filter->count;
+	taken = full ? filter->n : filter->count + 1;
+
+	for(ch = 0; ch < TCS34727_FILTER_CHANNELS; ch++){
+		in = *raw[ch];
+
+		switch(filter->type){
+		case TCS34727_FILTER_AVG:
+			if(full)
+				filter->acc[ch] -= filter->ring[ch][filter->head];
+			filter->acc[ch] += in;
+			*raw[ch] = (filter->acc[ch] + (taken >> 1)) / taken;
+			break;
+
+		case TCS34727_FILTER_EMA:
+			/* Seeded with the first sample, no ramp up from 0 */
+			if(filter->count == 0)
+				filter->acc[ch] = (uint32_t)in << TCS34727_FILTER_EMA_Q;
+			else
+				filter->acc[ch] = (int32_t)filter->acc[ch]
+					+ (((int32_t)((uint32_t)in << TCS34727_FILTER_EMA_Q) - (int32_t)filter->acc[ch]) >> filter->n);
+			*raw[ch] = (filter->acc[ch] + (1 << (TCS34727_FILTER_EMA_Q - 1))) >> TCS34727_FILTER_EMA_Q;
+			break;
+
+		case TCS34727_FILTER_MEDIAN:
+			*raw[ch] = TCS34727_Filter_Median(filter->sorted[ch], size, full, filter->ring[ch][filter->head], in);
+			break;
+
+		default:
+			break;
+		}
+
+		filter->ring[ch][filter->head] = in;
+	}
+
+	if(filter->type != TCS34727_FILTER_EMA && ++filter->head == filter->n)
+		filter->head = 0;
+	if(filter->count < 0xFF)
+		filter->count++;
+
+	if(filter->type == TCS34727_FILTER_EMA)
+		return filter->count >= (1U << filter->n) || filter->count == 0xFF;
+	return filter->count >= filter->n;
+}
@@ -0,0 +1,74 @@
+/*
+ * TCS34727Filter.h
+ *
+ *	Provides per channel noise filters for TCS34727 RGBC samples:
+ *	moving average, exponential (EMA) and median of N. Each filter
+ *	keeps its window in a fixed ring inside its struct, nothing is
+ *	allocated. The filtered counts replace RAW, so the normalization,
+ *	classifier and lux functions work on them unchanged.
+ *
+ *	Moving average and EMA update in O(1). The median keeps each
+ *	channel's window sorted, finds the leaving and the new sample by
+ *	binary search (O(log N) compares) and shifts only the entries
+ *	between them, at most N - 1 halfwords for N up to 9
+ *
+ * Created on: October 17th, 2026
+ *
+ */
+
+#ifndef TCS34727FILTER_H_
+#define TCS34727FILTER_H_
+
+#include <stdint.h>
+#include "TCS34727.h"
+
+/* List of Macros */
+#define TCS34727_FILTER_CHANNELS (4) // R, G, B, C in the order of the RAW fields
+#define TCS34727_FILTER_MAX_N (9) // Longest moving average and median window
+#define TCS34727_FILTER_EMA_MAX_SHIFT (8) // EMA weight of a new sample is 1 / 2^shift
+#define TCS34727_FILTER_EMA_Q (8) // Fraction bits of the EMA state
+
+typedef enum{
+	TCS34727_FILTER_NONE,								// RAW passes through
+	TCS34727_FILTER_AVG,								// Mean of the last N samples
+	TCS34727_FILTER_EMA,								// state += (sample - state) / 2^N
+	TCS34727_FILTER_MEDIAN							// Median of the last N samples, rejects spikes
+} TCS34727_FILTER_TYPE_t;
+
+/* Filter state, one per sample stream */
+typedef struct{
+	TCS34727_FILTER_TYPE_t type;
+	uint8_t n;													// Window, or the EMA shift
+	uint8_t count;											// Samples taken since the reset, stops at 255
+	uint8_t head;												// Ring slot the next sample goes to
+	uint32_t exposure;									// Exposure the samples were taken at
+	uint32_t acc[TCS34727_FILTER_CHANNELS];		// Window sum, or the EMA state in Q8
+	uint16_t ring[TCS34727_FILTER_CHANNELS][TCS34727_FILTER_MAX_N];		// Samples in arrival order
+	uint16_t sorted[TCS34727_FILTER_CHANNELS][TCS34727_FILTER_MAX_N];	// Same samples in ascending order, median only
+} TCS34727_FILTER_t;
+
+/*	-------------TCS34727_Filter_Init----------------
+ *	Input: Filter, Type, Window (1 - TCS34727_FILTER_MAX_N) or EMA
+ *				 shift (1 - TCS34727_FILTER_EMA_MAX_SHIFT)
+ *	Output: 1 on success, 0 if N is out of range for the type
+ */
+uint8_t TCS34727_Filter_Init(TCS34727_FILTER_t *filter, TCS34727_FILTER_TYPE_t type, uint8_t n);
+
+/*	-------------TCS34727_Filter_Reset---------------
+ *	Forgets the samples, e.g. after the scene changed on purpose
+ *	Input: Filter
+ *	Output: none
+ */
+void TCS34727_Filter_Reset(TCS34727_FILTER_t *filter);
+
+/*	------------TCS34727_Filter_Update---------------
+ *	Adds a sample and replaces its RAW channels with the filtered
+ *	ones. Samples of a different exposure (automatic exposure moved)
+ *	start the window over, counts of two exposures do not mix. Until
+ *	the window is full the filter works on the samples it has
+ *	Input: Filter, RGB Color User Instance Struct with a new reading
+ *	Output: 1 once the window is full (EMA: 2^N samples), else 0
+ */
+uint8_t TCS34727_Filter_Update(TCS34727_FILTER_t *filter, RGB_COLOR_HANDLE_t *RGB_COLOR_Instance);
+
+#endif
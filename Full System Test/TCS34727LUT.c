@@ -0,0 +1,105 @@
+/*
+ * TCS34727LUT.c
+ *
+ *	Lookup table of the TCS34727 palette classifier (TCS34727_Classify).
+ *	Generated by tools/tcs34727_lut_gen.py from tools/tcs34727_palette.csv,
+ *	weight 0.05, max-dist 0.25, margin 0.08. Do not edit, change the
+ *	palette and run the generator again
+ *
+ * Created on: October 17th, 2026
+ *
+ */
+
+#include "TCS34727.h"
+
+/* C_NORM where each brightness bin starts */
+const uint32_t TCS34727_LUT_LIGHT_EDGE[TCS34727_LUT_LIGHT - 1] = {13416, 30000, 67082};
+
+/* [brightness][r][g], class << TCS34727_LUT_CLASS_SHIFT | confidence */
+const uint8_t TCS34727_COLOR_LUT[TCS34727_LUT_LIGHT][TCS34727_LUT_CHROMA][TCS34727_LUT_CHROMA] = {
+	{
+		{0x30, 0x30, 0x23, 0x27, 0x28, 0x24, 0x50, 0x51, 0x11, 0x13, 0x12, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x30, 0x21, 0x27, 0x2C, 0x2F, 0x29, 0x20, 0x50, 0x16, 0x19, 0x17, 0x12, 0x30, 0x30, 0x30, 0x30},
+		{0x30, 0x22, 0x29, 0x2E, 0x2F, 0x2C, 0x21, 0x13, 0x1C, 0x1F, 0x1A, 0x14, 0x30, 0x30, 0x30, 0x30},
+		{0x30, 0x20, 0x25, 0x28, 0x28, 0x25, 0x21, 0x17, 0x1F, 0x1F, 0x1B, 0x15, 0x30, 0x30, 0x30, 0x30},
+		{0x60, 0x63, 0x61, 0x84, 0x89, 0x8D, 0x8D, 0x11, 0x1E, 0x1D, 0x19, 0x13, 0x30, 0x30, 0x30, 0x30},
+		{0x64, 0x69, 0x67, 0x82, 0x8F, 0x8F, 0x8F, 0x89, 0x12, 0x18, 0x15, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x66, 0x6C, 0x6E, 0x64, 0x8A, 0x8F, 0x8F, 0x87, 0x81, 0x11, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x63, 0x69, 0x6F, 0x69, 0x82, 0x8C, 0x86, 0x81, 0x41, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x01, 0x00, 0x61, 0x62, 0x62, 0x82, 0x41, 0x42, 0x42, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x07, 0x0C, 0x0E, 0x0B, 0x06, 0x00, 0x42, 0x42, 0x40, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x08, 0x0D, 0x0F, 0x0F, 0x0B, 0x04, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x06, 0x0B, 0x0D, 0x0D, 0x09, 0x04, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x03, 0x07, 0x08, 0x08, 0x05, 0x00, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x30, 0x01, 0x02, 0x02, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30}
+	},
+	{
+		{0x30, 0x30, 0x25, 0x2A, 0x2A, 0x23, 0x53, 0x54, 0x11, 0x14, 0x13, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x30, 0x23, 0x29, 0x2F, 0x2F, 0x28, 0x54, 0x54, 0x16, 0x1C, 0x1A, 0x14, 0x30, 0x30, 0x30, 0x30},
+		{0x30, 0x24, 0x2C, 0x2F, 0x2F, 0x2C, 0x53, 0x10, 0x1D, 0x1F, 0x1E, 0x17, 0x30, 0x30, 0x30, 0x30},
+		{0x30, 0x21, 0x28, 0x2F, 0x2F, 0x2D, 0x51, 0x16, 0x1F, 0x1F, 0x1F, 0x18, 0x10, 0x30, 0x30, 0x30},
+		{0x62, 0x65, 0x64, 0x22, 0x22, 0x81, 0x83, 0x19, 0x1F, 0x1F, 0x1C, 0x16, 0x30, 0x30, 0x30, 0x30},
+		{0x67, 0x6D, 0x6F, 0x6A, 0x84, 0x8B, 0x89, 0x81, 0x19, 0x1B, 0x17, 0x12, 0x30, 0x30, 0x30, 0x30},
+		{0x69, 0x6F, 0x6F, 0x6F, 0x64, 0x87, 0x80, 0x44, 0x44, 0x11, 0x11, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x65, 0x6E, 0x6F, 0x6F, 0x69, 0x43, 0x49, 0x4C, 0x49, 0x43, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x01, 0x01, 0x61, 0x63, 0x64, 0x46, 0x4E, 0x4D, 0x48, 0x43, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x0B, 0x0F, 0x0F, 0x0F, 0x0A, 0x41, 0x49, 0x48, 0x45, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x0C, 0x0F, 0x0F, 0x0F, 0x0F, 0x05, 0x41, 0x42, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x0A, 0x0F, 0x0F, 0x0F, 0x0D, 0x07, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x05, 0x0A, 0x0C, 0x0B, 0x08, 0x03, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x30, 0x03, 0x05, 0x05, 0x02, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30}
+	},
+	{
+		{0x30, 0x30, 0x25, 0x2A, 0x28, 0x21, 0x58, 0x59, 0x51, 0x13, 0x13, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x30, 0x23, 0x2A, 0x2F, 0x2F, 0x24, 0x5B, 0x59, 0x12, 0x1A, 0x1A, 0x15, 0x30, 0x30, 0x30, 0x30},
+		{0x30, 0x24, 0x2C, 0x2F, 0x2F, 0x28, 0x5C, 0x56, 0x1B, 0x1F, 0x1F, 0x18, 0x10, 0x30, 0x30, 0x30},
+		{0x30, 0x21, 0x28, 0x2F, 0x2F, 0x29, 0x58, 0x12, 0x1F, 0x1F, 0x1F, 0x18, 0x11, 0x30, 0x30, 0x30},
+		{0x63, 0x66, 0x65, 0x21, 0x23, 0x70, 0x50, 0x16, 0x1F, 0x1F, 0x1D, 0x16, 0x30, 0x30, 0x30, 0x30},
+		{0x68, 0x6E, 0x6F, 0x6D, 0x72, 0x7A, 0x74, 0x42, 0x17, 0x1C, 0x18, 0x13, 0x30, 0x30, 0x30, 0x30},
+		{0x6A, 0x6F, 0x6F, 0x6F, 0x66, 0x40, 0x48, 0x4C, 0x49, 0x41, 0x11, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x66, 0x6F, 0x6F, 0x6F, 0x68, 0x4B, 0x4F, 0x4F, 0x4E, 0x46, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x02, 0x02, 0x00, 0x63, 0x63, 0x4D, 0x4F, 0x4F, 0x4C, 0x45, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x0C, 0x0F, 0x0F, 0x0F, 0x0D, 0x43, 0x4D, 0x4B, 0x47, 0x42, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x0D, 0x0F, 0x0F, 0x0F, 0x0F, 0x05, 0x42, 0x45, 0x42, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x0B, 0x0F, 0x0F, 0x0F, 0x0E, 0x08, 0x00, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x07, 0x0B, 0x0E, 0x0D, 0x09, 0x04, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x01, 0x04, 0x06, 0x06, 0x03, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30}
+	},
+	{
+		{0x30, 0x30, 0x24, 0x26, 0x24, 0x52, 0x5B, 0x5B, 0x53, 0x11, 0x12, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x30, 0x21, 0x28, 0x2D, 0x29, 0x52, 0x5F, 0x5D, 0x52, 0x16, 0x17, 0x13, 0x30, 0x30, 0x30, 0x30},
+		{0x30, 0x23, 0x2A, 0x2F, 0x2C, 0x50, 0x5F, 0x5C, 0x14, 0x1C, 0x1D, 0x16, 0x30, 0x30, 0x30, 0x30},
+		{0x30, 0x20, 0x25, 0x2C, 0x2B, 0x22, 0x5C, 0x54, 0x1A, 0x1F, 0x1D, 0x17, 0x30, 0x30, 0x30, 0x30},
+		{0x62, 0x65, 0x64, 0x72, 0x76, 0x7B, 0x75, 0x12, 0x1B, 0x1F, 0x1B, 0x15, 0x30, 0x30, 0x30, 0x30},
+		{0x66, 0x6C, 0x6E, 0x64, 0x7C, 0x7F, 0x79, 0x71, 0x12, 0x17, 0x17, 0x11, 0x30, 0x30, 0x30, 0x30},
+		{0x68, 0x6F, 0x6F, 0x6C, 0x74, 0x75, 0x46, 0x4A, 0x4A, 0x42, 0x10, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x64, 0x6C, 0x6F, 0x6F, 0x62, 0x4A, 0x4F, 0x4F, 0x4F, 0x48, 0x40, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x02, 0x02, 0x01, 0x62, 0x41, 0x4F, 0x4F, 0x4F, 0x4D, 0x46, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x0B, 0x0F, 0x0F, 0x0F, 0x08, 0x46, 0x4E, 0x4C, 0x48, 0x42, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x0C, 0x0F, 0x0F, 0x0F, 0x0F, 0x02, 0x44, 0x45, 0x42, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x0A, 0x0F, 0x0F, 0x0F, 0x0D, 0x06, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x05, 0x0A, 0x0C, 0x0B, 0x08, 0x03, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x30, 0x03, 0x05, 0x05, 0x02, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30},
+		{0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30}
+	}
+};
+
+/* Centroids the table was built from */
+const TCS34727_PALETTE_t TCS34727_PALETTE[] = {
+	{WHITE_DETECT, 52000, 50000, 44000, 150000},
+	{BLACK_DETECT, 2100, 2000, 1800, 6000},
+	{RED_DETECT, 30000, 8000, 8500, 45000},
+	{GREEN_DETECT, 8000, 21000, 10000, 38000},
+	{BLUE_DETECT, 6000, 10500, 18000, 34000},
+	{YELLOW_DETECT, 42000, 37000, 12000, 92000},
+	{CYAN_DETECT, 11000, 30000, 29000, 70000},
+	{PURPLE_DETECT, 17000, 8000, 15000, 40000}
+};
+const uint8_t TCS34727_PALETTE_SIZE = sizeof(TCS34727_PALETTE) / sizeof(TCS34727_PALETTE[0]);
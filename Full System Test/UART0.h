@@ -54,6 +54,12 @@ void UART0_OutCRLF(void);
 // Output: ASCII code for key typed
 unsigned char UART0_InChar(void);
 
+//------------UART0_InCharNonBlocking------------
+// Get oldest serial port input without waiting
+// Input: none
+// Output: ASCII code for key typed, 0 if nothing has arrived
+unsigned char UART0_InCharNonBlocking(void);
+
 //------------UART_OutChar------------
 // Output 8-bit to serial port
 // Input: letter is an 8-bit ASCII character to be transferred
@@ -14,6 +14,13 @@
 
 /* Local Macros */
 #define TIMER_32_MAX_RELOAD		(4294967295)	
+
+/* Crystal frequencies selected by RCC XTAL field, starting at 0x06 */
+static const uint32_t XTAL_HZ[] = {
+	4000000, 4096000, 4915200, 5000000, 5120000, 6000000, 6144000,
+	7372800, 8000000, 8192000, 10000000, 12000000, 12288000, 13560000,
+	14318180, 16000000, 16384000, 18000000, 20000000, 24000000, 25000000
+};
  
 /* The reason why Wide Timer is used instead of regular time is because
 	 of the prescaler option */
@@ -34,6 +41,14 @@ void WTIMER0_Init(void){
 	WTIMER0_TAPR_R = PRESCALER_VALUE;										//Set prescaler to get 1kHz frequency or 1ms period
 }
 
+/* The DWT cycle counter is used to timestamp bus activity since it
+	 runs at the core clock and does not tie up a hardware timer */
+void CYCCNT_Init(void){
+	DEMCR_R |= DEMCR_TRCENA;															//Power up the DWT block
+	DWT_CYCCNT_R = 0;
+	DWT_CTRL_R |= DWT_CYCCNTENA;													//Start counting core clock cycles
+}
+
 void DELAY_1MS(uint32_t delay){
 	WTIMER0_TAILR_R = delay - 1;
 	WTIMER0_CTL_R |= WTIMER0_TAEN_BIT;
@@ -41,6 +56,61 @@ void DELAY_1MS(uint32_t delay){
 	WTIMER0_CTL_R &= ~(WTIMER0_TAEN_BIT);
 }
 
+/* Decodes RCC/RCC2 so clock dependent setup (I2C speed, timeouts)
+	 follows whatever clock the project is configured for */
+uint32_t SYSCLK_Get_Hz(void){
+	uint32_t rcc = SYSCTL_RCC_R;
+	uint32_t rcc2 = SYSCTL_RCC2_R;
+	uint32_t osc, src_hz, div, xtal;
+	uint8_t bypass;
+	
+	/* RCC2 overrides the source, bypass, and divider fields of RCC */
+	if(rcc2 & SYSCTL_RCC2_USERCC2){
+		osc = rcc2 & SYSCTL_RCC2_OSCSRC2_M;
+		bypass = (rcc2 & SYSCTL_RCC2_BYPASS2) != 0;
+		div = (rcc2 & SYSCTL_RCC2_SYSDIV2_M) >> SYSCTL_RCC2_SYSDIV2_S;
+	}
+	else{
+		osc = rcc & SYSCTL_RCC_OSCSRC_M;
+		bypass = (rcc & SYSCTL_RCC_BYPASS) != 0;
+		div = (rcc & SYSCTL_RCC_SYSDIV_M) >> SYSCTL_RCC_SYSDIV_S;
+	}
+	
+	/* Oscillator feeding either the PLL or the system clock directly */
+	switch(osc){
+		case SYSCTL_RCC2_OSCSRC2_MO:
+			xtal = (rcc & SYSCTL_RCC_XTAL_M) >> XTAL_FIELD_SHIFT;
+			if(xtal >= XTAL_FIELD_MIN && (xtal - XTAL_FIELD_MIN) < sizeof(XTAL_HZ)/sizeof(XTAL_HZ[0]))
+				src_hz = XTAL_HZ[xtal - XTAL_FIELD_MIN];
+			else
+				src_hz = PIOSC_HZ;
+			break;
+		case SYSCTL_RCC2_OSCSRC2_IO4:
+			src_hz = PIOSC_HZ / 4;
+			break;
+		case SYSCTL_RCC2_OSCSRC2_30:
+			src_hz = LFIOSC_HZ;
+			break;
+		case SYSCTL_RCC2_OSCSRC2_32:
+			src_hz = HIB_OSC_HZ;
+			break;
+		default:
+			src_hz = PIOSC_HZ;
+			break;
+	}
+	
+	/* PLL bypassed: divider only applies when USESYSDIV is set */
+	if(bypass)
+		return (rcc & SYSCTL_RCC_USESYSDIV) ? src_hz / (div + 1) : src_hz;
+	
+	/* PLL runs at 400MHz, either divided directly or pre-divided by 2 */
+	if((rcc2 & SYSCTL_RCC2_USERCC2) && (rcc2 & SYSCTL_RCC2_DIV400)){
+		div = (div << 1) | ((rcc2 & SYSCTL_RCC2_SYSDIV2LSB) ? 1 : 0);
+		return PLL_HZ / (div + 1);
+	}
+	return (PLL_HZ / 2) / (div + 1);
+}
+
 int16_t map(int16_t x, int16_t x_min, int16_t x_max, int16_t out_min, int16_t out_max){
 	if(x < x_min){
 		return x_min;
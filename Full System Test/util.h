@@ -24,8 +24,43 @@
 #define WTIMER0_PERIOD_MODE		(0x02)//page 732
 #define PRESCALER_VALUE				(160000) //16M / Pre = 1Hz
 
+/* Cortex-M4 DWT Cycle Counter (Not in tm4c123gh6pm.h)
+	 The host build (I2C_SIM) keeps time in the simulated bus instead */
+#ifndef I2C_SIM
+#define DEMCR_R								(*((volatile uint32_t *)0xE000EDFC))
+#define DWT_CTRL_R						(*((volatile uint32_t *)0xE0001000))
+#define DWT_CYCCNT_R					(*((volatile uint32_t *)0xE0001004))
+#else
+extern volatile uint32_t I2CSim_Dwt[2];
+uint32_t I2CSim_Cycles(void);
+#define DEMCR_R								I2CSim_Dwt[0]
+#define DWT_CTRL_R						I2CSim_Dwt[1]
+#endif
+#define DEMCR_TRCENA					(0x01000000) //Enable DWT block
+#define DWT_CYCCNTENA					(0x00000001) //Start cycle counter
+
+/* System Clock Decoding */
+#define PIOSC_HZ							(16000000)
+#define PLL_HZ								(400000000)
+#define LFIOSC_HZ							(30000)
+#define HIB_OSC_HZ						(32768)
+#define XTAL_FIELD_MIN				(0x06)	//RCC XTAL field value for 4MHz
+#define XTAL_FIELD_SHIFT			(6)
+
 void WTIMER0_Init(void);
+void CYCCNT_Init(void);
+uint32_t SYSCLK_Get_Hz(void);
 void DELAY_1MS(uint32_t);
 int16_t map(int16_t, int16_t, int16_t, int16_t, int16_t);
 
+/* Free running core clock cycle count, wraps every 2^32 cycles.
+	 Differences of two reads are valid across the wrap */
+static inline uint32_t CYCCNT_Get(void){
+	#ifndef I2C_SIM
+	return DWT_CYCCNT_R;
+	#else
+	return I2CSim_Cycles();
+	#endif
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,2423 @@
+/*
+ * i2c_sim_run.c
+ *
+ *	Host run of the sensor and display drivers on the simulated I2C
+ *	bus (I2CSim.h). TCS34727.c, MPU6050.c and LCD.c are built
+ *	unchanged with I2C_SIM defined, the board's parts are replaced by
+ *	the models of I2CSimDev.h, and the program goes through the same
+ *	bring-up as I2CMain.c: module init, scan, driver init. It then
+ *	checks that what the drivers read is what the models measure and
+ *	that the display shows what was printed, and times each driver
+ *	call in simulated bus time and in host time.
+ *
+ *	The color sensor then plays a recorded sequence of scenes twice:
+ *	sampled every integration with Read_RGBC_Next, and in threshold
+ *	mode where only the INT line (PE0) wakes the loop. Both report
+ *	the changes they saw and the bus load it took. Automatic exposure
+ *	is driven with brightness steps and ramps, reporting how many
+ *	readings and how long it takes to get back into its band. The
+ *	fixed-point color normalization is compared with the float one
+ *	over the RAW / C_RAW range and both are timed on the host. Parts of
+ *	every palette color go in front of the sensor at varying brightness
+ *	to measure how often the palette classifier gets them right. Lux
+ *	and CCT are compared with the float formulas over every clear count.
+ *	A sensor with drifted channel responses is calibrated from five
+ *	references, classified before and after, and the calibration is
+ *	stored to and loaded from the simulated EEPROM. The color sample
+ *	filters are checked against a plain mean and median, then run on a
+ *	noisy stream with glints to report their noise reduction, spike
+ *	rejection, settling and cost per sample.
+ *
+ *	The bus driver is taken through its failure paths with a part that
+ *	NACKs on command: every NACK has to end the transfer with exactly
+ *	one STOP and leave no command behind for an idle bus, and a part
+ *	stretching SCL past the deadline has to time out, get the bus
+ *	recovered and leave it usable. The interrupt driven engine gets the
+ *	same NACKs in each of its states and has to complete every transfer
+ *	with one STOP, and refuses a segment list set up as a read. A
+ *	register block staged into one buffer and the same block sent as
+ *	segments are compared in bytes copied, wire bytes, simulated time
+ *	and host time to prepare them. Color reads go through the queue
+ *	at sensor priority while display frames keep I2C0 saturated, and
+ *	their latency has to stay under one frame plus the read itself. A
+ *	read the sensor stretches past its deadline has to time out and
+ *	recover the bus for the next one. I2C_SetSpeed is checked
+ *	against a search of every TPR value at the usual core clocks and
+ *	SCL rates, and the throughput of a 16 byte read is measured at
+ *	100 kHz, 400 kHz and 1 MHz. A slave stuck mid-byte holds SDA for
+ *	1 to 30 SCL pulses: the transfer has to recover and go through
+ *	when the retries allow it, each recovery is timed against its
+ *	pulses and STOP, and the slave and interrupt setup of the module
+ *	has to survive the reset. A read on I2C0 and a write on the LCD
+ *	bus are started together and have to finish intact in the time of
+ *	the longer one. A part stretching SCL puts 4 byte reads in the
+ *	middle of each latency bucket of I2CStats.h, the histogram has to
+ *	count every read in its bucket. I2C_Scan runs over several sets of
+ *	addresses on the free I2C2 at 400 kHz and 100 kHz: it has to find
+ *	each set, bind the MPU6050 and LCD descriptors to what it kept and
+ *	finish in under 10 ms at 400 kHz. I2CBench runs on I2C3 in loopback
+ *	at every rate, polled and interrupt driven, and has to come close
+ *	to the wire rate, and a host reads the I2CSlave map back through
+ *	the loopback of I2C2. The bus calls of the full system
+ *	loop (see -l) run with the register cache of I2CCache.h and with it
+ *	emptied before every MPU6050_Process call, and the transactions it
+ *	saves per loop are reported.
+ *
+ *	With -l it then runs the bus calls of Test_Full_System (ModuleTest.c)
+ *	for a number of iterations and accounts the wire time of every
+ *	call: SCL clocks split into STARTs, repeated STARTs, STOPs and
+ *	bytes (8 bits + ACK), and the microseconds they take at the SCL
+ *	rate of the bus. Each iteration gets a line, then a per function
+ *	summary follows, so two versions of a driver can be compared by
+ *	the numbers.
+ *
+ *	Build and run from the repository root:
+ *		cc -std=gnu11 -O2 -DI2C_SIM -I"Full System Test" -o i2c_sim_run tools/i2c_sim_run.c \
+ *			"Full System Test"/{I2CSim,I2CSimDev,I2C,I2CAsync,I2CBench,I2CCache,I2CScan,I2CSlave,I2CStats,I2CTrace,SoftI2C,TCS34727,TCS34727LUT,TCS34727Filter,MPU6050,LCD}.c -lm
+ *		./i2c_sim_run
+ *
+ *	Options: -n <calls> per benchmark (default 1000), -q to hide the
+ *	driver console output, -l <iterations> of the full system loop,
+ *	-s <Hz> / -d <Hz> SCL rate of the sensor bus (I2C0) / display bus
+ *	instead of the rate the devices allow, -r <file> to also report
+ *	the filters on recorded samples: the CSV lines of the 'c' console
+ *	command (color,R,G,B,C,exposure,...), one color held per run of
+ *	lines. Exit status is the number of failed checks
+ *
+ *	Simulated cycles are 80MHz core cycles. Register accesses cost a
+ *	fixed I2C_SIM_REG_CYCLES, so the CPU side is indicative, the wire
+ *	time follows MTPR exactly
+ *
+ * Created on: October 17th, 2026
+ *
+ */
+
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "EEPROM.h"
+#include "I2C.h"
+#include "I2CAsync.h"
+#include "I2CBench.h"
+#include "I2CCache.h"
+#include "I2CScan.h"
+#include "I2CStats.h"
+#include "I2CSim.h"
+#include "I2CSimDev.h"
+#include "I2CSlave.h"
+#include "TCS34727.h"
+#include "TCS34727Filter.h"
+#include "MPU6050.h"
+#include "LCD.h"
+#include "ModuleTest.h"
+
+#define RUN_CALLS_DEFAULT   1000
+#define RUN_MPU_ADDR        MPU6050_ADDR_AD0_HIGH   // Alternate strapping, the scan has to find it
+#define RUN_LCD_ADDR        0x27                    // PCF8574 rather than the default PCF8574A
+#define RUN_TCS_SAMPLES     50                      // Back to back Read_RGBC_Next calls
+#define RUN_TCS_PERS        TCS34727_PERS_3         // Threshold mode persistence
+#define RUN_TCS_PERS_CYCLES 3
+#define RUN_AE_READINGS     4                       // Readings auto exposure may take to settle
+#define RUN_AE_RAMP_PCT     90                      // Readings in band during a ramp
+#define RUN_NORM_FULL_C     2048                    // Clear counts checked against every RAW below them
+#define RUN_NORM_STRIDE     97                      // RAW step for the clear counts above
+#define RUN_NORM_SAMPLES    4096                    // Random RGBC sets timed and classified
+#define RUN_NORM_REPS       200                     // Passes over them per path
+#define RUN_CLASS_SAMPLES   40                      // Parts of each palette color put in front
+#define RUN_CLASS_NOISE_PCT 4                       // Channel to channel spread of one reading
+#define RUN_CLASS_PCT       95                      // Parts the classifier has to get right
+#define RUN_CLASS_REPS      100000                  // Classifications timed
+#define RUN_LUX_COUNTS      0.25                    // Lux error allowed, in counts of G''
+#define RUN_LUX_PCT         0.01                    // or in percent, whichever is more
+#define RUN_CCT_K           1.0                     // CCT error allowed in K, the division truncates
+#define RUN_CAL_C_GAIN      0.85                    // Clear response of the drifted sensor
+#define RUN_CAL_WHITE_PCT   1.0                     // Corrected white off its centroid, per channel
+#define RUN_CAL_REPS        100000                  // Corrections timed
+#define RUN_FILT_ATIME      0xF0                    // 16 steps at 4x, RAW is a quarter of NORM
+#define RUN_FILT_HOLD       200                     // Samples each color is held in front
+#define RUN_FILT_SETTLE     48                      // Samples after a change left out of the steady numbers, EMA 1/8 included
+#define RUN_FILT_NOISE_PCT  2.0                     // Sample to sample noise, sigma in percent
+#define RUN_FILT_READ_NOISE 2.0                     // plus sigma in counts
+#define RUN_FILT_SPIKE_PCT  3                       // Samples with a glint on one channel
+#define RUN_FILT_EXACT      20000                   // Random samples checked against a plain mean / median
+#define RUN_FILT_REPS       200                     // Passes over the stream timed per filter
+#define RUN_FILT_RECORD_MAX 100000                  // Lines read from a -r file
+#define RUN_SPARE_ADDR      0x50                    // Free address on I2C0 for the test part
+#define RUN_NEVER           0xFFFFFFFFUL            // Test part ACKs every byte
+#define RUN_ASYNC_LIMIT     (I2C_SIM_SYSCLK_HZ / 1000)  // An interrupt driven transfer not done by then hangs
+#define RUN_QUEUE_READS     200                     // Sensor reads while display frames saturate I2C0
+#define RUN_QUEUE_SLACK_US  10                      // Interrupt and register time on top of the wire time
+#define RUN_QUEUE_BUSY_PCT  90                      // Bus share the display frames must take to count as saturated
+#define RUN_SPEED_XFERS     50                      // 16 byte reads timed per SCL rate
+#define RUN_SPEED_BYTES     16
+#define RUN_SPEED_PCT       95                      // Throughput against the wire limit of the read
+#define RUN_RECOVER_SLACK_US 5                     // Register time on top of the recovery pulses and STOP
+#define RUN_OVERLAP_ROUNDS  20                      // Transfers started on I2C0 and the LCD bus together
+#define RUN_OVERLAP_BYTES   16
+#define RUN_OVERLAP_SLACK_US 10                     // Interrupt and register time per round
+#define RUN_HIST_XFERS      10                      // Reads per injected delay
+#define RUN_CACHE_LOOPS     20                      // Full system iterations run with and without the register cache
+#define RUN_SEG_WRITES      200                     // Register block writes timed per path and size
+#define RUN_SEG_PREPS       1000000                 // Preparations timed per path and size on the host
+#define RUN_SCAN_BUS        I2C_BUS2                // Free module the address sets are put on
+#define RUN_SCAN_MODULE     2
+#define RUN_SCAN_MS         10                      // Longest scan allowed at 400 kHz
+#define RUN_BENCH_PCT       80                      // Long burst payload rate against one byte per 9 SCL clocks
+#define LOOP_FN_MAX         16                      // Functions the loop report tells apart
+#define SIM_CYCLES_PER_US   (I2C_SIM_SYSCLK_HZ / 1000000)
+
+/* Peripheral handlers of the drivers, the simulator calls them */
+void I2C0_Handler(void);
+void I2C1_Handler(void);
+
+static I2C_SIM_TCS34727_t tcs;
+static I2C_SIM_MPU6050_t mpu;
+static I2C_SIM_LCD_t lcd;
+static int failures;
+
+static const I2C_DEVICE_t* const sensor_devices[] = {&TCS34727_DEVICE, &MPU6050_DEVICE};
+static const I2C_DEVICE_t* const lcd_devices[] = {&LCD_DEVICE};
+
+/* Parts the console should not see, and a way back to the terminal */
+static int console_fd = -1;
+
+static void quiet(int on){
+	fflush(stdout);
+	if(on){
+		console_fd = dup(STDOUT_FILENO);
+		if(freopen("/dev/null", "w", stdout) == 0)
+			exit(1);
+	}
+	else if(console_fd >= 0){
+		dup2(console_fd, STDOUT_FILENO);
+		close(console_fd);
+		console_fd = -1;
+	}
+}
+
+static void check(int ok, const char* what){
+	printf("  %-44s %s\n", what, ok ? "ok" : "FAIL");
+	if(!ok)
+		failures++;
+}
+
+static double host_ns(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* What the sensor should report for a channel at the ATIME and AGAIN the driver set */
+static uint16_t tcs_expected(uint8_t channel){
+	static const uint8_t gain[4] = {1, 4, 16, 60};
+	uint32_t steps = 256 - tcs.dev.regs[TCS34727_TIMING_R_ADDR];
+	uint32_t full = steps * SIM_TCS_FULL_SCALE;
+	uint32_t count = tcs.light[channel] * steps * gain[tcs.dev.regs[TCS34727_CTRL_R_ADDR] & 0x03];
+
+	if(full > 0xFFFF)
+		full = 0xFFFF;
+
+	return count > full ? full : count;
+}
+
+/* Wait for the LCD queue the way the main loop would, by letting time run */
+static void lcd_drain(void){
+	I2CSim_Advance((uint64_t)20 * (I2C_SIM_SYSCLK_HZ / 1000));
+}
+
+/* One benchmark row: simulated time, wire time and host time per call */
+typedef void (*bench_fn)(void);
+
+static MPU6050_ACCEL_t accel;
+static MPU6050_GYRO_t gyro;
+
+static RGB_COLOR_HANDLE_t rgbc;
+
+/* Read_RGBC_Next back to back should return every integration once and keep up with ATIME */
+static void tcs_sample_rate(void){
+	uint32_t first, prev;
+	uint64_t start;
+	int skipped = 0;
+	int i;
+	double rate;
+
+	if(TCS34727_Read_RGBC_Next(&rgbc) != I2C_OK){
+		check(0, "TCS34727 next result");
+		return;
+	}
+	first = prev = tcs.result;
+	start = I2CSim_Now();
+	for(i = 0; i < RUN_TCS_SAMPLES; i++){
+		if(TCS34727_Read_RGBC_Next(&rgbc) != I2C_OK)
+			break;
+		if(tcs.result != prev + 1)
+			skipped++;
+		prev = tcs.result;
+	}
+	check(i == RUN_TCS_SAMPLES && skipped == 0 && rgbc.C_RAW == tcs_expected(0), "TCS34727 one result per integration");
+
+	rate = RUN_TCS_SAMPLES / ((double)(I2CSim_Now() - start) / I2C_SIM_SYSCLK_HZ);
+	printf("  TCS34727 %u samples in %u cycles: %.1f Hz, integration rate %.1f Hz\n", RUN_TCS_SAMPLES,
+		prev - first, rate, 1e6 / TCS34727_Get_Integration_Us());
+}
+
+/* Recorded scenes: how long, C/R/G/B per ATIME step, and whether it is a
+   change worth a reading. Short flashes and slow drift are not */
+typedef struct{
+	uint16_t ms;
+	uint16_t light[4];
+	uint8_t change;
+} SCENE_t;
+
+static const SCENE_t scenes[] = {
+	{300, {150,  70,  45,  30}, 0},				// Empty belt, threshold mode centers on it
+	{  4, {240, 150,  50,  40}, 0},				// Flash, two integrations at most
+	{300, {150,  70,  45,  30}, 0},
+	{300, {160,  75,  48,  32}, 0},				// Lighting drift inside the band
+	{300, {230, 150,  40,  30}, 1},				// Red part
+	{300, { 30,  10,  10,  10}, 1},				// Sensor covered
+	{300, {150,  70,  45,  30}, 1},				// Empty belt again
+};
+#define SCENE_COUNT (sizeof(scenes)/sizeof(scenes[0]))
+
+void GPIOPortE_Handler(void);
+
+static unsigned scene_ms(void){
+	unsigned ms = 0;
+	uint8_t i;
+
+	for(i = 0; i < SCENE_COUNT; i++)
+		ms += scenes[i].ms;
+
+	return ms;
+}
+
+/* Plays the scenes, reading either every integration or on the INT line only.
+   Returns the scenes whose readings did not match what was expected */
+static int tcs_scenes(uint8_t on_int, const char* name){
+	I2C_SIM_STATS_t before, after;
+	uint64_t start = I2CSim_Now();
+	uint64_t scene_at, end, latency = 0;
+	uint32_t period = TCS34727_Get_Integration_Us() * (I2C_SIM_SYSCLK_HZ / 1000000);
+	uint32_t reads = 0;
+	uint16_t ref;
+	uint16_t band;
+	uint8_t out = 0;
+	int changes, wrong = 0;
+	uint8_t i;
+
+	I2CSim_Get_Stats(0, &before);
+	TCS34727_Read_RGBC(&rgbc);
+	ref = rgbc.C_RAW;
+	for(i = 0; i < SCENE_COUNT; i++){
+		memcpy(tcs.light, scenes[i].light, sizeof(tcs.light));
+		scene_at = I2CSim_Now();
+		end = scene_at + (uint64_t)scenes[i].ms * (I2C_SIM_SYSCLK_HZ / 1000);
+		changes = 0;
+		while(I2CSim_Now() < end){
+			if(on_int){
+				/* The loop sleeps until the port interrupt */
+				if(!TCS34727_Changed()){
+					I2C_SPIN();
+					continue;
+				}
+				TCS34727_Read_Change(&rgbc);
+				reads++;
+			}
+			else{
+				/* Same band and persistence as threshold mode, in software */
+				if(TCS34727_Read_RGBC_Next(&rgbc) != I2C_OK)
+					continue;
+				reads++;
+				band = ref * TCS34727_THRESH_BAND_PCT / 100;
+				out = (rgbc.C_RAW + band >= ref && rgbc.C_RAW <= ref + band) ? 0 : out + 1;
+				if(out < RUN_TCS_PERS_CYCLES)
+					continue;
+				out = 0;
+				ref = rgbc.C_RAW;
+			}
+			if(changes++ == 0 && I2CSim_Now() - scene_at > latency)
+				latency = I2CSim_Now() - scene_at;
+		}
+		if((changes != 0) != scenes[i].change || changes > 1)
+			wrong++;
+	}
+	I2CSim_Get_Stats(0, &after);
+
+	printf("  %-22s %6u reads %7u transactions %8.1f wire us/s, slowest change %.1f ms\n", name, reads,
+		after.transactions - before.transactions,
+		(double)(after.busy_cycles - before.busy_cycles) / ((double)(I2CSim_Now() - start) / I2C_SIM_SYSCLK_HZ) / (I2C_SIM_SYSCLK_HZ / 1000000),
+		(double)latency / (I2C_SIM_SYSCLK_HZ / 1000));
+
+	/* The change has to persist, then the next integration raises INT */
+	if(on_int && latency > (uint64_t)(RUN_TCS_PERS_CYCLES + 1) * period)
+		wrong++;
+
+	return wrong;
+}
+
+/* Brightness steps for automatic exposure, clear counts per ATIME step at 1x */
+static const uint16_t ae_levels[] = {150, 2, 600, 20, 1, 800, 150};
+#define AE_LEVEL_COUNT (sizeof(ae_levels)/sizeof(ae_levels[0]))
+
+static int ae_in_band(uint16_t clear){
+	uint32_t full = (256 - tcs.dev.regs[TCS34727_TIMING_R_ADDR]) * TCS34727_FULL_SCALE_STEP;
+
+	if(full > 0xFFFF)
+		full = 0xFFFF;
+
+	return clear >= TCS34727_AE_MIN_COUNT && clear <= full * TCS34727_AE_MAX_PCT / 100;
+}
+
+/* Each step: readings and time until a reading is in band, and the
+   normalized clear count once settled. Returns the steps that did not
+   converge within RUN_AE_READINGS or normalized wrong */
+static int tcs_auto_exposure(void){
+	uint64_t start;
+	int readings, settled, wrong = 0;
+	uint32_t in_band, total;
+	uint8_t i;
+
+	printf("  TCS34727 auto exposure   light  readings      ms  steps  gain  rate Hz  C_NORM\n");
+	for(i = 0; i < AE_LEVEL_COUNT; i++){
+		tcs.light[0] = ae_levels[i];
+		start = I2CSim_Now();
+		settled = 0;
+		for(readings = 1; readings <= RUN_AE_READINGS; readings++){
+			if(TCS34727_Read_RGBC_Auto(&rgbc) != I2C_OK)
+				break;
+			if(ae_in_band(rgbc.C_RAW)){
+				settled = 1;
+				break;
+			}
+		}
+		printf("  %24s %6u %9d %7.1f %6u %5lu %8.1f %7lu\n", "", ae_levels[i], readings,
+			(double)(I2CSim_Now() - start) / (I2C_SIM_SYSCLK_HZ / 1000),
+			256 - tcs.dev.regs[TCS34727_TIMING_R_ADDR], (unsigned long)(TCS34727_Get_Exposure() / (256 - tcs.dev.regs[TCS34727_TIMING_R_ADDR])),
+			1e6 / TCS34727_Get_Integration_Us(), (unsigned long)rgbc.C_NORM);
+		if(!settled || rgbc.C_NORM != (uint32_t)ae_levels[i] * TCS34727_NORM_STEPS)
+			wrong++;
+	}
+
+	/* Exponential ramp up and back down, 1 to 800 counts per step and back over 2 s */
+	in_band = total = 0;
+	start = I2CSim_Now();
+	while(I2CSim_Now() - start < (uint64_t)2 * I2C_SIM_SYSCLK_HZ){
+		double t = (double)(I2CSim_Now() - start) / I2C_SIM_SYSCLK_HZ;
+		tcs.light[0] = (uint16_t)(pow(800.0, t < 1.0 ? t : 2.0 - t) + 0.5);
+		if(TCS34727_Read_RGBC_Auto(&rgbc) != I2C_OK)
+			break;
+		total++;
+		in_band += ae_in_band(rgbc.C_RAW);
+	}
+	printf("  TCS34727 ramp 1-800-1 in 2 s: %lu readings, %.1f%% in band\n", (unsigned long)total, 100.0 * in_band / total);
+	if(in_band * 100 < total * RUN_AE_RAMP_PCT)
+		wrong++;
+
+	return wrong;
+}
+
+/* Detect_Color as it was, on the float channels */
+static COLOR_DETECTED detect_float(const RGB_COLOR_HANDLE_t* c){
+	if(c->R > c->G && c->R > c->B && c->R_RAW > MIN_RAW_VALUE)
+		return RED_DETECT;
+	if(c->G > c->R && c->G > c->B && c->G_RAW > MIN_RAW_VALUE)
+		return GREEN_DETECT;
+	if(c->B > c->R && c->B > c->G && c->B_RAW > MIN_RAW_VALUE)
+		return BLUE_DETECT;
+	return NOTHING_DETECT;
+}
+
+/* Fixed-point channel minus the float one truncated, 255 above full scale */
+static int norm_diff(float value, uint8_t fixed){
+	return fixed - (value >= 255.0f ? 255 : (int)value);
+}
+
+/* GET_RGB_Fixed against GET_RGB: every RAW under the low clear counts,
+   a stride through the rest, then random sets for Detect_Color and the
+   time per call. Returns the channels outside -1..0 and the colors
+   that differ from the float comparison */
+static int tcs_normalize(void){
+	static RGB_COLOR_HANDLE_t samples[RUN_NORM_SAMPLES];
+	RGB_COLOR_HANDLE_t c = {0};
+	uint64_t pairs = 0, below = 0;
+	uint32_t raw, clear, i, rep;
+	int wrong = 0, diff;
+	double t0, float_ns, fixed_ns;
+
+	for(clear = 1; clear <= 0xFFFF; clear++){
+		uint32_t step = clear <= RUN_NORM_FULL_C ? 1 : RUN_NORM_STRIDE;
+		c.C_RAW = clear;
+		for(raw = 0; raw <= clear; raw += step){
+			c.R_RAW = raw;
+			TCS34727_GET_RGB(&c);
+			TCS34727_GET_RGB_Fixed(&c);
+			diff = norm_diff(c.R, c.R_INT);
+			pairs++;
+			if(diff == -1)
+				below++;
+			else if(diff != 0)
+				wrong++;
+		}
+	}
+
+	srand(21);
+	for(i = 0; i < RUN_NORM_SAMPLES; i++){
+		samples[i].C_RAW = rand() % 0x10000;
+		samples[i].R_RAW = rand() % (samples[i].C_RAW + 1);
+		samples[i].G_RAW = rand() % (samples[i].C_RAW + 1);
+		samples[i].B_RAW = (i % 16 == 0) ? samples[i].R_RAW : rand() % (samples[i].C_RAW + 1);	// Some ties
+		TCS34727_GET_RGB(&samples[i]);
+		TCS34727_GET_RGB_Fixed(&samples[i]);
+		if(Detect_Color(&samples[i]) != detect_float(&samples[i]))
+			wrong++;
+		diff = norm_diff(samples[i].G, samples[i].G_INT);
+		if(diff != 0 && diff != -1)
+			wrong++;
+	}
+
+	t0 = host_ns();
+	for(rep = 0; rep < RUN_NORM_REPS; rep++)
+		for(i = 0; i < RUN_NORM_SAMPLES; i++)
+			TCS34727_GET_RGB(&samples[i]);
+	float_ns = (host_ns() - t0) / ((double)RUN_NORM_REPS * RUN_NORM_SAMPLES);
+	t0 = host_ns();
+	for(rep = 0; rep < RUN_NORM_REPS; rep++)
+		for(i = 0; i < RUN_NORM_SAMPLES; i++)
+			TCS34727_GET_RGB_Fixed(&samples[i]);
+	fixed_ns = (host_ns() - t0) / ((double)RUN_NORM_REPS * RUN_NORM_SAMPLES);
+
+	printf("  TCS34727 normalize: %llu RAW/C_RAW pairs, %.2f%% one below float, %d out of tolerance\n",
+		(unsigned long long)pairs, 100.0 * below / pairs, wrong);
+	printf("  TCS34727 normalize host ns/call: float %.1f, fixed %.1f\n", float_ns, fixed_ns);
+
+	return wrong;
+}
+
+static const char* const color_names[] = {"RED", "GREEN", "BLUE", "NA", "YELLOW", "CYAN", "PURPLE", "WHITE", "BLACK"};
+#define COLOR_COUNT (sizeof(color_names)/sizeof(color_names[0]))
+
+/* Uniform in lo..hi */
+static double run_uniform(double lo, double hi){
+	return lo + (hi - lo) * rand() / RAND_MAX;
+}
+
+/* Parts of every palette color at 0.7x - 1.4x the centroid brightness with
+   channel noise, each read with automatic exposure and classified. Prints
+   the misreads and the time per classification. Returns 1 below RUN_CLASS_PCT */
+static int tcs_classify(void){
+	static const double channel_noise = RUN_CLASS_NOISE_PCT / 100.0;
+	uint32_t confusion[COLOR_COUNT][COLOR_COUNT] = {{0}};
+	uint32_t right = 0, total = 0, i, n;
+	volatile COLOR_DETECTED sink;
+	uint8_t p, ch, confidence;
+	COLOR_DETECTED color;
+	double t0, ns;
+
+	srand(22);
+	for(p = 0; p < TCS34727_PALETTE_SIZE; p++){
+		const TCS34727_PALETTE_t* part = &TCS34727_PALETTE[p];
+		const uint32_t norm[4] = {part->C_NORM, part->R_NORM, part->G_NORM, part->B_NORM};
+
+		for(n = 0; n < RUN_CLASS_SAMPLES; n++){
+			double scale = exp(run_uniform(log(0.7), log(1.4)));
+			for(ch = 0; ch < 4; ch++){
+				double light = norm[ch] * scale * (1.0 + run_uniform(-channel_noise, channel_noise)) / TCS34727_NORM_STEPS;
+				tcs.light[ch] = light > 0xFFFF ? 0xFFFF : (uint16_t)(light + 0.5);
+			}
+			for(i = 0; i < RUN_AE_READINGS; i++)
+				TCS34727_Read_RGBC_Auto(&rgbc);
+			color = TCS34727_Classify(&rgbc, &confidence);
+			if(confidence < TCS34727_CONF_MIN)
+				color = NOTHING_DETECT;
+			confusion[part->color][color]++;
+			right += (color == part->color);
+			total++;
+		}
+	}
+
+	printf("  TCS34727 palette: %lu of %lu parts right (%.1f%%)\n", (unsigned long)right, (unsigned long)total, 100.0 * right / total);
+	for(p = 0; p < COLOR_COUNT; p++)
+		for(ch = 0; ch < COLOR_COUNT; ch++)
+			if(p != ch && confusion[p][ch])
+				printf("  %24s %s read as %s: %lu\n", "", color_names[p], color_names[ch], (unsigned long)confusion[p][ch]);
+
+	t0 = host_ns();
+	for(i = 0; i < RUN_CLASS_REPS; i++){
+		rgbc.R_RAW = i & 0xFFF;
+		sink = TCS34727_Classify(&rgbc, &confidence);
+	}
+	ns = (host_ns() - t0) / RUN_CLASS_REPS;
+	(void)sink;
+	printf("  TCS34727 classify host ns/call: %.1f\n", ns);
+
+	return right * 100 < total * RUN_CLASS_PCT;
+}
+
+/* Channel crosstalk and gain of the drifted sensor, rows R, G, B */
+static const double cal_drift[3][3] = {{0.75, 0.08, 0.0}, {0.05, 1.10, 0.05}, {0.0, 0.10, 1.30}};
+
+/* Puts a palette part in front of the drifted sensor, brightness scaled and channel noise added */
+static void cal_drifted_part(const TCS34727_PALETTE_t* part, double scale, double noise){
+	const double rgb[3] = {part->R_NORM, part->G_NORM, part->B_NORM};
+	double light[4];
+	uint8_t ch;
+
+	light[0] = part->C_NORM * RUN_CAL_C_GAIN;
+	for(ch = 0; ch < 3; ch++)
+		light[ch + 1] = cal_drift[ch][0] * rgb[0] + cal_drift[ch][1] * rgb[1] + cal_drift[ch][2] * rgb[2];
+	for(ch = 0; ch < 4; ch++){
+		double v = light[ch] * scale * (1.0 + run_uniform(-noise, noise)) / TCS34727_NORM_STEPS;
+		tcs.light[ch] = v > 0xFFFF ? 0xFFFF : (uint16_t)(v + 0.5);
+	}
+}
+
+/* Classifier accuracy in percent on drifted parts of every palette color */
+static double cal_accuracy(void){
+	uint32_t right = 0, total = 0, i, n;
+	uint8_t p, confidence;
+	COLOR_DETECTED color;
+
+	srand(24);
+	for(p = 0; p < TCS34727_PALETTE_SIZE; p++){
+		for(n = 0; n < RUN_CLASS_SAMPLES; n++){
+			cal_drifted_part(&TCS34727_PALETTE[p], exp(run_uniform(log(0.7), log(1.4))), RUN_CLASS_NOISE_PCT / 100.0);
+			for(i = 0; i < RUN_AE_READINGS; i++)
+				TCS34727_Read_RGBC_Auto(&rgbc);
+			color = TCS34727_Classify(&rgbc, &confidence);
+			right += (confidence >= TCS34727_CONF_MIN && color == TCS34727_PALETTE[p].color);
+			total++;
+		}
+	}
+	return 100.0 * right / total;
+}
+
+/* Calibrates the drifted sensor the way ModuleTest.c does: BLACK, WHITE,
+   RED, GREEN, BLUE captured, fitted and applied. Checks the classifier
+   gets back to RUN_CLASS_PCT, that white lands on its centroid, that
+   black and white alone fit a diagonal and that the calibration comes
+   back from the EEPROM. Returns the number of failed checks */
+static int tcs_calibrate(void){
+	static const COLOR_DETECTED order[] = {BLACK_DETECT, WHITE_DETECT, RED_DETECT, GREEN_DETECT, BLUE_DETECT};
+	const uint8_t steps = sizeof(order) / sizeof(order[0]);
+	TCS34727_PALETTE_t refs[sizeof(order) / sizeof(order[0])];
+	const TCS34727_PALETTE_t* white = 0;
+	TCS34727_CAL_t cal, diag;
+	double before, after, err, worst = 0, t0, ns;
+	volatile uint16_t sink;
+	uint8_t i, p;
+	uint32_t n;
+	int wrong = 0;
+
+	TCS34727_Set_Cal(0);
+	EEPROM_Init();
+	wrong += TCS34727_Cal_Load() != 0;						// Blank EEPROM has no calibration
+	before = cal_accuracy();
+
+	for(i = 0; i < steps; i++){
+		for(p = 0; TCS34727_PALETTE[p].color != order[i]; p++)
+			;
+		cal_drifted_part(&TCS34727_PALETTE[p], 1.0, 0);
+		if(TCS34727_Cal_Capture(order[i], &refs[i]) != I2C_OK)
+			return wrong + 1;
+		if(order[i] == WHITE_DETECT)
+			white = &TCS34727_PALETTE[p];
+	}
+
+	wrong += !TCS34727_Cal_Fit(refs, 2, &diag);
+	wrong += diag.M[0][1] != 0 || diag.M[1][0] != 0 || diag.M[2][1] != 0;
+	wrong += TCS34727_Cal_Fit(&refs[1], steps - 1, &cal) != 0;	// Black is needed
+	if(!TCS34727_Cal_Fit(refs, steps, &cal))
+		return wrong + 1;
+	TCS34727_Set_Cal(&cal);
+	after = cal_accuracy();
+
+	/* Corrected white, back at the common scale */
+	cal_drifted_part(white, 1.0, 0);
+	for(i = 0; i < RUN_AE_READINGS; i++)
+		TCS34727_Read_RGBC_Auto(&rgbc);
+	TCS34727_Correct(&rgbc);
+	{
+		const double got[4] = {rgbc.R_CAL, rgbc.G_CAL, rgbc.B_CAL, rgbc.C_CAL};
+		const double want[4] = {white->R_NORM, white->G_NORM, white->B_NORM, white->C_NORM};
+		for(i = 0; i < 4; i++){
+			err = fabs(got[i] * TCS34727_NORM_STEPS / TCS34727_Get_Exposure() - want[i]) * 100 / want[i];
+			if(err > worst)
+				worst = err;
+		}
+	}
+	wrong += worst > RUN_CAL_WHITE_PCT;
+
+	t0 = host_ns();
+	for(n = 0; n < RUN_CAL_REPS; n++){
+		rgbc.R_RAW = n & 0xFFF;
+		TCS34727_Correct(&rgbc);
+		sink = rgbc.R_CAL;
+	}
+	ns = (host_ns() - t0) / RUN_CAL_REPS;
+	(void)sink;
+
+	/* Through the EEPROM and back */
+	wrong += TCS34727_Cal_Save() != EEPROM_OK;
+	TCS34727_Set_Cal(0);
+	wrong += TCS34727_Cal_Load() != 1 || TCS34727_Get_Cal() == 0 || memcmp(TCS34727_Get_Cal(), &cal, sizeof(cal)) != 0;
+
+	printf("  TCS34727 calibration: drifted sensor %.1f%% right, calibrated %.1f%%, white within %.2f%%\n", before, after, worst);
+	printf("  %24s M = [%d %d %d; %d %d %d; %d %d %d] / 4096, C gain %u / 4096\n", "",
+		cal.M[0][0], cal.M[0][1], cal.M[0][2], cal.M[1][0], cal.M[1][1], cal.M[1][2], cal.M[2][0], cal.M[2][1], cal.M[2][2], cal.C_GAIN);
+	printf("  TCS34727 correct host ns/call: %.1f\n", ns);
+
+	TCS34727_Set_Cal(0);
+	return wrong + (after < RUN_CLASS_PCT);
+}
+
+/* Filters compared, NONE first as the baseline */
+typedef struct{
+	TCS34727_FILTER_TYPE_t type;
+	uint8_t n;
+	const char* name;
+} FILTER_CASE_t;
+
+static const FILTER_CASE_t filter_cases[] = {
+	{TCS34727_FILTER_NONE, 1, "none"},
+	{TCS34727_FILTER_AVG, 3, "avg 3"}, {TCS34727_FILTER_AVG, 5, "avg 5"}, {TCS34727_FILTER_AVG, 9, "avg 9"},
+	{TCS34727_FILTER_EMA, 2, "ema 1/4"}, {TCS34727_FILTER_EMA, 3, "ema 1/8"},
+	{TCS34727_FILTER_MEDIAN, 3, "median 3"}, {TCS34727_FILTER_MEDIAN, 5, "median 5"}, {TCS34727_FILTER_MEDIAN, 9, "median 9"}};
+#define FILTER_CASES (sizeof(filter_cases) / sizeof(filter_cases[0]))
+
+/* Standard normal */
+static double run_gauss(void){
+	double u = run_uniform(1e-12, 1.0);
+	return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * run_uniform(0, 1.0));
+}
+
+static int cmp_u16(const void* a, const void* b){
+	return (int)*(const uint16_t*)a - (int)*(const uint16_t*)b;
+}
+
+/* Mean and median of every window against TCS34727_Filter_Update on a
+   random stream, with repeats and full scale values. Returns mismatches */
+static int filter_exact(void){
+	static uint16_t history[RUN_FILT_EXACT][TCS34727_FILTER_CHANNELS];
+	TCS34727_FILTER_t filter;
+	uint16_t window[TCS34727_FILTER_MAX_N];
+	uint32_t i, k, sum;
+	uint8_t n, ch, size;
+	int wrong = 0;
+
+	srand(25);
+	for(i = 0; i < RUN_FILT_EXACT; i++)
+		for(ch = 0; ch < TCS34727_FILTER_CHANNELS; ch++)
+			history[i][ch] = (rand() & 7) == 0 ? 0xFFFF : (rand() & 1) ? rand() % 16 : rand() & 0xFFFF;
+
+	for(n = 1; n <= TCS34727_FILTER_MAX_N; n++){
+		for(k = 0; k < 2; k++){
+			TCS34727_FILTER_TYPE_t type = k ? TCS34727_FILTER_MEDIAN : TCS34727_FILTER_AVG;
+			if(!TCS34727_Filter_Init(&filter, type, n))
+				return wrong + 1;
+			for(i = 0; i < RUN_FILT_EXACT; i++){
+				rgbc.R_RAW = history[i][0];
+				rgbc.G_RAW = history[i][1];
+				rgbc.B_RAW = history[i][2];
+				rgbc.C_RAW = history[i][3];
+				TCS34727_Filter_Update(&filter, &rgbc);
+
+				size = i + 1 < n ? i + 1 : n;
+				for(ch = 0; ch < TCS34727_FILTER_CHANNELS; ch++){
+					const uint16_t got = ch == 0 ? rgbc.R_RAW : ch == 1 ? rgbc.G_RAW : ch == 2 ? rgbc.B_RAW : rgbc.C_RAW;
+					uint8_t j;
+					for(j = 0, sum = 0; j < size; j++){
+						window[j] = history[i + 1 - size + j][ch];
+						sum += window[j];
+					}
+					qsort(window, size, sizeof(window[0]), cmp_u16);
+					wrong += got != (type == TCS34727_FILTER_AVG ? (sum + size / 2) / size : window[size / 2]);
+				}
+			}
+		}
+	}
+
+	/* Out of range windows are refused */
+	wrong += TCS34727_Filter_Init(&filter, TCS34727_FILTER_MEDIAN, TCS34727_FILTER_MAX_N + 1) != 0;
+	wrong += TCS34727_Filter_Init(&filter, TCS34727_FILTER_EMA, TCS34727_FILTER_EMA_MAX_SHIFT + 1) != 0;
+	wrong += TCS34727_Filter_Init(&filter, TCS34727_FILTER_AVG, 0) != 0;
+	return wrong;
+}
+
+/* Noisy stream: palette colors held RUN_FILT_HOLD samples each at
+   varying brightness, Gaussian noise on every channel and glints on a
+   few samples. Per filter reports, away from the color changes, the
+   RMS and worst error against the true counts and how often the
+   classifier is right, the samples it takes after a change until the
+   class is right, and the host time per sample. Returns 1 if median 5
+   does not cut the worst error or avg 9 the RMS error of no filter */
+static int tcs_filter(void){
+	static const uint8_t order[] = {7, 2, 0, 5, 1, 3, 6, 4, 2, 7};	// Palette entries shown, in turn
+	enum{ SAMPLES = sizeof(order) * RUN_FILT_HOLD };
+	static uint16_t truth[SAMPLES][TCS34727_FILTER_CHANNELS];
+	static uint16_t noisy[SAMPLES][TCS34727_FILTER_CHANNELS];
+	static COLOR_DETECTED label[SAMPLES];
+	double rms[FILTER_CASES], worst[FILTER_CASES], right[FILTER_CASES], settle[FILTER_CASES], ns[FILTER_CASES];
+	TCS34727_FILTER_t filter;
+	uint32_t i, steady, changes, rep;
+	uint8_t f, ch, confidence, settled;
+	double scale = 1.0, err, t0;
+	volatile uint16_t sink;
+	int exact;
+
+	exact = filter_exact();
+	printf("  TCS34727 filters: avg and median of 1-%u against a plain mean and median, %d mismatches\n", TCS34727_FILTER_MAX_N, exact);
+
+	if(TCS34727_Set_Exposure(RUN_FILT_ATIME, TCS34727_CTRL_AGAIN_4X) != I2C_OK)
+		return 1;
+
+	srand(26);
+	for(i = 0; i < SAMPLES; i++){
+		const TCS34727_PALETTE_t* part = &TCS34727_PALETTE[order[i / RUN_FILT_HOLD]];
+		const double norm[4] = {part->R_NORM, part->G_NORM, part->B_NORM, part->C_NORM};
+		uint8_t glint = (rand() % 100) < RUN_FILT_SPIKE_PCT ? rand() % 4 : 0xFF;
+
+		if(i % RUN_FILT_HOLD == 0)
+			scale = exp(run_uniform(log(0.8), log(1.25)));
+		label[i] = part->color;
+		for(ch = 0; ch < TCS34727_FILTER_CHANNELS; ch++){
+			double v = norm[ch] * scale * TCS34727_Get_Exposure() / TCS34727_NORM_STEPS;
+			truth[i][ch] = (uint16_t)(v + 0.5);
+			v += run_gauss() * (v * RUN_FILT_NOISE_PCT / 100 + RUN_FILT_READ_NOISE);
+			if(ch == glint)
+				v *= run_uniform(1.5, 3.0);
+			noisy[i][ch] = v < 0 ? 0 : v > 0xFFFF ? 0xFFFF : (uint16_t)(v + 0.5);
+		}
+	}
+
+	for(f = 0; f < FILTER_CASES; f++){
+		if(!TCS34727_Filter_Init(&filter, filter_cases[f].type, filter_cases[f].n))
+			return 1;
+		rms[f] = worst[f] = right[f] = settle[f] = 0;
+		steady = changes = 0;
+		settled = 1;
+		for(i = 0; i < SAMPLES; i++){
+			if(i % RUN_FILT_HOLD == 0 && i != 0){
+				changes++;
+				settled = 0;
+			}
+			rgbc.R_RAW = noisy[i][0];
+			rgbc.G_RAW = noisy[i][1];
+			rgbc.B_RAW = noisy[i][2];
+			rgbc.C_RAW = noisy[i][3];
+			TCS34727_Filter_Update(&filter, &rgbc);
+			COLOR_DETECTED color = TCS34727_Classify(&rgbc, &confidence);
+			if(confidence < TCS34727_CONF_MIN)
+				color = NOTHING_DETECT;
+			if(!settled){
+				if(color == label[i])
+					settled = 1;
+				else
+					settle[f]++;
+			}
+			if(i % RUN_FILT_HOLD < RUN_FILT_SETTLE)
+				continue;
+
+			const uint16_t out[4] = {rgbc.R_RAW, rgbc.G_RAW, rgbc.B_RAW, rgbc.C_RAW};
+			for(ch = 0; ch < TCS34727_FILTER_CHANNELS; ch++){
+				err = ((double)out[ch] - truth[i][ch]) * 100 / truth[i][ch];
+				rms[f] += err * err;
+				if(fabs(err) > worst[f])
+					worst[f] = fabs(err);
+			}
+			right[f] += (color == label[i]);
+			steady++;
+		}
+		rms[f] = sqrt(rms[f] / (steady * TCS34727_FILTER_CHANNELS));
+		right[f] = 100 * right[f] / steady;
+		settle[f] /= changes;
+
+		t0 = host_ns();
+		for(rep = 0; rep < RUN_FILT_REPS; rep++){
+			for(i = 0; i < SAMPLES; i++){
+				rgbc.R_RAW = noisy[i][0];
+				rgbc.G_RAW = noisy[i][1];
+				rgbc.B_RAW = noisy[i][2];
+				rgbc.C_RAW = noisy[i][3];
+				TCS34727_Filter_Update(&filter, &rgbc);
+				sink = rgbc.R_RAW;
+			}
+		}
+		ns[f] = (host_ns() - t0) / ((double)RUN_FILT_REPS * SAMPLES);
+	}
+	(void)sink;
+
+	printf("  TCS34727 filters on %u samples, %.0f%% + %.0f counts noise, %u%% glints:\n", (unsigned)SAMPLES,
+		RUN_FILT_NOISE_PCT, RUN_FILT_READ_NOISE, RUN_FILT_SPIKE_PCT);
+	printf("  %24s %-9s %8s %8s %8s %8s %8s\n", "", "filter", "rms %", "worst %", "right %", "settle", "ns");
+	for(f = 0; f < FILTER_CASES; f++)
+		printf("  %24s %-9s %8.2f %8.1f %8.1f %8.1f %8.1f\n", "", filter_cases[f].name, rms[f], worst[f], right[f], settle[f], ns[f]);
+
+	check(TCS34727_Set_Exposure(TCS34727_ATIME_2_4_MS, TCS34727_CTRL_AGAIN_4X) == I2C_OK, "TCS34727 exposure back to init");
+	return exact != 0 || worst[7] >= worst[0] || rms[3] >= rms[0];
+}
+
+/* Filters on recorded samples, see -r. Per filter, the spread of each
+   channel (at the common scale) within the runs of one color over the
+   spread without a filter. Returns 1 if the file has no usable runs */
+static int tcs_filter_record(const char* path){
+	static uint16_t raw[RUN_FILT_RECORD_MAX][TCS34727_FILTER_CHANNELS];
+	static uint32_t exposure[RUN_FILT_RECORD_MAX];
+	static char name[RUN_FILT_RECORD_MAX][12];
+	double var[FILTER_CASES][TCS34727_FILTER_CHANNELS];
+	TCS34727_FILTER_t filter;
+	uint32_t lines = 0, runs = 0, used, i, start, end;
+	unsigned r, g, b, c;
+	unsigned long e;
+	char line[256];
+	uint8_t f, ch;
+	FILE* in = fopen(path, "r");
+
+	if(in == 0){
+		printf("  TCS34727 filters: cannot open %s\n", path);
+		return 1;
+	}
+	while(lines < RUN_FILT_RECORD_MAX && fgets(line, sizeof(line), in)){
+		if(sscanf(line, "%11[^,],%u,%u,%u,%u,%lu", name[lines], &r, &g, &b, &c, &e) != 6 || e == 0)
+			continue;
+		raw[lines][0] = r;
+		raw[lines][1] = g;
+		raw[lines][2] = b;
+		raw[lines][3] = c;
+		exposure[lines] = e;
+		lines++;
+	}
+	fclose(in);
+
+	for(f = 0; f < FILTER_CASES; f++){
+		memset(var[f], 0, sizeof(var[f]));
+		used = runs = 0;
+		for(start = 0; start < lines; start = end){
+			double sum[4] = {0}, sq[4] = {0};
+			uint32_t n = 0;
+			for(end = start + 1; end < lines && exposure[end] == exposure[start] && strcmp(name[end], name[start]) == 0; end++)
+				;
+			if(!TCS34727_Filter_Init(&filter, filter_cases[f].type, filter_cases[f].n))
+				return 1;
+			for(i = start; i < end; i++){
+				rgbc.R_RAW = raw[i][0];
+				rgbc.G_RAW = raw[i][1];
+				rgbc.B_RAW = raw[i][2];
+				rgbc.C_RAW = raw[i][3];
+				if(!TCS34727_Filter_Update(&filter, &rgbc) || i - start < TCS34727_FILTER_MAX_N)
+					continue;						// Every filter judged on the same samples
+				const uint16_t out[4] = {rgbc.R_RAW, rgbc.G_RAW, rgbc.B_RAW, rgbc.C_RAW};
+				for(ch = 0; ch < TCS34727_FILTER_CHANNELS; ch++){
+					double v = (double)out[ch] * TCS34727_NORM_STEPS / exposure[i];
+					sum[ch] += v;
+					sq[ch] += v * v;
+				}
+				n++;
+			}
+			if(n < 2)
+				continue;
+			for(ch = 0; ch < TCS34727_FILTER_CHANNELS; ch++)
+				var[f][ch] += sq[ch] - sum[ch] * sum[ch] / n;
+			used += n;
+			runs++;
+		}
+		for(ch = 0; ch < TCS34727_FILTER_CHANNELS; ch++)
+			var[f][ch] = used > 0 ? var[f][ch] / used : 0;
+	}
+
+	if(runs == 0){
+		printf("  TCS34727 filters: no runs of one color long enough in %s\n", path);
+		return 1;
+	}
+	printf("  TCS34727 filters on %s: %lu samples in %lu runs, spread over no filter (R G B C)\n", path,
+		(unsigned long)used, (unsigned long)runs);
+	for(f = 1; f < FILTER_CASES; f++){
+		printf("  %24s %-9s", "", filter_cases[f].name);
+		for(ch = 0; ch < TCS34727_FILTER_CHANNELS; ch++)
+			printf(" %6.3f", var[0][ch] > 0 ? sqrt(var[f][ch] / var[0][ch]) : 0);
+		printf("\n");
+	}
+	return 0;
+}
+
+/* ams DN40 in double, the reference for TCS34727_Get_Lux_CCT */
+static int lux_cct_float(const RGB_COLOR_HANDLE_t* c, uint8_t atime, uint8_t again, double* lux, double* cct){
+	static const double gain[4] = {1, 4, 16, 60};
+	double steps = 256 - atime;
+	double saturation = steps * TCS34727_FULL_SCALE_STEP;
+	double ir, r, g, b, gpp;
+
+	*lux = *cct = 0;
+	if(saturation > 0xFFFF)
+		saturation = 0xFFFF;
+	if(steps < TCS34727_RIPPLE_STEPS)
+		saturation = saturation - (uint32_t)saturation / 4;
+	if(c->C_RAW >= saturation)
+		return 0;
+
+	ir = ((double)c->R_RAW + c->G_RAW + c->B_RAW - c->C_RAW) / 2.0;
+	if(ir < 0)
+		ir = 0;
+	r = c->R_RAW - ir;
+	g = c->G_RAW - ir;
+	b = c->B_RAW - ir;
+	gpp = 0.136 * r + 1.000 * g - 0.444 * b;
+	if(gpp <= 0 || r <= 0)
+		return 0;
+
+	*lux = gpp * (TCS34727_LUX_GA_X100 / 100.0) * TCS34727_LUX_DF / (steps * TCS34727_ATIME_STEP_US / 1000.0 * gain[again]);
+	*cct = 3810.0 * (b > 0 ? b : 0) / r + 1391.0;
+	return 1;
+}
+
+/* TCS34727_Get_Lux_CCT against the float formulas for every C_RAW at a
+   few exposures, R, G, B random up to C_RAW and a bit over it (IR).
+   Returns the samples outside the tolerances */
+static int tcs_lux_cct(void){
+	static const uint8_t exposures[][2] = {
+		{TCS34727_ATIME_2_4_MS, TCS34727_CTRL_AGAIN_1X}, {0xC0, TCS34727_CTRL_AGAIN_16X},
+		{0x00, TCS34727_CTRL_AGAIN_4X}, {0x00, TCS34727_CTRL_AGAIN_60X}};
+	static RGB_COLOR_HANDLE_t samples[0x10000];
+	double lux, cct, per_count, err, lux_worst = 0, cct_worst = 0, t0, ns = 0;
+	uint32_t i, e, total = 0, valid = 0;
+	int wrong = 0, ok;
+
+	srand(23);
+	for(i = 0; i < 0x10000; i++){
+		uint32_t top = i + i / 8 + 1;
+		uint16_t* channel[3] = {&samples[i].R_RAW, &samples[i].G_RAW, &samples[i].B_RAW};
+		samples[i].C_RAW = i;
+		for(e = 0; e < 3; e++){
+			uint32_t v = rand() % top;
+			*channel[e] = v > 0xFFFF ? 0xFFFF : v;
+		}
+	}
+
+	for(e = 0; e < sizeof(exposures) / sizeof(exposures[0]); e++){
+		if(TCS34727_Set_Exposure(exposures[e][0], exposures[e][1]) != I2C_OK)
+			return 1;
+		/* mlux one count of G'' is worth */
+		per_count = (TCS34727_LUX_GA_X100 / 100.0) * TCS34727_LUX_DF * 1000.0 / (TCS34727_Get_Exposure() * TCS34727_ATIME_STEP_US / 1000.0);
+
+		for(i = 0; i < 0x10000; i++){
+			ok = TCS34727_Get_Lux_CCT(&samples[i]);
+			total++;
+			if(ok != lux_cct_float(&samples[i], exposures[e][0], exposures[e][1], &lux, &cct)){
+				if(lux * 1000 > RUN_LUX_COUNTS * per_count)			// Only where G'' is about 0
+					wrong++;
+				continue;
+			}
+			if(!ok)
+				continue;
+			valid++;
+
+			/* Lux in counts of G'', against the larger tolerance */
+			err = fabs(samples[i].LUX_MILLI - lux * 1000);
+			if(err > RUN_LUX_COUNTS * per_count && err > lux * 1000 * RUN_LUX_PCT / 100)
+				wrong++;
+			if(err / per_count > lux_worst)
+				lux_worst = err / per_count;
+
+			if(cct > 0xFFFF)
+				continue;
+			err = fabs(samples[i].CCT - cct);
+			if(err > RUN_CCT_K)
+				wrong++;
+			if(err > cct_worst)
+				cct_worst = err;
+		}
+
+		t0 = host_ns();
+		for(i = 0; i < 0x10000; i++)
+			TCS34727_Get_Lux_CCT(&samples[i]);
+		ns += (host_ns() - t0) / 0x10000;
+	}
+
+	printf("  TCS34727 lux/CCT: %lu samples, %lu valid, worst lux %.2f counts, worst CCT %.1f K, %d out of tolerance\n",
+		(unsigned long)total, (unsigned long)valid, lux_worst, cct_worst, wrong);
+	printf("  TCS34727 lux/CCT host ns/call: %.1f\n", ns / (sizeof(exposures) / sizeof(exposures[0])));
+
+	return wrong;
+}
+
+static void call_tcs_red(void){ TCS34727_GET_RAW_RED(); }
+static void call_tcs_channels(void){
+	rgbc.R_RAW = TCS34727_GET_RAW_RED();
+	rgbc.G_RAW = TCS34727_GET_RAW_GREEN();
+	rgbc.B_RAW = TCS34727_GET_RAW_BLUE();
+	rgbc.C_RAW = TCS34727_GET_RAW_CLEAR();
+}
+static void call_tcs_rgbc(void){ TCS34727_Read_RGBC(&rgbc); }
+static void call_tcs_next(void){ TCS34727_Read_RGBC_Next(&rgbc); }
+static void call_mpu_accel(void){ MPU6050_Get_Accel(&accel); }
+static void call_mpu_gyro(void){ MPU6050_Get_Gyro(&gyro); }
+static void call_lcd_char(void){ LCD_Print_Char('x'); }
+
+static void bench(const char* name, uint8_t module, bench_fn fn, int calls){
+
+	I2C_SIM_STATS_t before, after;
+	uint64_t start;
+	double t0, t1;
+	int i;
+
+	I2CSim_Get_Stats(module, &before);
+	start = I2CSim_Now();
+	t0 = host_ns();
+	for(i = 0; i < calls; i++)
+		fn();
+	if(module == 1)
+		lcd_drain();
+	t1 = host_ns();
+	I2CSim_Get_Stats(module, &after);
+
+	printf("  %-24s %10.1f %10.1f %8.2f %10.0f\n", name,
+		(double)(I2CSim_Now() - start) / calls / (I2C_SIM_SYSCLK_HZ / 1000000),
+		(double)(after.busy_cycles - before.busy_cycles) / calls / (I2C_SIM_SYSCLK_HZ / 1000000),
+		(double)(after.bytes - before.bytes) / calls,
+		(t1 - t0) / calls);
+}
+
+/* ------------------------------------------------------------------ */
+/* Bus driver paths                                                    */
+/* ------------------------------------------------------------------ */
+
+/* A plain register file that can be told to NACK: the byte written
+   after nack_after bytes of a write, or the address of a read */
+typedef struct{
+	I2C_SIM_DEV_t dev;
+	uint32_t nack_after;
+	uint32_t written;
+	uint8_t nack_read;
+} RUN_DEV_t;
+
+static RUN_DEV_t spare;
+
+static uint8_t spare_start(I2C_SIM_DEV_t* dev, uint8_t read){
+	RUN_DEV_t* part = (RUN_DEV_t*)dev;
+
+	if(read && part->nack_read)
+		return 0;
+	if(!read)
+		part->written = 0;
+
+	return I2CSim_Regfile_Start(dev, read);
+}
+
+static uint8_t spare_write(I2C_SIM_DEV_t* dev, uint8_t byte){
+	RUN_DEV_t* part = (RUN_DEV_t*)dev;
+
+	if(part->written++ >= part->nack_after)
+		return 0;
+
+	return I2CSim_Regfile_Write(dev, byte);
+}
+
+static void spare_init(RUN_DEV_t* part, uint8_t addr){
+	I2CSim_Regfile_Init(&part->dev, "spare", addr);
+	part->dev.start = spare_start;
+	part->dev.write = spare_write;
+	part->nack_after = RUN_NEVER;
+	part->written = 0;
+	part->nack_read = 0;
+}
+
+/* One failing transfer on I2C0: the status it returned, the STOPs that
+   went out and whether the driver wrote a command with nothing to act
+   on. Returns 1 if any of it is off */
+static int nack_case(const char* name, uint8_t status, uint8_t expect, const I2C_SIM_STATS_t* before){
+	I2C_SIM_STATS_t after;
+	int wrong;
+
+	I2CSim_Get_Stats(0, &after);
+	wrong = status != expect || after.stops - before->stops != 1 || after.idle_cmds != before->idle_cmds
+		|| (I2C_MCS(I2C_BUS0) & I2C_MCS_BUSBSY);
+	printf("  %-30s status 0x%02X, %u STOP, %u idle command(s)%s\n", name, status,
+		after.stops - before->stops, after.idle_cmds - before->idle_cmds, wrong ? "  <-" : "");
+
+	spare.nack_after = RUN_NEVER;
+	spare.nack_read = 0;
+
+	return wrong;
+}
+
+/* NACKs on every kind of MCS command: the transfer ends with exactly one
+   STOP whether the failed command carried it or the driver added it.
+   Then a part that stretches SCL past the deadline: every attempt times
+   out, the bus is recovered each time, and the next transfer works */
+static int bus_error_paths(void){
+	static const uint8_t out[4] = {0x11, 0x22, 0x33, 0x44};
+	const I2C_SEG_t segs[2] = {{out, 1}, {out + 1, 2}};
+	I2C_BUS_STATS_t faults = I2C_BUS0->stats;
+	I2C_SIM_STATS_t before;
+	uint8_t in[4];
+	uint64_t start;
+	int wrong = 0;
+
+	spare_init(&spare, RUN_SPARE_ADDR);
+	I2CSim_Attach(0, &spare.dev);
+
+	spare.nack_after = 0;
+	I2CSim_Get_Stats(0, &before);
+	wrong += nack_case("register byte NACKed", I2C_Burst_Transmit(I2C_BUS0, RUN_SPARE_ADDR, 0, (uint8_t*)out, 4),
+		I2C_MCS_ERROR|I2C_MCS_DATACK, &before);
+	spare.nack_after = 2;
+	I2CSim_Get_Stats(0, &before);
+	wrong += nack_case("write NACKed mid burst", I2C_Burst_Transmit(I2C_BUS0, RUN_SPARE_ADDR, 0, (uint8_t*)out, 4),
+		I2C_MCS_ERROR|I2C_MCS_DATACK, &before);
+	spare.nack_after = 4;
+	I2CSim_Get_Stats(0, &before);
+	wrong += nack_case("write NACKed on RUN|STOP", I2C_Burst_Transmit(I2C_BUS0, RUN_SPARE_ADDR, 0, (uint8_t*)out, 4),
+		I2C_MCS_ERROR|I2C_MCS_DATACK, &before);
+	spare.nack_after = 2;
+	I2CSim_Get_Stats(0, &before);
+	wrong += nack_case("segments NACKed on the last", I2C_Write_Segments(I2C_BUS0, RUN_SPARE_ADDR, segs, 2),
+		I2C_MCS_ERROR|I2C_MCS_DATACK, &before);
+	spare.nack_read = 1;
+	I2CSim_Get_Stats(0, &before);
+	wrong += nack_case("read address NACKed, 4 bytes", I2C_Burst_Receive(I2C_BUS0, RUN_SPARE_ADDR, 0, in, 4),
+		I2C_MCS_ERROR|I2C_MCS_ADRACK, &before);
+	spare.nack_read = 1;
+	I2CSim_Get_Stats(0, &before);
+	wrong += nack_case("read address NACKed, 1 byte", I2C_Burst_Receive(I2C_BUS0, RUN_SPARE_ADDR, 0, in, 1),
+		I2C_MCS_ERROR|I2C_MCS_ADRACK, &before);
+
+	/* Stretching past the deadline */
+	spare.dev.stretch_cycles = 4 * I2C_BUS0->timeout_cycles;
+	start = I2CSim_Now();
+	if(I2C_Burst_Receive(I2C_BUS0, RUN_SPARE_ADDR, 0, in, 2) != I2C_ERR_TIMEOUT)
+		wrong++;
+	printf("  %-30s %u timeouts, %u recoveries, %u retries in %.1f ms\n", "SCL held past the deadline",
+		I2C_BUS0->stats.timeouts - faults.timeouts, I2C_BUS0->stats.recoveries - faults.recoveries,
+		I2C_BUS0->stats.retries - faults.retries, (double)(I2CSim_Now() - start) / (I2C_SIM_SYSCLK_HZ / 1000));
+	if(I2C_BUS0->stats.timeouts - faults.timeouts != I2C_BUS0->retry_limit + 1u
+		|| I2C_BUS0->stats.recoveries - faults.recoveries != I2C_BUS0->retry_limit + 1u)
+		wrong++;
+	spare.dev.stretch_cycles = 0;
+
+	/* The bus is usable afterwards */
+	if(I2C_Burst_Transmit(I2C_BUS0, RUN_SPARE_ADDR, 0, (uint8_t*)out, 4) != I2C_OK
+		|| I2C_Burst_Receive(I2C_BUS0, RUN_SPARE_ADDR, 0, in, 4) != I2C_OK || memcmp(in, out, 4) != 0)
+		wrong++;
+
+	I2CSim_Detach(0, &spare.dev);
+	return wrong;
+}
+
+/* Interrupt driven transfers that end in every engine state, with and
+   without a NACK there. Commands that carry STOP are not followed by an
+   interrupt once they fail, the engine has to finish right away */
+typedef struct{
+	const char* name;
+	I2C_XFER_DIR dir;
+	uint8_t addr;
+	uint32_t size;											// 0 for a one byte segment write
+	uint32_t nack_after;
+	uint8_t nack_read;
+	uint8_t status;
+} ASYNC_CASE_t;
+
+static const ASYNC_CASE_t async_cases[] = {
+	{"write, 4 bytes",           I2C_XFER_WRITE, RUN_SPARE_ADDR,     4, RUN_NEVER, 0, I2C_OK},
+	{"read, 4 bytes",            I2C_XFER_READ,  RUN_SPARE_ADDR,     4, RUN_NEVER, 0, I2C_OK},
+	{"read, 1 byte",             I2C_XFER_READ,  RUN_SPARE_ADDR,     1, RUN_NEVER, 0, I2C_OK},
+	{"one byte segment",         I2C_XFER_WRITE, RUN_SPARE_ADDR,     0, RUN_NEVER, 0, I2C_OK},
+	{"NACK in XFER_REG",         I2C_XFER_WRITE, RUN_SPARE_ADDR,     4, 0,         0, I2C_MCS_ERROR|I2C_MCS_DATACK},
+	{"NACK in XFER_TX",          I2C_XFER_WRITE, RUN_SPARE_ADDR,     4, 2,         0, I2C_MCS_ERROR|I2C_MCS_DATACK},
+	{"NACK in XFER_TX_LAST",     I2C_XFER_WRITE, RUN_SPARE_ADDR,     4, 4,         0, I2C_MCS_ERROR|I2C_MCS_DATACK},
+	{"NACK in XFER_RX",          I2C_XFER_READ,  RUN_SPARE_ADDR,     4, RUN_NEVER, 1, I2C_MCS_ERROR|I2C_MCS_ADRACK},
+	{"NACK in XFER_RX_LAST",     I2C_XFER_READ,  RUN_SPARE_ADDR,     1, RUN_NEVER, 1, I2C_MCS_ERROR|I2C_MCS_ADRACK},
+	{"segment data NACKed",      I2C_XFER_WRITE, RUN_SPARE_ADDR,     0, 0,         0, I2C_MCS_ERROR|I2C_MCS_DATACK},
+	{"segment address NACKed",   I2C_XFER_WRITE, RUN_SPARE_ADDR + 1, 0, RUN_NEVER, 0, I2C_MCS_ERROR|I2C_MCS_ADRACK},
+};
+#define ASYNC_CASE_COUNT (sizeof(async_cases)/sizeof(async_cases[0]))
+
+/* Submits a transfer on I2C0 and lets time run until it is done or
+   RUN_ASYNC_LIMIT passed. One that hangs is ended the way polled code
+   would, through Acquire's deadline. Returns 1 if it completed */
+static int async_run(I2C_XFER_t* xfer){
+	uint64_t deadline = I2CSim_Now() + RUN_ASYNC_LIMIT;
+
+	if(I2C_Async_Submit(I2C_BUS0, xfer) != I2C_OK)
+		return 0;
+	while(!xfer->done && I2CSim_Now() < deadline)
+		I2C_SPIN();
+	if(xfer->done)
+		return 1;
+
+	I2C_Async_Acquire(I2C_BUS0);
+	I2C_Async_Release(I2C_BUS0);
+	return 0;
+}
+
+static int async_states(void){
+	static uint8_t data[4] = {0x5A, 0xA5, 0x3C, 0xC3};
+	static uint8_t byte = 0x77;
+	const I2C_SEG_t seg = {&byte, 1};
+	const ASYNC_CASE_t* c;
+	I2C_SIM_STATS_t before, after;
+	I2C_XFER_t xfer;
+	uint64_t start;
+	int completed, wrong = 0;
+	uint8_t i;
+
+	spare_init(&spare, RUN_SPARE_ADDR);
+	I2CSim_Attach(0, &spare.dev);
+
+	for(i = 0; i < ASYNC_CASE_COUNT; i++){
+		c = &async_cases[i];
+		spare.nack_after = c->nack_after;
+		spare.nack_read = c->nack_read;
+
+		memset(&xfer, 0, sizeof(xfer));
+		xfer.slave_addr = c->addr;
+		xfer.dir = c->dir;
+		if(c->size == 0){
+			xfer.segs = &seg;
+			xfer.seg_count = 1;
+		}
+		else{
+			xfer.data = data;
+			xfer.size = c->size;
+		}
+
+		I2CSim_Get_Stats(0, &before);
+		start = I2CSim_Now();
+		completed = async_run(&xfer);
+		I2CSim_Get_Stats(0, &after);
+
+		printf("  %-30s status 0x%02X, %u STOP, %u idle command(s), %6.1f us%s\n", c->name, xfer.status,
+			after.stops - before.stops, after.idle_cmds - before.idle_cmds,
+			(double)(I2CSim_Now() - start) / SIM_CYCLES_PER_US, completed ? "" : "  <- hung");
+		if(!completed || xfer.status != c->status || after.stops - before.stops != 1 || after.idle_cmds != before.idle_cmds)
+			wrong++;
+	}
+
+	/* A segment list can only be written */
+	memset(&xfer, 0, sizeof(xfer));
+	xfer.slave_addr = RUN_SPARE_ADDR;
+	xfer.dir = I2C_XFER_READ;
+	xfer.segs = &seg;
+	xfer.seg_count = 1;
+	printf("  %-30s submit 0x%02X, queue 0x%02X\n", "segment read", I2C_Async_Submit(I2C_BUS0, &xfer),
+		I2C_Queue_Submit(I2C_BUS0, &xfer, I2C_PRIO_SENSOR));
+	if(I2C_Async_Submit(I2C_BUS0, &xfer) != I2C_ERR_PARAM || I2C_Queue_Submit(I2C_BUS0, &xfer, I2C_PRIO_SENSOR) != I2C_ERR_PARAM)
+		wrong++;
+
+	I2CSim_Detach(0, &spare.dev);
+	return wrong;
+}
+
+/* A register block written from a header and a payload kept apart:
+   staged into one buffer for I2C_Burst_Transmit, the way callers had
+   to before, and sent as segments by I2C_Write_Segments. Both have to
+   put the same bytes on the wire and in the part, the segments without
+   copying any. Simulated time only charges register accesses, so the
+   cost of the copy is timed on the host, preparing a write without
+   sending it. Returns the sizes that are off */
+static const uint8_t seg_sizes[] = {4, 16, 64};
+#define SEG_SIZE_COUNT (sizeof(seg_sizes)/sizeof(seg_sizes[0]))
+#define SEG_SIZE_MAX    64
+#define SEG_HEADER      2
+
+static uint8_t seg_header[SEG_HEADER] = {0xC0, 0x01};
+static uint8_t seg_payload[SEG_SIZE_MAX];
+static uint8_t seg_staged[SEG_HEADER + SEG_SIZE_MAX];
+static uint8_t seg_reg = 0x10;
+static I2C_SEG_t seg_list[3];
+
+/* What a caller does before sending, returns the bytes copied */
+static uint32_t seg_prepare(uint8_t path, uint8_t n){
+	if(path == 0){
+		memcpy(seg_staged, seg_header, SEG_HEADER);
+		memcpy(&seg_staged[SEG_HEADER], seg_payload, n);
+		return SEG_HEADER + n;
+	}
+
+	seg_list[0].data = &seg_reg;
+	seg_list[0].len = 1;
+	seg_list[1].data = seg_header;
+	seg_list[1].len = SEG_HEADER;
+	seg_list[2].data = seg_payload;
+	seg_list[2].len = n;
+	return 0;
+}
+
+static int seg_vs_copy(void){
+	static const char* const paths[] = {"copy", "segments"};
+	static volatile uint32_t sink;
+	I2C_SIM_STATS_t before, after;
+	uint64_t start, sim[2], wire[2];
+	double prep;
+	uint32_t copied, i;
+	uint8_t k, path, n, status;
+	int wrong = 0, bad;
+
+	spare_init(&spare, RUN_SPARE_ADDR);
+	I2CSim_Attach(0, &spare.dev);
+	for(i = 0; i < SEG_SIZE_MAX; i++)
+		seg_payload[i] = (uint8_t)(0x80 + i);
+
+	printf("  %5s %-9s %14s %12s %12s %12s\n", "bytes", "path", "copied/write", "wire bytes", "sim us", "prepare ns");
+	for(k = 0; k < SEG_SIZE_COUNT; k++){
+		n = seg_sizes[k];
+		for(path = 0; path < 2; path++){
+			memset(spare.dev.regs, 0, sizeof(spare.dev.regs));
+			copied = 0;
+			bad = 0;
+			I2CSim_Get_Stats(0, &before);
+			start = I2CSim_Now();
+			for(i = 0; i < RUN_SEG_WRITES; i++){
+				seg_payload[0] = (uint8_t)i;
+				copied += seg_prepare(path, n);
+				if(path == 0)
+					status = I2C_Burst_Transmit(I2C_BUS0, RUN_SPARE_ADDR, seg_reg, seg_staged, SEG_HEADER + n);
+				else
+					status = I2C_Write_Segments(I2C_BUS0, RUN_SPARE_ADDR, seg_list, 3);
+				if(status != I2C_OK)
+					bad++;
+			}
+			sim[path] = I2CSim_Now() - start;
+			I2CSim_Get_Stats(0, &after);
+			wire[path] = after.bytes - before.bytes;
+			if(memcmp(&spare.dev.regs[seg_reg], seg_header, SEG_HEADER) != 0
+				|| memcmp(&spare.dev.regs[seg_reg + SEG_HEADER], seg_payload, n) != 0)
+				bad++;
+
+			prep = host_ns();
+			for(i = 0; i < RUN_SEG_PREPS; i++){
+				seg_payload[1] = (uint8_t)i;
+				sink += seg_prepare(path, n) + seg_staged[n];
+			}
+			prep = (host_ns() - prep) / RUN_SEG_PREPS;
+
+			printf("  %5u %-9s %14.1f %12.1f %12.1f %12.2f%s\n", n, paths[path], (double)copied / RUN_SEG_WRITES,
+				(double)wire[path] / RUN_SEG_WRITES, (double)sim[path] / RUN_SEG_WRITES / SIM_CYCLES_PER_US, prep, bad ? "  <-" : "");
+			wrong += bad != 0;
+		}
+		if(wire[0] != wire[1] || sim[1] > sim[0])
+			wrong++;
+	}
+
+	I2CSim_Detach(0, &spare.dev);
+	return wrong;
+}
+
+/* LCD frames that keep I2C0 busy: each one queues itself again at
+   display priority as soon as it went out, the pool stays queued */
+static I2C_XFER_t sat_frames[LCD_FRAME_POOL_SIZE];
+static I2C_SEG_t sat_seg;
+static uint8_t sat_bytes[LCD_FRAME_SIZE];
+static uint8_t sat_on;
+static uint32_t sat_sent;
+
+static void sat_resubmit(I2C_XFER_t* xfer){
+	sat_sent++;
+	if(sat_on)
+		I2C_Queue_Submit(I2C_BUS0, xfer, I2C_PRIO_DISPLAY);
+}
+
+/* Wire cycles of a transaction on I2C0: START and address, bytes, a
+   repeated START and address if it reads, STOP */
+static uint64_t wire_cycles(uint32_t bytes, uint8_t read){
+	uint64_t bit = 2 * I2C_SCL_LP_HP * (uint64_t)((I2C_MTPR(I2C_BUS0) & I2C_MTPR_TPR_M) + 1);
+
+	return bit * (1 + I2C_BITS_PER_BYTE + bytes * I2C_BITS_PER_BYTE + (read ? 1 + I2C_BITS_PER_BYTE : 0) + 1);
+}
+
+/* TCS34727_Read_RGBC while LCD frames saturate its bus. At sensor
+   priority a read waits for the frame on the bus at most, so its
+   latency is bounded by one frame plus its own transfer. The same read
+   queued at display priority is timed for comparison, it waits for
+   the whole pool. A read stuck past its deadline has to end with a
+   timeout and leave the bus recovered. Returns the checks that failed */
+static int queue_latency(void){
+	uint64_t frame = wire_cycles(LCD_FRAME_SIZE, 0);
+	uint64_t read = wire_cycles(1 + TCS34727_RGBC_BYTES, 1);
+	uint64_t bound = frame + read + RUN_QUEUE_SLACK_US * SIM_CYCLES_PER_US;
+	uint64_t at, lat, lat_max = 0, lat_total = 0, disp_max = 0, start, end;
+	I2C_SIM_STATS_t before, after;
+	I2C_QUEUE_STATS_t queue;
+	I2C_BUS_STATS_t faults;
+	I2C_XFER_t xfer;
+	uint8_t buf[TCS34727_RGBC_BYTES];
+	uint8_t status;
+	int wrong = 0, bad_reads = 0;
+	uint32_t i;
+
+	spare_init(&spare, RUN_SPARE_ADDR);
+	I2CSim_Attach(0, &spare.dev);
+	sat_seg.data = sat_bytes;
+	sat_seg.len = LCD_FRAME_SIZE;
+	sat_on = 1;
+	sat_sent = 0;
+	for(i = 0; i < LCD_FRAME_POOL_SIZE; i++){
+		memset(&sat_frames[i], 0, sizeof(sat_frames[i]));
+		sat_frames[i].slave_addr = RUN_SPARE_ADDR;
+		sat_frames[i].segs = &sat_seg;
+		sat_frames[i].seg_count = 1;
+		sat_frames[i].callback = sat_resubmit;
+		I2C_Queue_Submit(I2C_BUS0, &sat_frames[i], I2C_PRIO_DISPLAY);
+	}
+	I2C_Queue_Reset_Stats(I2C_BUS0);
+
+	srand(3);
+	I2CSim_Get_Stats(0, &before);
+	start = I2CSim_Now();
+	for(i = 0; i < RUN_QUEUE_READS; i++){
+		/* Land anywhere in the frame on the bus */
+		I2CSim_Advance(rand() % frame);
+		at = I2CSim_Now();
+		if(TCS34727_Read_RGBC(&rgbc) != I2C_OK || rgbc.C_RAW != tcs_expected(0))
+			bad_reads++;
+		lat = I2CSim_Now() - at;
+		lat_total += lat;
+		if(lat > lat_max)
+			lat_max = lat;
+	}
+	I2CSim_Get_Stats(0, &after);
+	end = I2CSim_Now();
+	I2C_Queue_Get_Stats(I2C_BUS0, I2C_PRIO_SENSOR, &queue);
+
+	/* The same read behind the display frames */
+	for(i = 0; i < RUN_QUEUE_READS / 10; i++){
+		I2CSim_Advance(rand() % frame);
+		memset(&xfer, 0, sizeof(xfer));
+		xfer.slave_addr = TCS34727_ADDR;
+		xfer.slave_reg_addr = TCS34727_CMD|TCS34727_CMD_AUTO_INC|TCS34727_CDATAL_R_ADDR;
+		xfer.dir = I2C_XFER_READ;
+		xfer.data = buf;
+		xfer.size = sizeof(buf);
+		at = I2CSim_Now();
+		I2C_Queue_Submit(I2C_BUS0, &xfer, I2C_PRIO_DISPLAY);
+		I2C_Async_Wait(&xfer);
+		if(I2CSim_Now() - at > disp_max)
+			disp_max = I2CSim_Now() - at;
+	}
+
+	sat_on = 0;
+	while(I2C_Async_Busy(I2C_BUS0))
+		I2C_SPIN();
+	I2CSim_Detach(0, &spare.dev);
+
+	/* A read the part stretches past the deadline ends with a timeout,
+	   the bus is recovered before the queue goes on and the next read
+	   gets through */
+	faults = I2C_BUS0->stats;
+	tcs.dev.stretch_cycles = 4 * I2C_BUS0->timeout_cycles;
+	status = TCS34727_Read_RGBC(&rgbc);
+	tcs.dev.stretch_cycles = 0;
+	printf("  stuck sensor read status 0x%02X, %u recoveries\n", status, I2C_BUS0->stats.recoveries - faults.recoveries);
+	if(status != I2C_ERR_TIMEOUT || I2C_BUS0->stats.recoveries - faults.recoveries != 1
+		|| TCS34727_Read_RGBC(&rgbc) != I2C_OK || rgbc.C_RAW != tcs_expected(0) || I2C_Async_Busy(I2C_BUS0))
+		wrong++;
+
+	printf("  %u reads under %u LCD frames, bus %.1f%% busy\n", RUN_QUEUE_READS, sat_sent,
+		100.0 * (after.busy_cycles - before.busy_cycles) / (end - start));
+	printf("  sensor priority   read latency mean %6.1f us, max %6.1f us, bound %6.1f us (frame %.1f + read %.1f + %u)\n",
+		(double)lat_total / RUN_QUEUE_READS / SIM_CYCLES_PER_US, (double)lat_max / SIM_CYCLES_PER_US,
+		(double)bound / SIM_CYCLES_PER_US, (double)frame / SIM_CYCLES_PER_US, (double)read / SIM_CYCLES_PER_US, RUN_QUEUE_SLACK_US);
+	printf("  queue wait max    %6.1f us, display priority read max %6.1f us\n",
+		(double)queue.wait_max / SIM_CYCLES_PER_US, (double)disp_max / SIM_CYCLES_PER_US);
+
+	if(bad_reads != 0 || lat_max > bound || queue.wait_max > frame + RUN_QUEUE_SLACK_US * SIM_CYCLES_PER_US)
+		wrong++;
+	if((after.busy_cycles - before.busy_cycles) * 100 < (end - start) * RUN_QUEUE_BUSY_PCT)
+		wrong++;
+
+	return wrong;
+}
+
+/* Core clocks the TM4C123 is commonly run at, and SCL rates asked for */
+static const uint32_t speed_sysclks[] = {16000000, 20000000, 25000000, 40000000, 50000000, 66666666, 80000000};
+static const uint32_t speed_scls[] = {1000, 10000, 47000, 100000, 250000, 400000, 1000000, 3400000};
+#define SPEED_SYSCLK_COUNT (sizeof(speed_sysclks)/sizeof(speed_sysclks[0]))
+#define SPEED_SCL_COUNT (sizeof(speed_scls)/sizeof(speed_scls[0]))
+
+/* I2C_SetSpeed at every core clock and SCL rate against a search of
+   all TPR values: the fastest rate not above the request, 0 and MTPR
+   untouched when even TPR 127 is too fast. Then the bytes per second a
+   16 byte read moves at each standard rate on the simulated bus.
+   Returns the combinations and rates that are off */
+static int speed_table(void){
+	static const uint32_t rates[] = {I2C_SPEED_STANDARD, I2C_SPEED_FAST, I2C_SPEED_FAST_PLUS};
+	uint32_t keep = I2C_GetSpeed(I2C_BUS0);
+	uint32_t sysclk, scl, got, want, tpr, best, mtpr;
+	uint64_t start, wire, elapsed;
+	uint8_t buf[RUN_SPEED_BYTES];
+	int wrong = 0, combos = 0;
+	uint8_t i, j, k;
+
+	printf("  TPR at %u core clocks x %u SCL rates:\n  %10s", (unsigned)SPEED_SYSCLK_COUNT, (unsigned)SPEED_SCL_COUNT, "SCL \\ MHz");
+	for(i = 0; i < SPEED_SYSCLK_COUNT; i++)
+		printf(" %7.2f", speed_sysclks[i] / 1e6);
+	printf("\n");
+
+	for(j = 0; j < SPEED_SCL_COUNT; j++){
+		scl = speed_scls[j];
+		printf("  %10lu", (unsigned long)scl);
+		for(i = 0; i < SPEED_SYSCLK_COUNT; i++){
+			sysclk = speed_sysclks[i];
+			I2CSim_Set_Sysclk(sysclk);
+
+			/* Reference: lowest TPR, so the fastest rate, that is not above the request */
+			want = 0;
+			best = I2C_MTPR_TPR_M + 1;
+			for(tpr = 0; tpr <= I2C_MTPR_TPR_M; tpr++){
+				if(sysclk / (2 * I2C_SCL_LP_HP * (tpr + 1)) <= scl){
+					best = tpr;
+					want = sysclk / (2 * I2C_SCL_LP_HP * (tpr + 1));
+					break;
+				}
+			}
+
+			mtpr = I2C_MTPR(I2C_BUS0);
+			got = I2C_SetSpeed(I2C_BUS0, scl);
+			tpr = I2C_MTPR(I2C_BUS0) & I2C_MTPR_TPR_M;
+			if(got != want || (want != 0 && (tpr != best || I2C_GetSpeed(I2C_BUS0) != got))
+				|| (want == 0 && I2C_MTPR(I2C_BUS0) != mtpr)){
+				wrong++;
+				printf("  %3s", "off");
+			}
+			else if(want == 0)
+				printf(" %7s", "-");
+			else
+				printf(" %7lu", (unsigned long)tpr);
+			combos++;
+		}
+		printf("\n");
+	}
+	I2CSim_Set_Sysclk(0);
+	printf("  %d combinations, %d off\n", combos, wrong);
+
+	/* Throughput at 80 MHz */
+	spare_init(&spare, RUN_SPARE_ADDR);
+	I2CSim_Attach(0, &spare.dev);
+	printf("  %10s %8s %12s %12s %10s\n", "SCL Hz", "set Hz", "payload B/s", "wire limit", "per read us");
+	for(k = 0; k < sizeof(rates)/sizeof(rates[0]); k++){
+		got = I2C_SetSpeed(I2C_BUS0, rates[k]);
+		wire = wire_cycles(1 + RUN_SPEED_BYTES, 1);
+		start = I2CSim_Now();
+		for(i = 0; i < RUN_SPEED_XFERS; i++){
+			if(I2C_Burst_Receive(I2C_BUS0, RUN_SPARE_ADDR, 0, buf, sizeof(buf)) != I2C_OK)
+				wrong++;
+		}
+		elapsed = I2CSim_Now() - start;
+		printf("  %10lu %8lu %12.0f %12.0f %10.1f\n", (unsigned long)rates[k], (unsigned long)got,
+			(double)RUN_SPEED_XFERS * RUN_SPEED_BYTES * I2C_SIM_SYSCLK_HZ / elapsed,
+			(double)RUN_SPEED_BYTES * I2C_SIM_SYSCLK_HZ / wire,
+			(double)elapsed / RUN_SPEED_XFERS / SIM_CYCLES_PER_US);
+		if(got != rates[k] || elapsed * RUN_SPEED_PCT > wire * RUN_SPEED_XFERS * 100)
+			wrong++;
+	}
+	I2CSim_Detach(0, &spare.dev);
+	I2C_SetSpeed(I2C_BUS0, keep);
+
+	return wrong;
+}
+
+/* A slave stuck mid-byte holding SDA for a number of SCL pulses. Up to
+   nine, one recovery frees it and the retry goes through. More take a
+   recovery per retry, past what the retries allow the call times out.
+   Each recovery takes its pulses and a STOP at I2C_RECOVERY_SCL_HZ */
+static const uint8_t stuck_pulses[] = {1, 5, 9, 12, 30};
+#define STUCK_COUNT (sizeof(stuck_pulses)/sizeof(stuck_pulses[0]))
+
+static int recover_stuck(void){
+	uint64_t pulse = I2C_SIM_SYSCLK_HZ / I2C_RECOVERY_SCL_HZ;
+	uint32_t mcr, mimr, soar, simr;
+	I2C_BUS_STATS_t faults;
+	I2C_SIM_STATS_t before, after;
+	uint64_t start, bound;
+	uint32_t needed, expect_rec;
+	uint8_t in[4], status, expect;
+	int wrong = 0;
+	uint8_t i;
+
+	spare_init(&spare, RUN_SPARE_ADDR);
+	I2CSim_Attach(0, &spare.dev);
+
+	/* Slave, loopback and interrupt setup come back after the module reset */
+	mcr = I2C_MCR(I2C_BUS0);
+	mimr = I2C_MIMR(I2C_BUS0);
+	soar = I2C_SOAR(I2C_BUS0);
+	simr = I2C_SIMR(I2C_BUS0);
+	I2C_SOAR(I2C_BUS0) = 0x42;
+	I2C_SIMR(I2C_BUS0) = I2C_SIMR_DATAIM;
+	I2C_MCR(I2C_BUS0) = mcr | I2C_MCR_SFE;
+	I2C_Recover(I2C_BUS0);
+	if(I2C_SOAR(I2C_BUS0) != 0x42 || I2C_SIMR(I2C_BUS0) != I2C_SIMR_DATAIM || I2C_MIMR(I2C_BUS0) != mimr
+		|| I2C_MCR(I2C_BUS0) != (mcr | I2C_MCR_SFE) || I2C_GetSpeed(I2C_BUS0) != I2C_SPEED_FAST){
+		printf("  registers lost in the module reset\n");
+		wrong++;
+	}
+	I2C_MCR(I2C_BUS0) = mcr;
+	I2C_SOAR(I2C_BUS0) = soar;
+	I2C_SIMR(I2C_BUS0) = simr;
+
+	printf("  %6s %8s %11s %11s %12s %12s %9s\n", "pulses", "status", "recoveries", "SCL pulses", "recovery us", "bound us", "call ms");
+	for(i = 0; i < STUCK_COUNT; i++){
+		faults = I2C_BUS0->stats;
+		I2CSim_Get_Stats(0, &before);
+		I2CSim_Stick_Sda(0, stuck_pulses[i]);
+
+		start = I2CSim_Now();
+		status = I2C_Burst_Receive(I2C_BUS0, RUN_SPARE_ADDR, 0, in, sizeof(in));
+		I2CSim_Get_Stats(0, &after);
+
+		/* Nine pulses per recovery at most, one recovery per attempt */
+		needed = (stuck_pulses[i] + I2C_RECOVERY_PULSES - 1) / I2C_RECOVERY_PULSES;
+		expect = (needed <= I2C_BUS0->retry_limit) ? I2C_OK : I2C_ERR_TIMEOUT;
+		expect_rec = (expect == I2C_OK) ? needed : I2C_BUS0->retry_limit + 1u;
+		needed = stuck_pulses[i] - (needed - 1) * I2C_RECOVERY_PULSES;
+		bound = (expect == I2C_OK ? needed : I2C_RECOVERY_PULSES) * pulse + 2 * pulse + RUN_RECOVER_SLACK_US * SIM_CYCLES_PER_US;
+
+		printf("  %6u %8s %11u %11u %12.1f %12.1f %9.2f\n", stuck_pulses[i], status == I2C_OK ? "ok" : "timeout",
+			I2C_BUS0->stats.recoveries - faults.recoveries, after.gpio_clocks - before.gpio_clocks,
+			(double)I2C_BUS0->stats.recovery_cycles_last / SIM_CYCLES_PER_US, (double)bound / SIM_CYCLES_PER_US,
+			(double)(I2CSim_Now() - start) / (I2C_SIM_SYSCLK_HZ / 1000));
+
+		if(status != expect || I2C_BUS0->stats.recoveries - faults.recoveries != expect_rec
+			|| I2C_BUS0->stats.recovery_cycles_last > bound)
+			wrong++;
+		I2CSim_Stick_Sda(0, 0);
+	}
+
+	/* The bus works again */
+	if(I2C_Burst_Receive(I2C_BUS0, RUN_SPARE_ADDR, 0, in, sizeof(in)) != I2C_OK || I2C_GetSpeed(I2C_BUS0) != I2C_SPEED_FAST)
+		wrong++;
+
+	I2CSim_Detach(0, &spare.dev);
+	return wrong;
+}
+
+/* A read on I2C0 and a write on the LCD bus started together, each
+   by its own engine. The data of both has to arrive intact and a round
+   has to take as long as the longer transfer, not the two back to back.
+   Returns the rounds and checks that are off */
+static int two_bus_overlap(void){
+	static RUN_DEV_t spare1;
+	uint8_t in[RUN_OVERLAP_BYTES], out[RUN_OVERLAP_BYTES];
+	I2C_SIM_STATS_t before0, after0, before1, after1;
+	uint64_t start, busy0, busy1, busy_max, elapsed, both = 0, serial = 0, longer = 0;
+	I2C_XFER_t x0, x1;
+	int wrong = 0;
+	uint32_t round, i;
+
+	spare_init(&spare, RUN_SPARE_ADDR);
+	spare_init(&spare1, RUN_SPARE_ADDR);
+	I2CSim_Attach(0, &spare.dev);
+	I2CSim_Attach(1, &spare1.dev);
+
+	for(round = 0; round < RUN_OVERLAP_ROUNDS; round++){
+		for(i = 0; i < RUN_OVERLAP_BYTES; i++){
+			spare.dev.regs[round + i] = (uint8_t)(round * 7 + i);
+			out[i] = (uint8_t)~(round * 5 + i);
+		}
+		memset(in, 0, sizeof(in));
+
+		memset(&x0, 0, sizeof(x0));
+		x0.slave_addr = RUN_SPARE_ADDR;
+		x0.slave_reg_addr = (uint8_t)round;
+		x0.dir = I2C_XFER_READ;
+		x0.data = in;
+		x0.size = sizeof(in);
+		x1 = x0;
+		x1.dir = I2C_XFER_WRITE;
+		x1.data = out;
+
+		I2CSim_Get_Stats(0, &before0);
+		I2CSim_Get_Stats(1, &before1);
+		start = I2CSim_Now();
+		if(I2C_Async_Submit(I2C_BUS0, &x0) != I2C_OK || I2C_Async_Submit(LCD_BUS, &x1) != I2C_OK){
+			wrong++;
+			break;
+		}
+		I2C_Async_Wait(&x0);
+		I2C_Async_Wait(&x1);
+		elapsed = I2CSim_Now() - start;
+		I2CSim_Get_Stats(0, &after0);
+		I2CSim_Get_Stats(1, &after1);
+
+		busy0 = after0.busy_cycles - before0.busy_cycles;
+		busy1 = after1.busy_cycles - before1.busy_cycles;
+		busy_max = busy0 > busy1 ? busy0 : busy1;
+		both += elapsed;
+		serial += busy0 + busy1;
+		longer += busy_max;
+
+		if(x0.status != I2C_OK || x1.status != I2C_OK || memcmp(in, &spare.dev.regs[round], sizeof(in)) != 0
+			|| memcmp(out, &spare1.dev.regs[round], sizeof(out)) != 0
+			|| elapsed > busy_max + RUN_OVERLAP_SLACK_US * SIM_CYCLES_PER_US)
+			wrong++;
+	}
+
+	I2CSim_Detach(0, &spare.dev);
+	I2CSim_Detach(1, &spare1.dev);
+
+	printf("  %u rounds of a %u byte read at %lu Hz and write at %lu Hz: %.1f us per round, back to back %.1f us, longer one %.1f us\n",
+		RUN_OVERLAP_ROUNDS, RUN_OVERLAP_BYTES, (unsigned long)I2C_GetSpeed(I2C_BUS0), (unsigned long)I2C_GetSpeed(LCD_BUS),
+		(double)both / RUN_OVERLAP_ROUNDS / SIM_CYCLES_PER_US, (double)serial / RUN_OVERLAP_ROUNDS / SIM_CYCLES_PER_US,
+		(double)longer / RUN_OVERLAP_ROUNDS / SIM_CYCLES_PER_US);
+
+	return wrong;
+}
+
+/* The latency histogram of I2CStats.h against injected delays: the
+   test part stretches SCL before every byte so that a 4 byte read
+   lands in the middle of each bucket in turn, from the first one the
+   bare read does not already pass up to the open ended last one. All
+   reads of a delay have to be counted in its bucket, with their bytes.
+   Returns the buckets that are off */
+static int stats_histogram(void){
+	uint32_t timeout = I2C_BUS0->timeout_cycles;
+	uint64_t start, base, target, took;
+	uint32_t stretches;
+	I2C_SIM_STATS_t before, after;
+	I2C_DEV_STATS_t dev;
+	uint8_t in[4], slot, k, hit;
+	int wrong = 0;
+	uint32_t i;
+
+	spare_init(&spare, RUN_SPARE_ADDR);
+	I2CSim_Attach(0, &spare.dev);
+	/* Long stretches are what is measured here, not a fault */
+	I2C_BUS0->timeout_cycles = I2C_SIM_SYSCLK_HZ;
+
+	/* Bare read, and the bytes that each get a stretch */
+	I2CSim_Get_Stats(0, &before);
+	start = I2CSim_Now();
+	I2C_Burst_Receive(I2C_BUS0, RUN_SPARE_ADDR, 0, in, sizeof(in));
+	base = I2CSim_Now() - start;
+	I2CSim_Get_Stats(0, &after);
+	stretches = after.bytes - before.bytes;
+
+	printf("  %6s %12s %12s %10s %8s\n", "bucket", "below us", "injected us", "read us", "counted");
+	for(k = 1; k < I2C_STATS_BUCKETS; k++){
+		/* Middle of [2^(SHIFT+k-1), 2^(SHIFT+k)) */
+		target = (uint64_t)3 << (I2C_STATS_SHIFT + k - 2);
+		if(target <= base)
+			continue;
+
+		I2C_Stats_Reset();
+		spare.dev.stretch_cycles = (target - base) / stretches;
+		start = I2CSim_Now();
+		for(i = 0; i < RUN_HIST_XFERS; i++)
+			I2C_Burst_Receive(I2C_BUS0, RUN_SPARE_ADDR, 0, in, sizeof(in));
+		took = (I2CSim_Now() - start) / RUN_HIST_XFERS;
+
+		for(slot = 0; I2C_Stats_Get(slot, &dev); slot++){
+			if(dev.bus == 0 && dev.addr == RUN_SPARE_ADDR)
+				break;
+		}
+		hit = (slot < I2C_STATS_DEVICES && dev.bus == 0 && dev.addr == RUN_SPARE_ADDR) ? 1 : 0;
+
+		if(k == I2C_STATS_BUCKETS - 1)
+			printf("  %6u %12s", k, "-");
+		else
+			printf("  %6u %12.1f", k, (double)((uint64_t)1 << (I2C_STATS_SHIFT + k)) / SIM_CYCLES_PER_US);
+		printf(" %12.1f %10.1f %8lu\n", (double)(spare.dev.stretch_cycles * stretches) / SIM_CYCLES_PER_US,
+			(double)took / SIM_CYCLES_PER_US, hit ? (unsigned long)dev.hist[k] : 0UL);
+
+		if(!hit || dev.hist[k] != RUN_HIST_XFERS || dev.transactions != RUN_HIST_XFERS
+			|| dev.bytes != RUN_HIST_XFERS * sizeof(in) || dev.nacks != 0 || dev.timeouts != 0)
+			wrong++;
+	}
+
+	spare.dev.stretch_cycles = 0;
+	I2C_BUS0->timeout_cycles = timeout;
+	I2CSim_Detach(0, &spare.dev);
+	I2C_Stats_Reset();
+
+	return wrong;
+}
+
+/* Address sets the scan is run over: nothing, the board as strapped
+   and as shipped, the edges of the range, more parts than the device
+   table holds, and every address answering. 0 ends a set */
+static const uint8_t scan_set_empty[] = {0};
+static const uint8_t scan_set_board[] = {TCS34727_ADDR, MPU6050_ADDR_AD0_LOW, LCD_WRITE_ADDR, 0};
+static const uint8_t scan_set_alt[] = {TCS34727_ADDR, MPU6050_ADDR_AD0_HIGH, 0x27, 0};
+static const uint8_t scan_set_edges[] = {I2C_SCAN_FIRST, 0x20, 0x69, I2C_SCAN_LAST, 0};
+static const uint8_t scan_set_many[] = {0x10, 0x18, 0x20, 0x21, 0x22, 0x23, 0x29, 0x38, 0x3A, 0x3C, 0x3E,
+	0x48, 0x50, 0x58, 0x60, 0x68, 0x69, 0x70, 0};
+static const uint8_t* const scan_sets[] = {scan_set_empty, scan_set_board, scan_set_alt, scan_set_edges, scan_set_many, 0};
+static const char* const scan_set_names[] = {"empty", "board", "alt strapping", "range edges", "18 parts", "every address"};
+#define SCAN_SET_COUNT (sizeof(scan_set_names)/sizeof(scan_set_names[0]))
+#define SCAN_PARTS (I2C_SCAN_LAST - I2C_SCAN_FIRST + 1)
+
+/* Address the scan should bind a descriptor at its usual strapping
+   to, 0 if none of its addresses made it into the table */
+static uint8_t scan_expect_bind(const I2C_DEVICE_t* dev, const uint8_t* in_table){
+	uint8_t i;
+
+	if(in_table[dev->addr])
+		return dev->addr;
+	for(i = 0; i < dev->alt_count; i++){
+		if(in_table[dev->alt_addr[i]])
+			return dev->alt_addr[i];
+	}
+	return 0;
+}
+
+/* I2C_Scan of each address set on a free module at 400 kHz and 100 kHz:
+   it has to find exactly the parts there, keep as many as the device
+   table has room for, bind the MPU6050 and LCD descriptors to the first
+   of their addresses it kept, and finish in under RUN_SCAN_MS at
+   400 kHz. Returns the sets that are off */
+static int scan_timing(void){
+	static const uint32_t rates[] = {I2C_SPEED_FAST, I2C_SPEED_STANDARD};
+	static I2C_SIM_DEV_t parts[SCAN_PARTS];
+	uint8_t present[0x80], in_table[0x80];
+	I2C_DEVICE_t mpu_dev = MPU6050_DEVICE, lcd_dev = LCD_DEVICE;
+	I2C_SCAN_ENTRY_t entry;
+	char mpu_s[5], lcd_s[5];
+	uint8_t count, found, kept, room, slot, want_mpu, want_lcd, k, r, addr, bad;
+	uint64_t start, took[2];
+	int wrong = 0;
+
+	I2C_Init(RUN_SCAN_BUS);
+
+	printf("  %-14s %5s %6s %5s %8s %5s %9s %9s\n", "set", "parts", "found", "kept", "MPU6050", "LCD", "400k ms", "100k ms");
+	for(k = 0; k < SCAN_SET_COUNT; k++){
+		memset(present, 0, sizeof(present));
+		count = 0;
+		for(addr = I2C_SCAN_FIRST; addr <= I2C_SCAN_LAST; addr++){
+			if(scan_sets[k] == 0 || memchr(scan_sets[k], addr, strlen((const char*)scan_sets[k])) != 0){
+				I2CSim_Regfile_Init(&parts[count], "scan", addr);
+				I2CSim_Attach(RUN_SCAN_MODULE, &parts[count++]);
+				present[addr] = 1;
+			}
+		}
+
+		bad = 0;
+		for(r = 0; r < sizeof(rates)/sizeof(rates[0]); r++){
+			I2C_SetSpeed(RUN_SCAN_BUS, rates[r]);
+			start = I2CSim_Now();
+			found = I2C_Scan(RUN_SCAN_BUS, I2C_SCAN_FIRST, I2C_SCAN_LAST);
+			took[r] = I2CSim_Now() - start;
+
+			memset(in_table, 0, sizeof(in_table));
+			kept = 0;
+			room = I2C_SCAN_MAX;
+			for(slot = 0; I2C_Scan_Get(slot, &entry); slot++){
+				if(entry.bus != RUN_SCAN_MODULE){
+					room--;
+					continue;
+				}
+				if(!present[entry.addr])
+					bad++;
+				in_table[entry.addr] = 1;
+				kept++;
+			}
+			if(found != count || kept != (count < room ? count : room))
+				bad++;
+
+			/* From the usual strapping, as the drivers start */
+			mpu_dev.addr = MPU6050_ADDR_AD0_LOW;
+			lcd_dev.addr = LCD_WRITE_ADDR;
+			want_mpu = scan_expect_bind(&mpu_dev, in_table);
+			want_lcd = scan_expect_bind(&lcd_dev, in_table);
+			if((I2C_Scan_Bind(RUN_SCAN_BUS, &mpu_dev) == I2C_OK ? mpu_dev.addr : 0) != want_mpu
+				|| (I2C_Scan_Bind(RUN_SCAN_BUS, &lcd_dev) == I2C_OK ? lcd_dev.addr : 0) != want_lcd)
+				bad++;
+			if(rates[r] == I2C_SPEED_FAST && took[r] >= (uint64_t)RUN_SCAN_MS * (I2C_SIM_SYSCLK_HZ / 1000))
+				bad++;
+		}
+
+		snprintf(mpu_s, sizeof(mpu_s), want_mpu ? "0x%02X" : "-", want_mpu);
+		snprintf(lcd_s, sizeof(lcd_s), want_lcd ? "0x%02X" : "-", want_lcd);
+		printf("  %-14s %5u %6u %5u %8s %5s %9.2f %9.2f%s\n", scan_set_names[k], count, found, kept, mpu_s, lcd_s,
+			(double)took[0] / (I2C_SIM_SYSCLK_HZ / 1000), (double)took[1] / (I2C_SIM_SYSCLK_HZ / 1000), bad ? "  <-" : "");
+		wrong += bad != 0;
+
+		while(count > 0)
+			I2CSim_Detach(RUN_SCAN_MODULE, &parts[--count]);
+	}
+
+	/* Leave nothing of the test in the device table */
+	I2C_Scan(RUN_SCAN_BUS, I2C_SCAN_FIRST, I2C_SCAN_LAST);
+
+	return wrong;
+}
+
+/* I2CBench on I2C3 in loopback: master and own slave on every rate,
+   polled and interrupt driven, both directions. Every burst has to
+   go through and the long bursts have to come close to the wire rate.
+   The interrupt driven engine has to leave the CPU some of the time */
+static int loopback_bench(void){
+	static const uint32_t rates[] = {I2C_SPEED_STANDARD, I2C_SPEED_FAST, I2C_SPEED_FAST_PLUS};
+	static const I2C_XFER_DIR dirs[] = {I2C_XFER_WRITE, I2C_XFER_READ};
+	I2C_BENCH_RESULT_t result;
+	I2C_BENCH_MODE mode;
+	char line[128];
+	uint8_t status, r, d;
+	int wrong = 0;
+
+	I2C_Bench_Init(I2C_BENCH_BUS);
+
+	for(r = 0; r < sizeof(rates)/sizeof(rates[0]); r++){
+		for(mode = I2C_BENCH_POLLED; mode <= I2C_BENCH_IRQ; mode++){
+			for(d = 0; d < sizeof(dirs)/sizeof(dirs[0]); d++){
+				status = I2C_Bench_Run(I2C_BENCH_BUS, rates[r], mode, dirs[d], &result);
+				I2C_Bench_Format(&result, I2C_SIM_SYSCLK_HZ, line);
+				line[strcspn(line, "\r\n")] = 0;
+				if(status != I2C_OK || result.errors != 0 || result.scl_hz != rates[r]
+					|| (uint64_t)result.bytes_per_sec * 9 * 100 < (uint64_t)result.scl_hz * RUN_BENCH_PCT
+					|| (mode == I2C_BENCH_IRQ && result.cpu_pct >= 100)){
+					wrong++;
+					printf("  %s  <-\n", line);
+				}
+				else{
+					printf("  %s\n", line);
+				}
+			}
+		}
+	}
+
+	/* Module back to a plain master */
+	I2C_SCSR(I2C_BENCH_BUS) = 0;
+	I2C_SIMR(I2C_BENCH_BUS) = 0;
+	I2C_MCR(I2C_BENCH_BUS) = I2C_MCR_MFE;
+
+	return wrong;
+}
+
+/* I2CSlave on I2C2 with the module in loopback, read by its own
+   master the way a host would: the whole map, a block from the middle
+   and a read running past the end. Each read has to see the last
+   sample published */
+static int slave_map_read(void){
+	I2C_SLAVE_MAP_t sample, want, got;
+	I2C_SLAVE_STATS_t stats;
+	uint8_t tail[3];
+	int wrong = 0;
+	uint8_t i;
+
+	I2C_Slave_Init(I2C_SLAVE_BUS, I2C_SLAVE_ADDR);
+	I2C_MCR(I2C_SLAVE_BUS) |= I2C_MCR_LPBK;
+
+	memset(&sample, 0, sizeof(sample));
+	for(i = 0; i < 4; i++)
+		sample.rgbc[i] = 1000 + i;
+	for(i = 0; i < 3; i++){
+		sample.accel[i] = -100 * (i + 1);
+		sample.gyro[i] = 50 * (i + 1);
+		sample.angle[i] = 4500 - 1000 * i;
+	}
+	sample.color = RED_DETECT;
+	sample.servo = 90;
+
+	for(i = 0; i < 2; i++){
+		if(I2C_Slave_Publish(&sample) != I2C_OK)
+			wrong++;
+		want = sample;
+		want.id = I2C_SLAVE_MAP_ID;
+		want.version = I2C_SLAVE_MAP_VER;
+		want.seq = i + 1;
+
+		memset(&got, 0, sizeof(got));
+		if(I2C_Burst_Receive(I2C_SLAVE_BUS, I2C_SLAVE_ADDR, 0, (uint8_t*)&got, I2C_SLAVE_MAP_SIZE) != I2C_OK
+			|| memcmp(&got, &want, I2C_SLAVE_MAP_SIZE) != 0)
+			wrong++;
+		sample.servo++;
+	}
+
+	memset(&got, 0, sizeof(got));
+	if(I2C_Burst_Receive(I2C_SLAVE_BUS, I2C_SLAVE_ADDR, offsetof(I2C_SLAVE_MAP_t, accel), (uint8_t*)got.accel, sizeof(got.accel)) != I2C_OK
+		|| memcmp(got.accel, want.accel, sizeof(got.accel)) != 0)
+		wrong++;
+
+	if(I2C_Burst_Receive(I2C_SLAVE_BUS, I2C_SLAVE_ADDR, I2C_SLAVE_MAP_SIZE - 1, tail, sizeof(tail)) != I2C_OK
+		|| tail[0] != ((const uint8_t*)&want)[I2C_SLAVE_MAP_SIZE - 1] || tail[1] != I2C_SLAVE_FILL || tail[2] != I2C_SLAVE_FILL)
+		wrong++;
+
+	I2C_Slave_Get_Stats(&stats);
+	printf("  %lu reads, %lu bytes, %lu published\n", (unsigned long)stats.reads, (unsigned long)stats.bytes, (unsigned long)stats.published);
+	if(stats.reads != 4 || stats.bytes != 2 * I2C_SLAVE_MAP_SIZE + sizeof(got.accel) + sizeof(tail) || stats.published != 2)
+		wrong++;
+
+	I2C_SCSR(I2C_SLAVE_BUS) = 0;
+	I2C_SIMR(I2C_SLAVE_BUS) = 0;
+	I2C_MCR(I2C_SLAVE_BUS) = I2C_MCR_MFE;
+
+	return wrong;
+}
+
+/* ------------------------------------------------------------------ */
+/* Bus time of the full system loop                                    */
+/* ------------------------------------------------------------------ */
+
+/* Wire time charged to one driver function, both buses together */
+typedef struct{
+	const char* name;
+	uint32_t calls;
+	uint64_t elapsed;										// Simulated cycles from the call to its last byte
+	I2C_SIM_STATS_t wire;
+} LOOP_FN_t;
+
+static LOOP_FN_t loop_fns[LOOP_FN_MAX];
+static uint8_t loop_fn_count;
+static uint32_t loop_iterations;
+static uint8_t loop_uncached;							// Config reads go to the part, as before I2CCache
+
+static void stats_add(I2C_SIM_STATS_t* acc, const I2C_SIM_STATS_t* from, const I2C_SIM_STATS_t* to){
+	acc->transactions += to->transactions - from->transactions;
+	acc->restarts += to->restarts - from->restarts;
+	acc->stops += to->stops - from->stops;
+	acc->addr_bytes += to->addr_bytes - from->addr_bytes;
+	acc->bytes += to->bytes - from->bytes;
+	acc->nacks += to->nacks - from->nacks;
+	acc->idle_cmds += to->idle_cmds - from->idle_cmds;
+	acc->scl_clocks += to->scl_clocks - from->scl_clocks;
+	acc->busy_cycles += to->busy_cycles - from->busy_cycles;
+}
+
+static void stats_both(I2C_SIM_STATS_t* stats){
+	I2C_SIM_STATS_t zero = {0};
+	I2C_SIM_STATS_t bus;
+
+	*stats = zero;
+	I2CSim_Get_Stats(0, &bus);
+	stats_add(stats, &zero, &bus);
+	I2CSim_Get_Stats(1, &bus);
+	stats_add(stats, &zero, &bus);
+}
+
+/* Queued LCD frames go out after the call returns, they still belong to it */
+static void loop_drain(void){
+	while(I2C_Async_Busy(I2C_BUS0) || I2C_Async_Busy(LCD_BUS))
+		I2C_SPIN();
+}
+
+static void loop_account(const char* name, uint64_t at, const I2C_SIM_STATS_t* before){
+	I2C_SIM_STATS_t after;
+	LOOP_FN_t* fn;
+	uint8_t i;
+
+	for(i = 0; i < loop_fn_count && strcmp(loop_fns[i].name, name) != 0; i++);
+	if(i == LOOP_FN_MAX)
+		return;
+	if(i == loop_fn_count)
+		loop_fns[loop_fn_count++].name = name;
+
+	fn = &loop_fns[i];
+	stats_both(&after);
+	stats_add(&fn->wire, before, &after);
+	fn->elapsed += I2CSim_Now() - at;
+	fn->calls++;
+}
+
+#define TIMED(name, call) do{ \
+		I2C_SIM_STATS_t before_; \
+		uint64_t at_ = I2CSim_Now(); \
+		stats_both(&before_); \
+		call; \
+		loop_drain(); \
+		loop_account(name, at_, &before_); \
+	} while(0)
+
+/* Bus calls of Test_Full_System in ModuleTest.c, in the same order and
+	 with the same delays. The servo, LED and console steps touch no I2C
+	 and have no host build, so they are left out. Keep in step */
+static void full_system_iteration(void){
+
+	static RGB_COLOR_HANDLE_t color;
+	static TCS34727_FILTER_t filter;
+	static uint8_t filter_ready;
+	static MPU6050_ANGLE_t angle;
+	static char angle_buf[LCD_ROW_SIZE];
+	static char color_buf[LCD_ROW_SIZE];
+	uint8_t confidence;
+
+	TIMED("MPU6050_Get_Accel", MPU6050_Get_Accel(&accel));
+	TIMED("MPU6050_Get_Gyro", MPU6050_Get_Gyro(&gyro));
+	if(loop_uncached)
+		I2C_Cache_Invalidate(MPU6050_BUS, MPU6050_DEVICE.addr);
+	TIMED("MPU6050_Process_Accel", MPU6050_Process_Accel(&accel));
+	if(loop_uncached)
+		I2C_Cache_Invalidate(MPU6050_BUS, MPU6050_DEVICE.addr);
+	TIMED("MPU6050_Process_Gyro", MPU6050_Process_Gyro(&gyro));
+	MPU6050_Get_Angle(&accel, &gyro, &angle);
+
+	TIMED("TCS34727_Read_RGBC", TCS34727_Read_RGBC(&color));
+	if(!filter_ready)
+		filter_ready = TCS34727_Filter_Init(&filter, COLOR_FILTER_TYPE, COLOR_FILTER_N);
+	TCS34727_Filter_Update(&filter, &color);
+	TCS34727_GET_RGB_Fixed(&color);
+
+	snprintf(angle_buf, sizeof(angle_buf), "Angle:%0.2f", angle.ArX);
+	snprintf(color_buf, sizeof(color_buf), "Color:%s", color_names[TCS34727_Classify(&color, &confidence)]);
+
+	TIMED("LCD_Clear", LCD_Clear());
+	DELAY_1MS(2);
+	TIMED("LCD_Set_Cursor", LCD_Set_Cursor(ROW1, 0));
+	TIMED("LCD_Print_Str", LCD_Print_Str((uint8_t*)angle_buf));
+	DELAY_1MS(2);
+	TIMED("LCD_Set_Cursor", LCD_Set_Cursor(ROW2, 1));
+	TIMED("LCD_Print_Str", LCD_Print_Str((uint8_t*)color_buf));
+
+	DELAY_1MS(20);
+}
+
+static void full_system_report(uint32_t iterations){
+
+	I2C_SIM_STATS_t sensor0, sensor1, lcd0, lcd1;
+	uint64_t start;
+	uint32_t it;
+	uint8_t i;
+	LOOP_FN_t* fn;
+
+	printf("\nTest_Full_System bus time, I2C0 at %lu Hz, LCD bus at %lu Hz\n",
+		(unsigned long)I2C0_GetSpeed(), (unsigned long)I2C_GetSpeed(LCD_BUS));
+	printf("  iter   loop us   I2C0 wire us  I2C0 busy   LCD wire us\n");
+
+	for(it = 0; it < iterations; it++){
+		I2CSim_Get_Stats(0, &sensor0);
+		I2CSim_Get_Stats(1, &lcd0);
+		start = I2CSim_Now();
+		full_system_iteration();
+		I2CSim_Get_Stats(0, &sensor1);
+		I2CSim_Get_Stats(1, &lcd1);
+
+		printf("  %4lu %9.1f %14.1f %9.1f%% %13.1f\n", (unsigned long)it,
+			(double)(I2CSim_Now() - start) / SIM_CYCLES_PER_US,
+			(double)(sensor1.busy_cycles - sensor0.busy_cycles) / SIM_CYCLES_PER_US,
+			100.0 * (sensor1.busy_cycles - sensor0.busy_cycles) / (I2CSim_Now() - start),
+			(double)(lcd1.busy_cycles - lcd0.busy_cycles) / SIM_CYCLES_PER_US);
+	}
+	loop_iterations += iterations;
+
+	printf("\n  Per call                 calls/it  SCL clk  START  rSTART  STOP  bytes   wire us  call us  wire us/it\n");
+	for(i = 0; i < loop_fn_count; i++){
+		fn = &loop_fns[i];
+		printf("  %-24s %8.1f %8.1f %6.1f %7.1f %5.1f %6.1f %9.1f %8.1f %11.1f\n", fn->name,
+			(double)fn->calls / loop_iterations,
+			(double)fn->wire.scl_clocks / fn->calls,
+			(double)fn->wire.transactions / fn->calls,
+			(double)fn->wire.restarts / fn->calls,
+			(double)fn->wire.stops / fn->calls,
+			(double)fn->wire.bytes / fn->calls,
+			(double)fn->wire.busy_cycles / fn->calls / SIM_CYCLES_PER_US,
+			(double)fn->elapsed / fn->calls / SIM_CYCLES_PER_US,
+			(double)fn->wire.busy_cycles / loop_iterations / SIM_CYCLES_PER_US);
+	}
+}
+
+/* The full system loop with the register cache and with it emptied
+   before each MPU6050_Process call, which then reads ACCEL_CONFIG and
+   GYRO_CONFIG from the part on every loop as the driver did before.
+   The cache has to save exactly those two reads per loop and serve
+   them from RAM. The loop accounting is cleared again for -l.
+   Returns the checks that are off */
+static int cache_loop_compare(void){
+	static const char* const modes[] = {"cached", "uncached"};
+	I2C_SIM_STATS_t before, after, wire[2];
+	I2C_CACHE_STATS_t cache[2];
+	float ax[2], gx[2];
+	uint64_t start, elapsed[2];
+	uint32_t i;
+	uint8_t mode;
+
+	printf("\nTest_Full_System with and without the register cache, %u iterations\n", RUN_CACHE_LOOPS);
+	printf("  %-9s %13s %9s %11s %11s %8s %8s\n", "", "xfers/loop", "bytes", "wire us", "loop us", "hits", "misses");
+	for(mode = 0; mode < 2; mode++){
+		/* One loop first, so the cache state left by the other mode does not count */
+		loop_uncached = mode;
+		full_system_iteration();
+		I2C_Cache_Reset_Stats();
+		stats_both(&before);
+		start = I2CSim_Now();
+		for(i = 0; i < RUN_CACHE_LOOPS; i++)
+			full_system_iteration();
+		elapsed[mode] = I2CSim_Now() - start;
+		stats_both(&after);
+		memset(&wire[mode], 0, sizeof(wire[mode]));
+		stats_add(&wire[mode], &before, &after);
+		I2C_Cache_Get_Stats(&cache[mode]);
+		ax[mode] = accel.Ax;
+		gx[mode] = gyro.Gx;
+
+		printf("  %-9s %13.2f %9.1f %11.1f %11.1f %8.2f %8.2f\n", modes[mode],
+			(double)wire[mode].transactions / RUN_CACHE_LOOPS, (double)wire[mode].bytes / RUN_CACHE_LOOPS,
+			(double)wire[mode].busy_cycles / RUN_CACHE_LOOPS / SIM_CYCLES_PER_US,
+			(double)elapsed[mode] / RUN_CACHE_LOOPS / SIM_CYCLES_PER_US,
+			(double)cache[mode].hits / RUN_CACHE_LOOPS, (double)cache[mode].misses / RUN_CACHE_LOOPS);
+	}
+	loop_uncached = 0;
+	full_system_iteration();
+	printf("  saved %.2f transactions and %.1f wire us per loop\n",
+		(double)(wire[1].transactions - wire[0].transactions) / RUN_CACHE_LOOPS,
+		(double)(wire[1].busy_cycles - wire[0].busy_cycles) / RUN_CACHE_LOOPS / SIM_CYCLES_PER_US);
+
+	memset(loop_fns, 0, sizeof(loop_fns));
+	loop_fn_count = 0;
+	loop_iterations = 0;
+
+	return (wire[1].transactions - wire[0].transactions != 2 * RUN_CACHE_LOOPS)
+		+ (cache[0].hits != 2 * RUN_CACHE_LOOPS || cache[0].misses != 0)
+		+ (ax[0] != ax[1] || gx[0] != gx[1]);
+}
+
+int main(int argc, char** argv){
+
+	int calls = RUN_CALLS_DEFAULT;
+	int hide = 0;
+	int iterations = 0;
+	uint32_t sensor_hz = 0;
+	uint32_t lcd_hz = 0;
+	const char* record = 0;
+	int opt;
+	char row[SIM_LCD_COLS + 1];
+
+	while((opt = getopt(argc, argv, "n:ql:s:d:r:")) != -1){
+		switch(opt){
+			case 'n': calls = atoi(optarg); break;
+			case 'q': hide = 1; break;
+			case 'l': iterations = atoi(optarg); break;
+			case 's': sensor_hz = strtoul(optarg, 0, 0); break;
+			case 'd': lcd_hz = strtoul(optarg, 0, 0); break;
+			case 'r': record = optarg; break;
+			default:
+				fprintf(stderr, "usage: %s [-n calls] [-q] [-l iterations] [-s I2C0 Hz] [-d LCD bus Hz] [-r recorded.csv]\n", argv[0]);
+				return 1;
+		}
+	}
+	if(calls < 1)
+		calls = 1;
+
+	/* Parts on the board */
+	I2CSim_Reset();
+	tcs.light[0] = 400;										// C
+	tcs.light[1] = 200;										// R
+	tcs.light[2] = 120;										// G
+	tcs.light[3] = 80;										// B
+	I2CSim_TCS34727_Init(&tcs, TCS34727_ADDR);
+	I2CSim_MPU6050_Init(&mpu, RUN_MPU_ADDR);
+	mpu.accel[0] = 1000;  mpu.accel[1] = -2000;  mpu.accel[2] = 16384;
+	mpu.gyro[0] = 131;    mpu.gyro[1] = -262;    mpu.gyro[2] = 7;
+	I2CSim_LCD_Init(&lcd, RUN_LCD_ADDR);
+	I2CSim_Attach(0, &tcs.dev);
+	I2CSim_Attach(0, &mpu.dev);
+	I2CSim_Attach(1, &lcd.dev);
+
+	/* Bring-up of I2CMain.c */
+	if(hide)
+		quiet(1);
+	CYCCNT_Init();
+	I2C0_Init();
+	I2C0_Async_Init();
+	I2C0_SetSpeed_For_Devices(sensor_devices, sizeof(sensor_devices)/sizeof(sensor_devices[0]));
+	I2C_Init(LCD_BUS);
+	I2C_Async_Init(LCD_BUS);
+	I2C_SetSpeed_For_Devices(LCD_BUS, lcd_devices, sizeof(lcd_devices)/sizeof(lcd_devices[0]));
+	I2C_Scan(I2C_BUS0, I2C_SCAN_FIRST, I2C_SCAN_LAST);
+	I2C_Scan(LCD_BUS, I2C_SCAN_FIRST, I2C_SCAN_LAST);
+	TCS34727_Init();
+	MPU6050_Init();
+	LCD_Init();
+	I2C_Scan_Print();
+	if(hide)
+		quiet(0);
+
+	printf("\nChecks\n");
+	check(I2C0_GetSpeed() == I2C_SPEED_FAST, "I2C0 at 400kHz");
+	check(I2C_GetSpeed(LCD_BUS) == I2C_SPEED_STANDARD, "LCD bus at 100kHz");
+	if(sensor_hz != 0)
+		check(I2C0_SetSpeed(sensor_hz) != 0, "I2C0 at the -s rate");
+	if(lcd_hz != 0)
+		check(I2C_SetSpeed(LCD_BUS, lcd_hz) != 0, "LCD bus at the -d rate");
+	check(MPU6050_DEVICE.addr == RUN_MPU_ADDR, "MPU6050 bound to the scanned address");
+	check(LCD_DEVICE.addr == RUN_LCD_ADDR, "LCD bound to the scanned address");
+
+	check(TCS34727_GET_RAW_CLEAR() == tcs_expected(0), "TCS34727 clear");
+	check(TCS34727_GET_RAW_RED() == tcs_expected(1), "TCS34727 red");
+	check(TCS34727_GET_RAW_GREEN() == tcs_expected(2), "TCS34727 green");
+	check(TCS34727_GET_RAW_BLUE() == tcs_expected(3), "TCS34727 blue");
+	check(TCS34727_Read_RGBC(&rgbc) == I2C_OK && rgbc.C_RAW == tcs_expected(0) && rgbc.R_RAW == tcs_expected(1)
+		&& rgbc.G_RAW == tcs_expected(2) && rgbc.B_RAW == tcs_expected(3), "TCS34727 RGBC burst");
+	check(tcs.dev.regs[TCS34727_STATUS_R_ADDR] & TCS34727_STATUS_AVALID, "TCS34727 AVALID after init");
+	tcs_sample_rate();
+
+	/* Both runs start on the first scene */
+	memcpy(tcs.light, scenes[0].light, sizeof(tcs.light));
+	I2CSim_Advance((uint64_t)3 * TCS34727_Get_Integration_Us() * (I2C_SIM_SYSCLK_HZ / 1000000));
+	printf("  TCS34727 scenes, %u ms\n", scene_ms());
+	check(tcs_scenes(0, "every integration") == 0, "TCS34727 changes seen sampling");
+	tcs.int_base = TCS34727_INT_GPIO_BASE;
+	tcs.int_pin = TCS34727_INT_PIN;
+	I2CSim_Gpio_Irq(TCS34727_INT_GPIO_BASE, GPIOPortE_Handler);
+	TCS34727_INT_Init();
+	check(TCS34727_Threshold_Mode(RUN_TCS_PERS, TCS34727_THRESH_BAND_PCT) == I2C_OK, "TCS34727 threshold mode");
+	check(tcs_scenes(1, "threshold mode, INT") == 0, "TCS34727 only changes wake the loop");
+	check(TCS34727_Cycle_Mode() == I2C_OK && TCS34727_Read_RGBC_Next(&rgbc) == I2C_OK, "TCS34727 back to every integration");
+
+	check(tcs_auto_exposure() == 0, "TCS34727 auto exposure settles");
+	memcpy(tcs.light, scenes[0].light, sizeof(tcs.light));
+	check(TCS34727_Set_Exposure(TCS34727_ATIME_2_4_MS, TCS34727_CTRL_AGAIN_4X) == I2C_OK, "TCS34727 exposure back to init");
+	check(tcs_normalize() == 0, "TCS34727 fixed-point RGB within -1..0 of float");
+	check(tcs_classify() == 0, "TCS34727 palette classifier accuracy");
+	check(tcs_lux_cct() == 0, "TCS34727 fixed-point lux and CCT match DN40");
+	check(tcs_calibrate() == 0, "TCS34727 calibration fits, applies and persists");
+	check(tcs_filter() == 0, "TCS34727 sample filters exact and cut the noise");
+	if(record != 0)
+		check(tcs_filter_record(record) == 0, "TCS34727 filters on the recorded samples");
+	memcpy(tcs.light, scenes[0].light, sizeof(tcs.light));
+	check(TCS34727_Set_Exposure(TCS34727_ATIME_2_4_MS, TCS34727_CTRL_AGAIN_4X) == I2C_OK, "TCS34727 exposure back to init");
+
+	MPU6050_Get_Accel(&accel);
+	MPU6050_Get_Gyro(&gyro);
+	check(accel.Ax_RAW == 1000 && accel.Ay_RAW == -2000 && accel.Az_RAW == 16384, "MPU6050 accel");
+	check(gyro.Gx_RAW == 131 && gyro.Gy_RAW == -262 && gyro.Gz_RAW == 7, "MPU6050 gyro");
+	check((mpu.dev.regs[PWR_MGMT_1] & PWR_DEVICE_RESET) == 0 && mpu.dev.regs[SMPLRT_DIV] == SMPLRT_DIV_8, "MPU6050 configured");
+
+	LCD_Set_Cursor(ROW1, 0);
+	LCD_Print_Str((uint8_t*)"Color: RED");
+	LCD_Set_Cursor(ROW2, 3);
+	LCD_Print_Str((uint8_t*)"Angle 42");
+	lcd_drain();
+	I2CSim_LCD_Row(&lcd, 0, row);
+	check(strcmp(row, "Color: RED      ") == 0, "LCD row 1");
+	I2CSim_LCD_Row(&lcd, 1, row);
+	check(strcmp(row, "   Angle 42     ") == 0, "LCD row 2");
+	check(lcd.ignored == 0, "LCD no EN pulse while busy");
+
+	/* A part that stops answering */
+	I2CSim_Detach(0, &tcs.dev);
+	check(I2C_Probe(I2C_BUS0, TCS34727_ADDR) == (I2C_MCS_ERROR|I2C_MCS_ADRACK), "Detached part NACKs");
+	I2CSim_Attach(0, &tcs.dev);
+	check(I2C_Probe(I2C_BUS0, TCS34727_ADDR) == I2C_OK, "Reattached part ACKs");
+	check(bus_error_paths() == 0, "I2C NACK and timeout paths release the bus");
+	check(async_states() == 0, "I2C interrupt engine ends in every state");
+	check(seg_vs_copy() == 0, "I2C segment writes match staged writes without copies");
+	check(queue_latency() == 0, "TCS34727 read latency bounded under LCD load");
+	check(I2C_Burst_Transmit(I2C_BUS0, RUN_SPARE_ADDR, 0, (uint8_t*)&rgbc, 0) == I2C_ERR_PARAM, "Empty burst transmit rejected");
+	check(speed_table() == 0, "I2C_SetSpeed TPR and throughput per rate");
+	check(recover_stuck() == 0, "I2C_Recover frees a stuck SDA and keeps setup");
+	check(two_bus_overlap() == 0, "I2C0 and LCD bus transfers overlap");
+	check(stats_histogram() == 0, "I2C latency histogram matches injected delays");
+	check(scan_timing() == 0, "I2C_Scan finds and binds every address set in time");
+	check(loopback_bench() == 0, "I2CBench runs every rate and mode in loopback");
+	check(slave_map_read() == 0, "I2CSlave map read back through loopback");
+
+	printf("\nPer call (%d calls)       sim us    wire us    bytes    host ns\n", calls);
+	bench("TCS34727_GET_RAW_RED", 0, call_tcs_red, calls);
+	bench("TCS34727 4x GET_RAW", 0, call_tcs_channels, calls);
+	bench("TCS34727_Read_RGBC", 0, call_tcs_rgbc, calls);
+	bench("TCS34727_Read_RGBC_Next", 0, call_tcs_next, calls);
+	bench("MPU6050_Get_Accel", 0, call_mpu_accel, calls);
+	bench("MPU6050_Get_Gyro", 0, call_mpu_gyro, calls);
+	bench("LCD_Print_Char", 1, call_lcd_char, calls);
+
+	check(cache_loop_compare() == 0, "I2CCache saves the MPU6050 config reads per loop");
+	if(iterations > 0)
+		full_system_report(iterations);
+
+	printf("\n%s, %d check(s) failed\n", failures ? "FAIL" : "PASS", failures);
+
+	return failures;
+}
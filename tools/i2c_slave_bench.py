@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+"""
+i2c_slave_bench.py
+
+Simulated host master for the I2C slave data server (I2CSlave.c). It reads
+the register map back to back, as fast as the bus allows, while the
+firmware publishes new samples. It reports the read throughput you can
+get and checks that no read returned a torn sample.
+
+The slave side mirrors the firmware: two map buffers. The buffer is
+latched at every START. A publish is dropped while the host is still
+reading the back buffer. Each byte costs 9 SCL clocks plus the slave
+interrupt latency, because SCL is held low until the handler services
+SDR.
+
+Usage:
+    i2c_slave_bench.py                      # sweep 100k, 400k and 1M SCL
+    i2c_slave_bench.py --scl 400000         # one rate
+    i2c_slave_bench.py --length 8           # read only the color block
+    i2c_slave_bench.py --single             # single buffer, to see tearing
+"""
+
+import argparse
+import struct
+
+# Matches I2C_SLAVE_MAP_t in I2CSlave.h
+MAP = struct.Struct("<BBH4HBB3h3h3hh")
+MAP_ID = 0xA5
+MAP_VER = 1
+FILL = 0xFF
+
+
+def make_sample(n):
+    """Every field derived from n, so a torn read shows up as a mismatch."""
+    v = n & 0x7FFF
+    return [MAP_ID, MAP_VER, n & 0xFFFF] + [v] * 4 + [n & 0x3, 0] + [v] * 3 + [-v] * 3 + [v] * 3 + [v]
+
+
+def consistent(raw):
+    fields = list(MAP.unpack(raw[:MAP.size]))
+    if fields[2] == 0:
+        return True  # nothing published yet, map is all zero
+    return fields == make_sample(fields[2])
+
+
+class Slave:
+    """Register map server, same rules as I2CSlave.c."""
+
+    def __init__(self, double):
+        self.double = double
+        self.maps = [bytearray(MAP.size), bytearray(MAP.size)]
+        self.front = 0
+        self.latched = 0
+        self.active = False
+        self.ptr = 0
+        self.seq = 0
+        self.published = 0
+        self.skipped = 0
+
+    def start(self):
+        self.latched = self.front
+        self.active = True
+
+    def stop(self):
+        self.active = False
+
+    def write(self, byte, first):
+        if first:
+            self.ptr = byte
+
+    def read(self):
+        if self.ptr >= MAP.size:
+            return FILL
+        byte = self.maps[self.latched][self.ptr]
+        self.ptr += 1
+        return byte
+
+    def publish(self):
+        back = self.front ^ 1 if self.double else self.front
+        if self.double and self.active and self.latched == back:
+            self.skipped += 1
+            return
+        self.seq = (self.seq + 1) & 0xFFFF
+        self.maps[back][:] = MAP.pack(*make_sample(self.seq))
+        self.front = back
+        self.published += 1
+
+
+def run(scl, length, period, isr_us, gap_us, duration, double):
+    bit = 1.0 / scl
+    byte_time = 9 * bit + isr_us * 1e-6
+    slave = Slave(double)
+
+    t = 0.0
+    next_pub = 0.0
+    reads = torn = fresh = 0
+    last_seq = None
+
+    def advance(dt):
+        # Publishes land between bytes, the firmware copy never overlaps a byte
+        nonlocal t, next_pub
+        t += dt
+        while next_pub <= t:
+            slave.publish()
+            next_pub += period
+
+    while t < duration:
+        # START, address + pointer write
+        slave.start()
+        advance(bit + byte_time)
+        slave.write(0, True)
+        advance(byte_time)
+
+        # Repeated START, address + data read
+        slave.start()
+        advance(bit + byte_time)
+        raw = bytearray()
+        for _ in range(length):
+            raw.append(slave.read())
+            advance(byte_time)
+        slave.stop()
+        advance(bit + gap_us * 1e-6)
+
+        reads += 1
+        full = bytes(raw) + bytes(slave.maps[slave.latched][len(raw):])
+        if length >= MAP.size and not consistent(full):
+            torn += 1
+        seq = MAP.unpack(full[:MAP.size])[2] if length >= 4 else None
+        if seq is not None and seq != last_seq:
+            fresh += 1
+            last_seq = seq
+
+    return {
+        "scl": scl, "reads": reads / t, "bytes": reads * length / t,
+        "read_us": t / reads * 1e6, "published": slave.published,
+        "skipped": slave.skipped, "fresh": fresh, "torn": torn,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Simulated master reading the I2C slave map")
+    parser.add_argument("--scl", type=int, action="append", help="SCL rate in Hz (repeatable)")
+    parser.add_argument("--length", type=int, default=MAP.size, help="bytes per read (default whole map)")
+    parser.add_argument("--period-ms", type=float, default=30.0, help="firmware publish period")
+    parser.add_argument("--isr-us", type=float, default=2.0, help="slave interrupt latency per byte")
+    parser.add_argument("--gap-us", type=float, default=0.0, help="host idle time between reads")
+    parser.add_argument("--seconds", type=float, default=2.0, help="simulated time per rate")
+    parser.add_argument("--single", action="store_true", help="single buffered slave for comparison")
+    args = parser.parse_args()
+
+    print("map %d bytes, reading %d, publish every %.1f ms, %s buffer\n" % (
+        MAP.size, args.length, args.period_ms, "single" if args.single else "double"))
+    print("%9s %9s %10s %11s %10s %8s %8s %6s" % (
+        "SCL (Hz)", "read (us)", "reads/s", "bytes/s", "published", "skipped", "fresh", "torn"))
+    for scl in args.scl or [100000, 400000, 1000000]:
+        r = run(scl, args.length, args.period_ms * 1e-3, args.isr_us, args.gap_us,
+                args.seconds, not args.single)
+        print("%9d %9.1f %10.1f %11.0f %10d %8d %8d %6d" % (
+            r["scl"], r["read_us"], r["reads"], r["bytes"], r["published"],
+            r["skipped"], r["fresh"], r["torn"]))
+
+
+if __name__ == "__main__":
+    main()
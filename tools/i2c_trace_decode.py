@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+"""
+i2c_trace_decode.py
+
+Decodes the binary I2C trace dump sent over UART0 (console command 't',
+firmware built with I2C_TRACE_ENABLE) and prints where the bus time goes,
+per device.
+
+Usage:
+    i2c_trace_decode.py capture.bin            # raw UART0 capture
+    i2c_trace_decode.py --port COM5            # send 't' and read (needs pyserial)
+    i2c_trace_decode.py capture.bin --records  # also list every record
+
+The dump can be embedded in ordinary console text, the decoder looks for
+the "I2CT" header. Layout (little endian) matches I2CTrace.h:
+    "I2CT" u8 version, u8 record size, u16 count, u32 system clock Hz
+    count x { u32 timestamp, u32 duration, u16 seq, u16 len,
+              u8 addr, u8 reg, u8 flags, u8 error }
+"""
+
+import argparse
+import struct
+import sys
+
+MAGIC = b"I2CT"
+HEADER = struct.Struct("<BBHI")
+RECORD = struct.Struct("<IIHHBBBB")
+VERSION = 1
+
+SEQ_VALID = 0x8000
+FLAG_READ = 0x01
+FLAG_ASYNC = 0x02
+BUS_SHIFT = 2
+
+# Error bits as returned by the driver (MCS bits + driver codes)
+ERRORS = [(0x02, "ERROR"), (0x04, "ADRNACK"), (0x08, "DATNACK"),
+          (0x10, "ARBLST"), (0x20, "BUSY"), (0x40, "PARAM"), (0x80, "TIMEOUT")]
+
+# Parts this board carries, used to label addresses
+DEVICES = {
+    0x29: "TCS34727",
+    0x68: "MPU6050",
+    0x69: "MPU6050 (AD0 high)",
+    0x27: "LCD PCF8574",
+    0x3F: "LCD PCF8574A",
+}
+
+
+def error_name(error):
+    if error == 0:
+        return "OK"
+    return "|".join(name for bit, name in ERRORS if error & bit)
+
+
+def parse(data):
+    """Returns (system clock, records) of the last complete dump in data."""
+    pos = data.rfind(MAGIC)
+    while pos >= 0:
+        start = pos + len(MAGIC)
+        if len(data) >= start + HEADER.size:
+            version, size, count, sysclk = HEADER.unpack_from(data, start)
+            body = start + HEADER.size
+            if version == VERSION and size == RECORD.size and len(data) >= body + count * size:
+                records = [RECORD.unpack_from(data, body + i * size) for i in range(count)]
+                return sysclk, records
+        pos = data.rfind(MAGIC, 0, pos)
+    raise ValueError("no complete I2C trace dump found")
+
+
+def unwrap(records):
+    """Drops torn records and turns 32-bit cycle stamps into a running count."""
+    out = []
+    offset = 0
+    last = None
+    for ts, dur, seq, length, addr, reg, flags, error in records:
+        if not seq & SEQ_VALID:
+            continue
+        if last is not None and ts + offset < last:
+            offset += 1 << 32
+        last = ts + offset
+        out.append({
+            "start": last, "duration": dur, "seq": seq & 0x7FFF, "len": length,
+            "addr": addr, "reg": reg, "bus": flags >> BUS_SHIFT,
+            "read": bool(flags & FLAG_READ), "async": bool(flags & FLAG_ASYNC),
+            "error": error,
+        })
+    return out
+
+
+def report(sysclk, records, show_records):
+    us = 1e6 / sysclk
+    if not records:
+        print("trace is empty")
+        return
+
+    window = max(r["start"] + r["duration"] for r in records) - records[0]["start"]
+    print("%d transactions over %.3f ms (system clock %d Hz)\n" %
+          (len(records), window * us / 1000.0, sysclk))
+
+    if show_records:
+        print("%10s %4s %4s %-20s %4s %2s %5s %10s %s" %
+              ("t (us)", "bus", "addr", "device", "reg", "rw", "len", "dur (us)", "status"))
+        t0 = records[0]["start"]
+        for r in records:
+            print("%10.1f %4d 0x%02X %-20s 0x%02X %2s %5d %10.1f %s%s" % (
+                (r["start"] - t0) * us, r["bus"], r["addr"], DEVICES.get(r["addr"], "?"),
+                r["reg"], "R" if r["read"] else "W", r["len"], r["duration"] * us,
+                error_name(r["error"]), " (queued)" if r["async"] else ""))
+        print()
+
+    per_device = {}
+    for r in records:
+        key = (r["bus"], r["addr"])
+        d = per_device.setdefault(key, {"count": 0, "bytes": 0, "errors": 0, "total": 0, "max": 0})
+        d["count"] += 1
+        d["bytes"] += r["len"]
+        d["errors"] += 1 if r["error"] else 0
+        d["total"] += r["duration"]
+        d["max"] = max(d["max"], r["duration"])
+
+    busy = sum(d["total"] for d in per_device.values())
+    print("%4s %4s %-20s %6s %7s %6s %10s %7s %7s %9s %9s" %
+          ("bus", "addr", "device", "count", "bytes", "errors", "time (ms)",
+           "% bus", "% loop", "avg (us)", "max (us)"))
+    for (bus, addr), d in sorted(per_device.items(), key=lambda kv: -kv[1]["total"]):
+        print("%4d 0x%02X %-20s %6d %7d %6d %10.3f %6.1f%% %6.1f%% %9.1f %9.1f" % (
+            bus, addr, DEVICES.get(addr, "?"), d["count"], d["bytes"], d["errors"],
+            d["total"] * us / 1000.0, 100.0 * d["total"] / busy if busy else 0.0,
+            100.0 * d["total"] / window if window else 0.0,
+            d["total"] * us / d["count"], d["max"] * us))
+    print("\nbus busy %.3f ms of %.3f ms (%.1f%%), buses overlap so this can exceed 100%%" %
+          (busy * us / 1000.0, window * us / 1000.0, 100.0 * busy / window if window else 0.0))
+
+
+def read_port(port, baud, timeout):
+    import serial  # pyserial, only needed for live capture
+    with serial.Serial(port, baud, timeout=timeout) as ser:
+        ser.reset_input_buffer()
+        ser.write(b"t")
+        data = b""
+        while True:
+            chunk = ser.read(4096)
+            if not chunk:
+                return data
+            data += chunk
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode an I2C trace dump")
+    parser.add_argument("capture", nargs="?", help="raw UART0 capture file")
+    parser.add_argument("--port", help="serial port to request a dump from")
+    parser.add_argument("--baud", type=int, default=57600, help="UART0 baud rate (default 57600)")
+    parser.add_argument("--timeout", type=float, default=1.0, help="seconds of silence that end a dump")
+    parser.add_argument("--records", action="store_true", help="list every record")
+    args = parser.parse_args()
+
+    if args.port:
+        data = read_port(args.port, args.baud, args.timeout)
+    elif args.capture:
+        with open(args.capture, "rb") as f:
+            data = f.read()
+    else:
+        data = sys.stdin.buffer.read()
+
+    sysclk, records = parse(data)
+    report(sysclk, unwrap(records), args.records)
+
+
+if __name__ == "__main__":
+    main()
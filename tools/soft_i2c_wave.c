@@ -0,0 +1,652 @@
+/*
+ * soft_i2c_wave.c
+ *
+ *	Host check for the bit-banged I2C master (SoftI2C.c). The driver
+ *	source is built unchanged against a simulated GPIO port and cycle
+ *	counter. A slave model answers on the simulated lines, every line
+ *	change is recorded, and the recording is decoded like a logic
+ *	analyzer would: START/STOP, bytes and ACKs are checked against what
+ *	was sent, the I2C timing minimums are checked for the bus mode, and
+ *	the SCL rate and payload throughput achieved are reported.
+ *
+ *	Build and run from the repository root:
+ *		cc -std=gnu11 -O2 -I"Full System Test" -o soft_i2c_wave tools/soft_i2c_wave.c && ./soft_i2c_wave
+ *
+ *	Options: -r <ns> line rise time (default 300), -s <us> slave clock
+ *	stretch after every ACK in the stretch case (default 20), -v to print
+ *	the decoded transactions
+ *
+ *	Cycle costs are a model of an 80MHz TM4C123 on the APB bus, so the
+ *	overhead figures are indicative. The timing checks hold whatever the
+ *	costs, because the driver calibrates them out
+ *
+ * Created on: October 17th, 2026
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+/* ------------------------------------------------------------------ */
+/* Target stand-ins, in place before the driver pulls in its headers   */
+/* ------------------------------------------------------------------ */
+
+#include "tm4c123gh6pm.h"
+#undef SYSCTL_RCGCGPIO_R
+#undef SYSCTL_PRGPIO_R
+static unsigned long sim_rcgcgpio;
+#define SYSCTL_RCGCGPIO_R   sim_rcgcgpio
+#define SYSCTL_PRGPIO_R     sim_rcgcgpio
+
+/* util.h replacement: the cycle counter is the simulation clock */
+#define UTIL_H_
+#define SIM_SYSCLK_HZ       80000000UL
+#define SIM_CYC_COUNTER     3           // Cycles one CYCCNT read costs
+#define SIM_CYC_GPIO        4           // Cycles one GPIO read-modify-write costs
+static uint32_t DWT_CTRL_R = 1;
+#define DWT_CYCCNTENA       1
+static uint64_t sim_now;
+static void sim_step(void);
+static void CYCCNT_Init(void){}
+static uint32_t SYSCLK_Get_Hz(void){ return SIM_SYSCLK_HZ; }
+static inline uint32_t CYCCNT_Get(void){
+	sim_now += SIM_CYC_COUNTER;
+	sim_step();
+	return (uint32_t)sim_now;
+}
+
+/* GPIO port: only DIR and the bit-specific DATA reads matter */
+static volatile unsigned long* sim_gpio(uint32_t off);
+#define SOFT_I2C_GPIO_REG(bus, off) (*sim_gpio(off))
+
+#include "SoftI2C.c"
+
+/* ------------------------------------------------------------------ */
+/* Bus and slave model                                                 */
+/* ------------------------------------------------------------------ */
+
+#define SCL_PIN             0x01
+#define SDA_PIN             0x02
+#define SLAVE_ADDR          0x29
+#define MAX_EDGES           200000
+#define NEVER               UINT64_MAX
+
+typedef struct{
+	uint64_t t;
+	uint8_t scl;
+	uint8_t sda;
+} EDGE_t;
+
+static EDGE_t edges[MAX_EDGES];
+static uint32_t edge_count;
+
+static unsigned long gpio_dir;
+static unsigned long gpio_scratch;
+static uint64_t rise_cycles;
+
+/* Line state: a released line reaches high rise_cycles after its last
+	 driver lets go, a driven line falls at once */
+typedef struct{
+	uint8_t level;
+	uint8_t master_low;
+	uint8_t slave_low;
+	uint64_t release_t;									// When the last driver let go
+} LINE_t;
+
+static LINE_t scl_line;
+static LINE_t sda_line;
+
+/* Slave: register file with auto increment, stretches after ACKs */
+typedef enum{ S_IDLE, S_ADDR, S_WRITE, S_READ, S_IGNORE } SLAVE_STATE;
+static struct{
+	SLAVE_STATE state;
+	uint8_t bit;												// Bits of the current byte seen (0-8)
+	uint8_t shift;											// Byte coming in
+	uint8_t out;												// Byte going out on a read
+	uint8_t first;											// Next written byte is the register pointer
+	uint8_t ptr;
+	uint8_t regs[256];
+	uint8_t acking;											// Slave drives the ACK bit
+	uint8_t master_acked;								// Last read byte ACKed
+	uint64_t stretch;										// Cycles SCL is held after each ACK
+	uint8_t stuck;											// Hold SCL low forever after the next ACK
+	uint64_t sda_at;										// Pending SDA change
+	uint8_t sda_value;
+	uint64_t scl_release_at;						// Pending end of stretch
+} slave;
+
+static void line_drive(LINE_t* line, uint8_t master_low, uint8_t slave_low, uint64_t t){
+
+	uint8_t was_low = line->master_low || line->slave_low;
+
+	line->master_low = master_low;
+	line->slave_low = slave_low;
+
+	if(master_low || slave_low)
+		line->release_t = NEVER;
+	else if(was_low)
+		line->release_t = t;
+}
+
+static void record(uint64_t t){
+
+	if(edge_count && edges[edge_count-1].scl == scl_line.level && edges[edge_count-1].sda == sda_line.level)
+		return;
+	if(edge_count < MAX_EDGES){
+		edges[edge_count].t = t;
+		edges[edge_count].scl = scl_line.level;
+		edges[edge_count].sda = sda_line.level;
+		edge_count++;
+	}
+}
+
+/* Slave sees a change on the bus at time t */
+static void slave_event(uint8_t scl_old, uint8_t sda_old, uint64_t t){
+
+	uint8_t scl = scl_line.level;
+	uint8_t sda = sda_line.level;
+
+	/* START or repeated START */
+	if(scl && scl_old && sda_old && !sda){
+		slave.state = S_ADDR;
+		slave.bit = 0;
+		slave.shift = 0;
+		slave.acking = 0;
+		slave.sda_at = t;
+		slave.sda_value = 1;
+		return;
+	}
+
+	/* STOP */
+	if(scl && scl_old && !sda_old && sda){
+		slave.state = S_IDLE;
+		slave.sda_at = t;
+		slave.sda_value = 1;
+		return;
+	}
+
+	if(slave.state == S_IDLE || slave.state == S_IGNORE)
+		return;
+
+	/* Rising SCL: sample */
+	if(scl && !scl_old){
+		if(slave.bit < 8){
+			if(slave.state != S_READ)
+				slave.shift = (slave.shift << 1) | sda;
+		}
+		else if(slave.state == S_READ){
+			slave.master_acked = !sda;				// Our own ACK when this was the address byte
+		}
+		slave.bit++;
+		return;
+	}
+
+	/* Falling SCL: drive the next bit, data hold is a few cycles */
+	if(!scl && scl_old){
+
+		if(slave.bit == 8){
+			/* Byte complete, decide on the ACK */
+			slave.acking = 1;
+			if(slave.state == S_ADDR){
+				if((slave.shift >> 1) != SLAVE_ADDR){
+					slave.state = S_IGNORE;
+					slave.acking = 0;
+				}
+				else if(slave.shift & 1){
+					slave.state = S_READ;
+				}
+				else{
+					slave.state = S_WRITE;
+					slave.first = 1;
+				}
+			}
+			else if(slave.state == S_WRITE){
+				if(slave.first)
+					slave.ptr = slave.shift;
+				else
+					slave.regs[slave.ptr++] = slave.shift;
+				slave.first = 0;
+			}
+			else if(slave.state == S_READ){
+				slave.acking = 0;							// Master answers a read byte
+			}
+
+			slave.sda_at = t + 4;
+			slave.sda_value = !slave.acking;
+			return;
+		}
+
+		if(slave.bit == 9){
+			/* ACK clock done, start the next byte */
+			slave.bit = 0;
+			slave.shift = 0;
+
+			if(slave.acking && (slave.stretch || slave.stuck)){
+				slave.scl_release_at = slave.stuck ? NEVER : t + slave.stretch;
+				line_drive(&scl_line, scl_line.master_low, 1, t);
+			}
+
+			/* First read byte follows the address ACK, later ones need the master ACK */
+			if(slave.state == S_READ && (slave.acking || slave.master_acked)){
+				slave.out = slave.regs[slave.ptr++];
+				slave.sda_at = t + 4;
+				slave.sda_value = (slave.out >> 7) & 1;
+			}
+			else if(slave.state == S_READ){
+				slave.state = S_IGNORE;				// NACKed, let go until STOP
+				slave.sda_at = t + 4;
+				slave.sda_value = 1;
+			}
+			else{
+				slave.sda_at = t + 4;
+				slave.sda_value = 1;
+			}
+			slave.acking = 0;
+			return;
+		}
+
+		if(slave.state == S_READ){
+			slave.sda_at = t + 4;
+			slave.sda_value = (slave.out >> (7 - slave.bit)) & 1;
+		}
+	}
+}
+
+/* Level of a line at time t given its drivers */
+static uint8_t line_level(LINE_t* line, uint64_t t){
+	if(line->master_low || line->slave_low)
+		return 0;
+	return (t >= line->release_t + rise_cycles) ? 1 : line->level;
+}
+
+/* Applies every change due up to time t, in time order */
+static void settle(uint64_t t){
+
+	for(;;){
+		uint64_t next = NEVER;
+		uint8_t scl_old = scl_line.level;
+		uint8_t sda_old = sda_line.level;
+
+		if(!scl_line.level && scl_line.release_t != NEVER && scl_line.release_t + rise_cycles < next)
+			next = scl_line.release_t + rise_cycles;
+		if(!sda_line.level && sda_line.release_t != NEVER && sda_line.release_t + rise_cycles < next)
+			next = sda_line.release_t + rise_cycles;
+		if(slave.sda_at != NEVER && slave.sda_at < next)
+			next = slave.sda_at;
+		if(slave.scl_release_at != NEVER && slave.scl_release_at < next)
+			next = slave.scl_release_at;
+
+		if(next > t)
+			return;
+
+		if(slave.sda_at == next){
+			slave.sda_at = NEVER;
+			line_drive(&sda_line, sda_line.master_low, !slave.sda_value, next);
+		}
+		if(slave.scl_release_at == next){
+			slave.scl_release_at = NEVER;
+			line_drive(&scl_line, scl_line.master_low, 0, next);
+		}
+
+		scl_line.level = line_level(&scl_line, next);
+		sda_line.level = line_level(&sda_line, next);
+		if(scl_line.level != scl_old || sda_line.level != sda_old){
+			record(next);
+			slave_event(scl_old, sda_old, next);
+		}
+	}
+}
+
+/* Master side pin change at the current time */
+static void master_update(void){
+
+	uint8_t scl_old = scl_line.level;
+	uint8_t sda_old = sda_line.level;
+
+	line_drive(&scl_line, (gpio_dir & SCL_PIN) != 0, scl_line.slave_low, sim_now);
+	line_drive(&sda_line, (gpio_dir & SDA_PIN) != 0, sda_line.slave_low, sim_now);
+	scl_line.level = line_level(&scl_line, sim_now);
+	sda_line.level = line_level(&sda_line, sim_now);
+
+	if(scl_line.level != scl_old || sda_line.level != sda_old){
+		record(sim_now);
+		slave_event(scl_old, sda_old, sim_now);
+	}
+}
+
+static void sim_step(void){
+	settle(sim_now);
+	master_update();
+}
+
+static unsigned long dir_shadow;
+
+static volatile unsigned long* sim_gpio(uint32_t off){
+
+	sim_now += SIM_CYC_GPIO;
+	sim_step();
+
+	/* A DIR write lands after the access, pick it up on the next one */
+	if(dir_shadow != gpio_dir){
+		dir_shadow = gpio_dir;
+		master_update();
+	}
+
+	if(off == GPIO_DIR_OFFSET)
+		return &gpio_dir;
+
+	if(off < GPIO_DATA_OFFSET){
+		/* Bit-specific DATA read, open drain so the pad follows the line */
+		gpio_scratch = 0;
+		if((off >> 2) & SCL_PIN)
+			gpio_scratch |= scl_line.level ? SCL_PIN : 0;
+		if((off >> 2) & SDA_PIN)
+			gpio_scratch |= sda_line.level ? SDA_PIN : 0;
+		return &gpio_scratch;
+	}
+
+	gpio_scratch = 0;
+	return &gpio_scratch;
+}
+
+/* The driver writes DIR through the returned pointer, so the write is
+	 only seen on the next call. Every write in the driver is followed by
+	 a CYCCNT or GPIO access, which lands it at the time of that access */
+static void sim_flush(void){
+	if(dir_shadow != gpio_dir){
+		dir_shadow = gpio_dir;
+		master_update();
+	}
+}
+
+/* ------------------------------------------------------------------ */
+/* Decoder and timing checks                                           */
+/* ------------------------------------------------------------------ */
+
+typedef struct{
+	const char* mode;
+	uint32_t hz;
+	double t_low, t_high, t_su_sta, t_hd_sta, t_su_sto, t_buf, t_su_dat;	// Minimums in ns
+} SPEC_t;
+
+static const SPEC_t specs[] = {
+	{"Standard", 100000, 4700, 4000, 4700, 4000, 4000, 4700, 250},
+	{"Fast",     400000, 1300,  600,  600,  600,  600, 1300, 100},
+};
+
+typedef struct{
+	double t_low, t_high, t_su_sta, t_hd_sta, t_su_sto, t_buf, t_su_dat;	// Minimums seen in ns
+	uint32_t clocks;
+	uint64_t period_sum, period_min;			// Rise to rise within a byte, in cycles
+	uint32_t periods;
+	uint32_t bytes;
+	uint32_t acks, nacks;
+	char text[4096];
+} DECODE_t;
+
+static double ns(uint64_t cycles){
+	return cycles * 1e9 / SIM_SYSCLK_HZ;
+}
+
+static void keep_min(double* min, double value){
+	if(*min < 0 || value < *min)
+		*min = value;
+}
+
+static void decode(uint32_t from, uint32_t to, DECODE_t* d, int payload_bytes){
+
+	uint32_t i;
+	uint64_t scl_fall = 0, scl_rise = 0, sda_change = 0;
+	uint64_t start_t = 0, stop_t = 0, last_stop = 0;
+	int have_stop = 0, in_frame = 0;
+	int bit = 0;
+	uint16_t shift = 0;
+	size_t n = 0;
+
+	memset(d, 0, sizeof(*d));
+	d->t_low = d->t_high = d->t_su_sta = d->t_hd_sta = d->t_su_sto = d->t_buf = d->t_su_dat = -1;
+	(void)payload_bytes;
+
+	for(i = (from > 0) ? from : 1; i < to; i++){
+		EDGE_t* p = &edges[i-1];
+		EDGE_t* e = &edges[i];
+
+		if(e->scl != p->scl){
+			if(e->scl){
+				/* Rising SCL */
+				if(scl_fall)
+					keep_min(&d->t_low, ns(e->t - scl_fall));
+				if(in_frame && bit > 0 && scl_rise){
+					d->period_sum += e->t - scl_rise;
+					d->periods++;
+					if(d->period_min == 0 || e->t - scl_rise < d->period_min)
+						d->period_min = e->t - scl_rise;
+				}
+				if(in_frame && sda_change > scl_fall && bit >= 0)
+					keep_min(&d->t_su_dat, ns(e->t - sda_change));
+				scl_rise = e->t;
+				if(in_frame){
+					if(bit < 8)
+						shift = (shift << 1) | e->sda;
+					else{
+						if(e->sda) d->nacks++; else d->acks++;
+						n += snprintf(d->text + n, sizeof(d->text) - n, "%02X%c ", shift & 0xFF, e->sda ? '-' : '+');
+						d->bytes++;
+					}
+					d->clocks++;
+				}
+			}
+			else{
+				/* Falling SCL */
+				if(scl_rise)
+					keep_min(&d->t_high, ns(e->t - scl_rise));
+				if(in_frame && start_t && bit == -1)
+					keep_min(&d->t_hd_sta, ns(e->t - start_t));
+				scl_fall = e->t;
+				if(in_frame){
+					if(bit == -1)
+						bit = 0;
+					else if(bit == 8){
+						bit = 0;
+						shift = 0;
+					}
+					else if(++bit > 8)
+						bit = 0;
+				}
+			}
+		}
+
+		if(e->sda != p->sda){
+			if(e->scl && p->scl){
+				if(!e->sda){
+					/* START or repeated START */
+					keep_min(&d->t_su_sta, ns(e->t - scl_rise));
+					if(have_stop && !in_frame)
+						keep_min(&d->t_buf, ns(e->t - last_stop));
+					n += snprintf(d->text + n, sizeof(d->text) - n, in_frame ? "Sr " : "S ");
+					start_t = e->t;
+					in_frame = 1;
+					bit = -1;
+					shift = 0;
+				}
+				else{
+					/* STOP */
+					keep_min(&d->t_su_sto, ns(e->t - scl_rise));
+					n += snprintf(d->text + n, sizeof(d->text) - n, "P ");
+					stop_t = e->t;
+					last_stop = e->t;
+					have_stop = 1;
+					in_frame = 0;
+				}
+			}
+			else{
+				sda_change = e->t;
+			}
+		}
+	}
+	(void)stop_t;
+}
+
+static int check(const SPEC_t* spec, const DECODE_t* d){
+
+	int bad = 0;
+
+#define CHECK(field, name) \
+	if(d->field >= 0 && d->field < spec->field){ \
+		printf("    VIOLATION %-8s %7.0f ns < %5.0f ns\n", name, d->field, spec->field); bad++; }
+
+	CHECK(t_low, "tLOW");
+	CHECK(t_high, "tHIGH");
+	CHECK(t_su_sta, "tSU;STA");
+	CHECK(t_hd_sta, "tHD;STA");
+	CHECK(t_su_sto, "tSU;STO");
+	CHECK(t_buf, "tBUF");
+	CHECK(t_su_dat, "tSU;DAT");
+#undef CHECK
+
+	return bad;
+}
+
+/* ------------------------------------------------------------------ */
+/* Cases                                                               */
+/* ------------------------------------------------------------------ */
+
+static int verbose;
+static int failures;
+
+static void sim_reset(void){
+
+	memset(&scl_line, 0, sizeof(scl_line));
+	memset(&sda_line, 0, sizeof(sda_line));
+	scl_line.level = sda_line.level = 1;
+	scl_line.release_t = sda_line.release_t = 0;
+	gpio_dir = dir_shadow = 0;
+	slave.state = S_IDLE;
+	slave.sda_at = NEVER;
+	slave.scl_release_at = NEVER;
+	slave.stretch = 0;
+	slave.stuck = 0;
+	edge_count = 0;
+	record(sim_now);
+}
+
+static void expect(const char* what, int ok){
+	if(!ok){
+		printf("    FAIL %s\n", what);
+		failures++;
+	}
+}
+
+static void run_speed(uint32_t hz, uint32_t stretch_us){
+
+	SOFT_I2C_t* bus = SOFT_I2C_BUS0;
+	uint8_t tx[8] = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88};
+	uint8_t rx[16];
+	uint32_t expected, from, i;
+	uint64_t t0, t1;
+	uint8_t error;
+	DECODE_t d;
+	const SPEC_t* spec = (hz > 100000) ? &specs[1] : &specs[0];
+	double scl_khz;
+
+	sim_reset();
+	SoftI2C_Init(bus);
+	expected = SoftI2C_SetSpeed(bus, hz);
+	slave.stretch = (uint64_t)stretch_us * (SIM_SYSCLK_HZ / 1000000);
+	for(i = 0; i < 256; i++)
+		slave.regs[i] = (uint8_t)(0xA0 + i);
+
+	printf("%3lu kHz %s mode, edge overhead %lu cycles, expected %lu Hz%s\n",
+			(unsigned long)(hz / 1000), spec->mode, (unsigned long)bus->overhead, (unsigned long)expected,
+			stretch_us ? ", slave stretching" : "");
+
+	/* Write then read back through the register pointer */
+	from = edge_count;
+	t0 = sim_now;
+	error = SoftI2C_Burst_Transmit(bus, SLAVE_ADDR, 0x10, tx, sizeof(tx));
+	expect("burst transmit status", error == I2C_OK);
+	memset(rx, 0, sizeof(rx));
+	error = SoftI2C_Burst_Receive(bus, SLAVE_ADDR, 0x10, rx, sizeof(rx));
+	sim_flush();
+	t1 = sim_now;
+	expect("burst receive status", error == I2C_OK);
+	expect("data written reached the slave", memcmp(&slave.regs[0x10], tx, sizeof(tx)) == 0);
+	expect("data read back", memcmp(rx, tx, sizeof(tx)) == 0 && rx[8] == 0xA0 + 0x18);
+
+	decode(from, edge_count, &d, 0);
+	if(verbose)
+		printf("    %s\n", d.text);
+	expect("bytes decoded", d.bytes == (2 + 8) + (2 + 1 + 16));
+	expect("one NACK (last read byte)", d.nacks == 1);
+
+	scl_khz = d.period_min ? 1e6 / ns(d.period_min) : 0;
+	printf("    SCL %.1f kHz average, %.1f kHz fastest (spec %lu kHz max)\n",
+			d.periods ? 1e6 / ns(d.period_sum / d.periods) : 0, scl_khz, (unsigned long)(spec->hz / 1000));
+	printf("    tLOW %.0f ns, tHIGH %.0f ns, tSU;DAT %.0f ns\n", d.t_low, d.t_high, d.t_su_dat);
+	printf("    tSU;STA %.0f ns, tHD;STA %.0f ns, tSU;STO %.0f ns, tBUF %.0f ns\n",
+			d.t_su_sta, d.t_hd_sta, d.t_su_sto, d.t_buf);
+	printf("    %u payload bytes in %.1f us, %.0f B/s\n", (unsigned)(sizeof(tx) + sizeof(rx)),
+			ns(t1 - t0) / 1000, (sizeof(tx) + sizeof(rx)) * 1e9 / ns(t1 - t0));
+
+	failures += check(spec, &d);
+	expect("SCL not above the mode rate", scl_khz <= spec->hz / 1000.0);
+}
+
+static void run_errors(void){
+
+	SOFT_I2C_t* bus = SOFT_I2C_BUS0;
+	uint8_t rx[2];
+	uint8_t error;
+
+	printf("Error paths\n");
+
+	sim_reset();
+	SoftI2C_Init(bus);
+	SoftI2C_SetSpeed(bus, I2C_SPEED_FAST);
+
+	error = SoftI2C_Burst_Receive(bus, SLAVE_ADDR + 1, 0, rx, 2);
+	printf("    absent address: 0x%02X\n", error);
+	expect("address NACK reported like the module", error == (I2C_MCS_ERROR|I2C_MCS_ADRACK));
+	sim_flush();
+	expect("bus released after NACK", !scl_line.master_low && !sda_line.master_low && !sda_line.slave_low);
+
+	expect("zero length rejected", SoftI2C_Burst_Receive(bus, SLAVE_ADDR, 0, rx, 0) == I2C_ERR_PARAM);
+	expect("1MHz refused", SoftI2C_SetSpeed(bus, I2C_SPEED_FAST_PLUS) == 0);
+	expect("Receive returns the byte", SoftI2C_Receive(bus, SLAVE_ADDR, 0x10) == slave.regs[0x10]);
+
+	slave.stuck = 1;
+	error = SoftI2C_Transmit(bus, SLAVE_ADDR, 0x00, 0x5A);
+	printf("    slave holding SCL: 0x%02X\n", error);
+	expect("stuck SCL times out", error == I2C_ERR_TIMEOUT);
+}
+
+int main(int argc, char** argv){
+
+	int i;
+	uint32_t rise_ns = 300;
+	uint32_t stretch_us = 20;
+
+	for(i = 1; i < argc; i++){
+		if(!strcmp(argv[i], "-r") && i + 1 < argc)
+			rise_ns = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "-s") && i + 1 < argc)
+			stretch_us = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "-v"))
+			verbose = 1;
+		else{
+			fprintf(stderr, "usage: %s [-r rise_ns] [-s stretch_us] [-v]\n", argv[0]);
+			return 2;
+		}
+	}
+	rise_cycles = (uint64_t)rise_ns * SIM_SYSCLK_HZ / 1000000000ULL;
+
+	run_speed(I2C_SPEED_STANDARD, 0);
+	run_speed(I2C_SPEED_FAST, 0);
+	run_speed(I2C_SPEED_FAST, stretch_us);
+	run_errors();
+
+	printf(failures ? "%d check(s) failed\n" : "All checks passed\n", failures);
+	return failures ? 1 : 0;
+}
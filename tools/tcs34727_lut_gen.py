@@ -0,0 +1,233 @@
+#!/usr/bin/env python3
+"""
+tcs34727_lut_gen.py
+
+Builds the lookup table of the TCS34727 palette classifier
+(TCS34727_Classify) from the palette centroids, and writes it out as
+TCS34727LUT.c. Run it again whenever the palette changes.
+
+Each table cell is one chromaticity bin (r = R/(R+G+B), g = G/(R+G+B),
+TCS34727_LUT_CHROMA bins each) at one brightness bin (C_NORM,
+TCS34727_LUT_LIGHT bins). The brightness edges are evenly spaced in
+log2 between the darkest and the brightest centroid. A cell gets the
+color of the nearest centroid in (r, g, weight * log2 C_NORM). The
+confidence (0-15) is the margin to the nearest centroid of another
+color (full at --margin or more), reduced once the cell is more than
+half of --max-dist from its own. A cell farther than --max-dist from
+every centroid is NOTHING at confidence 0.
+
+Usage:
+    tcs34727_lut_gen.py                        # regenerate TCS34727LUT.c
+    tcs34727_lut_gen.py --print                # also show the table
+    tcs34727_lut_gen.py --check samples.csv    # accuracy on recorded samples
+
+Recorded samples are the lines console command 'c' prints, with the
+color the part really was in front: color,R_RAW,G_RAW,B_RAW,C_RAW,exposure.
+Further columns are ignored. They go through the same integer math as
+the firmware, so the result is what the board would have said.
+"""
+
+import argparse
+import csv
+import math
+import os
+import re
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SRC = os.path.join(HERE, "..", "Full System Test")
+HEADER = os.path.join(SRC, "TCS34727.h")
+
+# COLOR_DETECTED in TCS34727.h
+COLORS = {"RED": 0, "GREEN": 1, "BLUE": 2, "NOTHING": 3, "YELLOW": 4,
+          "CYAN": 5, "PURPLE": 6, "WHITE": 7, "BLACK": 8}
+NAMES = {v: k for k, v in COLORS.items()}
+
+
+def header_macros():
+    """Table geometry and the constants the firmware math uses."""
+    text = open(HEADER).read()
+    macros = {}
+    for name in ("TCS34727_LUT_CHROMA", "TCS34727_LUT_LIGHT", "TCS34727_LUT_CLASS_SHIFT",
+                 "TCS34727_CONF_MAX", "TCS34727_RGB_Q", "TCS34727_NORM_STEPS", "MIN_RAW_VALUE"):
+        m = re.search(r"#define\s+%s\s+\(?(\w+)\)?" % name, text)
+        if not m:
+            sys.exit("%s not found in %s" % (name, HEADER))
+        macros[name] = int(m.group(1), 0)
+    return macros
+
+
+def read_palette(path):
+    palette = []
+    with open(path) as f:
+        for row in csv.reader(line for line in f if not line.startswith("#")):
+            if not row:
+                continue
+            name = row[0].strip().upper()
+            if name not in COLORS or name == "NOTHING":
+                sys.exit("%s: unknown palette color %s" % (path, row[0]))
+            r, g, b, c = (int(v) for v in row[1:5])
+            palette.append((name, r, g, b, c))
+    if not palette:
+        sys.exit("%s: empty palette" % path)
+    return palette
+
+
+def build(palette, m, weight, max_dist, full_margin):
+    chroma = m["TCS34727_LUT_CHROMA"]
+    levels = m["TCS34727_LUT_LIGHT"]
+    conf_max = m["TCS34727_CONF_MAX"]
+
+    points = []
+    for name, r, g, b, c in palette:
+        s = r + g + b
+        points.append((COLORS[name], r / s, g / s, math.log2(c)))
+
+    lo = min(p[3] for p in points)
+    hi = max(p[3] for p in points)
+    width = (hi - lo) / levels if hi > lo else 1.0
+    edges = [lo + width * (i + 1) for i in range(levels - 1)]
+    centers = [lo + width * (i + 0.5) for i in range(levels)]
+
+    table = []
+    for li in range(levels):
+        plane = []
+        for ri in range(chroma):
+            row = []
+            for gi in range(chroma):
+                r = (ri + 0.5) / chroma
+                g = (gi + 0.5) / chroma
+                best = {}
+                for color, pr, pg, pl in points:
+                    d = math.sqrt((r - pr) ** 2 + (g - pg) ** 2 + (weight * (centers[li] - pl)) ** 2)
+                    best[color] = min(d, best.get(color, d))
+                ranked = sorted(best.items(), key=lambda kv: kv[1])
+                color, d1 = ranked[0]
+                d2 = ranked[1][1] if len(ranked) > 1 else max_dist
+                if d1 > max_dist:
+                    row.append((COLORS["NOTHING"], 0))
+                    continue
+                margin = min(1.0, (d2 - d1) / full_margin)
+                near = min(1.0, 2.0 * (max_dist - d1) / max_dist)
+                conf = int(round(conf_max * margin * near))
+                row.append((color, max(0, min(conf_max, conf))))
+            plane.append(row)
+        table.append(plane)
+
+    return table, [int(round(2 ** e)) for e in edges]
+
+
+def classify(table, edges, m, r, g, b, c, exposure):
+    """TCS34727_Classify in Python, same integer math."""
+    chroma = m["TCS34727_LUT_CHROMA"]
+    q = m["TCS34727_RGB_Q"]
+    s = r + g + b
+    if c <= m["MIN_RAW_VALUE"] or s == 0:
+        return COLORS["NOTHING"], 0
+    recip = (chroma << q) // s
+    ri = min((r * recip) >> q, chroma - 1)
+    gi = min((g * recip) >> q, chroma - 1)
+    light = c * m["TCS34727_NORM_STEPS"]
+    li = 0
+    while li < len(edges) and light >= edges[li] * exposure:
+        li += 1
+    return table[li][ri][gi]
+
+
+def write_c(path, table, edges, palette, m, args):
+    chroma = m["TCS34727_LUT_CHROMA"]
+    shift = m["TCS34727_LUT_CLASS_SHIFT"]
+    out = []
+    out.append("/*")
+    out.append(" * TCS34727LUT.c")
+    out.append(" *")
+    out.append(" *\tLookup table of the TCS34727 palette classifier (TCS34727_Classify).")
+    out.append(" *\tGenerated by tools/tcs34727_lut_gen.py from %s," % os.path.relpath(args.palette, os.path.join(HERE, "..")).replace(os.sep, "/"))
+    out.append(" *\tweight %g, max-dist %g, margin %g. Do not edit, change the" % (args.weight, args.max_dist, args.margin))
+    out.append(" *\tpalette and run the generator again")
+    out.append(" *")
+    out.append(" * Created on: October 17th, 2026")
+    out.append(" *")
+    out.append(" */")
+    out.append("")
+    out.append('#include "TCS34727.h"')
+    out.append("")
+    out.append("/* C_NORM where each brightness bin starts */")
+    out.append("const uint32_t TCS34727_LUT_LIGHT_EDGE[TCS34727_LUT_LIGHT - 1] = {%s};" % ", ".join(str(e) for e in edges))
+    out.append("")
+    out.append("/* [brightness][r][g], class << TCS34727_LUT_CLASS_SHIFT | confidence */")
+    out.append("const uint8_t TCS34727_COLOR_LUT[TCS34727_LUT_LIGHT][TCS34727_LUT_CHROMA][TCS34727_LUT_CHROMA] = {")
+    for li, plane in enumerate(table):
+        out.append("\t{")
+        for ri, row in enumerate(plane):
+            cells = ", ".join("0x%02X" % (color << shift | conf) for color, conf in row)
+            out.append("\t\t{%s}%s" % (cells, "," if ri < chroma - 1 else ""))
+        out.append("\t}%s" % ("," if li < len(table) - 1 else ""))
+    out.append("};")
+    out.append("")
+    out.append("/* Centroids the table was built from */")
+    out.append("const TCS34727_PALETTE_t TCS34727_PALETTE[] = {")
+    for i, (name, r, g, b, c) in enumerate(palette):
+        out.append("\t{%s_DETECT, %d, %d, %d, %d}%s" % (name, r, g, b, c, "," if i < len(palette) - 1 else ""))
+    out.append("};")
+    out.append("const uint8_t TCS34727_PALETTE_SIZE = sizeof(TCS34727_PALETTE) / sizeof(TCS34727_PALETTE[0]);")
+    with open(path, "w", newline="\n") as f:
+        f.write("\n".join(out) + "\n")
+
+
+def check(path, table, edges, m, min_conf):
+    confusion = {}
+    right = total = 0
+    with open(path) as f:
+        for row in csv.reader(line for line in f if not line.startswith("#")):
+            if len(row) < 6:
+                continue
+            want = COLORS[row[0].strip().upper()]
+            r, g, b, c, exposure = (int(v) for v in row[1:6])
+            color, conf = classify(table, edges, m, r, g, b, c, exposure)
+            if conf < min_conf:
+                color = COLORS["NOTHING"]
+            confusion[(want, color)] = confusion.get((want, color), 0) + 1
+            right += color == want
+            total += 1
+    if total == 0:
+        sys.exit("%s: no samples" % path)
+    print("%d samples, %.1f%% right" % (total, 100.0 * right / total))
+    for (want, got), n in sorted(confusion.items()):
+        if want != got:
+            print("  %-7s read as %-7s %d" % (NAMES[want], NAMES[got], n))
+    return right == total
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate the TCS34727 palette lookup table")
+    parser.add_argument("--palette", default=os.path.join(HERE, "tcs34727_palette.csv"))
+    parser.add_argument("--out", default=os.path.join(SRC, "TCS34727LUT.c"))
+    parser.add_argument("--weight", type=float, default=0.05, help="chromaticity distance per octave of brightness")
+    parser.add_argument("--max-dist", type=float, default=0.25, help="farthest a cell may be from its centroid")
+    parser.add_argument("--margin", type=float, default=0.08, help="lead over the next color that gives full confidence")
+    parser.add_argument("--print", action="store_true", help="print the table")
+    parser.add_argument("--check", metavar="CSV", help="classify recorded samples instead of writing the table")
+    args = parser.parse_args()
+
+    m = header_macros()
+    palette = read_palette(args.palette)
+    table, edges = build(palette, m, args.weight, args.max_dist, args.margin)
+
+    if args.print:
+        for li, plane in enumerate(table):
+            print("brightness %d, C_NORM %s" % (li, "< %d" % edges[0] if li == 0 else ">= %d" % edges[li - 1]))
+            for row in plane:
+                print("  " + " ".join("%s%X" % (NAMES[color][0] if color != COLORS["BLACK"] else "K", conf) for color, conf in row))
+
+    if args.check:
+        return 0 if check(args.check, table, edges, m, m.get("TCS34727_CONF_MIN", 0)) else 1
+
+    write_c(args.out, table, edges, palette, m, args)
+    print("%s: %d palette rows, %d x %d x %d cells, edges %s" % (os.path.relpath(args.out), len(palette),
+          len(table), len(table[0]), len(table[0][0]), edges))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())